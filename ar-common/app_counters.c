@@ -0,0 +1,223 @@
+/***************************************************************************//**
+ * @file app_counters.c
+ * @brief app_counters.c
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include PLATFORM_HEADER
+#include "stack/include/ember.h"
+#include "hal/hal.h"
+#include "app_framework_common.h"
+#include "app_counters.h"
+#include "app_memory.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Sums the deltas of a counter over the ring.
+ *****************************************************************************/
+static uint32_t ring_sum(EmberCounterType type);
+
+/**************************************************************************//**
+ * Converts a count over the ring window to hundredths per second.
+ *****************************************************************************/
+static uint32_t to_rate(uint32_t count, uint32_t window_ms);
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+/// Counter sampling event control
+EmberEventControl *counters_control;
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+/// Increase of every counter since the last reset, as of the last sample
+static uint32_t totals[EMBER_COUNTER_TYPE_COUNT];
+/// Stack counter values at the last sample. The stack counters are never
+/// reset here, other modules (e.g. the CCA controller) read them too.
+static uint32_t snapshot[EMBER_COUNTER_TYPE_COUNT];
+/// Increase of every counter per sample period, saturated to 16 bits
+static uint16_t ring[APP_COUNTERS_RING_SIZE][EMBER_COUNTER_TYPE_COUNT];
+/// Slot of the last sample and number of samples in the ring
+static uint8_t ring_head = 0;
+static uint8_t ring_count = 0;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Allocates the sampling event and starts sampling.
+ *****************************************************************************/
+void app_counters_init(void)
+{
+  emberAfAllocateEvent(&counters_control, &counters_handler);
+  app_counters_reset();
+}
+
+/**************************************************************************//**
+ * Takes the current stack counter values as the new baseline and empties the
+ * delta ring.
+ *****************************************************************************/
+void app_counters_reset(void)
+{
+  uint8_t i;
+
+  for (i = 0; i < EMBER_COUNTER_TYPE_COUNT; i++) {
+    if (emberGetCounter(i, &snapshot[i]) != EMBER_SUCCESS) {
+      snapshot[i] = 0;
+    }
+  }
+  MEMSET(totals, 0, sizeof(totals));
+  MEMSET(ring, 0, sizeof(ring));
+  ring_head = 0;
+  ring_count = 0;
+  emberEventControlSetDelayMS(*counters_control, APP_COUNTERS_SAMPLE_PERIOD_MS);
+}
+
+/**************************************************************************//**
+ * Returns the increase of a stack counter from the last reset to the last
+ * sample.
+ *****************************************************************************/
+uint32_t app_counters_get(EmberCounterType type)
+{
+  return (type < EMBER_COUNTER_TYPE_COUNT) ? totals[type] : 0;
+}
+
+/**************************************************************************//**
+ * Returns the increase of a stack counter during the last sample period.
+ *****************************************************************************/
+uint16_t app_counters_get_last_delta(EmberCounterType type)
+{
+  if (type >= EMBER_COUNTER_TYPE_COUNT || ring_count == 0) {
+    return 0;
+  }
+  return ring[ring_head][type];
+}
+
+/**************************************************************************//**
+ * Computes the rates over the delta ring.
+ *****************************************************************************/
+void app_counters_get_rates(app_counters_rates_t *rates)
+{
+  uint32_t window_ms = (uint32_t)ring_count * APP_COUNTERS_SAMPLE_PERIOD_MS;
+
+  rates->window_ms = window_ms;
+  rates->tx = to_rate(ring_sum(EMBER_COUNTER_PHY_OUT_PACKETS), window_ms);
+  rates->rx = to_rate(ring_sum(EMBER_COUNTER_PHY_IN_PACKETS), window_ms);
+  rates->ack_failures =
+    to_rate(ring_sum(EMBER_COUNTER_MAC_OUT_UNICAST_ACK_FAIL), window_ms);
+  rates->cca_failures =
+    to_rate(ring_sum(EMBER_COUNTER_MAC_OUT_UNICAST_CCA_FAIL)
+            + ring_sum(EMBER_COUNTER_MAC_OUT_BROADCAST_CCA_FAIL), window_ms);
+  rates->retries =
+    to_rate(ring_sum(EMBER_COUNTER_MAC_OUT_UNICAST_RETRY), window_ms);
+}
+
+/**************************************************************************//**
+ * Serializes every counter.
+ *****************************************************************************/
+uint16_t app_counters_dump(uint8_t *buffer)
+{
+  app_memory_stats_t memory;
+  uint16_t length = 0;
+  uint8_t i;
+
+  buffer[length++] = APP_COUNTERS_DUMP_VERSION;
+  buffer[length++] = EMBER_COUNTER_TYPE_COUNT;
+  emberStoreLowHighInt16u(buffer + length, APP_COUNTERS_SAMPLE_PERIOD_MS / 100);
+  length += 2;
+  for (i = 0; i < EMBER_COUNTER_TYPE_COUNT; i++) {
+    emberStoreLowHighInt32u(buffer + length, totals[i]);
+    length += 4;
+  }
+  app_memory_get_stats(&memory);
+  emberStoreLowHighInt16u(buffer + length, memory.stack_size);
+  emberStoreLowHighInt16u(buffer + length + 2, memory.stack_peak);
+  emberStoreLowHighInt16u(buffer + length + 4, memory.buffer_size);
+  emberStoreLowHighInt16u(buffer + length + 6, memory.buffer_used);
+  emberStoreLowHighInt16u(buffer + length + 8, memory.buffer_peak);
+  emberStoreLowHighInt16u(buffer + length + 10, memory.c_heap_used);
+  emberStoreLowHighInt16u(buffer + length + 12, memory.c_heap_peak);
+  length += 14;
+  return length;
+}
+
+/**************************************************************************//**
+ * Event handler that samples every stack counter into the next ring slot. A
+ * counter that went backwards was reset elsewhere and counts from 0.
+ *****************************************************************************/
+void counters_handler(void)
+{
+  uint32_t value;
+  uint32_t delta;
+  uint8_t i;
+
+  emberEventControlSetDelayMS(*counters_control, APP_COUNTERS_SAMPLE_PERIOD_MS);
+  app_memory_sample();
+
+  if (ring_count > 0) {
+    ring_head = (ring_head + 1) % APP_COUNTERS_RING_SIZE;
+  }
+  if (ring_count < APP_COUNTERS_RING_SIZE) {
+    ring_count++;
+  }
+
+  for (i = 0; i < EMBER_COUNTER_TYPE_COUNT; i++) {
+    if (emberGetCounter(i, &value) != EMBER_SUCCESS) {
+      value = snapshot[i];
+    }
+    delta = (value >= snapshot[i]) ? (value - snapshot[i]) : value;
+    ring[ring_head][i] = (delta > UINT16_MAX) ? UINT16_MAX : (uint16_t)delta;
+    totals[i] += delta;
+    snapshot[i] = value;
+  }
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Sums the deltas of a counter over the ring.
+ *****************************************************************************/
+static uint32_t ring_sum(EmberCounterType type)
+{
+  uint32_t sum = 0;
+  uint8_t i;
+
+  for (i = 0; i < ring_count; i++) {
+    sum += ring[i][type];
+  }
+  return sum;
+}
+
+/**************************************************************************//**
+ * Converts a count over the ring window to hundredths per second.
+ *****************************************************************************/
+static uint32_t to_rate(uint32_t count, uint32_t window_ms)
+{
+  if (window_ms == 0) {
+    return 0;
+  }
+  return (uint32_t)(((uint64_t)count * 100 * MILLISECOND_TICKS_PER_SECOND)
+                    / window_ms);
+}
@@ -0,0 +1,97 @@
+/***************************************************************************//**
+ * @file app_counters.h
+ * @brief app_counters.h
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+#ifndef APP_COUNTERS_H
+#define APP_COUNTERS_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include "counters-config.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Version of the binary snapshot layout
+#define APP_COUNTERS_DUMP_VERSION      (2u)
+/// Length of the binary snapshot
+#define APP_COUNTERS_DUMP_LENGTH       (4 + 4 * EMBER_COUNTER_TYPE_COUNT + 14)
+
+/// Rates averaged over the delta ring, in hundredths of events per second
+typedef struct {
+  uint32_t tx;
+  uint32_t rx;
+  uint32_t ack_failures;
+  uint32_t cca_failures;
+  uint32_t retries;
+  /// Time covered by the ring
+  uint32_t window_ms;
+} app_counters_rates_t;
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+/// Counter sampling event control
+extern EmberEventControl *counters_control;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Allocates the sampling event and starts sampling.
+ *****************************************************************************/
+void app_counters_init(void);
+
+/**************************************************************************//**
+ * Restarts the counts from the current stack counter values and empties the
+ * delta ring. The stack counters themselves are left alone.
+ *****************************************************************************/
+void app_counters_reset(void);
+
+/**************************************************************************//**
+ * Returns the increase of a stack counter from the last reset to the last
+ * sample.
+ *****************************************************************************/
+uint32_t app_counters_get(EmberCounterType type);
+
+/**************************************************************************//**
+ * Returns the increase of a stack counter during the last sample period.
+ *****************************************************************************/
+uint16_t app_counters_get_last_delta(EmberCounterType type);
+
+/**************************************************************************//**
+ * Computes the rates over the delta ring.
+ *****************************************************************************/
+void app_counters_get_rates(app_counters_rates_t *rates);
+
+/**************************************************************************//**
+ * Serializes every counter, little endian: version (1), counter count (1),
+ * sample period in ms / 100 (2), then each counter since the last reset as
+ * 4 bytes in EmberCounterType order, then the memory usage as 2 bytes each in
+ * app_memory_stats_t order. The buffer heap peak is the highest use seen at
+ * the app_memory_sample() points, not a true allocator high-water mark.
+ *
+ * @param *buffer holds at least APP_COUNTERS_DUMP_LENGTH bytes
+ * @returns the length of the snapshot
+ *****************************************************************************/
+uint16_t app_counters_dump(uint8_t *buffer);
+
+/**************************************************************************//**
+ * Event handler that samples every stack counter.
+ *****************************************************************************/
+void counters_handler(void);
+
+#endif  // APP_COUNTERS_H
@@ -0,0 +1,192 @@
+/***************************************************************************//**
+ * @file app_memory.c
+ * @brief app_memory.c
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include PLATFORM_HEADER
+#include "stack/include/ember.h"
+#include "stack/framework/buffer-management.h"
+#include "em_device.h"
+#if defined(__GNUC__)
+#include <malloc.h>
+#endif
+#if defined(EMBER_AF_PLUGIN_MICRIUM_RTOS)
+#include <kernel/include/os.h>
+#endif
+#include "app_memory.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Bounds of the main stack, from the linker
+#if defined(__GNUC__)
+extern uint32_t __StackLimit;
+extern uint32_t __StackTop;
+#define STACK_BOTTOM                   (&__StackLimit)
+#define STACK_TOP                      (&__StackTop)
+#elif defined(__ICCARM__)
+#pragma section = "CSTACK"
+#define STACK_BOTTOM                   ((uint32_t *)__section_begin("CSTACK"))
+#define STACK_TOP                      ((uint32_t *)__section_end("CSTACK"))
+#endif
+
+/// Stack left untouched below the frame of the painting function
+#define PAINT_MARGIN_WORDS             (16)
+
+/// Task stack usage is only known with the Micrium debug task list
+#if defined(EMBER_AF_PLUGIN_MICRIUM_RTOS) \
+  && (OS_CFG_DBG_EN == DEF_ENABLED) && (OS_CFG_STAT_TASK_STK_CHK_EN == DEF_ENABLED)
+#define TASK_STACK_CHECK
+#endif
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Clamps a byte count to 16 bits.
+ *****************************************************************************/
+static uint16_t clamp16(uint32_t value);
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+/// Peak use of the Ember buffer heap
+static uint16_t buffer_peak = 0;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Paints the main stack from its bottom up to a margin below the current
+ * stack pointer.
+ *****************************************************************************/
+void app_memory_init(void)
+{
+#if defined(STACK_BOTTOM)
+  uint32_t *word = STACK_BOTTOM;
+  uint32_t *limit = (uint32_t *)__get_MSP() - PAINT_MARGIN_WORDS;
+
+  while (word < limit) {
+    *word++ = APP_MEMORY_PAINT_PATTERN;
+  }
+#endif
+  app_memory_reset_peak();
+}
+
+/**************************************************************************//**
+ * Updates the peak use of the Ember buffer heap.
+ *****************************************************************************/
+void app_memory_sample(void)
+{
+  uint16_t used = emBufferBytesUsed();
+
+  if (used > buffer_peak) {
+    buffer_peak = used;
+  }
+}
+
+/**************************************************************************//**
+ * Scans the stack watermark and fills the memory usage.
+ *****************************************************************************/
+void app_memory_get_stats(app_memory_stats_t *stats)
+{
+  MEMSET(stats, 0, sizeof(*stats));
+
+#if defined(STACK_BOTTOM)
+  {
+    const uint32_t *word = STACK_BOTTOM;
+
+    while (word < STACK_TOP && *word == APP_MEMORY_PAINT_PATTERN) {
+      word++;
+    }
+    stats->stack_size = clamp16((uint32_t)(STACK_TOP - STACK_BOTTOM) * 4);
+    stats->stack_peak = clamp16((uint32_t)(STACK_TOP - word) * 4);
+  }
+#endif
+
+  app_memory_sample();
+  stats->buffer_size = emBufferBytesTotal();
+  stats->buffer_used = emBufferBytesUsed();
+  stats->buffer_peak = buffer_peak;
+
+#if defined(__GNUC__)
+  {
+    struct mallinfo info = mallinfo();
+    stats->c_heap_used = clamp16((uint32_t)info.uordblks);
+    stats->c_heap_peak = clamp16((uint32_t)info.arena);
+  }
+#endif
+}
+
+/**************************************************************************//**
+ * Restarts the peak tracking of the Ember buffer heap.
+ *****************************************************************************/
+void app_memory_reset_peak(void)
+{
+  buffer_peak = emBufferBytesUsed();
+}
+
+/**************************************************************************//**
+ * Returns the stack usage of an RTOS task.
+ *****************************************************************************/
+bool app_memory_get_task(uint8_t index,
+                         const char **name,
+                         uint16_t *size,
+                         uint16_t *used)
+{
+#if defined(TASK_STACK_CHECK)
+  OS_TCB *tcb = OSTaskDbgListPtr;
+  CPU_STK_SIZE stack_free;
+  CPU_STK_SIZE stack_used;
+  RTOS_ERR err;
+
+  while (tcb != NULL && index > 0) {
+    tcb = tcb->DbgNextPtr;
+    index--;
+  }
+  if (tcb == NULL) {
+    return false;
+  }
+  OSTaskStkChk(tcb, &stack_free, &stack_used, &err);
+  if (RTOS_ERR_CODE_GET(err) != RTOS_ERR_NONE) {
+    stack_free = 0;
+    stack_used = 0;
+  }
+  *name = (tcb->NamePtr != NULL) ? tcb->NamePtr : "?";
+  *size = clamp16((stack_free + stack_used) * sizeof(CPU_STK));
+  *used = clamp16(stack_used * sizeof(CPU_STK));
+  return true;
+#else
+  (void) index;
+  (void) name;
+  (void) size;
+  (void) used;
+  return false;
+#endif
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Clamps a byte count to 16 bits.
+ *****************************************************************************/
+static uint16_t clamp16(uint32_t value)
+{
+  return (value > UINT16_MAX) ? UINT16_MAX : (uint16_t)value;
+}
@@ -0,0 +1,95 @@
+/***************************************************************************//**
+ * @file app_memory.h
+ * @brief app_memory.h
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+#ifndef APP_MEMORY_H
+#define APP_MEMORY_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdint.h>
+#include <stdbool.h>
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Word written to the unused part of the stacks, the watermark scan counts
+/// how many of them are left
+#define APP_MEMORY_PAINT_PATTERN       (0xCDCDCDCDu)
+
+/// Memory usage, in bytes
+typedef struct {
+  /// Main stack size and the deepest use seen since startup
+  uint16_t stack_size;
+  uint16_t stack_peak;
+  /// Ember buffer heap (EMBER_HEAP_SIZE) size, current and peak use, the
+  /// peak as seen by app_memory_sample()
+  uint16_t buffer_size;
+  uint16_t buffer_used;
+  uint16_t buffer_peak;
+  /// C heap (SL_HEAP_SIZE) current use and space taken from the system,
+  /// which only grows and thus is its peak
+  uint16_t c_heap_used;
+  uint16_t c_heap_peak;
+} app_memory_stats_t;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Paints the unused part of the main stack. To be called as early as
+ * possible, whatever was used before counts as used.
+ *****************************************************************************/
+void app_memory_init(void);
+
+/**************************************************************************//**
+ * Updates the peak use of the Ember buffer heap. The peak is sampled, not
+ * tracked by the allocator: it is the highest use seen at the sampling
+ * points, right after a message is handed to the stack, while a received
+ * message is handled, every counters sample period and whenever the usage
+ * is read. Buffers allocated and freed within a single stack call in between
+ * are missed.
+ *****************************************************************************/
+void app_memory_sample(void);
+
+/**************************************************************************//**
+ * Scans the stack watermark and fills the memory usage.
+ *****************************************************************************/
+void app_memory_get_stats(app_memory_stats_t *stats);
+
+/**************************************************************************//**
+ * Restarts the peak tracking of the Ember buffer heap. The stack watermark
+ * cannot be reset.
+ *****************************************************************************/
+void app_memory_reset_peak(void);
+
+/**************************************************************************//**
+ * Returns the stack usage of an RTOS task. Only available with Micrium OS
+ * built with OS_CFG_DBG_EN and OS_CFG_STAT_TASK_STK_CHK_EN, and for tasks
+ * created with OS_OPT_TASK_STK_CHK.
+ *
+ * @param index is the index of the task in the task list
+ * @param **name receives the name of the task
+ * @param *size receives the stack size in bytes
+ * @param *used receives the deepest stack use in bytes
+ * @returns false if there is no such task.
+ *****************************************************************************/
+bool app_memory_get_task(uint8_t index,
+                         const char **name,
+                         uint16_t *size,
+                         uint16_t *used);
+
+#endif  // APP_MEMORY_H
@@ -0,0 +1,119 @@
+/***************************************************************************//**
+ * @file app_protocol.h
+ * @brief app_protocol.h
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+#ifndef APP_PROTOCOL_H
+#define APP_PROTOCOL_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+// Application extensions of the sensor/sink protocol. The frames keep the
+// sensor/sink header (protocol ID, command ID, EUI64, node ID), the extended
+// command IDs are placed above the ones of sensor_sink_command_id.
+// This header is shared by the Sink and the Sensor applications.
+
+/// Sink to sensor: configuration of the sensor.
+/// Payload: flags (1), report period in ms (2, little endian)
+#define APP_COMMAND_ID_CONFIGURE                (0x80u)
+
+/// Sink to range extender: permit joining, to steer new sensors to the
+/// least loaded parent.
+/// Payload: flags (1), duration in s (1, 0xFF unlimited), then the selective
+/// join payload, if any, up to the end of the frame
+#define APP_COMMAND_ID_PERMIT_JOIN              (0x81u)
+
+/// Longest application frame, sensor/sink header included. The advertise
+/// TLVs and the extended commands do not fit in SENSOR_SINK_MAXIMUM_LENGTH,
+/// which only covers the sensor data.
+#define APP_FRAME_MAX_LENGTH                    (64u)
+/// Longest payload following the sensor/sink header
+#define APP_PAYLOAD_MAX_LENGTH                  (APP_FRAME_MAX_LENGTH - SENSOR_SINK_DATA_OFFSET)
+
+/// Offsets in the payload of the extended downlink commands
+#define APP_DOWNLINK_FLAGS_OFFSET               (0u)
+#define APP_CONFIGURE_REPORT_PERIOD_OFFSET      (1u)
+#define APP_CONFIGURE_LENGTH                    (3u)
+/// Shortest report period a sensor accepts, in ms
+#define APP_CONFIGURE_MIN_REPORT_PERIOD_MS      (100u)
+#define APP_PERMIT_JOIN_DURATION_OFFSET         (1u)
+#define APP_PERMIT_JOIN_PAYLOAD_OFFSET          (2u)
+/// Longest selective join payload
+#define APP_PERMIT_JOIN_MAX_PAYLOAD_LENGTH      (16u)
+
+/// Downlink flag: the sink holds more frames for the sensor
+#define APP_DOWNLINK_FLAG_PENDING               (0x01u)
+
+/// The payload of the advertise command is a list of TLV elements:
+/// type (1), length of the value (1), value.
+#define APP_TLV_TYPE_OFFSET                     (0u)
+#define APP_TLV_LENGTH_OFFSET                   (1u)
+#define APP_TLV_VALUE_OFFSET                    (2u)
+
+/// Advertise TLV: node IDs (2 bytes each, little endian) of the sensors the
+/// sink holds frames for
+#define APP_ADVERTISE_TLV_PENDING               (0x01u)
+
+/// Advertise TLV: channels of the frequency hopping list the sink excludes.
+/// Value: first channel of the list (2, little endian) followed by a bitmap,
+/// bit n % 8 of byte n / 8 is set if channel first + n is excluded
+#define APP_ADVERTISE_TLV_CHANNEL_MAP           (0x02u)
+/// Largest bitmap of the channel map element (100 channels)
+#define APP_CHANNEL_MAP_MAX_BITMAP_LENGTH       (13u)
+
+/// Advertise TLV: network time beacon, the first element of the payload.
+/// Value: time of the sink in ms when the advertisement was handed to the
+/// stack (4, little endian), wrapping
+#define APP_ADVERTISE_TLV_TIME                  (0x03u)
+#define APP_TIME_LENGTH                         (4u)
+
+/// The payload of the data command holds the sensor data
+/// (SENSOR_SINK_DATA_LENGTH bytes), optionally followed by TLV elements.
+/// Data TLV: timing of the report. Value: time from the sampling to the send
+/// call (2, little endian), time from the send call to the MAC acknowledgement
+/// of the previous report (2, little endian), both in ms and saturated
+#define APP_DATA_TLV_TIMING                     (0x01u)
+#define APP_DATA_TIMING_SAMPLE_AGE_OFFSET       (0u)
+#define APP_DATA_TIMING_LAST_TX_OFFSET          (2u)
+#define APP_DATA_TIMING_LENGTH                  (4u)
+
+/// Data TLV: network time in ms the sensors were sampled at (4, little
+/// endian), only sent by sensors synchronized to a time beacon
+#define APP_DATA_TLV_SAMPLE_TIME                (0x02u)
+
+/// Data TLV: node ID of the parent of the sensor (2, little endian), the
+/// sink itself or a range extender
+#define APP_DATA_TLV_PARENT                     (0x03u)
+#define APP_PARENT_LENGTH                       (2u)
+
+/// Data TLV: sequence number of the report (4, little endian), counted by
+/// the sensor from its startup. Lets hosts reading several sinks drop the
+/// copies of a report heard by more than one of them.
+#define APP_DATA_TLV_SEQUENCE                   (0x04u)
+#define APP_SEQUENCE_LENGTH                     (4u)
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+
+#endif  // APP_PROTOCOL_H
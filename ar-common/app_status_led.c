@@ -0,0 +1,312 @@
+/***************************************************************************//**
+ * @file app_status_led.c
+ * @brief app_status_led.c
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include PLATFORM_HEADER
+#include "em_device.h"
+#include "stack/include/ember.h"
+#include "hal/hal.h"
+#include "sl_component_catalog.h"
+#include "sl_app_common.h"
+#include "app_framework_common.h"
+#if defined(SL_CATALOG_LED0_PRESENT)
+#include "sl_simple_led_instances.h"
+#endif
+#include "app_status_led.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define PATTERN_STEPS                  (16u)
+#define PATTERN_OFF                    (0x0000u)
+#define PATTERN_ON                     (0xFFFFu)
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Starts the pattern of a state from its first step.
+ *****************************************************************************/
+static void apply(app_status_led_state_t state);
+
+/**************************************************************************//**
+ * Writes the current step to the LED and schedules the event at the next
+ * change of the LED or at the end of the temporary state, whichever comes
+ * first.
+ *****************************************************************************/
+static void update(void);
+
+static void write_led(bool on);
+
+#if APP_STATUS_LED_LOOP_METER
+static void print_loop_cost(void);
+#endif
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+/// Blink pattern event control
+EmberEventControl *status_led_control;
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static const uint16_t patterns[] = {
+  [APP_STATUS_LED_OFF] = PATTERN_OFF,
+  [APP_STATUS_LED_FORMING] = APP_STATUS_LED_PATTERN_FORMING,
+  [APP_STATUS_LED_JOINED] = PATTERN_ON,
+  [APP_STATUS_LED_PAIRING] = APP_STATUS_LED_PATTERN_PAIRING,
+  [APP_STATUS_LED_ERROR] = APP_STATUS_LED_PATTERN_ERROR,
+};
+
+static struct {
+  app_status_led_state_t lasting;
+  app_status_led_state_t shown;
+  /// Temporary state, shown for duration_ms if timed
+  bool temporary;
+  bool timed;
+  uint32_t started_ms;
+  uint32_t duration_ms;
+  /// Current step of the pattern and steps until the next change
+  uint8_t step;
+  uint8_t run;
+} status;
+
+#if APP_STATUS_LED_LOOP_METER
+/// Main loop measurement
+static struct {
+  uint16_t remaining;
+  bool started;
+  uint32_t last_cycles;
+  app_status_led_loop_cost_t result;
+} meter;
+#endif
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Allocates the blink pattern event and turns the LED off.
+ *****************************************************************************/
+void app_status_led_init(void)
+{
+  emberAfAllocateEvent(&status_led_control, &status_led_handler);
+  app_status_led_set(APP_STATUS_LED_OFF);
+}
+
+/**************************************************************************//**
+ * Sets the lasting state.
+ *****************************************************************************/
+void app_status_led_set(app_status_led_state_t state)
+{
+  status.lasting = state;
+  status.temporary = false;
+  apply(state);
+}
+
+/**************************************************************************//**
+ * Shows a state for a while, then goes back to the lasting one.
+ *****************************************************************************/
+void app_status_led_show(app_status_led_state_t state, uint32_t duration_ms)
+{
+  status.temporary = true;
+  status.timed = (duration_ms > 0);
+  status.started_ms = halCommonGetInt32uMillisecondTick();
+  status.duration_ms = duration_ms;
+  apply(state);
+}
+
+/**************************************************************************//**
+ * Shows the pairing state while joining is permitted.
+ *****************************************************************************/
+void app_status_led_permit_join(uint8_t duration_s)
+{
+  if (duration_s == 0) {
+    if (status.temporary && status.shown == APP_STATUS_LED_PAIRING) {
+      status.temporary = false;
+      apply(status.lasting);
+    }
+  } else if (duration_s == 0xFF) {
+    app_status_led_show(APP_STATUS_LED_PAIRING, 0);
+  } else {
+    app_status_led_show(APP_STATUS_LED_PAIRING,
+                        (uint32_t)duration_s * MILLISECOND_TICKS_PER_SECOND);
+  }
+}
+
+/**************************************************************************//**
+ * Returns the state shown.
+ *****************************************************************************/
+app_status_led_state_t app_status_led_get(void)
+{
+  return status.shown;
+}
+
+/**************************************************************************//**
+ * Event handler that steps the blink pattern.
+ *****************************************************************************/
+void status_led_handler(void)
+{
+  emberEventControlSetInactive(*status_led_control);
+  if (status.temporary && status.timed
+      && elapsedTimeInt32u(status.started_ms, halCommonGetInt32uMillisecondTick())
+      >= status.duration_ms) {
+    status.temporary = false;
+    apply(status.lasting);
+    return;
+  }
+  status.step = (uint8_t)((status.step + status.run) % PATTERN_STEPS);
+  update();
+}
+
+#if APP_STATUS_LED_LOOP_METER
+/**************************************************************************//**
+ * Starts measuring the next main loop iterations.
+ *****************************************************************************/
+bool app_status_led_measure_loop(uint16_t iterations, bool polling)
+{
+  if (meter.remaining > 0 || iterations == 0) {
+    return false;
+  }
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+  meter.result.iterations = 0;
+  meter.result.polling = polling;
+  meter.result.min_cycles = UINT32_MAX;
+  meter.result.max_cycles = 0;
+  meter.result.total_cycles = 0;
+  meter.started = false;
+  meter.remaining = iterations;
+  return true;
+}
+
+/**************************************************************************//**
+ * Returns the last measurement.
+ *****************************************************************************/
+const app_status_led_loop_cost_t *app_status_led_get_loop_cost(void)
+{
+  return &meter.result;
+}
+
+/**************************************************************************//**
+ * Samples the cycle counter.
+ *****************************************************************************/
+void app_status_led_loop_tick(void)
+{
+  uint32_t now_cycles;
+  uint32_t cycles;
+
+  if (meter.remaining == 0) {
+    return;
+  }
+  if (meter.result.polling) {
+    // What emberAfTickCallback() did on every iteration before
+    write_led(emberStackIsUp());
+  }
+  now_cycles = DWT->CYCCNT;
+  if (!meter.started) {
+    // The first sample only starts the first iteration.
+    meter.started = true;
+    meter.last_cycles = now_cycles;
+    return;
+  }
+  cycles = now_cycles - meter.last_cycles;
+  meter.last_cycles = now_cycles;
+  if (cycles < meter.result.min_cycles) {
+    meter.result.min_cycles = cycles;
+  }
+  if (cycles > meter.result.max_cycles) {
+    meter.result.max_cycles = cycles;
+  }
+  meter.result.total_cycles += cycles;
+  meter.result.iterations++;
+  if (--meter.remaining == 0) {
+    if (meter.result.polling) {
+      // The polling overwrote the pattern.
+      update();
+    }
+    print_loop_cost();
+  }
+}
+#endif
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+static void apply(app_status_led_state_t state)
+{
+  status.shown = state;
+  status.step = 0;
+  update();
+}
+
+static void update(void)
+{
+  uint16_t pattern = patterns[status.shown];
+  bool on = ((pattern >> status.step) & 0x01u) != 0;
+  uint32_t delay_ms = 0;
+  uint32_t remaining_ms;
+
+  write_led(on);
+  status.run = 0;
+  if (pattern != PATTERN_OFF && pattern != PATTERN_ON) {
+    do {
+      status.run++;
+    } while (status.run < PATTERN_STEPS
+             && (((pattern >> ((status.step + status.run) % PATTERN_STEPS)) & 0x01u) != 0) == on);
+    delay_ms = (uint32_t)status.run * APP_STATUS_LED_STEP_MS;
+  }
+  if (status.temporary && status.timed) {
+    remaining_ms = elapsedTimeInt32u(status.started_ms, halCommonGetInt32uMillisecondTick());
+    remaining_ms = (remaining_ms < status.duration_ms) ? status.duration_ms - remaining_ms : 0;
+    if (delay_ms == 0 || remaining_ms < delay_ms) {
+      delay_ms = remaining_ms;
+    }
+  } else if (delay_ms == 0) {
+    // Steady, nothing to run until the next state change
+    emberEventControlSetInactive(*status_led_control);
+    return;
+  }
+  emberEventControlSetDelayMS(*status_led_control, delay_ms);
+}
+
+static void write_led(bool on)
+{
+#if defined(SL_CATALOG_LED0_PRESENT)
+  if (on) {
+    sl_led_turn_on(&sl_led_led0);
+  } else {
+    sl_led_turn_off(&sl_led_led0);
+  }
+#else
+  (void) on;
+#endif
+}
+
+#if APP_STATUS_LED_LOOP_METER
+static void print_loop_cost(void)
+{
+  APP_INFO("Loop cost (%s): %d iterations, min %lu, avg %lu, max %lu cycles\n",
+           meter.result.polling ? "LED polling" : "LED events",
+           meter.result.iterations,
+           meter.result.min_cycles,
+           (uint32_t)(meter.result.total_cycles / meter.result.iterations),
+           meter.result.max_cycles);
+}
+#endif
@@ -0,0 +1,127 @@
+/***************************************************************************//**
+ * @file app_status_led.h
+ * @brief app_status_led.h
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+#ifndef APP_STATUS_LED_H
+#define APP_STATUS_LED_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdint.h>
+#include <stdbool.h>
+#include "status-led-config.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// States shown on LED0
+typedef enum {
+  /// No network: off
+  APP_STATUS_LED_OFF,
+  /// Forming or joining a network: APP_STATUS_LED_PATTERN_FORMING
+  APP_STATUS_LED_FORMING,
+  /// On the network: on
+  APP_STATUS_LED_JOINED,
+  /// Joining permitted: APP_STATUS_LED_PATTERN_PAIRING
+  APP_STATUS_LED_PAIRING,
+  /// A join failed or the stack reported an error:
+  /// APP_STATUS_LED_PATTERN_ERROR
+  APP_STATUS_LED_ERROR
+} app_status_led_state_t;
+
+/// Outcome of a main loop measurement, in CPU cycles between two
+/// consecutive emberAfTickCallback() calls. The shortest iteration is the
+/// cost of a loop with nothing to do; the others include the events run and,
+/// on a sleepy device, the time asleep in EM1.
+typedef struct {
+  uint16_t iterations;
+  /// The LED was polled on every iteration, as before the status LED events
+  bool polling;
+  uint32_t min_cycles;
+  uint32_t max_cycles;
+  uint64_t total_cycles;
+} app_status_led_loop_cost_t;
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+/// Blink pattern event control
+extern EmberEventControl *status_led_control;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Allocates the blink pattern event and turns the LED off.
+ *****************************************************************************/
+void app_status_led_init(void);
+
+/**************************************************************************//**
+ * Sets the lasting state, e.g. on a stack status change. A temporary state
+ * shown by app_status_led_show() is dropped.
+ *****************************************************************************/
+void app_status_led_set(app_status_led_state_t state);
+
+/**************************************************************************//**
+ * Shows a state for a while, then goes back to the lasting one.
+ *
+ * @param duration_ms is the display time, 0 until the next call or
+ *        app_status_led_set()
+ *****************************************************************************/
+void app_status_led_show(app_status_led_state_t state, uint32_t duration_ms);
+
+/**************************************************************************//**
+ * Shows the pairing state while joining is permitted.
+ *
+ * @param duration_s is the duration given to emberPermitJoining(): 0 closes
+ *        joining, 0xFF leaves it open
+ *****************************************************************************/
+void app_status_led_permit_join(uint8_t duration_s);
+
+/**************************************************************************//**
+ * Returns the state shown.
+ *****************************************************************************/
+app_status_led_state_t app_status_led_get(void);
+
+/**************************************************************************//**
+ * Event handler that steps the blink pattern. It only runs when the LED
+ * changes, never for the steady states.
+ *****************************************************************************/
+void status_led_handler(void);
+
+#if APP_STATUS_LED_LOOP_METER
+/**************************************************************************//**
+ * Starts measuring the next main loop iterations, printed when done.
+ *
+ * @param polling also polls the stack and writes the LED on every iteration,
+ *        as emberAfTickCallback() did before, for the comparison
+ * @returns false if a measurement runs or iterations is 0.
+ *****************************************************************************/
+bool app_status_led_measure_loop(uint16_t iterations, bool polling);
+
+/**************************************************************************//**
+ * Returns the last measurement, iterations is 0 if none completed.
+ *****************************************************************************/
+const app_status_led_loop_cost_t *app_status_led_get_loop_cost(void);
+
+/**************************************************************************//**
+ * Samples the cycle counter. To be called from emberAfTickCallback(), it
+ * returns right away when no measurement runs.
+ *****************************************************************************/
+void app_status_led_loop_tick(void);
+#endif
+
+#endif  // APP_STATUS_LED_H
@@ -0,0 +1,179 @@
+/***************************************************************************//**
+ * @file app_trace.c
+ * @brief app_trace.c
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include PLATFORM_HEADER
+#include "stack/include/ember.h"
+#include "em_core.h"
+#include "sl_sleeptimer.h"
+#include "app_trace.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Recorded event, kept at 8 bytes so that the ring stays small
+typedef struct {
+  uint32_t tick;
+  uint8_t type;
+  uint8_t arg8;
+  uint16_t arg16;
+} trace_entry_t;
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+/// Trace ring
+static trace_entry_t ring[APP_TRACE_SIZE];
+/// Slot of the next event and number of events in the ring
+static uint16_t ring_head = 0;
+static uint16_t ring_count = 0;
+/// Events lost because the ring was full
+static uint32_t overwritten = 0;
+/// Recording state
+static bool enabled = false;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Empties the trace ring and applies APP_TRACE_ENABLED_AT_STARTUP.
+ *****************************************************************************/
+void app_trace_init(void)
+{
+  app_trace_clear();
+  enabled = (APP_TRACE_ENABLED_AT_STARTUP != 0);
+}
+
+/**************************************************************************//**
+ * Records an event with the current sleeptimer tick.
+ *****************************************************************************/
+void app_trace_record(app_trace_type_t type, uint8_t arg8, uint16_t arg16)
+{
+  trace_entry_t *entry;
+  CORE_DECLARE_IRQ_STATE;
+
+  if (!enabled) {
+    return;
+  }
+
+  CORE_ENTER_ATOMIC();
+  entry = &ring[ring_head];
+  entry->tick = sl_sleeptimer_get_tick_count();
+  entry->type = (uint8_t)type;
+  entry->arg8 = arg8;
+  entry->arg16 = arg16;
+  ring_head = (ring_head + 1) % APP_TRACE_SIZE;
+  if (ring_count < APP_TRACE_SIZE) {
+    ring_count++;
+  } else {
+    overwritten++;
+  }
+  CORE_EXIT_ATOMIC();
+}
+
+/**************************************************************************//**
+ * Empties the trace ring.
+ *****************************************************************************/
+void app_trace_clear(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  ring_head = 0;
+  ring_count = 0;
+  overwritten = 0;
+  CORE_EXIT_ATOMIC();
+}
+
+/**************************************************************************//**
+ * Pauses or resumes the recording.
+ *****************************************************************************/
+void app_trace_set_enabled(bool enable)
+{
+  enabled = enable;
+}
+
+/**************************************************************************//**
+ * Tells whether events are recorded.
+ *****************************************************************************/
+bool app_trace_is_enabled(void)
+{
+  return enabled;
+}
+
+/**************************************************************************//**
+ * Returns the number of events in the ring.
+ *****************************************************************************/
+uint16_t app_trace_get_count(void)
+{
+  return ring_count;
+}
+
+/**************************************************************************//**
+ * Serializes the dump header.
+ *****************************************************************************/
+uint8_t app_trace_dump_header(uint8_t *buffer)
+{
+  uint8_t length = 0;
+
+  buffer[length++] = 'T';
+  buffer[length++] = 'R';
+  buffer[length++] = APP_TRACE_DUMP_VERSION;
+  buffer[length++] = APP_TRACE_ENTRY_LENGTH;
+  emberStoreLowHighInt16u(buffer + length, emberGetNodeId());
+  length += 2;
+  emberStoreLowHighInt32u(buffer + length, sl_sleeptimer_get_timer_frequency());
+  length += 4;
+  emberStoreLowHighInt16u(buffer + length, ring_count);
+  length += 2;
+  emberStoreLowHighInt16u(buffer + length,
+                          (overwritten > UINT16_MAX) ? UINT16_MAX : (uint16_t)overwritten);
+  length += 2;
+  return length;
+}
+
+/**************************************************************************//**
+ * Serializes an event of the ring, 0 is the oldest one.
+ *****************************************************************************/
+bool app_trace_dump_entry(uint16_t index, uint8_t *buffer)
+{
+  const trace_entry_t *entry;
+
+  if (index >= ring_count) {
+    return false;
+  }
+  entry = &ring[(ring_head + APP_TRACE_SIZE - ring_count + index) % APP_TRACE_SIZE];
+  emberStoreLowHighInt32u(buffer, entry->tick);
+  buffer[4] = entry->type;
+  buffer[5] = entry->arg8;
+  emberStoreLowHighInt16u(buffer + 6, entry->arg16);
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
@@ -0,0 +1,123 @@
+/***************************************************************************//**
+ * @file app_trace.h
+ * @brief app_trace.h
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+#ifndef APP_TRACE_H
+#define APP_TRACE_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdint.h>
+#include <stdbool.h>
+#include "trace-config.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Version of the binary dump layout
+#define APP_TRACE_DUMP_VERSION         (1u)
+/// Length of the dump header: 'T', 'R', version, entry length, node ID,
+/// sleeptimer frequency, entry count and overwritten entry count
+#define APP_TRACE_HEADER_LENGTH        (14)
+/// Length of a serialized entry: tick (4), type (1), arg8 (1), arg16 (2)
+#define APP_TRACE_ENTRY_LENGTH         (8)
+
+/// Types of the recorded events
+typedef enum {
+  /// Frame received, arg8: command ID, arg16: source node ID
+  APP_TRACE_RX        = 0,
+  /// Frame handed to the stack, arg8: command ID, arg16: destination node ID
+  APP_TRACE_TX        = 1,
+  /// Transmission completed, arg8: status, arg16: destination node ID
+  APP_TRACE_TX_DONE   = 2,
+  /// Application event fired, arg8: app_trace_event_id_t
+  APP_TRACE_EVENT     = 3,
+  /// Entering sleep, arg8: energy mode
+  APP_TRACE_SLEEP     = 4,
+  /// Back in EM0, arg8: energy mode left
+  APP_TRACE_WAKE      = 5,
+  /// I2C transfer started
+  APP_TRACE_I2C_START = 6,
+  /// I2C transfer finished, arg8: 1 on success
+  APP_TRACE_I2C_STOP  = 7,
+  APP_TRACE_TYPE_COUNT
+} app_trace_type_t;
+
+/// Application events reported with APP_TRACE_EVENT
+typedef enum {
+  APP_TRACE_EVENT_REPORT      = 0,
+  APP_TRACE_EVENT_POLL        = 1,
+  APP_TRACE_EVENT_ADVERTISE   = 2,
+  APP_TRACE_EVENT_DATA_REPORT = 3,
+  APP_TRACE_EVENT_TX_QUEUE    = 4
+} app_trace_event_id_t;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Empties the trace ring and applies APP_TRACE_ENABLED_AT_STARTUP.
+ *****************************************************************************/
+void app_trace_init(void);
+
+/**************************************************************************//**
+ * Records an event with the current sleeptimer tick. Safe to call from
+ * interrupt context, the oldest event is overwritten when the ring is full.
+ *
+ * @param type is the type of the event
+ * @param arg8 and arg16 are the type specific arguments
+ *****************************************************************************/
+void app_trace_record(app_trace_type_t type, uint8_t arg8, uint16_t arg16);
+
+/**************************************************************************//**
+ * Empties the trace ring.
+ *****************************************************************************/
+void app_trace_clear(void);
+
+/**************************************************************************//**
+ * Pauses or resumes the recording.
+ *****************************************************************************/
+void app_trace_set_enabled(bool enable);
+
+/**************************************************************************//**
+ * Tells whether events are recorded.
+ *****************************************************************************/
+bool app_trace_is_enabled(void);
+
+/**************************************************************************//**
+ * Returns the number of events in the ring.
+ *****************************************************************************/
+uint16_t app_trace_get_count(void);
+
+/**************************************************************************//**
+ * Serializes the dump header.
+ *
+ * @param *buffer receives APP_TRACE_HEADER_LENGTH bytes
+ * @returns the length of the header.
+ *****************************************************************************/
+uint8_t app_trace_dump_header(uint8_t *buffer);
+
+/**************************************************************************//**
+ * Serializes an event of the ring. Recording should be paused while the
+ * ring is read, otherwise the indices move under the reader.
+ *
+ * @param index is the index of the event, 0 is the oldest one
+ * @param *buffer receives APP_TRACE_ENTRY_LENGTH bytes
+ * @returns false if there is no such event.
+ *****************************************************************************/
+bool app_trace_dump_entry(uint16_t index, uint8_t *buffer);
+
+#endif  // APP_TRACE_H
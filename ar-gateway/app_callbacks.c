@@ -17,6 +17,8 @@
 // -----------------------------------------------------------------------------
 //                                   Includes
 // -----------------------------------------------------------------------------
+#include <stdio.h>
+#include <string.h>
 #include PLATFORM_HEADER
 #include "stack/include/ember.h"
 #include "hal/hal.h"
@@ -24,17 +26,36 @@
 #include "sl_flex_assert.h"
 #include "sl_app_common.h"
 #include "app_framework_common.h"
-#include "sl_simple_led_instances.h"
+#include "app_protocol.h"
+#include "app_tx_queue.h"
+#include "app_mailbox.h"
+#include "app_channel_survey.h"
+#include "app_channel_map.h"
+#include "app_cca.h"
+#include "app_counters.h"
+#include "app_latency.h"
+#include "app_trace.h"
+#include "app_memory.h"
+#include "app_sensor_table.h"
+#include "app_sensor_query.h"
+#include "app_status_led.h"
+#include "app_topology.h"
+#include "app_serial.h"
+#include "app_host_link.h"
+#include "app_uart_tx.h"
 
 // -----------------------------------------------------------------------------
 //                              Macros and Typedefs
 // -----------------------------------------------------------------------------
+/// Maximum number of sensors flagged as pending in one advertisement
+#define ADVERTISE_MAX_PENDING_NODES   (8u)
+/// Longest record line: "rec:", EUI64, node ID, two 32-bit values and the
+/// sequence number, their commas and the NUL of snprintf()
+#define RECORD_MAX_LENGTH             (4u + 16u + 5u + 12u + 11u + 11u + 1u)
 
 // -----------------------------------------------------------------------------
 //                                Global Variables
 // -----------------------------------------------------------------------------
-/// Table of sensors paired with the sink.
-sensor sensors[SENSOR_TABLE_SIZE];
 /// TX options set up for the network
 EmberMessageOptions tx_options = EMBER_OPTIONS_ACK_REQUESTED;
 /// Advertising period event control
@@ -45,10 +66,6 @@ EmberEventControl *data_report_control;
 // -----------------------------------------------------------------------------
 //                                Static Variables
 // -----------------------------------------------------------------------------
-/// Current contents of the data sent with send()
-static uint8_t message[SENSOR_SINK_MAXIMUM_LENGTH];
-/// Length of the message data to eb sent with send()
-static EmberMessageLength message_length;
 
 // -----------------------------------------------------------------------------
 //                          Static Function Declarations
@@ -59,13 +76,52 @@ static EmberMessageLength message_length;
 static void sink_init(void);
 
 /**************************************************************************//**
- * Helper function to send messages to sensors.
+ * Builds the TLV payload of the advertisement.
+ *
+ * @param *buffer is the output, it holds at least SENSOR_SINK_MAXIMUM_LENGTH
+ *        - SENSOR_SINK_DATA_OFFSET bytes
+ * @returns the length of the payload
+ *****************************************************************************/
+static uint8_t build_advertise_payload(uint8_t *buffer, uint8_t size);
+
+/**************************************************************************//**
+ * Parses the TLV elements following the sensor data of a data command.
+ *
+ * @param index is the index of the sensor in the sensor table
+ * @param *sequence receives the sequence number of the report, if any
+ * @returns true if the report carries a sequence number.
+ *****************************************************************************/
+static bool parse_data_trailer(uint8_t index,
+                               const uint8_t *buffer,
+                               uint8_t length,
+                               uint32_t *sequence);
+
+/**************************************************************************//**
+ * Reports a sensor dropped by the timeout sweep.
+ *****************************************************************************/
+static void on_sensor_timeout(uint8_t index);
+
+/**************************************************************************//**
+ * Prints a received report as a machine readable record line for the host
+ * tools: "rec:<EUI64>,<node ID>,<temperature>,<humidity>[,<sequence>]", the
+ * EUI64 and the node ID in hex, the temperature in millicelsius, the relative
+ * humidity in thousandths of percent and the sequence number in decimal.
+ *****************************************************************************/
+static void print_record(uint8_t index,
+                         const uint8_t *data,
+                         uint8_t length,
+                         bool has_sequence,
+                         uint32_t sequence);
+
+/**************************************************************************//**
+ * Helper function to queue messages to sensors.
  *
  * @param node_id is the destination sink node ID
  * @param command_id is the command that is being sent to the sink node
  * @param *buffer is a piece of data related to the command
  * @param buffer_length is the length of the buffer
- * @returns Returns an EMBER_SUCCESS if successful or the reason of failure.
+ * @returns Returns an EMBER_SUCCESS if the message is queued or the reason of
+ *          failure.
  *****************************************************************************/
 static EmberStatus send(EmberNodeId node_id,
                         sensor_sink_command_id command_id,
@@ -82,15 +138,18 @@ static EmberStatus send(EmberNodeId node_id,
  *****************************************************************************/
 void advertise_handler(void)
 {
+  app_trace_record(APP_TRACE_EVENT, APP_TRACE_EVENT_ADVERTISE, 0);
   // If the sink is not on the network, the periodic event is cancelled and
   // advertisements are not set.
   if (!emberStackIsUp()) {
     emberEventControlSetInactive(*advertise_control);
   } else {
+    uint8_t payload[APP_PAYLOAD_MAX_LENGTH];
+    uint8_t payload_length = build_advertise_payload(payload, sizeof(payload));
     EmberStatus status = send(EMBER_BROADCAST_ADDRESS,
                               SENSOR_SINK_COMMAND_ID_ADVERTISE,
-                              NULL,
-                              0);
+                              payload,
+                              payload_length);
     APP_INFO("TX: Advertise to 0x%04X: 0x%02X\n",
              EMBER_BROADCAST_ADDRESS,
              status);
@@ -105,22 +164,23 @@ void advertise_handler(void)
  *****************************************************************************/
 void data_report_handler(void)
 {
+  app_trace_record(APP_TRACE_EVENT, APP_TRACE_EVENT_DATA_REPORT, 0);
   // If the sink is not on the network, the periodic event is cancelled and
   // sensors data is no longer printed out.
   if (!emberStackIsUp()) {
     emberEventControlSetInactive(*data_report_control);
   } else {
     uint8_t i;
-    for (i = 0; i < SENSOR_TABLE_SIZE; i++) {
-      if (sensors[i].node_id != EMBER_NULL_NODE_ID
-          && sensors[i].reported_data_length >= 2) {
+    for (i = 0; i < APP_SENSOR_TABLE_SIZE; i++) {
+      uint8_t length;
+      const uint8_t *data = app_sensor_table_get_report(i, 0, &length);
+      if (data != NULL && length >= 4) {
+        const uint8_t *eui64 = sensor_cold.node_eui64[i];
         // Temperature is sampled in "millicelsius".
-        int32_t temperature = emberFetchLowHighInt32u(sensors[i].reported_data);
+        int32_t temperature = emberFetchLowHighInt32u(data);
         APP_INFO("< %02X%02X%02X%02X%02X%02X%02X%02X , %d.%d%d >\n",
-                 sensors[i].node_eui64[7], sensors[i].node_eui64[6],
-                 sensors[i].node_eui64[5], sensors[i].node_eui64[4],
-                 sensors[i].node_eui64[3], sensors[i].node_eui64[2],
-                 sensors[i].node_eui64[1], sensors[i].node_eui64[0],
+                 eui64[7], eui64[6], eui64[5], eui64[4],
+                 eui64[3], eui64[2], eui64[1], eui64[0],
                  temperature / 1000,
                  (temperature % 1000) / 100,
                  (temperature % 100) / 10);
@@ -136,13 +196,26 @@ void data_report_handler(void)
 ******************************************************************************/
 void emberAfInitCallback(void)
 {
+  app_memory_init();
+  app_uart_tx_init();
   emberAfAllocateEvent(&advertise_control, &advertise_handler);
   emberAfAllocateEvent(&data_report_control, &data_report_handler);
   // CLI info message
   APP_INFO("Sink\n");
 
   emberSetSecurityKey(&security_key);
+  app_trace_init();
   sink_init();
+  app_tx_queue_init();
+  app_mailbox_init();
+  app_channel_survey_init();
+  app_channel_map_init();
+  app_cca_init();
+  app_counters_init();
+  app_serial_init();
+  app_host_link_init();
+  app_sensor_query_init();
+  app_status_led_init();
   emberNetworkInit();
 
 #if defined(EMBER_AF_PLUGIN_BLE)
@@ -155,6 +228,16 @@ void emberAfInitCallback(void)
  *****************************************************************************/
 void emberAfIncomingMessageCallback(EmberIncomingMessage *message)
 {
+  // The received message still holds its buffers.
+  app_memory_sample();
+  app_trace_record(APP_TRACE_RX,
+                   (message->length > SENSOR_SINK_COMMAND_ID_OFFSET)
+                   ? message->payload[SENSOR_SINK_COMMAND_ID_OFFSET] : 0xFF,
+                   message->source);
+  // The sensor is awake and polls shortly, hand over what it missed.
+  app_mailbox_node_awake(message->source);
+  app_topology_note_heard(message->source);
+
   if (message->length < SENSOR_SINK_MINIMUM_LENGTH
       || (emberFetchLowHighInt16u(message->payload + SENSOR_SINK_PROTOCOL_ID_OFFSET)
           != SENSOR_SINK_PROTOCOL_ID)) {
@@ -165,14 +248,16 @@ void emberAfIncomingMessageCallback(EmberIncomingMessage *message)
     case SENSOR_SINK_COMMAND_ID_ADVERTISE_REQUEST:
     {
       EmberStatus status;
+      uint8_t payload[APP_PAYLOAD_MAX_LENGTH];
+      uint8_t payload_length = build_advertise_payload(payload, sizeof(payload));
       APP_INFO("RX: Advertise Request from 0x%04X\n", message->source);
 
       // We received an advertise request from a sensor, unicast back an advertise
       // command.
       status = send(message->source,
                     SENSOR_SINK_COMMAND_ID_ADVERTISE,
-                    NULL,
-                    0);
+                    payload,
+                    payload_length);
       APP_INFO("TX: Advertise to 0x%04X: 0x%02X\n",
                message->source,
                status);
@@ -183,29 +268,12 @@ void emberAfIncomingMessageCallback(EmberIncomingMessage *message)
       break;
     case SENSOR_SINK_COMMAND_ID_PAIR_REQUEST:
     {
-      uint8_t i;
+      const uint8_t *eui64 = message->payload + SENSOR_SINK_EUI64_OFFSET;
       APP_INFO("RX: Pair Request from 0x%04X\n", message->source);
-      // Check whether the sensor is already present in the table first.
-      for (i = 0; i < SENSOR_TABLE_SIZE; i++) {
-        if (sensors[i].node_id != EMBER_NULL_NODE_ID
-            && MEMCOMPARE(sensors[i].node_eui64,
-                          message->payload + SENSOR_SINK_EUI64_OFFSET,
-                          EUI64_SIZE) == 0) {
-          break;
-        }
-      }
-
-      // Find an empty entry in the table.
-      if (i == SENSOR_TABLE_SIZE) {
-        for (i = 0; i < SENSOR_TABLE_SIZE; i++) {
-          if (sensors[i].node_id == EMBER_NULL_NODE_ID) {
-            break;
-          }
-        }
-      }
 
-      // Add or update the entry in the table.
-      if (i < SENSOR_TABLE_SIZE) {
+      // Add or update the entry in the table if there is room for it.
+      if (app_sensor_table_find_eui64(eui64) != APP_SENSOR_TABLE_INVALID_INDEX
+          || app_sensor_table_find_node(EMBER_NULL_NODE_ID) != APP_SENSOR_TABLE_INVALID_INDEX) {
         EmberStatus status = send(message->source,
                                   SENSOR_SINK_COMMAND_ID_PAIR_CONFIRM,
                                   NULL,
@@ -214,13 +282,14 @@ void emberAfIncomingMessageCallback(EmberIncomingMessage *message)
                  message->source,
                  status);
         if (status == EMBER_SUCCESS) {
-          sensors[i].node_id = message->source;
-
-          MEMCOPY(sensors[i].node_eui64,
-                  message->payload + SENSOR_SINK_EUI64_OFFSET,
-                  EUI64_SIZE);
-
-          sensors[i].last_report_ms = halCommonGetInt32uMillisecondTick();
+          bool added;
+          uint8_t index = app_sensor_table_add(message->source, eui64, &added);
+          if (added) {
+            app_latency_clear(index);
+          }
+          if (index != APP_SENSOR_TABLE_INVALID_INDEX) {
+            sensor_cold.last_rssi[index] = message->rssi;
+          }
         }
       }
     }
@@ -230,26 +299,40 @@ void emberAfIncomingMessageCallback(EmberIncomingMessage *message)
       break;
     case SENSOR_SINK_COMMAND_ID_DATA:
     {
-      uint8_t i, j;
-      for (i = 0; i < SENSOR_TABLE_SIZE; i++) {
-        if (MEMCOMPARE(sensors[i].node_eui64,
-                       message->payload + SENSOR_SINK_EUI64_OFFSET,
-                       EUI64_SIZE) == 0) {
-          APP_INFO("RX: Data from 0x%04X:", message->source);
-          for (j = SENSOR_SINK_DATA_OFFSET; j < message->length; j++) {
-            APP_INFO(" %02X", message->payload[j]);
-          }
-          APP_INFO("\n");
-
-          sensors[i].reported_data_length = message->length - SENSOR_SINK_DATA_OFFSET;
-
-          MEMCOPY(sensors[i].reported_data,
-                  message->payload + SENSOR_SINK_DATA_OFFSET,
-                  sensors[i].reported_data_length);
-
-          sensors[i].last_report_ms = halCommonGetInt32uMillisecondTick();
-          break;
+      uint8_t index = app_sensor_table_find_eui64(message->payload
+                                                  + SENSOR_SINK_EUI64_OFFSET);
+      uint8_t data_length = message->length - SENSOR_SINK_DATA_OFFSET;
+      uint32_t sequence = 0;
+      bool has_sequence = false;
+      uint8_t j;
+      if (index != APP_SENSOR_TABLE_INVALID_INDEX) {
+        APP_INFO("RX: Data from 0x%04X:", message->source);
+        for (j = SENSOR_SINK_DATA_OFFSET; j < message->length; j++) {
+          APP_INFO(" %02X", message->payload[j]);
+        }
+        APP_INFO("\n");
+
+        // Application TLV elements may follow the sensor data.
+        if (data_length > SENSOR_SINK_DATA_LENGTH) {
+          has_sequence = parse_data_trailer(index,
+                                            message->payload + SENSOR_SINK_DATA_OFFSET
+                                            + SENSOR_SINK_DATA_LENGTH,
+                                            data_length - SENSOR_SINK_DATA_LENGTH,
+                                            &sequence);
+          data_length = SENSOR_SINK_DATA_LENGTH;
         }
+
+        app_sensor_table_store_report(index,
+                                      message->payload + SENSOR_SINK_DATA_OFFSET,
+                                      data_length);
+        // last_rssi is the RSSI of the last hop, i.e. of the range extender
+        // for the sensors behind one
+        sensor_cold.last_rssi[index] = message->rssi;
+        print_record(index,
+                     message->payload + SENSOR_SINK_DATA_OFFSET,
+                     data_length,
+                     has_sequence,
+                     sequence);
       }
     }
     break;
@@ -266,6 +349,13 @@ void emberAfIncomingMessageCallback(EmberIncomingMessage *message)
 void emberAfMessageSentCallback(EmberStatus status,
                                 EmberOutgoingMessage *message)
 {
+  app_trace_record(APP_TRACE_TX_DONE, status, message->destination);
+  app_topology_note_tx(message->destination, status);
+  // Frames of the TX queue are retried or dropped there, and fed to the
+  // channel map with their submission channel.
+  if (app_tx_queue_message_sent(status, message)) {
+    return;
+  }
   if (status != EMBER_SUCCESS) {
     APP_INFO("TX: 0x%02X\n", status);
   }
@@ -280,20 +370,40 @@ void emberAfStackStatusCallback(EmberStatus status)
   switch (status) {
     case EMBER_NETWORK_UP:
       APP_INFO("Network up\n");
+      app_status_led_set(APP_STATUS_LED_JOINED);
 
       emberEventControlSetActive(*advertise_control);
       emberEventControlSetActive(*data_report_control);
       break;
     case EMBER_NETWORK_DOWN:
       APP_INFO("Network down\n");
+      app_status_led_set(APP_STATUS_LED_OFF);
       sink_init();
+      app_latency_clear(APP_LATENCY_GLOBAL);
+      app_tx_queue_flush();
+      app_mailbox_clear();
+      app_channel_map_reset();
       break;
     default:
       APP_INFO("Stack status: 0x%02X\n", status);
+      app_status_led_show(APP_STATUS_LED_ERROR, APP_STATUS_LED_ERROR_MS);
       break;
   }
 }
 
+/**************************************************************************//**
+ * This function is called when a child joins the sink.
+ *****************************************************************************/
+void emberAfChildJoinCallback(EmberNodeType nodeType,
+                              EmberNodeId nodeId)
+{
+  APP_INFO("Child joined: 0x%04X, type 0x%02X\n", nodeId, nodeType);
+  app_mailbox_child_joined(nodeType, nodeId);
+  if (nodeType == EMBER_STAR_RANGE_EXTENDER) {
+    app_topology_note_extender(nodeId);
+  }
+}
+
 /**************************************************************************//**
  * This function is called in each iteration of the main application loop and
  * can be used to perform periodic functions.
@@ -301,24 +411,14 @@ void emberAfStackStatusCallback(EmberStatus status)
 void emberAfTickCallback(void)
 {
   // Time out sensors that have not reported in a while.
-  uint32_t nowMs = halCommonGetInt32uMillisecondTick();
-  uint8_t i;
-  for (i = 0; i < SENSOR_TABLE_SIZE; i++) {
-    if (sensors[i].node_id != EMBER_NULL_NODE_ID) {
-      if (SENSOR_TIMEOUT_MS
-          < elapsedTimeInt32u(sensors[i].last_report_ms, nowMs)) {
-        APP_INFO("EVENT: timed out sensor 0x%04X\n",
-                 sensors[i].node_id);
-        sensors[i].node_id = EMBER_NULL_NODE_ID;
-      }
-    }
-  }
+  app_sensor_table_sweep(halCommonGetInt32uMillisecondTick(),
+                         SENSOR_TIMEOUT_MS,
+                         on_sensor_timeout);
 
-  if (emberStackIsUp()) {
-    sl_led_turn_on(&sl_led_led0);
-  } else {
-    sl_led_turn_off(&sl_led_led0);
-  }
+  // The status LED follows the stack status callbacks instead of a poll.
+#if APP_STATUS_LED_LOOP_METER
+  app_status_led_loop_tick();
+#endif
 }
 
 /**************************************************************************//**
@@ -342,6 +442,9 @@ void emberAfEnergyScanCompleteCallback(int8_t mean,
                                        int8_t max,
                                        uint16_t variance)
 {
+  if (app_channel_survey_scan_complete(mean, min, max, variance)) {
+    return;
+  }
   APP_INFO("Energy scan complete, mean=%d min=%d max=%d var=%d\n",
            mean, min, max, variance);
 }
@@ -384,36 +487,200 @@ void emberAfPluginMicriumRtosAppTask1MainLoopCallback(void *p_arg)
  *****************************************************************************/
 static void sink_init(void)
 {
+  app_sensor_table_init();
+  app_topology_init();
+}
+
+/**************************************************************************//**
+ * Reports a sensor dropped by the timeout sweep.
+ *****************************************************************************/
+static void on_sensor_timeout(uint8_t index)
+{
+  APP_INFO("EVENT: timed out sensor 0x%04X\n", sensor_hot.node_id[index]);
+  app_mailbox_node_left(sensor_hot.node_id[index]);
+}
+
+/**************************************************************************//**
+ * Prints a received report as a machine readable record line.
+ *****************************************************************************/
+static void print_record(uint8_t index,
+                         const uint8_t *data,
+                         uint8_t length,
+                         bool has_sequence,
+                         uint32_t sequence)
+{
+  const uint8_t *eui64 = sensor_cold.node_eui64[index];
+  char *out;
+  int written;
+
+  if (length < SENSOR_SINK_DATA_LENGTH) {
+    return;
+  }
+  // Formatted in place in the output ring, through printf if the ring is
+  // full or the TX engine did not start.
+  out = (char *)app_uart_tx_reserve(RECORD_MAX_LENGTH + APP_UART_TX_EOL_LENGTH);
+  if (out == NULL) {
+    APP_INFO("rec:%02X%02X%02X%02X%02X%02X%02X%02X,%04X,%ld,%lu",
+             eui64[7], eui64[6], eui64[5], eui64[4],
+             eui64[3], eui64[2], eui64[1], eui64[0],
+             sensor_hot.node_id[index],
+             (int32_t)emberFetchLowHighInt32u(data),
+             emberFetchLowHighInt32u(data + 4));
+    if (has_sequence) {
+      APP_INFO(",%lu", sequence);
+    }
+    APP_INFO("\n");
+    return;
+  }
+  written = snprintf(out, RECORD_MAX_LENGTH,
+                     "rec:%02X%02X%02X%02X%02X%02X%02X%02X,%04X,%ld,%lu",
+                     eui64[7], eui64[6], eui64[5], eui64[4],
+                     eui64[3], eui64[2], eui64[1], eui64[0],
+                     sensor_hot.node_id[index],
+                     (int32_t)emberFetchLowHighInt32u(data),
+                     emberFetchLowHighInt32u(data + 4));
+  if (has_sequence) {
+    written += snprintf(out + written, RECORD_MAX_LENGTH - written, ",%lu", sequence);
+  }
+  memcpy(out + written, APP_UART_TX_EOL, APP_UART_TX_EOL_LENGTH);
+  app_uart_tx_commit((uint16_t)written + APP_UART_TX_EOL_LENGTH);
+}
+
+/**************************************************************************//**
+ * Builds the TLV payload of the advertisement. Sleepy sensors listed in the
+ * pending TLV switch to short polling to fetch their mailbox. The channel map
+ * tells the sensors which hopping channels to avoid. The time beacon carries
+ * the network time, which is the millisecond tick of the sink; it comes first
+ * so that the TX queue can refresh it when it sends the frame. An element
+ * that does not fit in the buffer is left out, the pending list is cut
+ * short.
+ *****************************************************************************/
+static uint8_t build_advertise_payload(uint8_t *buffer, uint8_t size)
+{
+  EmberNodeId pending[ADVERTISE_MAX_PENDING_NODES];
+  uint8_t pending_count = app_mailbox_get_pending_nodes(pending,
+                                                        ADVERTISE_MAX_PENDING_NODES);
+  uint8_t channel_map[2 + APP_CHANNEL_MAP_MAX_BITMAP_LENGTH];
+  uint8_t channel_map_length;
+  uint8_t length = 0;
   uint8_t i;
-  for (i = 0; i < SENSOR_TABLE_SIZE; i++) {
-    sensors[i].node_id = EMBER_NULL_NODE_ID;
+
+  if (size < APP_TLV_VALUE_OFFSET + APP_TIME_LENGTH) {
+    return 0;
   }
+  buffer[length + APP_TLV_TYPE_OFFSET] = APP_ADVERTISE_TLV_TIME;
+  buffer[length + APP_TLV_LENGTH_OFFSET] = APP_TIME_LENGTH;
+  emberStoreLowHighInt32u(buffer + length + APP_TLV_VALUE_OFFSET,
+                          halCommonGetInt32uMillisecondTick());
+  length += APP_TLV_VALUE_OFFSET + APP_TIME_LENGTH;
+
+  if (size - length < APP_TLV_VALUE_OFFSET + 2) {
+    pending_count = 0;
+  } else if (pending_count > (size - length - APP_TLV_VALUE_OFFSET) / 2) {
+    pending_count = (size - length - APP_TLV_VALUE_OFFSET) / 2;
+  }
+  if (pending_count > 0) {
+    buffer[length + APP_TLV_TYPE_OFFSET] = APP_ADVERTISE_TLV_PENDING;
+    buffer[length + APP_TLV_LENGTH_OFFSET] = 2 * pending_count;
+    length += APP_TLV_VALUE_OFFSET;
+    for (i = 0; i < pending_count; i++) {
+      emberStoreLowHighInt16u(buffer + length, pending[i]);
+      length += 2;
+    }
+  }
+
+  channel_map_length = app_channel_map_serialize(channel_map);
+  if (channel_map_length > 0
+      && length + APP_TLV_VALUE_OFFSET + channel_map_length <= size) {
+    buffer[length + APP_TLV_TYPE_OFFSET] = APP_ADVERTISE_TLV_CHANNEL_MAP;
+    buffer[length + APP_TLV_LENGTH_OFFSET] = channel_map_length;
+    MEMCOPY(buffer + length + APP_TLV_VALUE_OFFSET,
+            channel_map,
+            channel_map_length);
+    length += APP_TLV_VALUE_OFFSET + channel_map_length;
+  }
+  return length;
 }
 
 /**************************************************************************//**
-   Helper function to send messages to sensors.
+ * Parses the TLV elements following the sensor data of a data command. A
+ * sensor synchronized to the time beacon sends the network time of the
+ * sample, which gives the exact latency. Otherwise the timing element gives
+ * the age of the sample when the sensor sent it; the radio delay of this
+ * very frame is unknown to the sensor, the one of its previous report stands
+ * in for it.
+ *****************************************************************************/
+static bool parse_data_trailer(uint8_t index,
+                               const uint8_t *buffer,
+                               uint8_t length,
+                               uint32_t *sequence)
+{
+  uint8_t offset = 0;
+  bool sequence_found = false;
+  uint32_t latency_ms = 0;
+  bool latency_found = false;
+  bool sample_time_found = false;
+
+  while (offset + APP_TLV_VALUE_OFFSET <= length) {
+    uint8_t type = buffer[offset + APP_TLV_TYPE_OFFSET];
+    uint8_t value_length = buffer[offset + APP_TLV_LENGTH_OFFSET];
+    const uint8_t *value = buffer + offset + APP_TLV_VALUE_OFFSET;
+
+    if (offset + APP_TLV_VALUE_OFFSET + value_length > length) {
+      break;
+    }
+
+    switch (type) {
+      case APP_DATA_TLV_TIMING:
+        if (value_length >= APP_DATA_TIMING_LENGTH && !sample_time_found) {
+          latency_ms = emberFetchLowHighInt16u(value + APP_DATA_TIMING_SAMPLE_AGE_OFFSET);
+          latency_ms += emberFetchLowHighInt16u(value + APP_DATA_TIMING_LAST_TX_OFFSET);
+          latency_found = true;
+        }
+        break;
+      case APP_DATA_TLV_SAMPLE_TIME:
+        if (value_length >= APP_TIME_LENGTH) {
+          uint32_t age_ms = elapsedTimeInt32u(emberFetchLowHighInt32u(value),
+                                              halCommonGetInt32uMillisecondTick());
+          // A sample from the future is a clock error, keep the estimate.
+          if (age_ms < 0x80000000u) {
+            latency_ms = age_ms;
+            latency_found = true;
+            sample_time_found = true;
+          }
+        }
+        break;
+      case APP_DATA_TLV_PARENT:
+        if (value_length >= APP_PARENT_LENGTH) {
+          app_topology_note_parent(index, emberFetchLowHighInt16u(value));
+        }
+        break;
+      case APP_DATA_TLV_SEQUENCE:
+        if (value_length >= APP_SEQUENCE_LENGTH) {
+          *sequence = emberFetchLowHighInt32u(value);
+          sequence_found = true;
+        }
+        break;
+      default:
+        // Unknown elements are skipped.
+        break;
+    }
+    offset += APP_TLV_VALUE_OFFSET + value_length;
+  }
+
+  if (latency_found) {
+    app_latency_record(index, latency_ms);
+  }
+  return sequence_found;
+}
+
+/**************************************************************************//**
+   Helper function to queue messages to sensors.
  *****************************************************************************/
 static EmberStatus send(EmberNodeId node_id,
                         sensor_sink_command_id command_id,
                         uint8_t *buffer,
                         uint8_t buffer_length)
 {
-  message_length = 0;
-  emberStoreLowHighInt16u(message + message_length, SENSOR_SINK_PROTOCOL_ID);
-  message_length += 2;
-  message[message_length++] = command_id;
-  MEMCOPY(message + message_length, emberGetEui64(), EUI64_SIZE);
-  message_length += EUI64_SIZE;
-  emberStoreLowHighInt16u(message + message_length, emberGetNodeId());
-  message_length += 2;
-  if (buffer_length != 0) {
-    MEMCOPY(message + message_length, buffer, buffer_length);
-    message_length += buffer_length;
-  }
-  return emberMessageSend(node_id,
-                          0, // endpoint
-                          0, // messageTag
-                          message_length,
-                          message,
-                          tx_options);
+  return app_tx_queue_send(node_id, command_id, buffer, buffer_length);
 }
@@ -0,0 +1,285 @@
+/***************************************************************************//**
+ * @file app_cca.c
+ * @brief app_cca.c
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include PLATFORM_HEADER
+#include "stack/include/ember.h"
+#include "hal/hal.h"
+#include "sl_app_common.h"
+#include "app_framework_common.h"
+#include "stack-common-config.h"
+#include "frequency-hopping-config.h"
+#include "app_channel_survey.h"
+#include "app_cca.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// MAC counters sampled by the controller
+typedef enum {
+  SAMPLE_ACK_SUCCESS,
+  SAMPLE_ACK_FAIL,
+  SAMPLE_NO_ACK,
+  SAMPLE_BROADCAST,
+  SAMPLE_UNICAST_CCA_FAIL,
+  SAMPLE_BROADCAST_CCA_FAIL,
+  SAMPLE_COUNT
+} sample_t;
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Reads the MAC counters and returns their increase since the last call.
+ *****************************************************************************/
+static void read_deltas(uint32_t *deltas);
+
+/**************************************************************************//**
+ * Applies a new threshold, clamped to the configured bounds.
+ *****************************************************************************/
+static void apply(int16_t threshold_dbm, const char *reason);
+
+/**************************************************************************//**
+ * Returns the highest noise floor surveyed on the hopping list, or
+ * APP_CCA_NOISE_FLOOR_UNKNOWN if none of its channels was surveyed.
+ *****************************************************************************/
+static int16_t hopping_noise_floor(void);
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+/// CCA threshold controller event control
+EmberEventControl *cca_control;
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+/// Stack counters behind each sample
+static const EmberCounterType sample_counters[SAMPLE_COUNT] = {
+  EMBER_COUNTER_MAC_OUT_UNICAST_ACK_SUCCESS,
+  EMBER_COUNTER_MAC_OUT_UNICAST_ACK_FAIL,
+  EMBER_COUNTER_MAC_OUT_UNICAST_NO_ACK,
+  EMBER_COUNTER_MAC_OUT_BROADCAST,
+  EMBER_COUNTER_MAC_OUT_UNICAST_CCA_FAIL,
+  EMBER_COUNTER_MAC_OUT_BROADCAST_CCA_FAIL,
+};
+/// Counter values at the last sample
+static uint32_t last_counters[SAMPLE_COUNT];
+/// Controller state
+static bool enabled = (APP_CCA_PERIOD_S > 0);
+static app_cca_stats_t stats;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Allocates the controller event and starts the controller.
+ *****************************************************************************/
+void app_cca_init(void)
+{
+  emberAfAllocateEvent(&cca_control, &cca_handler);
+  stats.noise_floor_dbm = APP_CCA_NOISE_FLOOR_UNKNOWN;
+  app_cca_set_enabled(enabled);
+}
+
+/**************************************************************************//**
+ * Starts or stops the controller.
+ *****************************************************************************/
+void app_cca_set_enabled(bool enable)
+{
+  uint32_t deltas[SAMPLE_COUNT];
+
+  enabled = enable && (APP_CCA_PERIOD_S > 0);
+  if (enabled) {
+    // Start from fresh counters.
+    read_deltas(deltas);
+    emberEventControlSetDelayMS(*cca_control,
+                                (uint32_t)APP_CCA_PERIOD_S * MILLISECOND_TICKS_PER_SECOND);
+  } else {
+    emberEventControlSetInactive(*cca_control);
+    emberSetCcaThreshold(EMBER_RADIO_CCA_THRESHOLD);
+  }
+}
+
+/**************************************************************************//**
+ * Tells whether the controller runs.
+ *****************************************************************************/
+bool app_cca_is_enabled(void)
+{
+  return enabled;
+}
+
+/**************************************************************************//**
+ * Returns the metrics of the controller.
+ *****************************************************************************/
+const app_cca_stats_t *app_cca_get_stats(void)
+{
+  return &stats;
+}
+
+/**************************************************************************//**
+ * Event handler that samples the MAC counters and adjusts the threshold.
+ *
+ * CCA failures while unicasts still get acknowledged, at least
+ * APP_CCA_MIN_UNICASTS of them, mean the energy sensed on the channel does
+ * not prevent delivery: the threshold is raised to stop backing off for it. Missing ACKs mean the transmissions collide: the
+ * threshold is lowered so CSMA backs off earlier. A quiet channel moves it
+ * back towards the configured default. The threshold always stays
+ * APP_CCA_NOISE_MARGIN_DB above the noise floor of the last survey. The
+ * threshold applies to every channel of the hopping list, the floor is the
+ * noisiest of them rather than the channel the radio is on at the sample.
+ *****************************************************************************/
+void cca_handler(void)
+{
+  uint32_t deltas[SAMPLE_COUNT];
+  uint32_t unicasts;
+  uint32_t cca_failures;
+  uint32_t attempts;
+  int16_t threshold = emberGetCcaThreshold();
+  int16_t floor_dbm = APP_CCA_MIN_DBM;
+
+  emberEventControlSetDelayMS(*cca_control,
+                              (uint32_t)APP_CCA_PERIOD_S * MILLISECOND_TICKS_PER_SECOND);
+  if (!emberStackIsUp()) {
+    return;
+  }
+
+  stats.periods++;
+  read_deltas(deltas);
+  unicasts = deltas[SAMPLE_ACK_SUCCESS] + deltas[SAMPLE_ACK_FAIL];
+  cca_failures = deltas[SAMPLE_UNICAST_CCA_FAIL] + deltas[SAMPLE_BROADCAST_CCA_FAIL];
+  attempts = unicasts + deltas[SAMPLE_NO_ACK] + deltas[SAMPLE_BROADCAST] + cca_failures;
+
+  stats.noise_floor_dbm = hopping_noise_floor();
+  if (stats.noise_floor_dbm != APP_CCA_NOISE_FLOOR_UNKNOWN
+      && stats.noise_floor_dbm + APP_CCA_NOISE_MARGIN_DB > floor_dbm) {
+    floor_dbm = stats.noise_floor_dbm + APP_CCA_NOISE_MARGIN_DB;
+  }
+
+  if (attempts < APP_CCA_MIN_SAMPLES) {
+    return;
+  }
+  stats.sampled_periods++;
+  stats.cca_fail_percent = (uint8_t)((cca_failures * 100) / attempts);
+  stats.ack_fail_percent = (unicasts > 0)
+                           ? (uint8_t)((deltas[SAMPLE_ACK_FAIL] * 100) / unicasts)
+                           : 0;
+
+  if (stats.ack_fail_percent >= APP_CCA_ACK_FAIL_PERCENT) {
+    threshold -= APP_CCA_STEP_DB;
+    if (threshold < floor_dbm) {
+      threshold = floor_dbm;
+    }
+    apply(threshold, "collisions");
+  } else if (stats.cca_fail_percent >= APP_CCA_BUSY_PERCENT
+             && unicasts >= APP_CCA_MIN_UNICASTS) {
+    // Without enough acknowledged unicasts, nothing shows that delivery
+    // still works through the energy sensed: keep backing off for it.
+    apply(threshold + APP_CCA_STEP_DB, "busy channel");
+  } else if (stats.cca_fail_percent <= APP_CCA_QUIET_PERCENT) {
+    int16_t target = EMBER_RADIO_CCA_THRESHOLD;
+    if (target < floor_dbm) {
+      target = floor_dbm;
+    }
+    if (threshold > target + APP_CCA_STEP_DB) {
+      apply(threshold - APP_CCA_STEP_DB, "quiet channel");
+    } else if (threshold < target - APP_CCA_STEP_DB) {
+      apply(threshold + APP_CCA_STEP_DB, "quiet channel");
+    } else if (threshold != target) {
+      apply(target, "quiet channel");
+    }
+  }
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Reads the MAC counters and returns their increase since the last call. A
+ * counter that went backwards was reset and counts from 0.
+ *****************************************************************************/
+static void read_deltas(uint32_t *deltas)
+{
+  uint32_t value;
+  uint8_t i;
+
+  for (i = 0; i < SAMPLE_COUNT; i++) {
+    if (emberGetCounter(sample_counters[i], &value) != EMBER_SUCCESS) {
+      value = last_counters[i];
+    }
+    deltas[i] = (value >= last_counters[i]) ? (value - last_counters[i]) : value;
+    last_counters[i] = value;
+  }
+}
+
+/**************************************************************************//**
+ * Returns the highest noise floor surveyed on the hopping list.
+ *****************************************************************************/
+static int16_t hopping_noise_floor(void)
+{
+  const app_channel_survey_result_t *survey;
+  int16_t floor_dbm = APP_CCA_NOISE_FLOOR_UNKNOWN;
+  uint16_t channel;
+
+  for (channel = EMBER_FREQUENCY_HOPPING_START_CHANNEL;
+       channel <= EMBER_FREQUENCY_HOPPING_END_CHANNEL;
+       channel++) {
+    survey = app_channel_survey_get_channel(channel);
+    if (survey != NULL
+        && (floor_dbm == APP_CCA_NOISE_FLOOR_UNKNOWN || survey->score > floor_dbm)) {
+      floor_dbm = survey->score;
+    }
+  }
+  return floor_dbm;
+}
+
+/**************************************************************************//**
+ * Applies a new threshold, clamped to the configured bounds, and logs the
+ * decision.
+ *****************************************************************************/
+static void apply(int16_t threshold_dbm, const char *reason)
+{
+  int8_t current = emberGetCcaThreshold();
+  EmberStatus status;
+
+  if (threshold_dbm < APP_CCA_MIN_DBM) {
+    threshold_dbm = APP_CCA_MIN_DBM;
+  } else if (threshold_dbm > APP_CCA_MAX_DBM) {
+    threshold_dbm = APP_CCA_MAX_DBM;
+  }
+  if (threshold_dbm == current) {
+    return;
+  }
+
+  status = emberSetCcaThreshold((int8_t)threshold_dbm);
+  APP_INFO("CCA: %d -> %d dBm, %s (CCA fail %d%%, ACK fail %d%%): 0x%02X\n",
+           current,
+           threshold_dbm,
+           reason,
+           stats.cca_fail_percent,
+           stats.ack_fail_percent,
+           status);
+  if (status == EMBER_SUCCESS) {
+    if (threshold_dbm > current) {
+      stats.raised++;
+    } else {
+      stats.lowered++;
+    }
+  }
+}
@@ -0,0 +1,80 @@
+/***************************************************************************//**
+ * @file app_cca.h
+ * @brief app_cca.h
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+#ifndef APP_CCA_H
+#define APP_CCA_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include "cca-controller-config.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Noise floor value when no channel survey covers the current channel
+#define APP_CCA_NOISE_FLOOR_UNKNOWN    (INT16_MIN)
+
+/// Metrics of the CCA threshold controller
+typedef struct {
+  /// Control periods evaluated, and the ones with enough transmissions
+  uint32_t periods;
+  uint32_t sampled_periods;
+  /// Threshold changes
+  uint32_t raised;
+  uint32_t lowered;
+  /// Inputs of the last sampled period
+  uint8_t cca_fail_percent;
+  uint8_t ack_fail_percent;
+  int16_t noise_floor_dbm;
+} app_cca_stats_t;
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+/// CCA threshold controller event control
+extern EmberEventControl *cca_control;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Allocates the controller event and starts the controller.
+ *****************************************************************************/
+void app_cca_init(void);
+
+/**************************************************************************//**
+ * Starts or stops the controller. Stopping it restores
+ * EMBER_RADIO_CCA_THRESHOLD.
+ *****************************************************************************/
+void app_cca_set_enabled(bool enabled);
+
+/**************************************************************************//**
+ * Tells whether the controller runs.
+ *****************************************************************************/
+bool app_cca_is_enabled(void);
+
+/**************************************************************************//**
+ * Returns the metrics of the controller.
+ *****************************************************************************/
+const app_cca_stats_t *app_cca_get_stats(void);
+
+/**************************************************************************//**
+ * Event handler that samples the MAC counters and adjusts the threshold.
+ *****************************************************************************/
+void cca_handler(void);
+
+#endif  // APP_CCA_H
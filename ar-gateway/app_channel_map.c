@@ -0,0 +1,263 @@
+/***************************************************************************//**
+ * @file app_channel_map.c
+ * @brief app_channel_map.c
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include PLATFORM_HEADER
+#include "stack/include/ember.h"
+#include "hal/hal.h"
+#include "sl_app_common.h"
+#include "app_framework_common.h"
+#include "app_protocol.h"
+#include "app_channel_map.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// The failure rate is a moving average in 1/256 units, weight of a sample
+/// is 1/8
+#define RATE_ONE            (256u)
+#define RATE_SHIFT          (3u)
+#define RATE_TO_PERCENT(rate)   ((uint8_t)(((rate) * 100u) / RATE_ONE))
+#define PERCENT_TO_RATE(percent)   (((percent) * RATE_ONE) / 100u)
+
+/// Probation check period
+#define PROBATION_CHECK_MS  (1000u)
+
+/// Maximum number of channels excluded at the same time
+#define MAX_EXCLUDED                                          \
+  ((APP_CHANNEL_MAP_CHANNEL_COUNT * APP_CHANNEL_MAP_MAX_EXCLUDED_PERCENT) / 100u)
+
+/// Size of the exclusion bitmap
+#define BITMAP_LENGTH       ((APP_CHANNEL_MAP_CHANNEL_COUNT + 7u) / 8u)
+
+/// Channel state
+typedef struct {
+  app_channel_map_stats_t stats;
+  uint16_t rate;
+  uint32_t excluded_ms;
+} channel_t;
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Returns the state of a channel, NULL if it is not on the hopping list.
+ *****************************************************************************/
+static channel_t *find_channel(uint16_t channel);
+
+/**************************************************************************//**
+ * Tells whether the radio was seen hopping between channels. A network
+ * formed on a fixed channel must never exclude it.
+ *****************************************************************************/
+static bool is_hopping(void);
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+/// Channel map probation event control
+EmberEventControl *channel_map_control;
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+/// Channels of the hopping list
+static channel_t channels[APP_CHANNEL_MAP_CHANNEL_COUNT];
+/// Number of excluded channels
+static uint8_t excluded_count;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Allocates the probation event and clears the map.
+ *****************************************************************************/
+void app_channel_map_init(void)
+{
+  emberAfAllocateEvent(&channel_map_control, &channel_map_handler);
+  app_channel_map_reset();
+}
+
+/**************************************************************************//**
+ * Clears the metrics and puts every channel back in use.
+ *****************************************************************************/
+void app_channel_map_reset(void)
+{
+  MEMSET(channels, 0, sizeof(channels));
+  excluded_count = 0;
+  emberEventControlSetInactive(*channel_map_control);
+}
+
+/**************************************************************************//**
+ * Accounts the outcome of a transmission on the channel it was submitted on.
+ * Only the statuses caused by the channel count as failures, the others
+ * (e.g. an indirect timeout of a sleepy sensor) are ignored.
+ *****************************************************************************/
+void app_channel_map_note_tx(uint16_t radio_channel, EmberStatus status)
+{
+  channel_t *channel = find_channel(radio_channel);
+  bool failed;
+
+  if (channel == NULL) {
+    return;
+  }
+
+  switch (status) {
+    case EMBER_SUCCESS:
+      failed = false;
+      break;
+    case EMBER_MAC_NO_ACK_RECEIVED:
+      channel->stats.tx_failures++;
+      failed = true;
+      break;
+    case EMBER_PHY_TX_CCA_FAIL:
+      channel->stats.cca_failures++;
+      failed = true;
+      break;
+    default:
+      return;
+  }
+
+  channel->stats.attempts++;
+  channel->rate -= channel->rate >> RATE_SHIFT;
+  if (failed) {
+    channel->rate += RATE_ONE >> RATE_SHIFT;
+  }
+  channel->stats.failure_percent = RATE_TO_PERCENT(channel->rate);
+
+  if (!channel->stats.excluded
+      && channel->stats.attempts >= APP_CHANNEL_MAP_MIN_ATTEMPTS
+      && channel->rate >= PERCENT_TO_RATE(APP_CHANNEL_MAP_EXCLUDE_PERCENT)
+      && excluded_count < MAX_EXCLUDED
+      && is_hopping()) {
+    channel->stats.excluded = true;
+    channel->stats.exclusions++;
+    channel->excluded_ms = halCommonGetInt32uMillisecondTick();
+    excluded_count++;
+    APP_INFO("Channel map: channel %d excluded, %d%% failures\n",
+             radio_channel,
+             channel->stats.failure_percent);
+    if (!emberEventControlGetActive(*channel_map_control)) {
+      emberEventControlSetDelayMS(*channel_map_control, PROBATION_CHECK_MS);
+    }
+  }
+}
+
+/**************************************************************************//**
+ * Tells whether the radio currently sits on an excluded channel.
+ *****************************************************************************/
+bool app_channel_map_current_excluded(void)
+{
+  channel_t *channel = find_channel(emberGetRadioChannel());
+  return (channel != NULL && channel->stats.excluded);
+}
+
+/**************************************************************************//**
+ * Serializes the map: first channel of the hopping list (2, little endian)
+ * then the exclusion bitmap.
+ *****************************************************************************/
+uint8_t app_channel_map_serialize(uint8_t *buffer)
+{
+  uint8_t i;
+
+  if (excluded_count == 0) {
+    return 0;
+  }
+  emberStoreLowHighInt16u(buffer, EMBER_FREQUENCY_HOPPING_START_CHANNEL);
+  MEMSET(buffer + 2, 0, BITMAP_LENGTH);
+  for (i = 0; i < APP_CHANNEL_MAP_CHANNEL_COUNT; i++) {
+    if (channels[i].stats.excluded) {
+      buffer[2 + i / 8] |= (uint8_t)(1u << (i % 8));
+    }
+  }
+  return 2 + BITMAP_LENGTH;
+}
+
+/**************************************************************************//**
+ * Returns the metrics of a channel of the hopping list.
+ *****************************************************************************/
+const app_channel_map_stats_t *app_channel_map_get(uint8_t index)
+{
+  if (index >= APP_CHANNEL_MAP_CHANNEL_COUNT) {
+    return NULL;
+  }
+  return &channels[index].stats;
+}
+
+/**************************************************************************//**
+ * Event handler that puts the excluded channels back on probation. Their
+ * failure rate restarts just below the exclusion threshold, so a channel that
+ * is still jammed is excluded again after a couple of failures.
+ *****************************************************************************/
+void channel_map_handler(void)
+{
+  uint32_t now_ms = halCommonGetInt32uMillisecondTick();
+  uint8_t i;
+
+  emberEventControlSetInactive(*channel_map_control);
+
+  for (i = 0; i < APP_CHANNEL_MAP_CHANNEL_COUNT; i++) {
+    channel_t *channel = &channels[i];
+    if (channel->stats.excluded
+        && elapsedTimeInt32u(channel->excluded_ms, now_ms)
+        >= (uint32_t)APP_CHANNEL_MAP_PROBATION_S * MILLISECOND_TICKS_PER_SECOND) {
+      channel->stats.excluded = false;
+      channel->rate = PERCENT_TO_RATE(APP_CHANNEL_MAP_EXCLUDE_PERCENT)
+                      - (RATE_ONE >> RATE_SHIFT);
+      channel->stats.failure_percent = RATE_TO_PERCENT(channel->rate);
+      excluded_count--;
+      APP_INFO("Channel map: channel %d on probation\n",
+               EMBER_FREQUENCY_HOPPING_START_CHANNEL + i);
+    }
+  }
+
+  if (excluded_count > 0) {
+    emberEventControlSetDelayMS(*channel_map_control, PROBATION_CHECK_MS);
+  }
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Returns the state of a channel, NULL if it is not on the hopping list.
+ *****************************************************************************/
+static channel_t *find_channel(uint16_t channel)
+{
+  if (channel < EMBER_FREQUENCY_HOPPING_START_CHANNEL
+      || channel > EMBER_FREQUENCY_HOPPING_END_CHANNEL) {
+    return NULL;
+  }
+  return &channels[channel - EMBER_FREQUENCY_HOPPING_START_CHANNEL];
+}
+
+/**************************************************************************//**
+ * Tells whether transmissions were seen on more than one channel.
+ *****************************************************************************/
+static bool is_hopping(void)
+{
+  uint8_t used = 0;
+  uint8_t i;
+
+  for (i = 0; i < APP_CHANNEL_MAP_CHANNEL_COUNT && used < 2; i++) {
+    if (channels[i].stats.attempts > 0) {
+      used++;
+    }
+  }
+  return (used >= 2);
+}
@@ -0,0 +1,105 @@
+/***************************************************************************//**
+ * @file app_channel_map.h
+ * @brief app_channel_map.h
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+#ifndef APP_CHANNEL_MAP_H
+#define APP_CHANNEL_MAP_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include "frequency-hopping-config.h"
+#include "channel-map-config.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Number of channels of the hopping list
+#define APP_CHANNEL_MAP_CHANNEL_COUNT                    \
+  (EMBER_FREQUENCY_HOPPING_END_CHANNEL                   \
+   - EMBER_FREQUENCY_HOPPING_START_CHANNEL + 1)
+
+/// Per channel metrics
+typedef struct {
+  /// Transmissions completed on the channel
+  uint32_t attempts;
+  /// Transmissions that failed for lack of ACK
+  uint32_t tx_failures;
+  /// Transmissions that failed the CCA
+  uint32_t cca_failures;
+  /// Smoothed failure rate in percent
+  uint8_t failure_percent;
+  /// Whether the channel is excluded
+  bool excluded;
+  /// Number of times the channel was excluded
+  uint16_t exclusions;
+} app_channel_map_stats_t;
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+/// Channel map probation event control
+extern EmberEventControl *channel_map_control;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Allocates the probation event and clears the map.
+ *****************************************************************************/
+void app_channel_map_init(void);
+
+/**************************************************************************//**
+ * Clears the metrics and puts every channel back in use.
+ *****************************************************************************/
+void app_channel_map_reset(void);
+
+/**************************************************************************//**
+ * Accounts the outcome of a transmission. The TX queue reports every attempt
+ * of its frames, with the channel the radio was on when the frame was handed
+ * to the stack: by the time the sent callback runs the radio may have hopped.
+ *
+ * @param radio_channel is the channel at submission
+ * @param status is the outcome of the transmission
+ *****************************************************************************/
+void app_channel_map_note_tx(uint16_t radio_channel, EmberStatus status);
+
+/**************************************************************************//**
+ * Tells whether the radio currently sits on an excluded channel.
+ *****************************************************************************/
+bool app_channel_map_current_excluded(void);
+
+/**************************************************************************//**
+ * Serializes the map as the value of the APP_ADVERTISE_TLV_CHANNEL_MAP
+ * element.
+ *
+ * @param *buffer holds at least 2 + APP_CHANNEL_MAP_MAX_BITMAP_LENGTH bytes
+ * @returns the length of the value, 0 if no channel is excluded.
+ *****************************************************************************/
+uint8_t app_channel_map_serialize(uint8_t *buffer);
+
+/**************************************************************************//**
+ * Returns the metrics of a channel of the hopping list.
+ *
+ * @param index is the position in the hopping list
+ *****************************************************************************/
+const app_channel_map_stats_t *app_channel_map_get(uint8_t index);
+
+/**************************************************************************//**
+ * Event handler that puts the excluded channels back on probation.
+ *****************************************************************************/
+void channel_map_handler(void);
+
+#endif  // APP_CHANNEL_MAP_H
@@ -0,0 +1,308 @@
+/***************************************************************************//**
+ * @file app_channel_survey.c
+ * @brief app_channel_survey.c
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include PLATFORM_HEADER
+#include "stack/include/ember.h"
+#include "hal/hal.h"
+#include "sl_app_common.h"
+#include "app_framework_common.h"
+#include "app_channel_survey.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Time to wait for the completion of an energy scan before giving up
+#define SCAN_TIMEOUT_MS     (2000u)
+/// Attempts to scan a channel before it is skipped, and the delay between
+#define SCAN_MAX_ATTEMPTS   (3u)
+#define SCAN_RETRY_MS       (100u)
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Ranks the scanned channels and reports the outcome of the survey.
+ *****************************************************************************/
+static void finish(void);
+
+/**************************************************************************//**
+ * Retries the scan of the current channel, or skips it after
+ * SCAN_MAX_ATTEMPTS.
+ *****************************************************************************/
+static void retry_or_skip(void);
+
+/**************************************************************************//**
+ * Integer square root.
+ *****************************************************************************/
+static uint16_t square_root(uint16_t value);
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+/// Channel survey event control
+EmberEventControl *channel_survey_control;
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+/// Results of the last survey, indexed by channel
+static app_channel_survey_result_t results[APP_CHANNEL_SURVEY_MAX_CHANNELS];
+/// Whether each channel was scanned by the last survey
+static bool scanned[APP_CHANNEL_SURVEY_MAX_CHANNELS];
+/// Channels of the last survey, best first
+static uint8_t ranking[APP_CHANNEL_SURVEY_MAX_CHANNELS];
+/// Number of channels scanned by the last survey
+static uint8_t channel_count = 0;
+/// Survey state: channel being scanned, its attempts and the channels
+/// skipped after failed scans
+static bool running = false;
+static bool scan_pending = false;
+static uint8_t current_channel = 0;
+static uint8_t attempts = 0;
+static uint8_t skipped_count = 0;
+static app_channel_survey_done_t done_callback = NULL;
+/// Background re-survey period, 0 if disabled
+static uint16_t period_s = APP_CHANNEL_SURVEY_PERIOD_S;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Allocates the survey event and arms the background re-survey.
+ *****************************************************************************/
+void app_channel_survey_init(void)
+{
+  emberAfAllocateEvent(&channel_survey_control, &channel_survey_handler);
+  app_channel_survey_set_period(period_s);
+}
+
+/**************************************************************************//**
+ * Starts a survey of every channel of the PHY.
+ *****************************************************************************/
+EmberStatus app_channel_survey_start(app_channel_survey_done_t done)
+{
+  if (running) {
+    return EMBER_INVALID_CALL;
+  }
+  running = true;
+  scan_pending = false;
+  channel_count = 0;
+  current_channel = 0;
+  attempts = 0;
+  skipped_count = 0;
+  MEMSET(scanned, 0, sizeof(scanned));
+  done_callback = done;
+  emberEventControlSetActive(*channel_survey_control);
+  return EMBER_SUCCESS;
+}
+
+/**************************************************************************//**
+ * Feeds the survey with an energy scan result and chains the next scan.
+ *****************************************************************************/
+bool app_channel_survey_scan_complete(int8_t mean,
+                                      int8_t min,
+                                      int8_t max,
+                                      uint16_t variance)
+{
+  app_channel_survey_result_t *result;
+
+  if (!running || !scan_pending) {
+    return false;
+  }
+
+  result = &results[current_channel];
+  result->mean = mean;
+  result->min = min;
+  result->max = max;
+  result->variance = variance;
+  result->score = mean + (int16_t)square_root(variance);
+  scanned[current_channel] = true;
+  channel_count++;
+  current_channel++;
+  attempts = 0;
+  scan_pending = false;
+  emberEventControlSetActive(*channel_survey_control);
+  return true;
+}
+
+/**************************************************************************//**
+ * Sets the background re-survey period, 0 disables it.
+ *****************************************************************************/
+void app_channel_survey_set_period(uint16_t period)
+{
+  period_s = period;
+  if (running) {
+    // Rescheduled when the ongoing survey completes.
+    return;
+  }
+  if (period_s == 0) {
+    emberEventControlSetInactive(*channel_survey_control);
+  } else {
+    emberEventControlSetDelayMS(*channel_survey_control,
+                                (uint32_t)period_s * MILLISECOND_TICKS_PER_SECOND);
+  }
+}
+
+/**************************************************************************//**
+ * Returns the result of the last survey.
+ *****************************************************************************/
+const app_channel_survey_result_t *app_channel_survey_get(uint8_t rank,
+                                                          uint16_t *channel)
+{
+  if (running || rank >= channel_count) {
+    return NULL;
+  }
+  *channel = ranking[rank];
+  return &results[ranking[rank]];
+}
+
+/**************************************************************************//**
+ * Returns the result of the last survey for a given channel.
+ *****************************************************************************/
+const app_channel_survey_result_t *app_channel_survey_get_channel(uint16_t channel)
+{
+  if (running || channel >= APP_CHANNEL_SURVEY_MAX_CHANNELS || !scanned[channel]) {
+    return NULL;
+  }
+  return &results[channel];
+}
+
+/**************************************************************************//**
+ * Event handler that starts the next energy scan. Outside a survey, the event
+ * fires for the background re-survey. The scans would take the sink off the
+ * hopping sequence, so the re-survey waits for the next period while a
+ * network is up.
+ *****************************************************************************/
+void channel_survey_handler(void)
+{
+  EmberStatus status;
+
+  emberEventControlSetInactive(*channel_survey_control);
+
+  if (!running) {
+    if (period_s > 0 && emberNetworkState() != EMBER_NO_NETWORK) {
+      app_channel_survey_set_period(period_s);
+    } else if (period_s > 0) {
+      app_channel_survey_start(NULL);
+    }
+    return;
+  }
+
+  if (scan_pending) {
+    APP_INFO("Channel survey: no scan result on channel %d\n", current_channel);
+    scan_pending = false;
+    retry_or_skip();
+    return;
+  }
+
+  if (current_channel < APP_CHANNEL_SURVEY_MAX_CHANNELS) {
+    attempts++;
+    status = emberStartEnergyScan(current_channel, APP_CHANNEL_SURVEY_SAMPLES);
+    if (status == EMBER_SUCCESS) {
+      scan_pending = true;
+      emberEventControlSetDelayMS(*channel_survey_control, SCAN_TIMEOUT_MS);
+      return;
+    }
+    if (status != EMBER_PHY_INVALID_CHANNEL) {
+      APP_INFO("Channel survey: scan on channel %d failed, status=0x%02X\n",
+               current_channel, status);
+      retry_or_skip();
+      return;
+    }
+  }
+  // Past the last channel of the PHY.
+  finish();
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Ranks the scanned channels by score, ties broken by the peak energy, and
+ * reports the outcome of the survey. A survey that skipped a channel is a
+ * failure, its best channel is only the best of the channels scanned.
+ *****************************************************************************/
+static void finish(void)
+{
+  app_channel_survey_done_t done = done_callback;
+  uint8_t count = 0;
+  uint8_t channel;
+  uint8_t j;
+
+  for (channel = 0; channel < APP_CHANNEL_SURVEY_MAX_CHANNELS; channel++) {
+    if (!scanned[channel]) {
+      continue;
+    }
+    for (j = count++; j > 0; j--) {
+      const app_channel_survey_result_t *previous = &results[ranking[j - 1]];
+      if (previous->score < results[channel].score
+          || (previous->score == results[channel].score
+              && previous->max <= results[channel].max)) {
+        break;
+      }
+      ranking[j] = ranking[j - 1];
+    }
+    ranking[j] = channel;
+  }
+
+  running = false;
+  scan_pending = false;
+  done_callback = NULL;
+  app_channel_survey_set_period(period_s);
+
+  if (channel_count == 0) {
+    APP_INFO("Channel survey: no channel scanned\n");
+  } else {
+    APP_INFO("Channel survey: %d channel(s), %d skipped, best %d (score %d dBm)\n",
+             channel_count, skipped_count, ranking[0], results[ranking[0]].score);
+  }
+  if (done != NULL) {
+    done((channel_count > 0 && skipped_count == 0) ? EMBER_SUCCESS : EMBER_ERR_FATAL,
+         (channel_count > 0) ? ranking[0] : 0);
+  }
+}
+
+/**************************************************************************//**
+ * Retries the scan of the current channel, or skips it after
+ * SCAN_MAX_ATTEMPTS.
+ *****************************************************************************/
+static void retry_or_skip(void)
+{
+  if (attempts >= SCAN_MAX_ATTEMPTS) {
+    APP_INFO("Channel survey: channel %d skipped\n", current_channel);
+    skipped_count++;
+    current_channel++;
+    attempts = 0;
+  }
+  emberEventControlSetDelayMS(*channel_survey_control, SCAN_RETRY_MS);
+}
+
+/**************************************************************************//**
+ * Integer square root.
+ *****************************************************************************/
+static uint16_t square_root(uint16_t value)
+{
+  uint16_t root = 0;
+
+  while ((uint32_t)(root + 1) * (root + 1) <= value) {
+    root++;
+  }
+  return root;
+}
@@ -0,0 +1,114 @@
+/***************************************************************************//**
+ * @file app_channel_survey.h
+ * @brief app_channel_survey.h
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+#ifndef APP_CHANNEL_SURVEY_H
+#define APP_CHANNEL_SURVEY_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include "channel-survey-config.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Energy scan result of a channel
+typedef struct {
+  int8_t mean;
+  int8_t min;
+  int8_t max;
+  uint16_t variance;
+  /// Ranking score in dBm: mean plus standard deviation, lower is better
+  int16_t score;
+} app_channel_survey_result_t;
+
+/**************************************************************************//**
+ * Called when a survey completes.
+ *
+ * @param status is EMBER_SUCCESS if every channel of the PHY was scanned,
+ *        EMBER_ERR_FATAL if a channel could not be scanned after retries or
+ *        none was
+ * @param best_channel is the channel with the lowest score, of the channels
+ *        scanned
+ *****************************************************************************/
+typedef void (*app_channel_survey_done_t)(EmberStatus status,
+                                          uint16_t best_channel);
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+/// Channel survey event control
+extern EmberEventControl *channel_survey_control;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Allocates the survey event and arms the background re-survey.
+ *****************************************************************************/
+void app_channel_survey_init(void);
+
+/**************************************************************************//**
+ * Starts a survey of every channel of the PHY. The scans are chained through
+ * emberAfEnergyScanCompleteCallback(). A failed or unanswered scan is
+ * retried, then the channel is skipped and the survey goes on.
+ *
+ * @param done is called once the channels are ranked, may be NULL
+ * @returns EMBER_SUCCESS or EMBER_INVALID_CALL if a survey is ongoing.
+ *****************************************************************************/
+EmberStatus app_channel_survey_start(app_channel_survey_done_t done);
+
+/**************************************************************************//**
+ * Feeds the survey with an energy scan result. To be called from
+ * emberAfEnergyScanCompleteCallback().
+ *
+ * @returns true if the result belonged to the survey.
+ *****************************************************************************/
+bool app_channel_survey_scan_complete(int8_t mean,
+                                      int8_t min,
+                                      int8_t max,
+                                      uint16_t variance);
+
+/**************************************************************************//**
+ * Sets the background re-survey period, 0 disables it. The background
+ * re-survey only runs while the sink is not on a network, it keeps the noise
+ * floors fresh for the next network formed on the best channel.
+ *****************************************************************************/
+void app_channel_survey_set_period(uint16_t period_s);
+
+/**************************************************************************//**
+ * Returns the result of the last survey.
+ *
+ * @param rank is the position in the ranking, 0 is the best channel
+ * @param *channel is the output channel
+ * @returns the result or NULL if rank is past the surveyed channels.
+ *****************************************************************************/
+const app_channel_survey_result_t *app_channel_survey_get(uint8_t rank,
+                                                          uint16_t *channel);
+
+/**************************************************************************//**
+ * Returns the result of the last survey for a given channel.
+ *
+ * @returns the result or NULL if the channel was not surveyed.
+ *****************************************************************************/
+const app_channel_survey_result_t *app_channel_survey_get_channel(uint16_t channel);
+
+/**************************************************************************//**
+ * Event handler that starts the next energy scan, or a background re-survey.
+ *****************************************************************************/
+void channel_survey_handler(void);
+
+#endif  // APP_CHANNEL_SURVEY_H
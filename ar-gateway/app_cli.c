@@ -25,6 +25,23 @@
 #include "sl_cli.h"
 #include "sl_flex_assert.h"
 #include "sl_app_common.h"
+#include "app_protocol.h"
+#include "app_tx_queue.h"
+#include "app_mailbox.h"
+#include "app_channel_survey.h"
+#include "app_channel_map.h"
+#include "app_cca.h"
+#include "app_counters.h"
+#include "app_latency.h"
+#include "app_trace.h"
+#include "app_memory.h"
+#include "app_sensor_table.h"
+#include "app_sensor_query.h"
+#include "app_topology.h"
+#include "app_serial.h"
+#include "app_uart_tx.h"
+#include "app_host_link.h"
+#include "app_status_led.h"
 
 // -----------------------------------------------------------------------------
 //                              Macros and Typedefs
@@ -35,10 +52,34 @@
 /// The destination endpoint of the outgoing message
 #define DATA_ENDPOINT           1
 #define TX_TEST_ENDPOINT        2
+/// Default benchmark of the output paths: 16 lines of 80 characters
+#define UART_BENCH_LINES        16
+#define UART_BENCH_LENGTH       80
+/// Default main loop measurement
+#define LOOP_COST_ITERATIONS    1000
 
 // -----------------------------------------------------------------------------
 //                          Static Function Declarations
 // -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Forms a network on the given channel.
+ *****************************************************************************/
+static void form_network(uint16_t channel);
+
+/**************************************************************************//**
+ * Prints the channel ranking once a survey completes.
+ *****************************************************************************/
+static void print_survey(EmberStatus status, uint16_t best_channel);
+
+/**************************************************************************//**
+ * Forms a network on the best channel once a survey completes.
+ *****************************************************************************/
+static void form_on_best_channel(EmberStatus status, uint16_t best_channel);
+
+/**************************************************************************//**
+ * Prints the bytes, cycles and cycles per byte of a benchmark path.
+ *****************************************************************************/
+static void print_bench_path(const char *name, const app_uart_tx_bench_path_t *path);
 
 // -----------------------------------------------------------------------------
 //                                Global Variables
@@ -61,21 +102,39 @@ static int16_t tx_power = SENSOR_SINK_TX_POWER;
  *****************************************************************************/
 void cli_form(sl_cli_command_arg_t *arguments)
 {
-  EmberStatus status;
-  EmberNetworkParameters parameters;
+  form_network(sl_cli_get_argument_uint8(arguments, 0));
+}
 
-  // Initialize the security key to the default key prior to forming the
-  // network.
-  emberSetSecurityKey(&security_key);
+/******************************************************************************
+ * CLI - form_auto command
+ * Surveys every channel and forms a network on the least noisy one.
+ *****************************************************************************/
+void cli_form_auto(sl_cli_command_arg_t *arguments)
+{
+  (void) arguments;
+  EmberStatus status = app_channel_survey_start(form_on_best_channel);
 
-  MEMSET(&parameters, 0, sizeof(EmberNetworkParameters));
-  parameters.radioTxPower = tx_power;
-  parameters.radioChannel = sl_cli_get_argument_uint8(arguments, 0);
-  parameters.panId = SENSOR_SINK_PAN_ID;
+  if (status != EMBER_SUCCESS) {
+    APP_INFO("Channel survey busy, status=0x%02X\n", status);
+  }
+}
 
-  status = emberFormNetwork(&parameters);
+/******************************************************************************
+ * CLI - channel_survey command
+ * Surveys every channel and prints the ranking. An optional argument sets the
+ * background re-survey period in seconds, 0 disables it.
+ *****************************************************************************/
+void cli_channel_survey(sl_cli_command_arg_t *arguments)
+{
+  EmberStatus status;
 
-  APP_INFO("form 0x%02X\n", status);
+  if (sl_cli_get_argument_count(arguments) > 0) {
+    app_channel_survey_set_period(sl_cli_get_argument_uint16(arguments, 0));
+  }
+  status = app_channel_survey_start(print_survey);
+  if (status != EMBER_SUCCESS) {
+    APP_INFO("Channel survey busy, status=0x%02X\n", status);
+  }
 }
 
 /******************************************************************************
@@ -97,6 +156,7 @@ void cli_pjoin(sl_cli_command_arg_t *arguments)
   }
 
   emberPermitJoining(duration);
+  app_status_led_permit_join(duration);
 }
 
 /******************************************************************************
@@ -154,6 +214,9 @@ void cli_remove_child(sl_cli_command_arg_t *arguments)
   }
 
   status = emberRemoveChild(&address);
+  if (status == EMBER_SUCCESS && address.mode == EMBER_MAC_ADDRESS_MODE_SHORT) {
+    app_topology_forget_extender(address.addr.shortAddress);
+  }
 
   APP_INFO("Child removal 0x%02X\n", status);
 }
@@ -170,24 +233,37 @@ void cli_advertise(sl_cli_command_arg_t *arguments)
 
 /******************************************************************************
  * CLI - sensors
- * Prints the values of the child sensors.
+ * Prints a page of the child sensors that pass the optional filters: the
+ * start cursor, the page size, the fields, silent for more than N s, RSSI
+ * below X dBm and the parent node ID. The rows are printed by the sensor
+ * query event, the last line gives the cursor of the next page.
  *****************************************************************************/
 void cli_sensors(sl_cli_command_arg_t *arguments)
 {
-  (void) arguments;
-  uint8_t i;
-  APP_INFO("### Sensors table ###\n");
-  for (i = 0; i < SENSOR_TABLE_SIZE; i++) {
-    if (sensors[i].node_id != EMBER_NULL_NODE_ID) {
-      APP_INFO("entry:%d id:0x%04X eui64:(>)%02X%02X%02X%02X%02X%02X%02X%02X last report:0x%04X\n",
-               (uint16_t)i,
-               sensors[i].node_id,
-               sensors[i].node_eui64[7], sensors[i].node_eui64[6],
-               sensors[i].node_eui64[5], sensors[i].node_eui64[4],
-               sensors[i].node_eui64[3], sensors[i].node_eui64[2],
-               sensors[i].node_eui64[1], sensors[i].node_eui64[0],
-               sensors[i].last_report_ms);
-    }
+  uint8_t argument_count = sl_cli_get_argument_count(arguments);
+  app_sensor_query_t query;
+
+  app_sensor_query_set_defaults(&query);
+  if (argument_count > 0) {
+    query.cursor = sl_cli_get_argument_uint8(arguments, 0);
+  }
+  if (argument_count > 1) {
+    query.limit = sl_cli_get_argument_uint8(arguments, 1);
+  }
+  if (argument_count > 2 && sl_cli_get_argument_uint8(arguments, 2) != 0) {
+    query.fields = sl_cli_get_argument_uint8(arguments, 2) & APP_SENSOR_QUERY_FIELD_ALL;
+  }
+  if (argument_count > 3) {
+    query.filter.stale_s = sl_cli_get_argument_uint16(arguments, 3);
+  }
+  if (argument_count > 4) {
+    query.filter.rssi_below = sl_cli_get_argument_int8(arguments, 4);
+  }
+  if (argument_count > 5) {
+    query.filter.parent_id = sl_cli_get_argument_uint16(arguments, 5);
+  }
+  if (app_sensor_query_start(&query) != EMBER_SUCCESS) {
+    APP_INFO("Sensor query in progress\n");
   }
 }
 
@@ -370,3 +446,602 @@ void cli_counter(sl_cli_command_arg_t *arguments)
     APP_INFO("Get counter failed, status=0x%02X\n", status);
   }
 }
+
+/******************************************************************************
+ * CLI - tx_queue command
+ * Prints the depth, latency and drop metrics of the TX queue. An optional
+ * non-zero argument clears the metrics after printing them.
+ *****************************************************************************/
+void cli_tx_queue(sl_cli_command_arg_t *arguments)
+{
+  const app_tx_queue_stats_t *stats = app_tx_queue_get_stats();
+  uint32_t delivered = 0;
+  uint8_t i;
+
+  APP_INFO("### TX queue ###\n");
+  APP_INFO("          Depth: %d (peak %d, size %d)\n",
+           stats->depth, stats->peak_depth, APP_TX_QUEUE_SIZE);
+  for (i = 0; i < APP_TX_PRIORITY_COUNT; i++) {
+    APP_INFO("     Priority %d: enqueued %lu, delivered %lu\n",
+             i, stats->enqueued[i], stats->delivered[i]);
+    delivered += stats->delivered[i];
+  }
+  APP_INFO("        Retries: %lu\n", stats->retries);
+  APP_INFO("   Drops (full): %lu\n", stats->dropped_overflow);
+  APP_INFO(" Drops (failed): %lu\n", stats->dropped_failed);
+  if (delivered != 0) {
+    APP_INFO("   Latency (ms): min %lu avg %lu max %lu\n",
+             stats->latency_min_ms,
+             stats->latency_sum_ms / delivered,
+             stats->latency_max_ms);
+  }
+
+  if (sl_cli_get_argument_count(arguments) > 0
+      && sl_cli_get_argument_uint8(arguments, 0) != 0) {
+    app_tx_queue_reset_stats();
+  }
+}
+
+/******************************************************************************
+ * CLI - configure command
+ * Sets the report period of a sensor, at least
+ * APP_CONFIGURE_MIN_REPORT_PERIOD_MS. Sleepy sensors get it through their
+ * mailbox, where it replaces any configuration not delivered yet.
+ *****************************************************************************/
+void cli_configure(sl_cli_command_arg_t *arguments)
+{
+  EmberNodeId node_id = sl_cli_get_argument_uint16(arguments, 0);
+  uint16_t report_period_ms = sl_cli_get_argument_uint16(arguments, 1);
+  uint8_t payload[APP_CONFIGURE_LENGTH];
+  EmberStatus status;
+
+  if (report_period_ms < APP_CONFIGURE_MIN_REPORT_PERIOD_MS) {
+    APP_INFO("Report period below %d ms\n", APP_CONFIGURE_MIN_REPORT_PERIOD_MS);
+    return;
+  }
+
+  payload[APP_DOWNLINK_FLAGS_OFFSET] = 0;
+  emberStoreLowHighInt16u(payload + APP_CONFIGURE_REPORT_PERIOD_OFFSET,
+                          report_period_ms);
+  status = app_mailbox_post(node_id,
+                            APP_COMMAND_ID_CONFIGURE,
+                            payload,
+                            APP_CONFIGURE_LENGTH);
+
+  APP_INFO("TX: Configure to 0x%04X (%s): 0x%02X\n",
+           node_id,
+           (app_mailbox_is_pending(node_id) ? "mailbox" : "direct"),
+           status);
+}
+
+/******************************************************************************
+ * CLI - mailbox command
+ * Prints the mailboxes of the sleepy sensors.
+ *****************************************************************************/
+void cli_mailbox(sl_cli_command_arg_t *arguments)
+{
+  (void) arguments;
+  const app_mailbox_stats_t *stats;
+  EmberNodeId node_id;
+  uint8_t count;
+  uint8_t i;
+
+  APP_INFO("### Mailboxes ###\n");
+  for (i = 0; i < APP_MAILBOX_COUNT; i++) {
+    stats = app_mailbox_get(i, &node_id, &count);
+    if (stats != NULL) {
+      APP_INFO("id:0x%04X pending:%d posted:%lu coalesced:%lu released:%lu expired:%lu overflowed:%lu\n",
+               node_id,
+               count,
+               stats->posted,
+               stats->coalesced,
+               stats->released,
+               stats->expired,
+               stats->overflowed);
+    }
+  }
+}
+
+/******************************************************************************
+ * CLI - channel_map command
+ * Prints the TX failure metrics and the exclusion state of the hopping
+ * channels. An optional non-zero argument resets the map after printing it.
+ *****************************************************************************/
+void cli_channel_map(sl_cli_command_arg_t *arguments)
+{
+  const app_channel_map_stats_t *stats;
+  uint8_t i;
+
+  APP_INFO("### Channel map ###\n");
+  APP_INFO("channel attempts no-ack   cca rate excluded\n");
+  for (i = 0; (stats = app_channel_map_get(i)) != NULL; i++) {
+    APP_INFO("%7d %8lu %6lu %5lu %3d%% %s (%d)\n",
+             EMBER_FREQUENCY_HOPPING_START_CHANNEL + i,
+             stats->attempts,
+             stats->tx_failures,
+             stats->cca_failures,
+             stats->failure_percent,
+             stats->excluded ? "yes" : "no",
+             stats->exclusions);
+  }
+
+  if (sl_cli_get_argument_count(arguments) > 0
+      && sl_cli_get_argument_uint8(arguments, 0) != 0) {
+    app_channel_map_reset();
+  }
+}
+
+/******************************************************************************
+ * CLI - cca command
+ * Prints the CCA threshold and the state of its controller. An optional
+ * argument starts (1) or stops (0) the controller, stopping it restores the
+ * configured threshold.
+ *****************************************************************************/
+void cli_cca(sl_cli_command_arg_t *arguments)
+{
+  const app_cca_stats_t *stats = app_cca_get_stats();
+
+  if (sl_cli_get_argument_count(arguments) > 0) {
+    app_cca_set_enabled(sl_cli_get_argument_uint8(arguments, 0) != 0);
+  }
+
+  APP_INFO("### CCA threshold controller ###\n");
+  APP_INFO("      Threshold: %d dBm, controller %s\n",
+           emberGetCcaThreshold(),
+           app_cca_is_enabled() ? ENABLED : DISABLED);
+  APP_INFO("        Periods: %lu, %lu with enough traffic\n",
+           stats->periods, stats->sampled_periods);
+  APP_INFO("        Changes: %lu raised, %lu lowered\n",
+           stats->raised, stats->lowered);
+  APP_INFO("    Last period: CCA fail %d%%, ACK fail %d%%\n",
+           stats->cca_fail_percent, stats->ack_fail_percent);
+  if (stats->noise_floor_dbm != APP_CCA_NOISE_FLOOR_UNKNOWN) {
+    APP_INFO("    Noise floor: %d dBm\n", stats->noise_floor_dbm);
+  } else {
+    APP_INFO("    Noise floor: unknown, run channel_survey\n");
+  }
+}
+
+/******************************************************************************
+ * CLI - counters command
+ * Prints the rates over the delta ring and a snapshot of every stack counter
+ * with its increase during the last sample period. An optional non-zero
+ * argument resets the counters after printing them.
+ *****************************************************************************/
+void cli_counters(sl_cli_command_arg_t *arguments)
+{
+  app_counters_rates_t rates;
+  uint8_t i;
+
+  app_counters_get_rates(&rates);
+  APP_INFO("### Stack counters ###\n");
+  APP_INFO("Rates over %lu ms (per s): TX %lu.%02lu, RX %lu.%02lu, "
+           "ACK fail %lu.%02lu, CCA fail %lu.%02lu, retries %lu.%02lu\n",
+           rates.window_ms,
+           rates.tx / 100, rates.tx % 100,
+           rates.rx / 100, rates.rx % 100,
+           rates.ack_failures / 100, rates.ack_failures % 100,
+           rates.cca_failures / 100, rates.cca_failures % 100,
+           rates.retries / 100, rates.retries % 100);
+  for (i = 0; i < EMBER_COUNTER_TYPE_COUNT; i++) {
+    APP_INFO("0x%02X: %lu (+%d)\n",
+             i, app_counters_get(i), app_counters_get_last_delta(i));
+  }
+
+  if (sl_cli_get_argument_count(arguments) > 0
+      && sl_cli_get_argument_uint8(arguments, 0) != 0) {
+    app_counters_reset();
+  }
+}
+
+/******************************************************************************
+ * CLI - counters_dump command
+ * Prints the binary snapshot of every stack counter as a single hex line.
+ *****************************************************************************/
+void cli_counters_dump(sl_cli_command_arg_t *arguments)
+{
+  (void) arguments;
+  uint8_t buffer[APP_COUNTERS_DUMP_LENGTH];
+  uint16_t length = app_counters_dump(buffer);
+  uint16_t i;
+
+  APP_INFO("counters:");
+  for (i = 0; i < length; i++) {
+    APP_INFO("%02X", buffer[i]);
+  }
+  APP_INFO("\n");
+}
+
+/******************************************************************************
+ * CLI - latency command
+ * Prints the sample to sink latency percentiles of every paired sensor and
+ * of the whole network. An optional argument prints the histogram buckets of
+ * the given sensor table entry instead, 255 for the global one.
+ *****************************************************************************/
+void cli_latency(sl_cli_command_arg_t *arguments)
+{
+  const app_latency_histogram_t *histogram;
+  uint8_t i;
+
+  if (sl_cli_get_argument_count(arguments) > 0) {
+    uint8_t index = sl_cli_get_argument_uint8(arguments, 0);
+    histogram = app_latency_get((index < APP_SENSOR_TABLE_SIZE) ? index : APP_LATENCY_GLOBAL);
+    APP_INFO("### Latency histogram ###\n");
+    for (i = 0; i < APP_LATENCY_BUCKET_COUNT; i++) {
+      APP_INFO("%6lu ms: %d\n", (i == 0) ? 0 : (1lu << i), histogram->buckets[i]);
+    }
+    return;
+  }
+
+  APP_INFO("### Sample to sink latency (ms) ###\n");
+  APP_INFO("index  node  count   min   p50   p90   p99   max   avg\n");
+  for (i = 0; i <= APP_LATENCY_GLOBAL; i++) {
+    histogram = app_latency_get(i);
+    if (i < APP_SENSOR_TABLE_SIZE && sensor_hot.node_id[i] == EMBER_NULL_NODE_ID) {
+      continue;
+    }
+    if (i < APP_SENSOR_TABLE_SIZE) {
+      APP_INFO("%5d 0x%04X", i, sensor_hot.node_id[i]);
+    } else {
+      APP_INFO("  all       ");
+    }
+    APP_INFO(" %6lu %5lu %5lu %5lu %5lu %5lu %5lu\n",
+             histogram->count,
+             histogram->min_ms,
+             app_latency_percentile(histogram, 50),
+             app_latency_percentile(histogram, 90),
+             app_latency_percentile(histogram, 99),
+             histogram->max_ms,
+             (histogram->count > 0) ? (histogram->sum_ms / histogram->count) : 0);
+  }
+}
+
+/******************************************************************************
+ * CLI - trace command
+ * Prints the state of the event trace. An optional argument pauses (0) or
+ * resumes (1) the recording.
+ *****************************************************************************/
+void cli_trace(sl_cli_command_arg_t *arguments)
+{
+  if (sl_cli_get_argument_count(arguments) > 0) {
+    app_trace_set_enabled(sl_cli_get_argument_uint8(arguments, 0) != 0);
+  }
+  APP_INFO("Trace %s, %d/%d events\n",
+           app_trace_is_enabled() ? "recording" : "paused",
+           app_trace_get_count(),
+           APP_TRACE_SIZE);
+}
+
+/******************************************************************************
+ * CLI - trace_dump command
+ * Prints the header and every event of the trace as hex lines, oldest event
+ * first. The recording is paused meanwhile. An optional argument of 1 empties
+ * the trace afterwards.
+ *****************************************************************************/
+void cli_trace_dump(sl_cli_command_arg_t *arguments)
+{
+  uint8_t buffer[APP_TRACE_HEADER_LENGTH];
+  bool was_enabled = app_trace_is_enabled();
+  uint16_t count;
+  uint16_t index;
+  uint8_t length;
+  uint8_t i;
+
+  app_trace_set_enabled(false);
+  count = app_trace_get_count();
+  length = app_trace_dump_header(buffer);
+  APP_INFO("trace:");
+  for (i = 0; i < length; i++) {
+    APP_INFO("%02X", buffer[i]);
+  }
+  APP_INFO("\n");
+  for (index = 0; index < count; index++) {
+    if (index % 4 == 0) {
+      APP_INFO("trace:");
+    }
+    app_trace_dump_entry(index, buffer);
+    for (i = 0; i < APP_TRACE_ENTRY_LENGTH; i++) {
+      APP_INFO("%02X", buffer[i]);
+    }
+    if (index % 4 == 3 || index == count - 1) {
+      APP_INFO("\n");
+    }
+  }
+
+  if (sl_cli_get_argument_count(arguments) > 0
+      && sl_cli_get_argument_uint8(arguments, 0) == 1) {
+    app_trace_clear();
+  }
+  app_trace_set_enabled(was_enabled);
+}
+
+/******************************************************************************
+ * CLI - memory command
+ * Prints the stack high-water marks and the heap usage. The buffer heap peak
+ * is sampled, see app_memory_sample(). An optional argument of 1 restarts the
+ * peak tracking of the Ember buffer heap afterwards.
+ *****************************************************************************/
+void cli_memory(sl_cli_command_arg_t *arguments)
+{
+  app_memory_stats_t stats;
+  const char *name;
+  uint16_t size;
+  uint16_t used;
+  uint8_t i;
+
+  app_memory_get_stats(&stats);
+  APP_INFO("### Memory usage (bytes) ###\n");
+  APP_INFO("     Main stack: %d/%d peak\n", stats.stack_peak, stats.stack_size);
+  for (i = 0; app_memory_get_task(i, &name, &size, &used); i++) {
+    APP_INFO("     Task stack: %d/%d peak, %s\n", used, size, name);
+  }
+  APP_INFO("   Buffer heap: %d used, %d sampled peak, %d total\n",
+           stats.buffer_used, stats.buffer_peak, stats.buffer_size);
+  APP_INFO("         C heap: %d used, %d peak\n",
+           stats.c_heap_used, stats.c_heap_peak);
+
+  if (sl_cli_get_argument_count(arguments) > 0
+      && sl_cli_get_argument_uint8(arguments, 0) == 1) {
+    app_memory_reset_peak();
+  }
+}
+
+/******************************************************************************
+ * CLI - topology command
+ * Prints the range extenders with their load and the parent of every paired
+ * sensor.
+ *****************************************************************************/
+void cli_topology(sl_cli_command_arg_t *arguments)
+{
+  (void) arguments;
+  EmberNodeId node_id;
+  uint8_t sensor_count;
+  uint8_t i;
+
+  APP_INFO("### Topology ###\n");
+  APP_INFO("sink 0x%04X: %d sensor(s)\n",
+           emberGetNodeId(),
+           app_topology_count_sensors(emberGetNodeId()));
+  for (i = 0; i < APP_TOPOLOGY_MAX_EXTENDERS; i++) {
+    if (app_topology_get_extender(i, &node_id, &sensor_count)) {
+      APP_INFO("extender 0x%04X: %d/%d sensor(s)\n",
+               node_id, sensor_count, APP_TOPOLOGY_EXTENDER_CAPACITY);
+    }
+  }
+  for (i = 0; i < APP_SENSOR_TABLE_SIZE; i++) {
+    if (sensor_hot.node_id[i] != EMBER_NULL_NODE_ID) {
+      APP_INFO("sensor 0x%04X via 0x%04X\n",
+               sensor_hot.node_id[i],
+               (sensor_cold.parent_id[i] == EMBER_NULL_NODE_ID)
+               ? emberGetNodeId() : sensor_cold.parent_id[i]);
+    }
+  }
+}
+
+/******************************************************************************
+ * CLI - pjoin_balanced command
+ * Permits joining for the given seconds (or unlimited = 0xff) on the least
+ * loaded parent only, the sink or a range extender, with an optional
+ * selective join payload.
+ *****************************************************************************/
+void cli_pjoin_balanced(sl_cli_command_arg_t *arguments)
+{
+  uint8_t duration = sl_cli_get_argument_uint8(arguments, 0);
+  size_t length = 0;
+  uint8_t *contents = NULL;
+  EmberNodeId parent_id;
+  EmberStatus status;
+
+  if (sl_cli_get_argument_count(arguments) > 1) {
+    contents = sl_cli_get_argument_hex(arguments, 1, &length);
+  }
+  status = app_topology_permit_joining(duration,
+                                       contents,
+                                       (length > UINT8_MAX) ? UINT8_MAX : (uint8_t)length,
+                                       &parent_id);
+  APP_INFO("Permit join on 0x%04X: 0x%02X\n", parent_id, status);
+  if (status == EMBER_SUCCESS) {
+    app_status_led_permit_join(duration);
+  }
+}
+
+/******************************************************************************
+ * CLI - hl command
+ * Serves a binary request frame of the host link, see app_host_link.h. The
+ * response is printed as a "#HL <hex>" line.
+ *****************************************************************************/
+void cli_host_link(sl_cli_command_arg_t *arguments)
+{
+  size_t length = 0;
+  uint8_t *frame = sl_cli_get_argument_hex(arguments, 0, &length);
+
+  app_host_link_handle(frame, (length > UINT8_MAX) ? UINT8_MAX : (uint8_t)length);
+}
+
+/******************************************************************************
+ * CLI - baud command
+ * Switches the VCOM to the given baud rate once the answer is out. The new
+ * rate has to be confirmed with the command without argument, or a host link
+ * request, within APP_SERIAL_BAUD_CONFIRM_MS. Without argument, it prints the
+ * current rate.
+ *****************************************************************************/
+void cli_baud(sl_cli_command_arg_t *arguments)
+{
+  EmberStatus status;
+  uint32_t baud;
+
+  if (sl_cli_get_argument_count(arguments) == 0) {
+    app_serial_confirm();
+    APP_INFO("Baud rate: %lu\n", app_serial_get_baud());
+    return;
+  }
+  baud = sl_cli_get_argument_uint32(arguments, 0);
+  status = app_serial_request_baud(baud);
+  if (status == EMBER_SUCCESS) {
+    APP_INFO("Baud rate: switching to %lu, confirm within %u ms\n",
+             baud, APP_SERIAL_BAUD_CONFIRM_MS);
+  } else {
+    APP_INFO("Baud rate %lu refused: 0x%02X\n", baud, status);
+  }
+}
+
+/******************************************************************************
+ * CLI - uart_tx command
+ * Prints the metrics of the LDMA output ring. An optional non-zero argument
+ * clears them after printing them.
+ *****************************************************************************/
+void cli_uart_tx(sl_cli_command_arg_t *arguments)
+{
+  const app_uart_tx_stats_t *stats = app_uart_tx_get_stats();
+
+  APP_INFO("### UART TX ###\n");
+  APP_INFO("      Committed: %lu bytes\n", stats->committed);
+  APP_INFO("           Sent: %lu bytes\n", stats->sent);
+  APP_INFO("      Transfers: %lu (%lu descriptors)\n",
+           stats->transfers, stats->descriptors);
+  APP_INFO("      Ring peak: %d/%d bytes\n", stats->peak_used, APP_UART_TX_RING_SIZE);
+  APP_INFO("    Write waits: %lu\n", stats->waits);
+  APP_INFO("        Dropped: %lu bytes\n", stats->dropped);
+
+  if (sl_cli_get_argument_count(arguments) > 0
+      && sl_cli_get_argument_uint8(arguments, 0) != 0) {
+    app_uart_tx_reset_stats();
+  }
+}
+
+/******************************************************************************
+ * CLI - uart_bench command
+ * Prints the same "#UB" lines through the VCOM stream, printf into the
+ * output ring and in place in the ring, then the CPU cycles per byte of each
+ * path. Optional arguments: line count and line length.
+ *****************************************************************************/
+void cli_uart_bench(sl_cli_command_arg_t *arguments)
+{
+  uint16_t count = UART_BENCH_LINES;
+  uint8_t length = UART_BENCH_LENGTH;
+  app_uart_tx_bench_t result;
+
+  if (sl_cli_get_argument_count(arguments) > 0) {
+    count = sl_cli_get_argument_uint16(arguments, 0);
+  }
+  if (sl_cli_get_argument_count(arguments) > 1) {
+    length = sl_cli_get_argument_uint8(arguments, 1);
+  }
+  if (!app_uart_tx_benchmark(count, length, &result)) {
+    APP_INFO("uart_bench: 1 or more lines of 10 to 200 characters\n");
+    return;
+  }
+  APP_INFO("### UART TX benchmark, %d lines of %d characters ###\n", count, length);
+  print_bench_path("   VCOM printf", &result.vcom_printf);
+  print_bench_path("   Ring printf", &result.ring_printf);
+  print_bench_path(" Ring in place", &result.ring_direct);
+  APP_INFO("   Ring drained: %lu cycles later\n", result.drain_cycles);
+}
+
+/******************************************************************************
+ * CLI - loop_cost command
+ * Measures the CPU cycles of the next main loop iterations, printed once
+ * done. Optional arguments: iteration count and 1 to poll the LED on every
+ * iteration, as before the status LED events, for the comparison.
+ *****************************************************************************/
+void cli_loop_cost(sl_cli_command_arg_t *arguments)
+{
+#if APP_STATUS_LED_LOOP_METER
+  uint16_t iterations = LOOP_COST_ITERATIONS;
+  bool polling = false;
+
+  if (sl_cli_get_argument_count(arguments) > 0) {
+    iterations = sl_cli_get_argument_uint16(arguments, 0);
+  }
+  if (sl_cli_get_argument_count(arguments) > 1) {
+    polling = (sl_cli_get_argument_uint8(arguments, 1) != 0);
+  }
+  if (!app_status_led_measure_loop(iterations, polling)) {
+    APP_INFO("loop_cost: 1 or more iterations, one measurement at a time\n");
+  }
+#else
+  (void) arguments;
+  APP_INFO("loop_cost: built without APP_STATUS_LED_LOOP_METER\n");
+#endif
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Prints the bytes, cycles and cycles per byte of a benchmark path.
+ *****************************************************************************/
+static void print_bench_path(const char *name, const app_uart_tx_bench_path_t *path)
+{
+  uint32_t tenths = (path->bytes > 0)
+                    ? (uint32_t)((uint64_t)path->cycles * 10u / path->bytes) : 0;
+
+  APP_INFO("%s: %lu bytes, %lu cycles, %lu.%lu cycles/byte\n",
+           name, path->bytes, path->cycles, tenths / 10u, tenths % 10u);
+}
+
+/**************************************************************************//**
+ * Forms a network on the given channel.
+ *****************************************************************************/
+static void form_network(uint16_t channel)
+{
+  EmberStatus status;
+  EmberNetworkParameters parameters;
+
+  // Initialize the security key to the default key prior to forming the
+  // network.
+  emberSetSecurityKey(&security_key);
+
+  MEMSET(&parameters, 0, sizeof(EmberNetworkParameters));
+  parameters.radioTxPower = tx_power;
+  parameters.radioChannel = channel;
+  parameters.panId = SENSOR_SINK_PAN_ID;
+
+  status = emberFormNetwork(&parameters);
+  if (status == EMBER_SUCCESS && !emberStackIsUp()) {
+    // Until EMBER_NETWORK_UP, unless it already came
+    app_status_led_set(APP_STATUS_LED_FORMING);
+  }
+
+  APP_INFO("form 0x%02X\n", status);
+}
+
+/**************************************************************************//**
+ * Prints the channel ranking once a survey completes.
+ *****************************************************************************/
+static void print_survey(EmberStatus status, uint16_t best_channel)
+{
+  const app_channel_survey_result_t *result;
+  uint16_t channel;
+  uint8_t rank;
+
+  (void) best_channel;
+  APP_INFO("### Channel survey ###\n");
+  if (status != EMBER_SUCCESS) {
+    APP_INFO("Incomplete survey, status=0x%02X\n", status);
+  }
+  APP_INFO("rank channel  mean   min   max variance score\n");
+  for (rank = 0; (result = app_channel_survey_get(rank, &channel)) != NULL; rank++) {
+    APP_INFO("%4d %7d %5d %5d %5d %8d %5d\n",
+             rank,
+             channel,
+             result->mean,
+             result->min,
+             result->max,
+             result->variance,
+             result->score);
+  }
+}
+
+/**************************************************************************//**
+ * Forms a network on the best channel once a survey completes.
+ *****************************************************************************/
+static void form_on_best_channel(EmberStatus status, uint16_t best_channel)
+{
+  print_survey(status, best_channel);
+  if (status == EMBER_SUCCESS) {
+    form_network(best_channel);
+  } else {
+    APP_INFO("Channel survey failed, network not formed\n");
+  }
+}
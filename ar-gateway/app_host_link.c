@@ -0,0 +1,483 @@
+/***************************************************************************//**
+ * @file app_host_link.c
+ * @brief app_host_link.c
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdio.h>
+#include <string.h>
+#include PLATFORM_HEADER
+#include "stack/include/ember.h"
+#include "hal/hal.h"
+#include "sl_app_common.h"
+#include "app_framework_common.h"
+#include "app_protocol.h"
+#include "app_counters.h"
+#include "app_sensor_table.h"
+#include "app_sensor_query.h"
+#include "app_status_led.h"
+#include "app_serial.h"
+#include "app_uart_tx.h"
+#include "app_host_link.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// The destination endpoint of the data sent, as the data CLI command
+#define DATA_ENDPOINT                  (1u)
+/// The status is the first byte of a response payload
+#define STATUS_OFFSET                  (APP_HOST_LINK_PAYLOAD_OFFSET)
+/// Start of the response lines
+#define RESPONSE_PREFIX                "#HL "
+/// Room for the longest response payload, the sensors, sensor query or
+/// counters one
+#define RESPONSE_MAX_PAYLOAD                                               \
+  (3u + APP_HOST_LINK_SENSORS_PER_RESPONSE * APP_HOST_LINK_SENSOR_ENTRY_LENGTH \
+   + 1u + APP_COUNTERS_DUMP_LENGTH)
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Serves a request.
+ *
+ * @param type is the message type
+ * @param *request is the request payload
+ * @param length is the length of the request payload
+ * @param *response receives the response payload, status first
+ * @returns the length of the response payload.
+ *****************************************************************************/
+static uint16_t serve(uint8_t type,
+                      const uint8_t *request,
+                      uint8_t length,
+                      uint8_t *response);
+
+/**************************************************************************//**
+ * Fills a page of the sensor table, from a given entry on.
+ *****************************************************************************/
+static uint16_t serve_sensors(uint8_t first, uint8_t *response);
+
+/**************************************************************************//**
+ * Fills a page of the sensors that pass the filters of the request.
+ *****************************************************************************/
+static uint16_t serve_sensor_query(const uint8_t *request,
+                                   uint8_t length,
+                                   uint8_t *response);
+
+/**************************************************************************//**
+ * Starts a stream test, answered once its lines are out.
+ *****************************************************************************/
+static uint8_t start_stream(uint8_t id, const uint8_t *request, uint8_t length);
+
+/**************************************************************************//**
+ * Formats the next line of the stream test, line_length characters and a
+ * terminating NUL.
+ *****************************************************************************/
+static void format_stream_line(char *line);
+
+/**************************************************************************//**
+ * Appends the CRC to the response frame and prints it.
+ *
+ * @param length is the length of the frame without CRC
+ *****************************************************************************/
+static void send_response(uint16_t length);
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+/// Stream test event control
+EmberEventControl *host_link_control;
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+/// Response frame being built
+static uint8_t response_frame[APP_HOST_LINK_PAYLOAD_OFFSET + RESPONSE_MAX_PAYLOAD
+                              + APP_HOST_LINK_CRC_LENGTH];
+
+/// Stream test in progress
+static struct {
+  bool active;
+  uint8_t id;
+  uint8_t line_length;
+  uint16_t line_count;
+  uint16_t sequence;
+  uint32_t bytes;
+  uint32_t started_ms;
+} stream;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Allocates the stream test event.
+ *****************************************************************************/
+void app_host_link_init(void)
+{
+  emberAfAllocateEvent(&host_link_control, &host_link_handler);
+  stream.active = false;
+}
+
+/**************************************************************************//**
+ * Checks and serves a request frame, then prints the response line.
+ *****************************************************************************/
+void app_host_link_handle(const uint8_t *frame, uint8_t length)
+{
+  uint16_t response_length;
+
+  // Without request ID and type, the host could not match an answer.
+  if (length < APP_HOST_LINK_PAYLOAD_OFFSET) {
+    return;
+  }
+  response_frame[APP_HOST_LINK_ID_OFFSET] = frame[APP_HOST_LINK_ID_OFFSET];
+  response_frame[APP_HOST_LINK_TYPE_OFFSET] = frame[APP_HOST_LINK_TYPE_OFFSET]
+                                              | APP_HOST_LINK_RESPONSE;
+  if (length < APP_HOST_LINK_PAYLOAD_OFFSET + APP_HOST_LINK_CRC_LENGTH
+      || app_host_link_crc(frame, length - APP_HOST_LINK_CRC_LENGTH, 0xFFFF)
+      != emberFetchLowHighInt16u(frame + length - APP_HOST_LINK_CRC_LENGTH)) {
+    response_frame[STATUS_OFFSET] = APP_HOST_LINK_STATUS_BAD_FRAME;
+    response_length = STATUS_OFFSET + 1;
+  } else if (frame[APP_HOST_LINK_TYPE_OFFSET] == APP_HOST_LINK_STREAM) {
+    app_serial_confirm();
+    response_frame[STATUS_OFFSET] =
+      start_stream(frame[APP_HOST_LINK_ID_OFFSET],
+                   frame + APP_HOST_LINK_PAYLOAD_OFFSET,
+                   length - APP_HOST_LINK_PAYLOAD_OFFSET - APP_HOST_LINK_CRC_LENGTH);
+    if (response_frame[STATUS_OFFSET] == EMBER_SUCCESS) {
+      // Answered at the end of the stream
+      return;
+    }
+    response_length = STATUS_OFFSET + 1;
+  } else {
+    // A valid frame proves that the host follows a baud rate change.
+    app_serial_confirm();
+    response_length = APP_HOST_LINK_PAYLOAD_OFFSET
+                      + serve(frame[APP_HOST_LINK_TYPE_OFFSET],
+                              frame + APP_HOST_LINK_PAYLOAD_OFFSET,
+                              length - APP_HOST_LINK_PAYLOAD_OFFSET
+                              - APP_HOST_LINK_CRC_LENGTH,
+                              response_frame + APP_HOST_LINK_PAYLOAD_OFFSET);
+  }
+  send_response(response_length);
+}
+
+/**************************************************************************//**
+ * Computes the CRC-16/CCITT of a buffer, bit by bit: the frames are short.
+ *****************************************************************************/
+uint16_t app_host_link_crc(const uint8_t *buffer, uint16_t length, uint16_t crc)
+{
+  uint8_t bit;
+
+  while (length-- > 0) {
+    crc ^= (uint16_t)(*buffer++) << 8;
+    for (bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000u) ? (uint16_t)((crc << 1) ^ 0x1021u) : (uint16_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+/**************************************************************************//**
+ * Event handler that prints the next lines of a stream test.
+ *****************************************************************************/
+void host_link_handler(void)
+{
+  char line[APP_HOST_LINK_STREAM_MAX_LINE + 1];
+  uint8_t count;
+  char *out;
+
+  emberEventControlSetInactive(*host_link_control);
+  if (!stream.active) {
+    return;
+  }
+  for (count = 0; count < APP_HOST_LINK_STREAM_LINES_PER_EVENT
+       && stream.sequence < stream.line_count; count++) {
+    // Formatted in place in the output ring, or printed if the TX engine
+    // did not start.
+    out = (char *)app_uart_tx_reserve(stream.line_length + APP_UART_TX_EOL_LENGTH + 1);
+    if (out == NULL && !app_uart_tx_is_idle()) {
+      // The ring is full, LDMA sends it meanwhile.
+      emberEventControlSetDelayMS(*host_link_control, 1);
+      return;
+    }
+    if (out != NULL) {
+      format_stream_line(out);
+      memcpy(out + stream.line_length, APP_UART_TX_EOL, APP_UART_TX_EOL_LENGTH);
+      app_uart_tx_commit(stream.line_length + APP_UART_TX_EOL_LENGTH);
+    } else {
+      format_stream_line(line);
+      APP_INFO("%s\n", line);
+    }
+    stream.bytes += stream.line_length + APP_UART_TX_EOL_LENGTH;
+    stream.sequence++;
+  }
+  if (stream.sequence < stream.line_count) {
+    emberEventControlSetActive(*host_link_control);
+    return;
+  }
+
+  stream.active = false;
+  response_frame[APP_HOST_LINK_ID_OFFSET] = stream.id;
+  response_frame[APP_HOST_LINK_TYPE_OFFSET] = APP_HOST_LINK_STREAM | APP_HOST_LINK_RESPONSE;
+  response_frame[STATUS_OFFSET] = EMBER_SUCCESS;
+  emberStoreLowHighInt16u(response_frame + STATUS_OFFSET + 1, stream.line_count);
+  emberStoreLowHighInt32u(response_frame + STATUS_OFFSET + 3, stream.bytes);
+  emberStoreLowHighInt32u(response_frame + STATUS_OFFSET + 7,
+                          elapsedTimeInt32u(stream.started_ms,
+                                            halCommonGetInt32uMillisecondTick()));
+  send_response(STATUS_OFFSET + 11);
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+static uint16_t serve(uint8_t type,
+                      const uint8_t *request,
+                      uint8_t length,
+                      uint8_t *response)
+{
+  EmberStatus status;
+  uint16_t dump_length;
+  uint8_t sensors = 0;
+  uint8_t i;
+
+  switch (type) {
+    case APP_HOST_LINK_PING:
+      response[0] = EMBER_SUCCESS;
+      response[1] = APP_HOST_LINK_VERSION;
+      memcpy(response + 2, request, length);
+      return 2 + length;
+
+    case APP_HOST_LINK_INFO:
+      for (i = 0; i < APP_SENSOR_TABLE_SIZE; i++) {
+        if (sensor_hot.node_id[i] != EMBER_NULL_NODE_ID) {
+          sensors++;
+        }
+      }
+      response[0] = EMBER_SUCCESS;
+      response[1] = emberNetworkState();
+      response[2] = emberGetNodeType();
+      emberStoreLowHighInt16u(response + 3, emberGetNodeId());
+      emberStoreLowHighInt16u(response + 5, emberGetPanId());
+      emberStoreLowHighInt16u(response + 7, (uint16_t)emberGetRadioChannel());
+      emberStoreLowHighInt16u(response + 9, (uint16_t)emberGetRadioPower());
+      response[11] = tx_options;
+      response[12] = sensors;
+      response[13] = APP_SENSOR_TABLE_SIZE;
+      return 14;
+
+    case APP_HOST_LINK_SENSORS:
+      if (length < 1) {
+        break;
+      }
+      return serve_sensors(request[0], response);
+
+    case APP_HOST_LINK_SENSOR_QUERY:
+      if (length < 3) {
+        break;
+      }
+      return serve_sensor_query(request, length, response);
+
+    case APP_HOST_LINK_SEND_DATA:
+      if (length < 2) {
+        break;
+      }
+      response[0] = emberMessageSend(emberFetchLowHighInt16u(request),
+                                     DATA_ENDPOINT,
+                                     0, // messageTag
+                                     length - 2,
+                                     (uint8_t *)request + 2,
+                                     tx_options);
+      return 1;
+
+    case APP_HOST_LINK_PERMIT_JOIN:
+      if (length < 1) {
+        break;
+      }
+      status = EMBER_SUCCESS;
+      if (length > 1) {
+        status = emberSetSelectiveJoinPayload(length - 1, (uint8_t *)request + 1);
+      } else {
+        emberClearSelectiveJoinPayload();
+      }
+      if (status == EMBER_SUCCESS) {
+        status = emberPermitJoining(request[0]);
+      }
+      if (status == EMBER_SUCCESS) {
+        app_status_led_permit_join(request[0]);
+      }
+      response[0] = status;
+      return 1;
+
+    case APP_HOST_LINK_SET_BAUD:
+      if (length < 4) {
+        break;
+      }
+      response[0] = app_serial_request_baud(emberFetchLowHighInt32u(request));
+      return 1;
+
+    case APP_HOST_LINK_COUNTERS:
+      response[0] = EMBER_SUCCESS;
+      dump_length = app_counters_dump(response + 1);
+      if (length > 0 && (request[0] & 0x01u) != 0) {
+        app_counters_reset();
+      }
+      return 1 + dump_length;
+
+    default:
+      response[0] = APP_HOST_LINK_STATUS_UNKNOWN_TYPE;
+      return 1;
+  }
+  response[0] = APP_HOST_LINK_STATUS_BAD_ARGUMENT;
+  return 1;
+}
+
+static uint16_t serve_sensors(uint8_t first, uint8_t *response)
+{
+  uint32_t now_ms = halCommonGetInt32uMillisecondTick();
+  uint8_t *entry = response + 3;
+  uint8_t count = 0;
+  uint16_t i;
+
+  for (i = first; i < APP_SENSOR_TABLE_SIZE
+       && count < APP_HOST_LINK_SENSORS_PER_RESPONSE; i++) {
+    if (sensor_hot.node_id[i] == EMBER_NULL_NODE_ID) {
+      continue;
+    }
+    entry[0] = (uint8_t)i;
+    emberStoreLowHighInt16u(entry + 1, sensor_hot.node_id[i]);
+    emberStoreLowHighInt16u(entry + 3, sensor_cold.parent_id[i]);
+    memcpy(entry + 5, sensor_cold.node_eui64[i], EUI64_SIZE);
+    emberStoreLowHighInt32u(entry + 13,
+                            elapsedTimeInt32u(sensor_hot.last_report_ms[i], now_ms));
+    entry += APP_HOST_LINK_SENSOR_ENTRY_LENGTH;
+    count++;
+  }
+  response[0] = EMBER_SUCCESS;
+  response[1] = (i < APP_SENSOR_TABLE_SIZE) ? (uint8_t)i : 0xFFu;
+  response[2] = count;
+  return (uint16_t)(entry - response);
+}
+
+static uint16_t serve_sensor_query(const uint8_t *request,
+                                   uint8_t length,
+                                   uint8_t *response)
+{
+  uint32_t now_ms = halCommonGetInt32uMillisecondTick();
+  app_sensor_query_t query;
+  uint8_t *entry = response + 4;
+  uint8_t max_count;
+  uint8_t count = 0;
+  uint8_t index;
+
+  app_sensor_query_set_defaults(&query);
+  query.cursor = request[0];
+  query.limit = request[1];
+  if (request[2] != 0) {
+    query.fields = request[2] & APP_SENSOR_QUERY_FIELD_ALL;
+  }
+  if (length >= 5) {
+    query.filter.stale_s = emberFetchLowHighInt16u(request + 3);
+  }
+  if (length >= 6) {
+    query.filter.rssi_below = (int8_t)request[5];
+  }
+  if (length >= 8) {
+    query.filter.parent_id = emberFetchLowHighInt16u(request + 6);
+  }
+
+  // As many entries as the room of a sensors page, more with fewer fields
+  max_count = (uint8_t)(APP_HOST_LINK_SENSORS_PER_RESPONSE * APP_HOST_LINK_SENSOR_ENTRY_LENGTH
+                        / app_sensor_query_entry_length(query.fields));
+  if (query.limit != 0 && query.limit < max_count) {
+    max_count = query.limit;
+  }
+  index = app_sensor_query_next(&query.filter, query.cursor, now_ms);
+  while (index != APP_SENSOR_TABLE_INVALID_INDEX && count < max_count) {
+    entry += app_sensor_query_encode(index, query.fields, now_ms, entry);
+    count++;
+    index = app_sensor_query_next(&query.filter, (uint16_t)index + 1, now_ms);
+  }
+  response[0] = EMBER_SUCCESS;
+  response[1] = index;
+  response[2] = count;
+  response[3] = query.fields;
+  return (uint16_t)(entry - response);
+}
+
+static uint8_t start_stream(uint8_t id, const uint8_t *request, uint8_t length)
+{
+  if (stream.active) {
+    return APP_HOST_LINK_STATUS_BUSY;
+  }
+  if (length < 3 || request[2] < APP_HOST_LINK_STREAM_MIN_LINE
+      || request[2] > APP_HOST_LINK_STREAM_MAX_LINE) {
+    return APP_HOST_LINK_STATUS_BAD_ARGUMENT;
+  }
+  stream.active = true;
+  stream.id = id;
+  stream.line_count = emberFetchLowHighInt16u(request);
+  stream.line_length = request[2];
+  stream.sequence = 0;
+  stream.bytes = 0;
+  stream.started_ms = halCommonGetInt32uMillisecondTick();
+  emberEventControlSetActive(*host_link_control);
+  return EMBER_SUCCESS;
+}
+
+static void format_stream_line(char *line)
+{
+  uint8_t i;
+
+  snprintf(line, APP_HOST_LINK_STREAM_MIN_LINE + 1,
+           APP_HOST_LINK_STREAM_PREFIX "%04X ", stream.sequence);
+  for (i = APP_HOST_LINK_STREAM_MIN_LINE; i < stream.line_length; i++) {
+    line[i] = (char)('A' + (stream.sequence + i) % 26);
+  }
+  line[stream.line_length] = '\0';
+}
+
+static void send_response(uint16_t length)
+{
+  static const char hex[] = "0123456789ABCDEF";
+  const uint16_t prefix_length = sizeof(RESPONSE_PREFIX) - 1;
+  char *out;
+  uint16_t i;
+
+  emberStoreLowHighInt16u(response_frame + length,
+                          app_host_link_crc(response_frame, length, 0xFFFF));
+  length += APP_HOST_LINK_CRC_LENGTH;
+
+  // Encoded in place in the output ring, byte by byte through printf if the
+  // ring is full or the TX engine did not start.
+  out = (char *)app_uart_tx_reserve(prefix_length + 2 * length + APP_UART_TX_EOL_LENGTH);
+  if (out == NULL) {
+    APP_INFO(RESPONSE_PREFIX);
+    for (i = 0; i < length; i++) {
+      APP_INFO("%02X", response_frame[i]);
+    }
+    APP_INFO("\n");
+    return;
+  }
+  memcpy(out, RESPONSE_PREFIX, prefix_length);
+  for (i = 0; i < length; i++) {
+    out[prefix_length + 2 * i] = hex[response_frame[i] >> 4];
+    out[prefix_length + 2 * i + 1] = hex[response_frame[i] & 0x0F];
+  }
+  memcpy(out + prefix_length + 2 * length, APP_UART_TX_EOL, APP_UART_TX_EOL_LENGTH);
+  app_uart_tx_commit(prefix_length + 2 * length + APP_UART_TX_EOL_LENGTH);
+}
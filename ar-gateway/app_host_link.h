@@ -0,0 +1,134 @@
+/***************************************************************************//**
+ * @file app_host_link.h
+ * @brief app_host_link.h
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+#ifndef APP_HOST_LINK_H
+#define APP_HOST_LINK_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdint.h>
+#include "host-link-config.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Version of the frame layout, returned by APP_HOST_LINK_PING
+#define APP_HOST_LINK_VERSION              (1u)
+
+/// A frame is the request ID, the message type, the payload and the
+/// CRC-16/CCITT (initial value 0xFFFF, little endian) of the preceding bytes.
+/// Requests come as the hex argument of the "hl" CLI command, responses go
+/// out as "#HL <hex>" lines between the other output. A response echoes the
+/// request ID, has APP_HOST_LINK_RESPONSE set in its type and its payload
+/// starts with a status.
+#define APP_HOST_LINK_ID_OFFSET            (0u)
+#define APP_HOST_LINK_TYPE_OFFSET          (1u)
+#define APP_HOST_LINK_PAYLOAD_OFFSET       (2u)
+#define APP_HOST_LINK_CRC_LENGTH           (2u)
+#define APP_HOST_LINK_RESPONSE             (0x80u)
+/// Longest request: "hl {<hex>}" must fit the CLI input buffer
+#define APP_HOST_LINK_MAX_REQUEST_LENGTH   (61u)
+
+/// Link statuses, the other statuses are EmberStatus values
+#define APP_HOST_LINK_STATUS_BAD_FRAME     (0xF0u)
+#define APP_HOST_LINK_STATUS_UNKNOWN_TYPE  (0xF1u)
+#define APP_HOST_LINK_STATUS_BAD_ARGUMENT  (0xF2u)
+#define APP_HOST_LINK_STATUS_BUSY          (0xF3u)
+
+/// Length of a sensor entry of APP_HOST_LINK_SENSORS: entry index (1), node
+/// ID (2), parent ID (2), EUI64 (8, little endian), time since the last
+/// report in ms (4)
+#define APP_HOST_LINK_SENSOR_ENTRY_LENGTH  (17u)
+
+/// Lines of APP_HOST_LINK_STREAM: "#HS <sequence, 4 hex digits> " and filler
+/// up to the requested length
+#define APP_HOST_LINK_STREAM_PREFIX        "#HS "
+#define APP_HOST_LINK_STREAM_MIN_LINE      (9u)
+#define APP_HOST_LINK_STREAM_MAX_LINE      (200u)
+
+/// Message types, multi-byte fields are little endian
+typedef enum {
+  /// Request: any bytes. Response: version, then the request bytes.
+  APP_HOST_LINK_PING        = 0x01,
+  /// Response: network state (1), node type (1), node ID (2), PAN ID (2),
+  /// channel (2), TX power (2), TX options (1), sensors (1), table size (1)
+  APP_HOST_LINK_INFO        = 0x02,
+  /// Request: first entry index (1). Response: next entry index (1, 0xFF
+  /// after the last entry), entry count (1), sensor entries.
+  APP_HOST_LINK_SENSORS     = 0x03,
+  /// Request: destination node ID (2), data. Response: status of the send.
+  APP_HOST_LINK_SEND_DATA   = 0x04,
+  /// Request: duration in s (1, 0xFF unlimited), optional selective join
+  /// payload. Response: status.
+  APP_HOST_LINK_PERMIT_JOIN = 0x05,
+  /// Request: optional flags (1), bit 0 resets the counters afterwards.
+  /// Response: the binary snapshot of app_counters_dump().
+  APP_HOST_LINK_COUNTERS    = 0x06,
+  /// Request: baud rate (4). Response: status, at the current rate. The sink
+  /// switches right after it; the next request at the new rate confirms it
+  /// (see app_serial_request_baud()).
+  APP_HOST_LINK_SET_BAUD    = 0x07,
+  /// Throughput test of the output. Request: line count (2), line length
+  /// (1). Response, once every line is out: line count (2), bytes sent (4),
+  /// duration in ms (4).
+  APP_HOST_LINK_STREAM      = 0x08,
+  /// Filtered sensor table page. Request: cursor (1), page size (1, 0 for
+  /// the most that fit), fields (1, APP_SENSOR_QUERY_FIELD_ flags, 0 for the
+  /// default ones), then the optional filters: silent for more than N s (2),
+  /// RSSI below X dBm (1), parent node ID (2). Response: next cursor (1, 0xFF
+  /// after the last match), entry count (1), fields (1), entries of
+  /// app_sensor_query_encode().
+  APP_HOST_LINK_SENSOR_QUERY = 0x09
+} app_host_link_type_t;
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+/// Stream test event control
+extern EmberEventControl *host_link_control;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Allocates the stream test event.
+ *****************************************************************************/
+void app_host_link_init(void);
+
+/**************************************************************************//**
+ * Checks and serves a request frame, then prints the response line. A frame
+ * too short or with a bad CRC is answered with APP_HOST_LINK_STATUS_BAD_FRAME
+ * if its request ID can be read.
+ *
+ * @param *frame is the request frame
+ * @param length is the length of the frame
+ *****************************************************************************/
+void app_host_link_handle(const uint8_t *frame, uint8_t length);
+
+/**************************************************************************//**
+ * Computes the CRC-16/CCITT of a buffer.
+ *
+ * @param crc is the initial value, 0xFFFF for a frame
+ *****************************************************************************/
+uint16_t app_host_link_crc(const uint8_t *buffer, uint16_t length, uint16_t crc);
+
+/**************************************************************************//**
+ * Event handler that prints the next lines of a stream test.
+ *****************************************************************************/
+void host_link_handler(void);
+
+#endif  // APP_HOST_LINK_H
@@ -0,0 +1,157 @@
+/***************************************************************************//**
+ * @file app_latency.c
+ * @brief app_latency.c
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include PLATFORM_HEADER
+#include "stack/include/ember.h"
+#include "sl_app_common.h"
+#include "app_latency.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Accounts a latency in a histogram.
+ *****************************************************************************/
+static void add(app_latency_histogram_t *histogram, uint32_t latency_ms);
+
+/**************************************************************************//**
+ * Empties a histogram.
+ *****************************************************************************/
+static void reset(app_latency_histogram_t *histogram);
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+/// Histograms of the sensor table entries followed by the global one
+static app_latency_histogram_t histograms[APP_SENSOR_TABLE_SIZE + 1];
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Accounts the latency of a report.
+ *****************************************************************************/
+void app_latency_record(uint8_t index, uint32_t latency_ms)
+{
+  if (index < APP_SENSOR_TABLE_SIZE) {
+    add(&histograms[index], latency_ms);
+  }
+  add(&histograms[APP_LATENCY_GLOBAL], latency_ms);
+}
+
+/**************************************************************************//**
+ * Clears the histogram of a sensor, or every histogram.
+ *****************************************************************************/
+void app_latency_clear(uint8_t index)
+{
+  uint8_t i;
+
+  if (index < APP_SENSOR_TABLE_SIZE) {
+    reset(&histograms[index]);
+  } else {
+    for (i = 0; i <= APP_LATENCY_GLOBAL; i++) {
+      reset(&histograms[i]);
+    }
+  }
+}
+
+/**************************************************************************//**
+ * Returns the histogram of a sensor, or the global one.
+ *****************************************************************************/
+const app_latency_histogram_t *app_latency_get(uint8_t index)
+{
+  if (index > APP_LATENCY_GLOBAL) {
+    return NULL;
+  }
+  return &histograms[index];
+}
+
+/**************************************************************************//**
+ * Estimates a percentile as the upper bound of the bucket it falls in, capped
+ * by the largest latency seen.
+ *****************************************************************************/
+uint32_t app_latency_percentile(const app_latency_histogram_t *histogram,
+                                uint8_t percent)
+{
+  uint32_t rank;
+  uint32_t seen = 0;
+  uint8_t i;
+
+  if (histogram->count == 0) {
+    return 0;
+  }
+  // Bucket counts saturate, rank against their own total.
+  for (i = 0; i < APP_LATENCY_BUCKET_COUNT; i++) {
+    seen += histogram->buckets[i];
+  }
+  rank = (seen * percent + 99) / 100;
+  seen = 0;
+  for (i = 0; i < APP_LATENCY_BUCKET_COUNT - 1; i++) {
+    seen += histogram->buckets[i];
+    if (seen >= rank) {
+      uint32_t upper_ms = (2u << i) - 1;
+      return (upper_ms < histogram->max_ms) ? upper_ms : histogram->max_ms;
+    }
+  }
+  return histogram->max_ms;
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Accounts a latency in a histogram.
+ *****************************************************************************/
+static void add(app_latency_histogram_t *histogram, uint32_t latency_ms)
+{
+  uint8_t bucket = 0;
+
+  while (bucket < APP_LATENCY_BUCKET_COUNT - 1
+         && latency_ms >= (2u << bucket)) {
+    bucket++;
+  }
+  if (histogram->buckets[bucket] < UINT16_MAX) {
+    histogram->buckets[bucket]++;
+  }
+  if (histogram->count == 0 || latency_ms < histogram->min_ms) {
+    histogram->min_ms = latency_ms;
+  }
+  if (latency_ms > histogram->max_ms) {
+    histogram->max_ms = latency_ms;
+  }
+  histogram->count++;
+  histogram->sum_ms += latency_ms;
+}
+
+/**************************************************************************//**
+ * Empties a histogram.
+ *****************************************************************************/
+static void reset(app_latency_histogram_t *histogram)
+{
+  MEMSET(histogram, 0, sizeof(*histogram));
+}
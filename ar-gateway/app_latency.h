@@ -0,0 +1,80 @@
+/***************************************************************************//**
+ * @file app_latency.h
+ * @brief app_latency.h
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+#ifndef APP_LATENCY_H
+#define APP_LATENCY_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include "sensor-table-config.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Number of histogram buckets. Bucket 0 holds latencies below 2 ms, bucket
+/// n latencies in [2^n, 2^(n+1)) ms, the last bucket everything above.
+#define APP_LATENCY_BUCKET_COUNT       (16u)
+
+/// Index of the global histogram for app_latency_get()
+#define APP_LATENCY_GLOBAL             (APP_SENSOR_TABLE_SIZE)
+
+/// Sample to sink latency histogram
+typedef struct {
+  uint16_t buckets[APP_LATENCY_BUCKET_COUNT];
+  uint32_t count;
+  uint32_t min_ms;
+  uint32_t max_ms;
+  uint32_t sum_ms;
+} app_latency_histogram_t;
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Accounts the latency of a report.
+ *
+ * @param index is the index of the sensor in the sensor table
+ * @param latency_ms is the sample to sink latency
+ *****************************************************************************/
+void app_latency_record(uint8_t index, uint32_t latency_ms);
+
+/**************************************************************************//**
+ * Clears the histogram of a sensor, or every histogram for
+ * APP_LATENCY_GLOBAL.
+ *****************************************************************************/
+void app_latency_clear(uint8_t index);
+
+/**************************************************************************//**
+ * Returns the histogram of a sensor, or the global one for
+ * APP_LATENCY_GLOBAL.
+ *****************************************************************************/
+const app_latency_histogram_t *app_latency_get(uint8_t index);
+
+/**************************************************************************//**
+ * Estimates a percentile as the upper bound of the bucket it falls in.
+ *
+ * @param percent is the percentile, e.g. 99
+ * @returns the estimate in ms, 0 for an empty histogram.
+ *****************************************************************************/
+uint32_t app_latency_percentile(const app_latency_histogram_t *histogram,
+                                uint8_t percent);
+
+#endif  // APP_LATENCY_H
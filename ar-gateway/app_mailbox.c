@@ -0,0 +1,355 @@
+/***************************************************************************//**
+ * @file app_mailbox.c
+ * @brief app_mailbox.c
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include PLATFORM_HEADER
+#include "stack/include/ember.h"
+#include "hal/hal.h"
+#include "sl_flex_assert.h"
+#include "sl_app_common.h"
+#include "app_framework_common.h"
+#include "app_protocol.h"
+#include "app_tx_queue.h"
+#include "app_mailbox.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// A command waiting for its sensor to wake up
+typedef struct {
+  uint8_t command_id;
+  uint8_t length;
+  uint8_t payload[APP_MAILBOX_PAYLOAD_SIZE];
+  uint32_t post_ms;
+} mailbox_command_t;
+
+/// Mailbox of a sleepy sensor, free if node_id is EMBER_NULL_NODE_ID
+typedef struct {
+  EmberNodeId node_id;
+  /// Pending commands, oldest first
+  uint8_t count;
+  mailbox_command_t commands[APP_MAILBOX_DEPTH];
+  app_mailbox_stats_t stats;
+} mailbox_t;
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Finds the mailbox of a node.
+ *
+ * @returns the mailbox or NULL.
+ *****************************************************************************/
+static mailbox_t *find(EmberNodeId node_id);
+
+/**************************************************************************//**
+ * Removes a command from a mailbox, keeping the others in order.
+ *****************************************************************************/
+static void remove_command(mailbox_t *mailbox, uint8_t index);
+
+/**************************************************************************//**
+ * Starts the expiry check if any mailbox holds a command.
+ *****************************************************************************/
+static void schedule_sweep(void);
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+/// Mailbox expiry check event control
+EmberEventControl *mailbox_control;
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+/// Mailboxes of the sleepy sensors
+static mailbox_t mailboxes[APP_MAILBOX_COUNT];
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Allocates the expiry check event and empties the mailboxes.
+ *****************************************************************************/
+void app_mailbox_init(void)
+{
+  emberAfAllocateEvent(&mailbox_control, &mailbox_handler);
+  app_mailbox_clear();
+}
+
+/**************************************************************************//**
+ * Forgets every mailbox.
+ *****************************************************************************/
+void app_mailbox_clear(void)
+{
+  uint8_t i;
+  for (i = 0; i < APP_MAILBOX_COUNT; i++) {
+    mailboxes[i].node_id = EMBER_NULL_NODE_ID;
+    mailboxes[i].count = 0;
+  }
+  if (mailbox_control != NULL) {
+    emberEventControlSetInactive(*mailbox_control);
+  }
+}
+
+/**************************************************************************//**
+ * Tracks the node type of a joining child.
+ *****************************************************************************/
+void app_mailbox_child_joined(EmberNodeType node_type, EmberNodeId node_id)
+{
+  mailbox_t *mailbox = find(node_id);
+  uint8_t i;
+
+  if (node_type != EMBER_STAR_SLEEPY_END_DEVICE) {
+    if (mailbox != NULL) {
+      mailbox->node_id = EMBER_NULL_NODE_ID;
+      mailbox->count = 0;
+    }
+    return;
+  }
+  if (mailbox != NULL) {
+    // Rejoin of a known sleepy child, keep its pending commands.
+    return;
+  }
+
+  for (i = 0; i < APP_MAILBOX_COUNT; i++) {
+    if (mailboxes[i].node_id == EMBER_NULL_NODE_ID) {
+      MEMSET(&mailboxes[i], 0, sizeof(mailbox_t));
+      mailboxes[i].node_id = node_id;
+      return;
+    }
+  }
+  APP_INFO("Mailbox: no mailbox left for 0x%04X\n", node_id);
+}
+
+/**************************************************************************//**
+ * Frees the mailbox of a sensor that left the network or timed out.
+ *****************************************************************************/
+void app_mailbox_node_left(EmberNodeId node_id)
+{
+  mailbox_t *mailbox = find(node_id);
+
+  if (mailbox != NULL) {
+    mailbox->node_id = EMBER_NULL_NODE_ID;
+    mailbox->count = 0;
+  }
+}
+
+/**************************************************************************//**
+ * Posts an extended downlink command to a sensor.
+ *****************************************************************************/
+EmberStatus app_mailbox_post(EmberNodeId node_id,
+                             uint8_t command_id,
+                             const uint8_t *payload,
+                             uint8_t length)
+{
+  mailbox_t *mailbox = find(node_id);
+  mailbox_command_t *command = NULL;
+  uint8_t i;
+
+  if (length <= APP_DOWNLINK_FLAGS_OFFSET) {
+    return EMBER_BAD_ARGUMENT;
+  }
+  if (length > APP_MAILBOX_PAYLOAD_SIZE) {
+    return EMBER_MESSAGE_TOO_LONG;
+  }
+  if (mailbox == NULL) {
+    // Not a sleepy child, it can receive right away.
+    return app_tx_queue_send(node_id, command_id, payload, length);
+  }
+
+  mailbox->stats.posted++;
+
+  // The latest command of a type supersedes the pending one.
+  for (i = 0; i < mailbox->count; i++) {
+    if (mailbox->commands[i].command_id == command_id) {
+      mailbox->stats.coalesced++;
+      remove_command(mailbox, i);
+      break;
+    }
+  }
+
+  if (mailbox->count == APP_MAILBOX_DEPTH) {
+    APP_INFO("Mailbox: overflow for 0x%04X, dropped command 0x%02X\n",
+             node_id,
+             mailbox->commands[0].command_id);
+    mailbox->stats.overflowed++;
+    remove_command(mailbox, 0);
+  }
+
+  command = &mailbox->commands[mailbox->count++];
+  command->command_id = command_id;
+  command->length = length;
+  MEMCOPY(command->payload, payload, length);
+  command->post_ms = halCommonGetInt32uMillisecondTick();
+
+  schedule_sweep();
+  return EMBER_SUCCESS;
+}
+
+/**************************************************************************//**
+ * Releases the mailbox of a sensor that is known to be awake.
+ *****************************************************************************/
+void app_mailbox_node_awake(EmberNodeId node_id)
+{
+  mailbox_t *mailbox = find(node_id);
+
+  if (mailbox == NULL) {
+    return;
+  }
+
+  while (mailbox->count > 0) {
+    mailbox_command_t *command = &mailbox->commands[0];
+    EmberStatus status;
+
+    // Keep the sensor polling until it got the last command.
+    if (mailbox->count > 1) {
+      command->payload[APP_DOWNLINK_FLAGS_OFFSET] |= APP_DOWNLINK_FLAG_PENDING;
+    } else {
+      command->payload[APP_DOWNLINK_FLAGS_OFFSET] &= ~APP_DOWNLINK_FLAG_PENDING;
+    }
+
+    status = app_tx_queue_send(node_id,
+                               command->command_id,
+                               command->payload,
+                               command->length);
+    if (status != EMBER_SUCCESS) {
+      // TX queue is full, the rest waits for the next wake up.
+      break;
+    }
+    mailbox->stats.released++;
+    remove_command(mailbox, 0);
+  }
+}
+
+/**************************************************************************//**
+ * Tells whether a sensor has commands waiting in its mailbox.
+ *****************************************************************************/
+bool app_mailbox_is_pending(EmberNodeId node_id)
+{
+  mailbox_t *mailbox = find(node_id);
+  return (mailbox != NULL && mailbox->count > 0);
+}
+
+/**************************************************************************//**
+ * Lists the sensors that have commands waiting in their mailbox.
+ *****************************************************************************/
+uint8_t app_mailbox_get_pending_nodes(EmberNodeId *node_ids, uint8_t max_count)
+{
+  uint8_t count = 0;
+  uint8_t i;
+  for (i = 0; i < APP_MAILBOX_COUNT && count < max_count; i++) {
+    if (mailboxes[i].node_id != EMBER_NULL_NODE_ID && mailboxes[i].count > 0) {
+      node_ids[count++] = mailboxes[i].node_id;
+    }
+  }
+  return count;
+}
+
+/**************************************************************************//**
+ * Reads a mailbox.
+ *****************************************************************************/
+const app_mailbox_stats_t *app_mailbox_get(uint8_t index,
+                                           EmberNodeId *node_id,
+                                           uint8_t *count)
+{
+  if (index >= APP_MAILBOX_COUNT
+      || mailboxes[index].node_id == EMBER_NULL_NODE_ID) {
+    return NULL;
+  }
+  *node_id = mailboxes[index].node_id;
+  *count = mailboxes[index].count;
+  return &mailboxes[index].stats;
+}
+
+/**************************************************************************//**
+ * Event handler that drops the expired commands.
+ *****************************************************************************/
+void mailbox_handler(void)
+{
+  uint32_t now_ms = halCommonGetInt32uMillisecondTick();
+  uint8_t i;
+
+  emberEventControlSetInactive(*mailbox_control);
+
+  for (i = 0; i < APP_MAILBOX_COUNT; i++) {
+    mailbox_t *mailbox = &mailboxes[i];
+    // Commands are kept oldest first, so only the head can expire.
+    while (mailbox->node_id != EMBER_NULL_NODE_ID
+           && mailbox->count > 0
+           && APP_MAILBOX_EXPIRY_MS
+           < elapsedTimeInt32u(mailbox->commands[0].post_ms, now_ms)) {
+      APP_INFO("Mailbox: command 0x%02X for 0x%04X expired\n",
+               mailbox->commands[0].command_id,
+               mailbox->node_id);
+      mailbox->stats.expired++;
+      remove_command(mailbox, 0);
+    }
+  }
+
+  schedule_sweep();
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Finds the mailbox of a node.
+ *****************************************************************************/
+static mailbox_t *find(EmberNodeId node_id)
+{
+  uint8_t i;
+  if (node_id == EMBER_NULL_NODE_ID) {
+    return NULL;
+  }
+  for (i = 0; i < APP_MAILBOX_COUNT; i++) {
+    if (mailboxes[i].node_id == node_id) {
+      return &mailboxes[i];
+    }
+  }
+  return NULL;
+}
+
+/**************************************************************************//**
+ * Removes a command from a mailbox, keeping the others in order.
+ *****************************************************************************/
+static void remove_command(mailbox_t *mailbox, uint8_t index)
+{
+  uint8_t i;
+  for (i = index; i + 1 < mailbox->count; i++) {
+    mailbox->commands[i] = mailbox->commands[i + 1];
+  }
+  mailbox->count--;
+}
+
+/**************************************************************************//**
+ * Starts the expiry check if any mailbox holds a command.
+ *****************************************************************************/
+static void schedule_sweep(void)
+{
+  uint8_t i;
+
+  if (emberEventControlGetActive(*mailbox_control)) {
+    return;
+  }
+  for (i = 0; i < APP_MAILBOX_COUNT; i++) {
+    if (mailboxes[i].node_id != EMBER_NULL_NODE_ID && mailboxes[i].count > 0) {
+      emberEventControlSetDelayMS(*mailbox_control, APP_MAILBOX_SWEEP_PERIOD_MS);
+      return;
+    }
+  }
+}
@@ -0,0 +1,136 @@
+/***************************************************************************//**
+ * @file app_mailbox.h
+ * @brief app_mailbox.h
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+#ifndef APP_MAILBOX_H
+#define APP_MAILBOX_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include "mailbox-config.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Per sensor mailbox metrics
+typedef struct {
+  /// Commands posted to the mailbox
+  uint32_t posted;
+  /// Commands that replaced a pending command of the same type
+  uint32_t coalesced;
+  /// Commands handed to the TX queue
+  uint32_t released;
+  /// Commands dropped after APP_MAILBOX_EXPIRY_MS
+  uint32_t expired;
+  /// Commands dropped because the mailbox was full
+  uint32_t overflowed;
+} app_mailbox_stats_t;
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+/// Mailbox expiry check event control
+extern EmberEventControl *mailbox_control;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Allocates the expiry check event and empties the mailboxes.
+ *****************************************************************************/
+void app_mailbox_init(void);
+
+/**************************************************************************//**
+ * Forgets every mailbox, e.g. when the network goes down.
+ *****************************************************************************/
+void app_mailbox_clear(void);
+
+/**************************************************************************//**
+ * Tracks the node type of a joining child. Sleepy children get a mailbox,
+ * the mailbox of any other node reusing the ID is dropped.
+ *
+ * @param node_type is the type of the child
+ * @param node_id is the node ID of the child
+ *****************************************************************************/
+void app_mailbox_child_joined(EmberNodeType node_type, EmberNodeId node_id);
+
+/**************************************************************************//**
+ * Frees the mailbox of a sensor that left the network or timed out, along
+ * with the commands it still holds.
+ *
+ * @param node_id is the node ID of the sensor
+ *****************************************************************************/
+void app_mailbox_node_left(EmberNodeId node_id);
+
+/**************************************************************************//**
+ * Posts an extended downlink command (see app_protocol.h) to a sensor. The
+ * first byte of the payload holds the downlink flags. Sleepy sensors get the
+ * command in their mailbox, where it replaces any pending command of the same
+ * type. Other nodes get it through the TX queue right away.
+ *
+ * @param node_id is the node ID of the sensor
+ * @param command_id is the extended command ID
+ * @param *payload is the payload of the command, starting with the flags
+ * @param length is the length of the payload
+ * @returns EMBER_SUCCESS if the command is posted or queued,
+ *          EMBER_BAD_ARGUMENT or EMBER_MESSAGE_TOO_LONG for an invalid payload
+ *          or the status of the TX queue.
+ *****************************************************************************/
+EmberStatus app_mailbox_post(EmberNodeId node_id,
+                             uint8_t command_id,
+                             const uint8_t *payload,
+                             uint8_t length);
+
+/**************************************************************************//**
+ * Releases the mailbox of a sensor that is known to be awake, i.e. a frame
+ * was just received from it and it polls its parent shortly after.
+ *
+ * @param node_id is the node ID of the sensor
+ *****************************************************************************/
+void app_mailbox_node_awake(EmberNodeId node_id);
+
+/**************************************************************************//**
+ * Tells whether a sensor has commands waiting in its mailbox.
+ *****************************************************************************/
+bool app_mailbox_is_pending(EmberNodeId node_id);
+
+/**************************************************************************//**
+ * Lists the sensors that have commands waiting in their mailbox.
+ *
+ * @param *node_ids is filled with the node IDs
+ * @param max_count is the capacity of node_ids
+ * @returns the number of node IDs written.
+ *****************************************************************************/
+uint8_t app_mailbox_get_pending_nodes(EmberNodeId *node_ids, uint8_t max_count);
+
+/**************************************************************************//**
+ * Reads a mailbox.
+ *
+ * @param index is the index of the mailbox, below APP_MAILBOX_COUNT
+ * @param *node_id is set to the owner of the mailbox
+ * @param *count is set to the number of pending commands
+ * @returns the metrics of the mailbox or NULL if the mailbox is not in use.
+ *****************************************************************************/
+const app_mailbox_stats_t *app_mailbox_get(uint8_t index,
+                                           EmberNodeId *node_id,
+                                           uint8_t *count);
+
+/**************************************************************************//**
+ * Event handler that drops the expired commands.
+ *****************************************************************************/
+void mailbox_handler(void);
+
+#endif  // APP_MAILBOX_H
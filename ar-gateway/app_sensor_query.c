@@ -0,0 +1,336 @@
+/***************************************************************************//**
+ * @file app_sensor_query.c
+ * @brief app_sensor_query.c
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdio.h>
+#include <string.h>
+#include PLATFORM_HEADER
+#include "stack/include/ember.h"
+#include "hal/hal.h"
+#include "sl_app_common.h"
+#include "app_framework_common.h"
+#include "app_sensor_table.h"
+#include "app_uart_tx.h"
+#include "app_sensor_query.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Checks an entry in use against the filters.
+ *****************************************************************************/
+static bool matches(const app_sensor_query_filter_t *filter,
+                    uint8_t index,
+                    uint32_t now_ms);
+
+/**************************************************************************//**
+ * Prints the line after the last row of the CLI query.
+ *
+ * @param next is the cursor of the next page or APP_SENSOR_TABLE_INVALID_INDEX
+ *****************************************************************************/
+static void print_summary(uint8_t next);
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+/// CLI query event control
+EmberEventControl *sensor_query_control;
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+/// CLI query being printed
+static struct {
+  bool active;
+  app_sensor_query_t query;
+  /// Entry index to look at next
+  uint16_t index;
+  /// Rows printed
+  uint8_t count;
+} cli_query;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Allocates the CLI query event.
+ *****************************************************************************/
+void app_sensor_query_init(void)
+{
+  emberAfAllocateEvent(&sensor_query_control, &sensor_query_handler);
+  cli_query.active = false;
+}
+
+/**************************************************************************//**
+ * Sets a query to its defaults.
+ *****************************************************************************/
+void app_sensor_query_set_defaults(app_sensor_query_t *query)
+{
+  query->filter.stale_s = 0;
+  query->filter.rssi_below = 0;
+  query->filter.parent_id = EMBER_NULL_NODE_ID;
+  query->fields = APP_SENSOR_QUERY_FIELD_DEFAULT;
+  query->cursor = 0;
+  query->limit = 0;
+}
+
+/**************************************************************************//**
+ * Finds the next entry that passes the filters.
+ *****************************************************************************/
+uint8_t app_sensor_query_next(const app_sensor_query_filter_t *filter,
+                              uint16_t from,
+                              uint32_t now_ms)
+{
+  uint16_t i;
+
+  for (i = from; i < APP_SENSOR_TABLE_SIZE; i++) {
+    if (sensor_hot.node_id[i] != EMBER_NULL_NODE_ID
+        && matches(filter, (uint8_t)i, now_ms)) {
+      return (uint8_t)i;
+    }
+  }
+  return APP_SENSOR_TABLE_INVALID_INDEX;
+}
+
+/**************************************************************************//**
+ * Returns the length of a binary entry with the given fields.
+ *****************************************************************************/
+uint8_t app_sensor_query_entry_length(uint8_t fields)
+{
+  uint8_t length = 1;
+
+  length += (fields & APP_SENSOR_QUERY_FIELD_NODE_ID) ? 2 : 0;
+  length += (fields & APP_SENSOR_QUERY_FIELD_EUI64) ? EUI64_SIZE : 0;
+  length += (fields & APP_SENSOR_QUERY_FIELD_PARENT) ? 2 : 0;
+  length += (fields & APP_SENSOR_QUERY_FIELD_AGE) ? 4 : 0;
+  length += (fields & APP_SENSOR_QUERY_FIELD_RSSI) ? 1 : 0;
+  length += (fields & APP_SENSOR_QUERY_FIELD_DATA) ? SENSOR_SINK_DATA_LENGTH : 0;
+  return length;
+}
+
+/**************************************************************************//**
+ * Encodes the binary entry of a sensor.
+ *****************************************************************************/
+uint8_t app_sensor_query_encode(uint8_t index,
+                                uint8_t fields,
+                                uint32_t now_ms,
+                                uint8_t *out)
+{
+  uint8_t *entry = out;
+  const uint8_t *data;
+  uint8_t data_length;
+
+  *entry++ = index;
+  if (fields & APP_SENSOR_QUERY_FIELD_NODE_ID) {
+    emberStoreLowHighInt16u(entry, sensor_hot.node_id[index]);
+    entry += 2;
+  }
+  if (fields & APP_SENSOR_QUERY_FIELD_EUI64) {
+    memcpy(entry, sensor_cold.node_eui64[index], EUI64_SIZE);
+    entry += EUI64_SIZE;
+  }
+  if (fields & APP_SENSOR_QUERY_FIELD_PARENT) {
+    emberStoreLowHighInt16u(entry, sensor_cold.parent_id[index]);
+    entry += 2;
+  }
+  if (fields & APP_SENSOR_QUERY_FIELD_AGE) {
+    emberStoreLowHighInt32u(entry,
+                            elapsedTimeInt32u(sensor_hot.last_report_ms[index], now_ms));
+    entry += 4;
+  }
+  if (fields & APP_SENSOR_QUERY_FIELD_RSSI) {
+    *entry++ = (uint8_t)sensor_cold.last_rssi[index];
+  }
+  if (fields & APP_SENSOR_QUERY_FIELD_DATA) {
+    data = app_sensor_table_get_report(index, 0, &data_length);
+    if (data != NULL && data_length >= SENSOR_SINK_DATA_LENGTH) {
+      memcpy(entry, data, SENSOR_SINK_DATA_LENGTH);
+    } else {
+      memset(entry, 0, SENSOR_SINK_DATA_LENGTH);
+    }
+    entry += SENSOR_SINK_DATA_LENGTH;
+  }
+  return (uint8_t)(entry - out);
+}
+
+/**************************************************************************//**
+ * Formats the text row of a sensor.
+ *****************************************************************************/
+uint16_t app_sensor_query_format(uint8_t index,
+                                 uint8_t fields,
+                                 uint32_t now_ms,
+                                 char *out)
+{
+  const uint8_t *eui64 = sensor_cold.node_eui64[index];
+  const uint8_t *data;
+  uint8_t data_length;
+  int length;
+
+  length = snprintf(out, APP_SENSOR_QUERY_LINE_SIZE, "entry:%d", (uint16_t)index);
+  if (fields & APP_SENSOR_QUERY_FIELD_NODE_ID) {
+    length += snprintf(out + length, APP_SENSOR_QUERY_LINE_SIZE - length,
+                       " id:0x%04X", sensor_hot.node_id[index]);
+  }
+  if (fields & APP_SENSOR_QUERY_FIELD_EUI64) {
+    length += snprintf(out + length, APP_SENSOR_QUERY_LINE_SIZE - length,
+                       " eui64:%02X%02X%02X%02X%02X%02X%02X%02X",
+                       eui64[7], eui64[6], eui64[5], eui64[4],
+                       eui64[3], eui64[2], eui64[1], eui64[0]);
+  }
+  if (fields & APP_SENSOR_QUERY_FIELD_PARENT) {
+    length += snprintf(out + length, APP_SENSOR_QUERY_LINE_SIZE - length,
+                       " parent:0x%04X", sensor_cold.parent_id[index]);
+  }
+  if (fields & APP_SENSOR_QUERY_FIELD_AGE) {
+    length += snprintf(out + length, APP_SENSOR_QUERY_LINE_SIZE - length,
+                       " age:%lu",
+                       elapsedTimeInt32u(sensor_hot.last_report_ms[index], now_ms));
+  }
+  if (fields & APP_SENSOR_QUERY_FIELD_RSSI) {
+    if (sensor_cold.last_rssi[index] == APP_SENSOR_TABLE_RSSI_UNKNOWN) {
+      length += snprintf(out + length, APP_SENSOR_QUERY_LINE_SIZE - length, " rssi:-");
+    } else {
+      length += snprintf(out + length, APP_SENSOR_QUERY_LINE_SIZE - length,
+                         " rssi:%d", (int16_t)sensor_cold.last_rssi[index]);
+    }
+  }
+  if (fields & APP_SENSOR_QUERY_FIELD_DATA) {
+    data = app_sensor_table_get_report(index, 0, &data_length);
+    if (data != NULL && data_length >= SENSOR_SINK_DATA_LENGTH) {
+      length += snprintf(out + length, APP_SENSOR_QUERY_LINE_SIZE - length,
+                         " data:%ld,%lu",
+                         (int32_t)emberFetchLowHighInt32u(data),
+                         emberFetchLowHighInt32u(data + 4));
+    } else {
+      length += snprintf(out + length, APP_SENSOR_QUERY_LINE_SIZE - length, " data:-");
+    }
+  }
+  return (uint16_t)length;
+}
+
+/**************************************************************************//**
+ * Starts printing the results of a query from the CLI query event.
+ *****************************************************************************/
+EmberStatus app_sensor_query_start(const app_sensor_query_t *query)
+{
+  if (cli_query.active) {
+    return EMBER_INVALID_CALL;
+  }
+  cli_query.active = true;
+  cli_query.query = *query;
+  cli_query.index = query->cursor;
+  cli_query.count = 0;
+  APP_INFO("### Sensors table ###\n");
+  emberEventControlSetActive(*sensor_query_control);
+  return EMBER_SUCCESS;
+}
+
+/**************************************************************************//**
+ * Event handler that prints the next rows of the CLI query.
+ *****************************************************************************/
+void sensor_query_handler(void)
+{
+  uint32_t now_ms = halCommonGetInt32uMillisecondTick();
+  char line[APP_SENSOR_QUERY_LINE_SIZE];
+  uint8_t rows;
+  uint8_t index;
+  uint16_t length;
+  char *out;
+
+  emberEventControlSetInactive(*sensor_query_control);
+  if (!cli_query.active) {
+    return;
+  }
+  for (rows = 0; rows < APP_SENSOR_QUERY_ROWS_PER_EVENT; rows++) {
+    index = app_sensor_query_next(&cli_query.query.filter, cli_query.index, now_ms);
+    if (index == APP_SENSOR_TABLE_INVALID_INDEX
+        || (cli_query.query.limit != 0 && cli_query.count >= cli_query.query.limit)) {
+      cli_query.active = false;
+      print_summary(index);
+      return;
+    }
+    // Formatted in place in the output ring, or printed if the TX engine
+    // did not start.
+    out = (char *)app_uart_tx_reserve(APP_SENSOR_QUERY_LINE_SIZE + APP_UART_TX_EOL_LENGTH);
+    if (out == NULL && !app_uart_tx_is_idle()) {
+      // The ring is full, LDMA sends it meanwhile.
+      emberEventControlSetDelayMS(*sensor_query_control, 1);
+      return;
+    }
+    if (out != NULL) {
+      length = app_sensor_query_format(index, cli_query.query.fields, now_ms, out);
+      memcpy(out + length, APP_UART_TX_EOL, APP_UART_TX_EOL_LENGTH);
+      app_uart_tx_commit(length + APP_UART_TX_EOL_LENGTH);
+    } else {
+      app_sensor_query_format(index, cli_query.query.fields, now_ms, line);
+      APP_INFO("%s\n", line);
+    }
+    cli_query.index = (uint16_t)index + 1;
+    cli_query.count++;
+  }
+  // The stack runs before the next rows.
+  emberEventControlSetActive(*sensor_query_control);
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+static bool matches(const app_sensor_query_filter_t *filter,
+                    uint8_t index,
+                    uint32_t now_ms)
+{
+  EmberNodeId parent_id;
+  int8_t rssi;
+
+  if (filter->stale_s != 0
+      && elapsedTimeInt32u(sensor_hot.last_report_ms[index], now_ms)
+      <= (uint32_t)filter->stale_s * MILLISECOND_TICKS_PER_SECOND) {
+    return false;
+  }
+  if (filter->rssi_below != 0) {
+    rssi = sensor_cold.last_rssi[index];
+    if (rssi == APP_SENSOR_TABLE_RSSI_UNKNOWN || rssi >= filter->rssi_below) {
+      return false;
+    }
+  }
+  if (filter->parent_id != EMBER_NULL_NODE_ID) {
+    // Sensors attached to the sink have no parent in the table.
+    parent_id = sensor_cold.parent_id[index];
+    if (parent_id == EMBER_NULL_NODE_ID) {
+      parent_id = emberGetNodeId();
+    }
+    if (parent_id != filter->parent_id) {
+      return false;
+    }
+  }
+  return true;
+}
+
+static void print_summary(uint8_t next)
+{
+  if (next == APP_SENSOR_TABLE_INVALID_INDEX) {
+    APP_INFO("sensors:%d next:end\n", (uint16_t)cli_query.count);
+  } else {
+    APP_INFO("sensors:%d next:%d\n", (uint16_t)cli_query.count, (uint16_t)next);
+  }
+}
@@ -0,0 +1,149 @@
+/***************************************************************************//**
+ * @file app_sensor_query.h
+ * @brief app_sensor_query.h
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+#ifndef APP_SENSOR_QUERY_H
+#define APP_SENSOR_QUERY_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include "sensor-query-config.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Fields of a result. A binary entry is the entry index followed by the
+/// selected fields in this order, multi-byte fields little endian.
+/// Node ID (2)
+#define APP_SENSOR_QUERY_FIELD_NODE_ID     (0x01u)
+/// EUI64 (8)
+#define APP_SENSOR_QUERY_FIELD_EUI64       (0x02u)
+/// Parent node ID (2), EMBER_NULL_NODE_ID when attached to the sink
+#define APP_SENSOR_QUERY_FIELD_PARENT      (0x04u)
+/// Time since the last report in ms (4)
+#define APP_SENSOR_QUERY_FIELD_AGE         (0x08u)
+/// RSSI of the last message in dBm (1), APP_SENSOR_TABLE_RSSI_UNKNOWN if none
+#define APP_SENSOR_QUERY_FIELD_RSSI        (0x10u)
+/// Latest report, temperature and humidity (8), zeros if none
+#define APP_SENSOR_QUERY_FIELD_DATA        (0x20u)
+#define APP_SENSOR_QUERY_FIELD_ALL         (0x3Fu)
+#define APP_SENSOR_QUERY_FIELD_DEFAULT                                   \
+  (APP_SENSOR_QUERY_FIELD_NODE_ID | APP_SENSOR_QUERY_FIELD_EUI64         \
+   | APP_SENSOR_QUERY_FIELD_PARENT | APP_SENSOR_QUERY_FIELD_AGE          \
+   | APP_SENSOR_QUERY_FIELD_RSSI)
+
+/// Longest binary entry, every field selected
+#define APP_SENSOR_QUERY_MAX_ENTRY_LENGTH  (1u + 2u + 8u + 2u + 4u + 1u + 8u)
+/// Longest text row, every field selected, with the terminating NUL
+#define APP_SENSOR_QUERY_LINE_SIZE         (112u)
+
+/// Filters of a query, an entry has to pass all of them. The default values
+/// disable them.
+typedef struct {
+  /// Silent for more than stale_s seconds, 0 for any
+  uint16_t stale_s;
+  /// Last RSSI below rssi_below dBm, 0 for any
+  int8_t rssi_below;
+  /// Behind the range extender parent_id, the node ID of the sink for the
+  /// sensors attached to it, EMBER_NULL_NODE_ID for any
+  EmberNodeId parent_id;
+} app_sensor_query_filter_t;
+
+typedef struct {
+  app_sensor_query_filter_t filter;
+  /// APP_SENSOR_QUERY_FIELD_ flags
+  uint8_t fields;
+  /// Entry index the query starts from, the next cursor of the previous page
+  uint8_t cursor;
+  /// Maximum number of results, 0 for the whole table
+  uint8_t limit;
+} app_sensor_query_t;
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+/// CLI query event control
+extern EmberEventControl *sensor_query_control;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Allocates the CLI query event.
+ *****************************************************************************/
+void app_sensor_query_init(void);
+
+/**************************************************************************//**
+ * Sets a query to its defaults: the whole table, every filter disabled and
+ * the default fields.
+ *****************************************************************************/
+void app_sensor_query_set_defaults(app_sensor_query_t *query);
+
+/**************************************************************************//**
+ * Finds the next entry that passes the filters.
+ *
+ * @param from is the first entry index to look at
+ * @param now_ms is the current millisecond tick
+ * @returns the index of the entry or APP_SENSOR_TABLE_INVALID_INDEX.
+ *****************************************************************************/
+uint8_t app_sensor_query_next(const app_sensor_query_filter_t *filter,
+                              uint16_t from,
+                              uint32_t now_ms);
+
+/**************************************************************************//**
+ * Returns the length of a binary entry with the given fields.
+ *****************************************************************************/
+uint8_t app_sensor_query_entry_length(uint8_t fields);
+
+/**************************************************************************//**
+ * Encodes the binary entry of a sensor.
+ *
+ * @param *out receives app_sensor_query_entry_length(fields) bytes
+ * @returns the length of the entry.
+ *****************************************************************************/
+uint8_t app_sensor_query_encode(uint8_t index,
+                                uint8_t fields,
+                                uint32_t now_ms,
+                                uint8_t *out);
+
+/**************************************************************************//**
+ * Formats the text row of a sensor, "entry:<index>" and a "<name>:<value>"
+ * pair per field, without line ending.
+ *
+ * @param *out receives up to APP_SENSOR_QUERY_LINE_SIZE characters, the
+ *        terminating NUL included
+ * @returns the length of the row.
+ *****************************************************************************/
+uint16_t app_sensor_query_format(uint8_t index,
+                                 uint8_t fields,
+                                 uint32_t now_ms,
+                                 char *out);
+
+/**************************************************************************//**
+ * Starts printing the results of a query from the CLI query event, a few
+ * rows per run. The last row is followed by "sensors:<count> next:<cursor>",
+ * the cursor of the next page or "end".
+ *
+ * @returns EMBER_SUCCESS, or EMBER_INVALID_CALL while a query is printed.
+ *****************************************************************************/
+EmberStatus app_sensor_query_start(const app_sensor_query_t *query);
+
+/**************************************************************************//**
+ * Event handler that prints the next rows of the CLI query.
+ *****************************************************************************/
+void sensor_query_handler(void);
+
+#endif  // APP_SENSOR_QUERY_H
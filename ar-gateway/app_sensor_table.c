@@ -0,0 +1,206 @@
+/***************************************************************************//**
+ * @file app_sensor_table.c
+ * @brief app_sensor_table.c
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include PLATFORM_HEADER
+#include "stack/include/ember.h"
+#include "hal/hal.h"
+#include "sl_app_common.h"
+#include "app_sensor_table.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+/// Sensor table, hot and cold fields
+app_sensor_table_hot_t sensor_hot;
+app_sensor_table_cold_t sensor_cold;
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Frees every entry.
+ *****************************************************************************/
+void app_sensor_table_init(void)
+{
+  uint8_t i;
+
+  for (i = 0; i < APP_SENSOR_TABLE_SIZE; i++) {
+    app_sensor_table_remove(i);
+  }
+}
+
+/**************************************************************************//**
+ * Looks up an entry by node ID, only the hot node ID array is read.
+ * EMBER_NULL_NODE_ID finds the first free entry.
+ *****************************************************************************/
+uint8_t app_sensor_table_find_node(EmberNodeId node_id)
+{
+  uint8_t i;
+
+  for (i = 0; i < APP_SENSOR_TABLE_SIZE; i++) {
+    if (sensor_hot.node_id[i] == node_id) {
+      return i;
+    }
+  }
+  return APP_SENSOR_TABLE_INVALID_INDEX;
+}
+
+/**************************************************************************//**
+ * Looks up an entry by EUI64.
+ *****************************************************************************/
+uint8_t app_sensor_table_find_eui64(const uint8_t *eui64)
+{
+  uint8_t i;
+
+  for (i = 0; i < APP_SENSOR_TABLE_SIZE; i++) {
+    if (sensor_hot.node_id[i] != EMBER_NULL_NODE_ID
+        && MEMCOMPARE(sensor_cold.node_eui64[i], eui64, EUI64_SIZE) == 0) {
+      return i;
+    }
+  }
+  return APP_SENSOR_TABLE_INVALID_INDEX;
+}
+
+/**************************************************************************//**
+ * Returns the entry of a sensor, allocating a free one if needed.
+ *****************************************************************************/
+uint8_t app_sensor_table_add(EmberNodeId node_id,
+                             const uint8_t *eui64,
+                             bool *added)
+{
+  uint8_t index = app_sensor_table_find_eui64(eui64);
+
+  *added = false;
+  if (index == APP_SENSOR_TABLE_INVALID_INDEX) {
+    index = app_sensor_table_find_node(EMBER_NULL_NODE_ID);
+    if (index == APP_SENSOR_TABLE_INVALID_INDEX) {
+      return APP_SENSOR_TABLE_INVALID_INDEX;
+    }
+    MEMCOPY(sensor_cold.node_eui64[index], eui64, EUI64_SIZE);
+    sensor_cold.parent_id[index] = EMBER_NULL_NODE_ID;
+    sensor_cold.last_rssi[index] = APP_SENSOR_TABLE_RSSI_UNKNOWN;
+    sensor_cold.history_head[index] = 0;
+    sensor_cold.history_count[index] = 0;
+    *added = true;
+  }
+  sensor_hot.node_id[index] = node_id;
+  sensor_hot.last_report_ms[index] = halCommonGetInt32uMillisecondTick();
+  return index;
+}
+
+/**************************************************************************//**
+ * Frees an entry.
+ *****************************************************************************/
+void app_sensor_table_remove(uint8_t index)
+{
+  if (index < APP_SENSOR_TABLE_SIZE) {
+    sensor_hot.node_id[index] = EMBER_NULL_NODE_ID;
+    sensor_cold.history_count[index] = 0;
+  }
+}
+
+/**************************************************************************//**
+ * Stores a report in the history of an entry.
+ *****************************************************************************/
+void app_sensor_table_store_report(uint8_t index,
+                                   const uint8_t *data,
+                                   uint8_t length)
+{
+  uint8_t slot;
+
+  if (index >= APP_SENSOR_TABLE_SIZE) {
+    return;
+  }
+  if (length > SENSOR_SINK_DATA_LENGTH) {
+    length = SENSOR_SINK_DATA_LENGTH;
+  }
+
+  slot = sensor_cold.history_head[index];
+  if (sensor_cold.history_count[index] > 0) {
+    slot = (slot + 1) % APP_SENSOR_TABLE_HISTORY_DEPTH;
+  }
+  if (sensor_cold.history_count[index] < APP_SENSOR_TABLE_HISTORY_DEPTH) {
+    sensor_cold.history_count[index]++;
+  }
+  sensor_cold.history_head[index] = slot;
+  MEMCOPY(sensor_cold.reported_data[index][slot], data, length);
+  sensor_cold.reported_data_length[index][slot] = length;
+  sensor_hot.last_report_ms[index] = halCommonGetInt32uMillisecondTick();
+}
+
+/**************************************************************************//**
+ * Returns a report from the history of an entry, 0 is the latest one.
+ *****************************************************************************/
+const uint8_t *app_sensor_table_get_report(uint8_t index,
+                                           uint8_t age,
+                                           uint8_t *length)
+{
+  uint8_t slot;
+
+  if (index >= APP_SENSOR_TABLE_SIZE
+      || sensor_hot.node_id[index] == EMBER_NULL_NODE_ID
+      || age >= sensor_cold.history_count[index]) {
+    return NULL;
+  }
+  slot = (sensor_cold.history_head[index] + APP_SENSOR_TABLE_HISTORY_DEPTH - age)
+         % APP_SENSOR_TABLE_HISTORY_DEPTH;
+  *length = sensor_cold.reported_data_length[index][slot];
+  return sensor_cold.reported_data[index][slot];
+}
+
+/**************************************************************************//**
+ * Frees the entries that have not reported for longer than the timeout. Only
+ * the hot arrays are read.
+ *****************************************************************************/
+uint8_t app_sensor_table_sweep(uint32_t now_ms,
+                               uint32_t timeout_ms,
+                               app_sensor_table_timeout_cb_t on_timeout)
+{
+  uint8_t removed = 0;
+  uint8_t i;
+
+  for (i = 0; i < APP_SENSOR_TABLE_SIZE; i++) {
+    if (sensor_hot.node_id[i] != EMBER_NULL_NODE_ID
+        && elapsedTimeInt32u(sensor_hot.last_report_ms[i], now_ms) > timeout_ms) {
+      if (on_timeout != NULL) {
+        on_timeout(i);
+      }
+      app_sensor_table_remove(i);
+      removed++;
+    }
+  }
+  return removed;
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
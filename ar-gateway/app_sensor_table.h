@@ -0,0 +1,147 @@
+/***************************************************************************//**
+ * @file app_sensor_table.h
+ * @brief app_sensor_table.h
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+#ifndef APP_SENSOR_TABLE_H
+#define APP_SENSOR_TABLE_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include "sensor-table-config.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Index returned when no entry matches
+#define APP_SENSOR_TABLE_INVALID_INDEX (0xFFu)
+/// RSSI of an entry not heard since it was added
+#define APP_SENSOR_TABLE_RSSI_UNKNOWN  (INT8_MAX)
+
+/// Descriptor of the sensor table, X(type, name, dimensions) per field. Every
+/// field is an array of APP_SENSOR_TABLE_SIZE elements, followed by the
+/// per-entry dimensions. The hot fields are the ones read by the lookups and
+/// the timeout sweep, they stay packed together away from the cold ones.
+#define APP_SENSOR_TABLE_HOT_FIELDS(X)                                     \
+  X(EmberNodeId, node_id, )                                                \
+  X(uint32_t, last_report_ms, )
+
+#define APP_SENSOR_TABLE_COLD_FIELDS(X)                                    \
+  X(uint8_t, node_eui64, [EUI64_SIZE])                                     \
+  X(EmberNodeId, parent_id, )                                              \
+  X(int8_t, last_rssi, )                                                   \
+  X(uint8_t, history_head, )                                               \
+  X(uint8_t, history_count, )                                              \
+  X(uint8_t, reported_data_length, [APP_SENSOR_TABLE_HISTORY_DEPTH])       \
+  X(uint8_t, reported_data, [APP_SENSOR_TABLE_HISTORY_DEPTH][SENSOR_SINK_DATA_LENGTH])
+
+#define APP_SENSOR_TABLE_FIELD(type, name, dimensions) \
+  type name[APP_SENSOR_TABLE_SIZE] dimensions;
+
+/// Fields read on every lookup and sweep
+typedef struct {
+  APP_SENSOR_TABLE_HOT_FIELDS(APP_SENSOR_TABLE_FIELD)
+} app_sensor_table_hot_t;
+
+/// Fields only read once the entry is found
+typedef struct {
+  APP_SENSOR_TABLE_COLD_FIELDS(APP_SENSOR_TABLE_FIELD)
+} app_sensor_table_cold_t;
+
+/// Called by the timeout sweep before an entry is freed
+typedef void (*app_sensor_table_timeout_cb_t)(uint8_t index);
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+/// Sensor table, an entry is free when its node ID is EMBER_NULL_NODE_ID
+extern app_sensor_table_hot_t sensor_hot;
+extern app_sensor_table_cold_t sensor_cold;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Frees every entry.
+ *****************************************************************************/
+void app_sensor_table_init(void);
+
+/**************************************************************************//**
+ * Looks up an entry by node ID. EMBER_NULL_NODE_ID finds the first free
+ * entry.
+ *
+ * @returns the index of the entry or APP_SENSOR_TABLE_INVALID_INDEX.
+ *****************************************************************************/
+uint8_t app_sensor_table_find_node(EmberNodeId node_id);
+
+/**************************************************************************//**
+ * Looks up an entry by EUI64.
+ *
+ * @returns the index of the entry or APP_SENSOR_TABLE_INVALID_INDEX.
+ *****************************************************************************/
+uint8_t app_sensor_table_find_eui64(const uint8_t *eui64);
+
+/**************************************************************************//**
+ * Returns the entry of a sensor, allocating a free one if the EUI64 is not in
+ * the table yet. A new entry starts with an empty history.
+ *
+ * @param node_id is the node ID of the sensor
+ * @param *eui64 is the EUI64 of the sensor
+ * @param *added is set to true if the entry was allocated
+ * @returns the index of the entry or APP_SENSOR_TABLE_INVALID_INDEX if the
+ *          table is full.
+ *****************************************************************************/
+uint8_t app_sensor_table_add(EmberNodeId node_id,
+                             const uint8_t *eui64,
+                             bool *added);
+
+/**************************************************************************//**
+ * Frees an entry.
+ *****************************************************************************/
+void app_sensor_table_remove(uint8_t index);
+
+/**************************************************************************//**
+ * Stores a report in the history of an entry and refreshes its last report
+ * time. Data beyond SENSOR_SINK_DATA_LENGTH is dropped.
+ *****************************************************************************/
+void app_sensor_table_store_report(uint8_t index,
+                                   const uint8_t *data,
+                                   uint8_t length);
+
+/**************************************************************************//**
+ * Returns a report from the history of an entry.
+ *
+ * @param index is the index of the entry
+ * @param age is the age of the report, 0 is the latest one
+ * @param *length receives the length of the report
+ * @returns the report or NULL if the history is not that deep.
+ *****************************************************************************/
+const uint8_t *app_sensor_table_get_report(uint8_t index,
+                                           uint8_t age,
+                                           uint8_t *length);
+
+/**************************************************************************//**
+ * Frees the entries that have not reported for longer than the timeout.
+ *
+ * @param now_ms is the current millisecond tick
+ * @param timeout_ms is the report timeout
+ * @param on_timeout is called before every freed entry, it may be NULL
+ * @returns the number of freed entries.
+ *****************************************************************************/
+uint8_t app_sensor_table_sweep(uint32_t now_ms,
+                               uint32_t timeout_ms,
+                               app_sensor_table_timeout_cb_t on_timeout);
+
+#endif  // APP_SENSOR_TABLE_H
@@ -0,0 +1,154 @@
+/***************************************************************************//**
+ * @file app_serial.c
+ * @brief app_serial.c
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include PLATFORM_HEADER
+#include "stack/include/ember.h"
+#include "hal/hal.h"
+#include "em_usart.h"
+#include "sl_app_common.h"
+#include "app_framework_common.h"
+#include "sl_iostream_usart_vcom_config.h"
+#include "app_uart_tx.h"
+#include "app_serial.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Waits for the last byte to leave the USART, then applies the baud rate.
+ *****************************************************************************/
+static void apply_baud(uint32_t baud);
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+/// Baud rate switch event control
+EmberEventControl *serial_control;
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+/// Rates reached within 2 % from a 38.4 MHz HFPERCLK with 16x oversampling
+static const uint32_t supported_bauds[] = {
+  9600, 19200, 38400, 57600, 115200, 230400, 460800, 921600, 1000000, 2000000
+};
+static uint32_t current_baud = SL_IOSTREAM_USART_VCOM_BAUDRATE;
+static uint32_t previous_baud = SL_IOSTREAM_USART_VCOM_BAUDRATE;
+static uint32_t requested_baud = SL_IOSTREAM_USART_VCOM_BAUDRATE;
+static app_serial_state_t state = APP_SERIAL_IDLE;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Allocates the baud rate switch event.
+ *****************************************************************************/
+void app_serial_init(void)
+{
+  emberAfAllocateEvent(&serial_control, &serial_handler);
+}
+
+/**************************************************************************//**
+ * Schedules a baud rate change of the VCOM USART.
+ *****************************************************************************/
+EmberStatus app_serial_request_baud(uint32_t baud)
+{
+  uint8_t i;
+
+  if (state != APP_SERIAL_IDLE) {
+    return EMBER_INVALID_CALL;
+  }
+  for (i = 0; i < sizeof(supported_bauds) / sizeof(supported_bauds[0]); i++) {
+    if (supported_bauds[i] == baud) {
+      requested_baud = baud;
+      state = APP_SERIAL_SWITCHING;
+      emberEventControlSetActive(*serial_control);
+      return EMBER_SUCCESS;
+    }
+  }
+  return EMBER_BAD_ARGUMENT;
+}
+
+/**************************************************************************//**
+ * Confirms that the host talks at the new rate.
+ *****************************************************************************/
+void app_serial_confirm(void)
+{
+  if (state == APP_SERIAL_CONFIRMING) {
+    emberEventControlSetInactive(*serial_control);
+    state = APP_SERIAL_IDLE;
+  }
+}
+
+/**************************************************************************//**
+ * Returns the current baud rate.
+ *****************************************************************************/
+uint32_t app_serial_get_baud(void)
+{
+  return current_baud;
+}
+
+/**************************************************************************//**
+ * Returns the state of the baud rate change.
+ *****************************************************************************/
+app_serial_state_t app_serial_get_state(void)
+{
+  return state;
+}
+
+/**************************************************************************//**
+ * Event handler that switches the baud rate, or restores the previous one.
+ *****************************************************************************/
+void serial_handler(void)
+{
+  emberEventControlSetInactive(*serial_control);
+  // The output ring goes out at the rate it was written for, e.g. the answer
+  // to the request. Going back, the host does not read it anyway.
+  if (state == APP_SERIAL_SWITCHING && !app_uart_tx_is_idle()) {
+    emberEventControlSetDelayMS(*serial_control, 1);
+    return;
+  }
+  if (state == APP_SERIAL_SWITCHING) {
+    previous_baud = current_baud;
+    apply_baud(requested_baud);
+    state = APP_SERIAL_CONFIRMING;
+    emberEventControlSetDelayMS(*serial_control, APP_SERIAL_BAUD_CONFIRM_MS);
+  } else if (state == APP_SERIAL_CONFIRMING) {
+    apply_baud(previous_baud);
+    state = APP_SERIAL_IDLE;
+    APP_INFO("Baud rate not confirmed, back to %lu\n", current_baud);
+  }
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+static void apply_baud(uint32_t baud)
+{
+  // Only the shift register may still be busy.
+  while ((USART_StatusGet(SL_IOSTREAM_USART_VCOM_PERIPHERAL) & USART_STATUS_TXC) == 0) {
+  }
+  USART_BaudrateAsyncSet(SL_IOSTREAM_USART_VCOM_PERIPHERAL, 0, baud, usartOVS16);
+  current_baud = baud;
+}
@@ -0,0 +1,86 @@
+/***************************************************************************//**
+ * @file app_serial.h
+ * @brief app_serial.h
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+#ifndef APP_SERIAL_H
+#define APP_SERIAL_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include "serial-config.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// State of a baud rate change
+typedef enum {
+  APP_SERIAL_IDLE       = 0,
+  /// Switching once the pending output is out
+  APP_SERIAL_SWITCHING  = 1,
+  /// Running at the new rate, waiting for the host to confirm it
+  APP_SERIAL_CONFIRMING = 2
+} app_serial_state_t;
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+/// Baud rate switch event control
+extern EmberEventControl *serial_control;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Allocates the baud rate switch event.
+ *****************************************************************************/
+void app_serial_init(void);
+
+/**************************************************************************//**
+ * Schedules a baud rate change of the VCOM USART. The change happens from
+ * the event, after the answer to the request went out at the current rate.
+ * The host has APP_SERIAL_BAUD_CONFIRM_MS to confirm the new rate, otherwise
+ * the previous one is restored.
+ *
+ * @param baud is one of 9600, 19200, 38400, 57600, 115200, 230400, 460800,
+ *        921600, 1000000 and 2000000
+ * @returns EMBER_SUCCESS, EMBER_BAD_ARGUMENT for another rate or
+ *          EMBER_INVALID_CALL while a change is in progress.
+ *****************************************************************************/
+EmberStatus app_serial_request_baud(uint32_t baud);
+
+/**************************************************************************//**
+ * Confirms that the host talks at the new rate. Called for every request of
+ * the host, it does nothing unless a change waits for confirmation.
+ *****************************************************************************/
+void app_serial_confirm(void);
+
+/**************************************************************************//**
+ * Returns the current baud rate.
+ *****************************************************************************/
+uint32_t app_serial_get_baud(void);
+
+/**************************************************************************//**
+ * Returns the state of the baud rate change.
+ *****************************************************************************/
+app_serial_state_t app_serial_get_state(void);
+
+/**************************************************************************//**
+ * Event handler that switches the baud rate, or restores the previous one
+ * when the host did not confirm in time.
+ *****************************************************************************/
+void serial_handler(void);
+
+#endif  // APP_SERIAL_H
@@ -0,0 +1,334 @@
+/***************************************************************************//**
+ * @file app_topology.c
+ * @brief app_topology.c
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include PLATFORM_HEADER
+#include "stack/include/ember.h"
+#include "hal/hal.h"
+#include "sl_app_common.h"
+#include "app_protocol.h"
+#include "app_tx_queue.h"
+#include "app_sensor_table.h"
+#include "app_topology.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+_Static_assert(APP_PERMIT_JOIN_PAYLOAD_OFFSET + APP_PERMIT_JOIN_MAX_PAYLOAD_LENGTH
+               <= APP_PAYLOAD_MAX_LENGTH,
+               "the PERMIT_JOIN command exceeds the app frame maximum");
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Tells whether load a / capacity a is below load b / capacity b.
+ *****************************************************************************/
+static bool less_loaded(uint8_t load_a, uint8_t capacity_a,
+                        uint8_t load_b, uint8_t capacity_b);
+
+/**************************************************************************//**
+ * Returns the index of a range extender or APP_TOPOLOGY_MAX_EXTENDERS.
+ *****************************************************************************/
+static uint8_t find_extender(EmberNodeId node_id);
+
+/**************************************************************************//**
+ * Forgets an extender not heard for longer than
+ * APP_TOPOLOGY_EXTENDER_TIMEOUT_MS.
+ *
+ * @returns true if the extender is still known.
+ *****************************************************************************/
+static bool check_alive(uint8_t index, uint32_t now_ms);
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+/// Node IDs of the known range extenders, EMBER_NULL_NODE_ID when free
+static EmberNodeId extenders[APP_TOPOLOGY_MAX_EXTENDERS];
+/// When each extender was last heard from
+static uint32_t last_heard_ms[APP_TOPOLOGY_MAX_EXTENDERS];
+/// Failed transmissions to each extender since it was last heard from
+static uint8_t tx_failures[APP_TOPOLOGY_MAX_EXTENDERS];
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Forgets every range extender.
+ *****************************************************************************/
+void app_topology_init(void)
+{
+  uint8_t i;
+
+  for (i = 0; i < APP_TOPOLOGY_MAX_EXTENDERS; i++) {
+    extenders[i] = EMBER_NULL_NODE_ID;
+  }
+}
+
+/**************************************************************************//**
+ * Records a range extender.
+ *****************************************************************************/
+bool app_topology_note_extender(EmberNodeId node_id)
+{
+  uint8_t free_index = APP_TOPOLOGY_MAX_EXTENDERS;
+  uint8_t i;
+
+  for (i = 0; i < APP_TOPOLOGY_MAX_EXTENDERS; i++) {
+    if (extenders[i] == node_id) {
+      free_index = i;
+      break;
+    }
+    if (extenders[i] == EMBER_NULL_NODE_ID && free_index == APP_TOPOLOGY_MAX_EXTENDERS) {
+      free_index = i;
+    }
+  }
+  if (free_index == APP_TOPOLOGY_MAX_EXTENDERS) {
+    return false;
+  }
+  extenders[free_index] = node_id;
+  last_heard_ms[free_index] = halCommonGetInt32uMillisecondTick();
+  tx_failures[free_index] = 0;
+  return true;
+}
+
+/**************************************************************************//**
+ * Forgets a range extender.
+ *****************************************************************************/
+void app_topology_forget_extender(EmberNodeId node_id)
+{
+  uint8_t index = find_extender(node_id);
+
+  if (index < APP_TOPOLOGY_MAX_EXTENDERS) {
+    APP_INFO("Topology: range extender 0x%04X forgotten\n", node_id);
+    extenders[index] = EMBER_NULL_NODE_ID;
+  }
+}
+
+/**************************************************************************//**
+ * Notes that a node was heard from.
+ *****************************************************************************/
+void app_topology_note_heard(EmberNodeId node_id)
+{
+  uint8_t index = find_extender(node_id);
+
+  if (index < APP_TOPOLOGY_MAX_EXTENDERS) {
+    last_heard_ms[index] = halCommonGetInt32uMillisecondTick();
+    tx_failures[index] = 0;
+  }
+}
+
+/**************************************************************************//**
+ * Notes the outcome of a transmission to a node.
+ *****************************************************************************/
+void app_topology_note_tx(EmberNodeId destination, EmberStatus status)
+{
+  uint8_t index = find_extender(destination);
+
+  if (index >= APP_TOPOLOGY_MAX_EXTENDERS) {
+    return;
+  }
+  if (status == EMBER_SUCCESS) {
+    app_topology_note_heard(destination);
+  } else if (++tx_failures[index] >= APP_TOPOLOGY_EXTENDER_MAX_TX_FAILURES) {
+    app_topology_forget_extender(destination);
+  }
+}
+
+/**************************************************************************//**
+ * Records the parent reported by a sensor.
+ *****************************************************************************/
+void app_topology_note_parent(uint8_t index, EmberNodeId parent_id)
+{
+  if (index >= APP_SENSOR_TABLE_SIZE) {
+    return;
+  }
+  sensor_cold.parent_id[index] = parent_id;
+  if (parent_id != EMBER_NULL_NODE_ID && parent_id != emberGetNodeId()) {
+    app_topology_note_extender(parent_id);
+  }
+}
+
+/**************************************************************************//**
+ * Returns a range extender and the number of paired sensors behind it.
+ *****************************************************************************/
+bool app_topology_get_extender(uint8_t index,
+                               EmberNodeId *node_id,
+                               uint8_t *sensor_count)
+{
+  if (index >= APP_TOPOLOGY_MAX_EXTENDERS
+      || !check_alive(index, halCommonGetInt32uMillisecondTick())) {
+    return false;
+  }
+  *node_id = extenders[index];
+  *sensor_count = app_topology_count_sensors(extenders[index]);
+  return true;
+}
+
+/**************************************************************************//**
+ * Returns the number of paired sensors behind a parent.
+ *****************************************************************************/
+uint8_t app_topology_count_sensors(EmberNodeId parent_id)
+{
+  bool sink = (parent_id == emberGetNodeId());
+  uint8_t count = 0;
+  uint8_t i;
+
+  for (i = 0; i < APP_SENSOR_TABLE_SIZE; i++) {
+    EmberNodeId parent;
+    if (sensor_hot.node_id[i] == EMBER_NULL_NODE_ID) {
+      continue;
+    }
+    parent = sensor_cold.parent_id[i];
+    if (parent == parent_id || (sink && parent == EMBER_NULL_NODE_ID)) {
+      count++;
+    }
+  }
+  return count;
+}
+
+/**************************************************************************//**
+ * Picks the parent with the lowest load relative to its capacity.
+ *****************************************************************************/
+EmberNodeId app_topology_select_parent(void)
+{
+  EmberNodeId best = EMBER_NULL_NODE_ID;
+  uint8_t best_load = 0;
+  uint8_t best_capacity = 1;
+  uint8_t load = app_topology_count_sensors(emberGetNodeId());
+  uint32_t now_ms = halCommonGetInt32uMillisecondTick();
+  uint8_t i;
+
+  // Dead extenders neither take joins nor count against the sink.
+  for (i = 0; i < APP_TOPOLOGY_MAX_EXTENDERS; i++) {
+    if (check_alive(i, now_ms)) {
+      load++;
+    }
+  }
+  if (load < APP_TOPOLOGY_SINK_CAPACITY) {
+    best = emberGetNodeId();
+    best_load = load;
+    best_capacity = APP_TOPOLOGY_SINK_CAPACITY;
+  }
+
+  for (i = 0; i < APP_TOPOLOGY_MAX_EXTENDERS; i++) {
+    if (extenders[i] == EMBER_NULL_NODE_ID) {
+      continue;
+    }
+    load = app_topology_count_sensors(extenders[i]);
+    if (load < APP_TOPOLOGY_EXTENDER_CAPACITY
+        && (best == EMBER_NULL_NODE_ID
+            || less_loaded(load, APP_TOPOLOGY_EXTENDER_CAPACITY,
+                           best_load, best_capacity))) {
+      best = extenders[i];
+      best_load = load;
+      best_capacity = APP_TOPOLOGY_EXTENDER_CAPACITY;
+    }
+  }
+  return best;
+}
+
+/**************************************************************************//**
+ * Opens joining on the least loaded parent only.
+ *****************************************************************************/
+EmberStatus app_topology_permit_joining(uint8_t duration,
+                                        const uint8_t *payload,
+                                        uint8_t payload_length,
+                                        EmberNodeId *parent_id)
+{
+  uint8_t command[APP_PERMIT_JOIN_PAYLOAD_OFFSET + APP_PERMIT_JOIN_MAX_PAYLOAD_LENGTH];
+
+  *parent_id = app_topology_select_parent();
+  if (*parent_id == EMBER_NULL_NODE_ID) {
+    return EMBER_TABLE_FULL;
+  }
+  if (payload_length > APP_PERMIT_JOIN_MAX_PAYLOAD_LENGTH) {
+    return EMBER_BAD_ARGUMENT;
+  }
+
+  if (*parent_id == emberGetNodeId()) {
+    if (payload_length > 0) {
+      emberSetSelectiveJoinPayload(payload_length, (uint8_t *)payload);
+    } else {
+      emberClearSelectiveJoinPayload();
+    }
+    return emberPermitJoining(duration);
+  }
+
+  emberPermitJoining(0);
+  command[APP_DOWNLINK_FLAGS_OFFSET] = 0;
+  command[APP_PERMIT_JOIN_DURATION_OFFSET] = duration;
+  if (payload_length > 0) {
+    MEMCOPY(command + APP_PERMIT_JOIN_PAYLOAD_OFFSET, payload, payload_length);
+  }
+  return app_tx_queue_send(*parent_id,
+                           APP_COMMAND_ID_PERMIT_JOIN,
+                           command,
+                           APP_PERMIT_JOIN_PAYLOAD_OFFSET + payload_length);
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Tells whether load a / capacity a is below load b / capacity b.
+ *****************************************************************************/
+static bool less_loaded(uint8_t load_a, uint8_t capacity_a,
+                        uint8_t load_b, uint8_t capacity_b)
+{
+  return (uint16_t)load_a * capacity_b < (uint16_t)load_b * capacity_a;
+}
+
+/**************************************************************************//**
+ * Returns the index of a range extender or APP_TOPOLOGY_MAX_EXTENDERS.
+ *****************************************************************************/
+static uint8_t find_extender(EmberNodeId node_id)
+{
+  uint8_t i;
+
+  if (node_id == EMBER_NULL_NODE_ID) {
+    return APP_TOPOLOGY_MAX_EXTENDERS;
+  }
+  for (i = 0; i < APP_TOPOLOGY_MAX_EXTENDERS; i++) {
+    if (extenders[i] == node_id) {
+      return i;
+    }
+  }
+  return APP_TOPOLOGY_MAX_EXTENDERS;
+}
+
+/**************************************************************************//**
+ * Forgets an extender not heard for longer than
+ * APP_TOPOLOGY_EXTENDER_TIMEOUT_MS.
+ *****************************************************************************/
+static bool check_alive(uint8_t index, uint32_t now_ms)
+{
+  if (extenders[index] == EMBER_NULL_NODE_ID) {
+    return false;
+  }
+#if APP_TOPOLOGY_EXTENDER_TIMEOUT_MS > 0
+  if (elapsedTimeInt32u(last_heard_ms[index], now_ms) > APP_TOPOLOGY_EXTENDER_TIMEOUT_MS) {
+    APP_INFO("Topology: range extender 0x%04X silent\n", extenders[index]);
+    extenders[index] = EMBER_NULL_NODE_ID;
+    return false;
+  }
+#else
+  (void) now_ms;
+#endif
+  return true;
+}
@@ -0,0 +1,120 @@
+/***************************************************************************//**
+ * @file app_topology.h
+ * @brief app_topology.h
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+#ifndef APP_TOPOLOGY_H
+#define APP_TOPOLOGY_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include "topology-config.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Forgets every range extender. The parents of the sensors are kept in the
+ * sensor table.
+ *****************************************************************************/
+void app_topology_init(void);
+
+/**************************************************************************//**
+ * Records a range extender, e.g. when it joins the sink. A known extender
+ * counts as heard from.
+ *
+ * @returns false if the extender table is full.
+ *****************************************************************************/
+bool app_topology_note_extender(EmberNodeId node_id);
+
+/**************************************************************************//**
+ * Forgets a range extender, e.g. when it is removed from the child table.
+ *****************************************************************************/
+void app_topology_forget_extender(EmberNodeId node_id);
+
+/**************************************************************************//**
+ * Notes that a node was heard from. An extender not heard from for longer
+ * than APP_TOPOLOGY_EXTENDER_TIMEOUT_MS is forgotten.
+ *****************************************************************************/
+void app_topology_note_heard(EmberNodeId node_id);
+
+/**************************************************************************//**
+ * Notes the outcome of a transmission to a node. A delivery counts as heard
+ * from, an extender is forgotten after APP_TOPOLOGY_EXTENDER_MAX_TX_FAILURES
+ * failures in a row.
+ *****************************************************************************/
+void app_topology_note_tx(EmberNodeId destination, EmberStatus status);
+
+/**************************************************************************//**
+ * Records the parent reported by a sensor. A parent other than the sink is
+ * recorded as a range extender and counts as heard from.
+ *
+ * @param index is the index of the sensor in the sensor table
+ * @param parent_id is the node ID of its parent
+ *****************************************************************************/
+void app_topology_note_parent(uint8_t index, EmberNodeId parent_id);
+
+/**************************************************************************//**
+ * Returns a range extender and the number of paired sensors behind it. A
+ * silent extender is forgotten first.
+ *
+ * @param index is the index in the extender table
+ * @param *node_id receives the node ID of the extender
+ * @param *sensor_count receives the number of sensors it parents
+ * @returns false if there is no such extender.
+ *****************************************************************************/
+bool app_topology_get_extender(uint8_t index,
+                               EmberNodeId *node_id,
+                               uint8_t *sensor_count);
+
+/**************************************************************************//**
+ * Returns the number of paired sensors behind a parent. Sensors that did not
+ * report their parent yet count as children of the sink.
+ *****************************************************************************/
+uint8_t app_topology_count_sensors(EmberNodeId parent_id);
+
+/**************************************************************************//**
+ * Picks the parent with the lowest load relative to its capacity, the sink
+ * on a tie. The children of the sink include the extenders. Silent
+ * extenders are forgotten first and never picked.
+ *
+ * @returns the node ID of the sink or of an extender, EMBER_NULL_NODE_ID if
+ *          every parent is full.
+ *****************************************************************************/
+EmberNodeId app_topology_select_parent(void);
+
+/**************************************************************************//**
+ * Opens joining on the least loaded parent only. The sink permits joining
+ * itself or commands the chosen extender to, and closes its own joining in
+ * the latter case.
+ *
+ * @param duration is the duration in s, 0xFF for unlimited
+ * @param *payload is the selective join payload, NULL for none
+ * @param payload_length is the length of the selective join payload
+ * @param *parent_id receives the chosen parent
+ * @returns EMBER_SUCCESS, EMBER_TABLE_FULL if every parent is full,
+ *          EMBER_BAD_ARGUMENT if the payload is too long or the
+ *          status of the permit join or of the queued command.
+ *****************************************************************************/
+EmberStatus app_topology_permit_joining(uint8_t duration,
+                                        const uint8_t *payload,
+                                        uint8_t payload_length,
+                                        EmberNodeId *parent_id);
+
+#endif  // APP_TOPOLOGY_H
@@ -0,0 +1,530 @@
+/***************************************************************************//**
+ * @file app_tx_queue.c
+ * @brief app_tx_queue.c
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include PLATFORM_HEADER
+#include "stack/include/ember.h"
+#include "hal/hal.h"
+#include "sl_flex_assert.h"
+#include "sl_app_common.h"
+#include "app_framework_common.h"
+#include "app_protocol.h"
+#include "app_channel_map.h"
+#include "app_trace.h"
+#include "app_memory.h"
+#include "app_tx_queue.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Message tags of the queued frames: the flag marks them, the rest is the
+/// index of the entry.
+#define TX_QUEUE_TAG_FLAG       (0x80u)
+#define TX_QUEUE_TAG_INDEX_MASK (0x7Fu)
+/// No entry selected
+#define TX_QUEUE_NO_ENTRY       (0xFFu)
+
+#if (APP_TX_QUEUE_SIZE > TX_QUEUE_TAG_INDEX_MASK)
+  #error "APP_TX_QUEUE_SIZE does not fit in the message tag"
+#endif
+
+_Static_assert(APP_FRAME_MAX_LENGTH <= EMBER_MAX_SECURED_APPLICATION_PAYLOAD_LENGTH,
+               "APP_FRAME_MAX_LENGTH exceeds the secured payload of the stack");
+
+/// States of a queue entry
+typedef enum {
+  TX_ENTRY_FREE,
+  TX_ENTRY_QUEUED,
+  TX_ENTRY_IN_FLIGHT
+} tx_entry_state_t;
+
+/// A frame waiting in the queue
+typedef struct {
+  uint8_t frame[APP_FRAME_MAX_LENGTH];
+  EmberMessageLength length;
+  EmberNodeId destination;
+  uint8_t priority;
+  uint8_t state;
+  uint8_t attempts;
+  /// Radio channel of the last attempt, when it was handed to the stack
+  uint16_t channel;
+  /// Arrival order, used to serve the oldest frame first
+  uint32_t sequence;
+  uint32_t enqueue_ms;
+  /// Backoff before the entry becomes eligible again
+  uint32_t retry_start_ms;
+  uint32_t retry_delay_ms;
+} tx_entry_t;
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Selects the next frame to hand to the stack.
+ *
+ * @param now_ms is the current time
+ * @param *wait_ms is lowered to the remaining backoff of the entries that are
+ *        not eligible yet
+ * @returns the index of the entry or TX_QUEUE_NO_ENTRY
+ *****************************************************************************/
+static uint8_t select_next(uint32_t now_ms, uint32_t *wait_ms);
+
+/**************************************************************************//**
+ * Hands an entry to the stack.
+ *
+ * @returns false if the stack refused the frame, which is then queued for a
+ *          retry or dropped.
+ *****************************************************************************/
+static bool dispatch(uint8_t index);
+
+/**************************************************************************//**
+ * Schedules another attempt of a failed entry or drops it.
+ *****************************************************************************/
+static void retry_or_drop(uint8_t index, EmberStatus status);
+
+/**************************************************************************//**
+ * Releases an entry.
+ *****************************************************************************/
+static void release(uint8_t index);
+
+/**************************************************************************//**
+ * Tells whether a frame to the destination is already handed to the stack.
+ *****************************************************************************/
+static bool destination_in_flight(EmberNodeId destination);
+
+/**************************************************************************//**
+ * Tells whether a failed transmission is worth another attempt.
+ *****************************************************************************/
+static bool is_retryable(EmberStatus status);
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+/// TX queue scheduler event control
+EmberEventControl *tx_queue_control;
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+/// Queue entries
+static tx_entry_t entries[APP_TX_QUEUE_SIZE];
+/// Number of entries handed to the stack
+static uint8_t in_flight;
+/// Arrival counter of the entries
+static uint32_t next_sequence;
+/// Destination served last, for the round robin between destinations
+static EmberNodeId last_destination = EMBER_NULL_NODE_ID;
+/// Queue metrics
+static app_tx_queue_stats_t stats;
+/// Frame under construction by app_tx_queue_send()
+static uint8_t message[APP_FRAME_MAX_LENGTH];
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Allocates the scheduler event and empties the queue.
+ *****************************************************************************/
+void app_tx_queue_init(void)
+{
+  emberAfAllocateEvent(&tx_queue_control, &tx_queue_handler);
+  app_tx_queue_flush();
+  app_tx_queue_reset_stats();
+}
+
+/**************************************************************************//**
+ * Drops every queued frame.
+ *****************************************************************************/
+void app_tx_queue_flush(void)
+{
+  uint8_t i;
+  for (i = 0; i < APP_TX_QUEUE_SIZE; i++) {
+    entries[i].state = TX_ENTRY_FREE;
+  }
+  in_flight = 0;
+  stats.depth = 0;
+  last_destination = EMBER_NULL_NODE_ID;
+  if (tx_queue_control != NULL) {
+    emberEventControlSetInactive(*tx_queue_control);
+  }
+}
+
+/**************************************************************************//**
+ * Builds a sensor/sink frame and queues it.
+ *****************************************************************************/
+EmberStatus app_tx_queue_send(EmberNodeId destination,
+                              uint8_t command_id,
+                              const uint8_t *buffer,
+                              uint8_t buffer_length)
+{
+  EmberMessageLength message_length = 0;
+  app_tx_priority_t priority;
+
+  if (buffer_length > APP_PAYLOAD_MAX_LENGTH) {
+    return EMBER_MESSAGE_TOO_LONG;
+  }
+
+  switch (command_id) {
+    case SENSOR_SINK_COMMAND_ID_PAIR_CONFIRM:
+      priority = APP_TX_PRIORITY_PAIR_CONFIRM;
+      break;
+    case SENSOR_SINK_COMMAND_ID_ADVERTISE:
+      priority = APP_TX_PRIORITY_ADVERTISE;
+      break;
+    default:
+      priority = APP_TX_PRIORITY_CONFIG;
+      break;
+  }
+
+  emberStoreLowHighInt16u(message + message_length, SENSOR_SINK_PROTOCOL_ID);
+  message_length += 2;
+  message[message_length++] = command_id;
+  MEMCOPY(message + message_length, emberGetEui64(), EUI64_SIZE);
+  message_length += EUI64_SIZE;
+  emberStoreLowHighInt16u(message + message_length, emberGetNodeId());
+  message_length += 2;
+  if (buffer_length != 0) {
+    MEMCOPY(message + message_length, buffer, buffer_length);
+    message_length += buffer_length;
+  }
+  return app_tx_queue_enqueue(destination, priority, message, message_length);
+}
+
+/**************************************************************************//**
+ * Queues a frame for transmission.
+ *****************************************************************************/
+EmberStatus app_tx_queue_enqueue(EmberNodeId destination,
+                                 app_tx_priority_t priority,
+                                 const uint8_t *frame,
+                                 uint8_t length)
+{
+  uint8_t i;
+
+  if (length > APP_FRAME_MAX_LENGTH || priority >= APP_TX_PRIORITY_COUNT) {
+    return EMBER_MESSAGE_TOO_LONG;
+  }
+
+  for (i = 0; i < APP_TX_QUEUE_SIZE; i++) {
+    if (entries[i].state == TX_ENTRY_FREE) {
+      break;
+    }
+  }
+  if (i == APP_TX_QUEUE_SIZE) {
+    stats.dropped_overflow++;
+    return EMBER_TABLE_FULL;
+  }
+
+  MEMCOPY(entries[i].frame, frame, length);
+  entries[i].length = length;
+  entries[i].destination = destination;
+  entries[i].priority = priority;
+  entries[i].state = TX_ENTRY_QUEUED;
+  entries[i].attempts = 0;
+  entries[i].sequence = next_sequence++;
+  entries[i].enqueue_ms = halCommonGetInt32uMillisecondTick();
+  entries[i].retry_start_ms = entries[i].enqueue_ms;
+  entries[i].retry_delay_ms = 0;
+
+  stats.enqueued[priority]++;
+  stats.depth++;
+  if (stats.depth > stats.peak_depth) {
+    stats.peak_depth = stats.depth;
+  }
+
+  emberEventControlSetActive(*tx_queue_control);
+  return EMBER_SUCCESS;
+}
+
+/**************************************************************************//**
+ * Feeds the queue with the outcome of a transmission.
+ *****************************************************************************/
+bool app_tx_queue_message_sent(EmberStatus status,
+                               EmberOutgoingMessage *message)
+{
+  uint8_t index;
+
+  if ((message->tag & TX_QUEUE_TAG_FLAG) == 0) {
+    return false;
+  }
+  index = message->tag & TX_QUEUE_TAG_INDEX_MASK;
+  if (index >= APP_TX_QUEUE_SIZE
+      || entries[index].state != TX_ENTRY_IN_FLIGHT
+      || entries[index].destination != message->destination) {
+    return false;
+  }
+
+  in_flight--;
+  app_channel_map_note_tx(entries[index].channel, status);
+  if (status == EMBER_SUCCESS) {
+    uint32_t latency_ms = elapsedTimeInt32u(entries[index].enqueue_ms,
+                                            halCommonGetInt32uMillisecondTick());
+    stats.delivered[entries[index].priority]++;
+    stats.latency_sum_ms += latency_ms;
+    if (latency_ms < stats.latency_min_ms) {
+      stats.latency_min_ms = latency_ms;
+    }
+    if (latency_ms > stats.latency_max_ms) {
+      stats.latency_max_ms = latency_ms;
+    }
+    release(index);
+  } else {
+    retry_or_drop(index, status);
+  }
+
+  // A slot of the MAC queue is free again.
+  emberEventControlSetActive(*tx_queue_control);
+  return true;
+}
+
+/**************************************************************************//**
+ * Event handler that hands the next eligible frames to the stack.
+ *****************************************************************************/
+void tx_queue_handler(void)
+{
+  uint32_t wait_ms = UINT32_MAX;
+  uint8_t index;
+
+  emberEventControlSetInactive(*tx_queue_control);
+  app_trace_record(APP_TRACE_EVENT, APP_TRACE_EVENT_TX_QUEUE, 0);
+
+  if (!emberStackIsUp()) {
+    return;
+  }
+
+  if (app_channel_map_current_excluded()) {
+    // Hold the frames until the radio hops to a usable channel.
+    emberEventControlSetDelayMS(*tx_queue_control, APP_CHANNEL_MAP_RECHECK_MS);
+    return;
+  }
+
+  while (in_flight < APP_TX_QUEUE_MAX_IN_FLIGHT) {
+    // A refused frame restarts its backoff from a fresh tick, the selection
+    // must not run on an older one.
+    index = select_next(halCommonGetInt32uMillisecondTick(), &wait_ms);
+    if (index == TX_QUEUE_NO_ENTRY) {
+      break;
+    }
+    if (!dispatch(index) && entries[index].state == TX_ENTRY_QUEUED) {
+      // Refused for a lack of buffers or MAC queue slots, the other frames
+      // would be refused too. Come back after the backoff of the refused
+      // one, or at the next sent callback.
+      if (entries[index].retry_delay_ms < wait_ms) {
+        wait_ms = entries[index].retry_delay_ms;
+      }
+      break;
+    }
+  }
+
+  // Entries blocked by a full MAC queue are woken up by the sent callback,
+  // only the backoff needs a timer.
+  if (wait_ms != UINT32_MAX) {
+    emberEventControlSetDelayMS(*tx_queue_control, wait_ms);
+  }
+}
+
+/**************************************************************************//**
+ * Returns the metrics of the queue.
+ *****************************************************************************/
+const app_tx_queue_stats_t *app_tx_queue_get_stats(void)
+{
+  return &stats;
+}
+
+/**************************************************************************//**
+ * Clears the metrics of the queue, except the current depth.
+ *****************************************************************************/
+void app_tx_queue_reset_stats(void)
+{
+  uint8_t depth = stats.depth;
+  MEMSET(&stats, 0, sizeof(stats));
+  stats.depth = depth;
+  stats.peak_depth = depth;
+  stats.latency_min_ms = UINT32_MAX;
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Strict priority between the classes. Inside a class the destinations are
+ * served round robin, in ascending node ID order starting after the last
+ * served one, and the oldest frame of the chosen destination goes first.
+ * Only one frame per destination is handed to the stack at a time.
+ *****************************************************************************/
+static uint8_t select_next(uint32_t now_ms, uint32_t *wait_ms)
+{
+  uint8_t priority;
+  uint8_t i;
+
+  for (priority = 0; priority < APP_TX_PRIORITY_COUNT; priority++) {
+    uint8_t selected = TX_QUEUE_NO_ENTRY;
+    bool selected_after_last = false;
+
+    for (i = 0; i < APP_TX_QUEUE_SIZE; i++) {
+      tx_entry_t *entry = &entries[i];
+      uint32_t elapsed_ms;
+      bool after_last;
+
+      if (entry->state != TX_ENTRY_QUEUED || entry->priority != priority) {
+        continue;
+      }
+      elapsed_ms = elapsedTimeInt32u(entry->retry_start_ms, now_ms);
+      if (elapsed_ms < entry->retry_delay_ms) {
+        if (entry->retry_delay_ms - elapsed_ms < *wait_ms) {
+          *wait_ms = entry->retry_delay_ms - elapsed_ms;
+        }
+        continue;
+      }
+      if (destination_in_flight(entry->destination)) {
+        continue;
+      }
+
+      after_last = (last_destination == EMBER_NULL_NODE_ID
+                    || entry->destination > last_destination);
+      if (selected == TX_QUEUE_NO_ENTRY
+          || (after_last && !selected_after_last)
+          || (after_last == selected_after_last
+              && (entry->destination < entries[selected].destination
+                  || (entry->destination == entries[selected].destination
+                      && entry->sequence < entries[selected].sequence)))) {
+        selected = i;
+        selected_after_last = after_last;
+      }
+    }
+
+    if (selected != TX_QUEUE_NO_ENTRY) {
+      return selected;
+    }
+  }
+
+  return TX_QUEUE_NO_ENTRY;
+}
+
+/**************************************************************************//**
+ * Hands an entry to the stack.
+ *****************************************************************************/
+static bool dispatch(uint8_t index)
+{
+  tx_entry_t *entry = &entries[index];
+  EmberStatus status;
+
+  entry->attempts++;
+  entry->channel = emberGetRadioChannel();
+  // The time beacon leading an advertisement carries the time it is handed
+  // to the stack, not the time it was queued: advertisements are the lowest
+  // class and may wait behind the other frames and for their own backoff.
+  if (entry->length >= SENSOR_SINK_DATA_OFFSET + APP_TLV_VALUE_OFFSET + APP_TIME_LENGTH
+      && entry->frame[SENSOR_SINK_COMMAND_ID_OFFSET] == SENSOR_SINK_COMMAND_ID_ADVERTISE
+      && entry->frame[SENSOR_SINK_DATA_OFFSET + APP_TLV_TYPE_OFFSET] == APP_ADVERTISE_TLV_TIME
+      && entry->frame[SENSOR_SINK_DATA_OFFSET + APP_TLV_LENGTH_OFFSET] == APP_TIME_LENGTH) {
+    emberStoreLowHighInt32u(entry->frame + SENSOR_SINK_DATA_OFFSET + APP_TLV_VALUE_OFFSET,
+                            halCommonGetInt32uMillisecondTick());
+  }
+  status = emberMessageSend(entry->destination,
+                            0, // endpoint
+                            TX_QUEUE_TAG_FLAG | index,
+                            entry->length,
+                            entry->frame,
+                            tx_options);
+  last_destination = entry->destination;
+
+  if (status == EMBER_SUCCESS) {
+    // The stack holds its copy of the frame until the completion.
+    app_memory_sample();
+    entry->state = TX_ENTRY_IN_FLIGHT;
+    in_flight++;
+    app_trace_record(APP_TRACE_TX,
+                     (entry->length > SENSOR_SINK_COMMAND_ID_OFFSET)
+                     ? entry->frame[SENSOR_SINK_COMMAND_ID_OFFSET] : 0xFF,
+                     entry->destination);
+    return true;
+  }
+  app_channel_map_note_tx(entry->channel, status);
+  retry_or_drop(index, status);
+  return false;
+}
+
+/**************************************************************************//**
+ * Schedules another attempt of a failed entry or drops it.
+ *****************************************************************************/
+static void retry_or_drop(uint8_t index, EmberStatus status)
+{
+  tx_entry_t *entry = &entries[index];
+
+  if (is_retryable(status) && entry->attempts < APP_TX_QUEUE_MAX_ATTEMPTS) {
+    uint32_t delay_ms = (uint32_t)APP_TX_QUEUE_BACKOFF_BASE_MS << (entry->attempts - 1);
+    if (delay_ms > APP_TX_QUEUE_BACKOFF_MAX_MS) {
+      delay_ms = APP_TX_QUEUE_BACKOFF_MAX_MS;
+    }
+    // Random jitter keeps retries to different destinations apart.
+    delay_ms += halCommonGetRandom() % (delay_ms + 1);
+
+    entry->state = TX_ENTRY_QUEUED;
+    entry->retry_start_ms = halCommonGetInt32uMillisecondTick();
+    entry->retry_delay_ms = delay_ms;
+    stats.retries++;
+  } else {
+    APP_INFO("TX queue: dropped frame to 0x%04X after %d attempt(s): 0x%02X\n",
+             entry->destination,
+             entry->attempts,
+             status);
+    stats.dropped_failed++;
+    release(index);
+  }
+}
+
+/**************************************************************************//**
+ * Releases an entry.
+ *****************************************************************************/
+static void release(uint8_t index)
+{
+  entries[index].state = TX_ENTRY_FREE;
+  stats.depth--;
+}
+
+/**************************************************************************//**
+ * Tells whether a frame to the destination is already handed to the stack.
+ *****************************************************************************/
+static bool destination_in_flight(EmberNodeId destination)
+{
+  uint8_t i;
+  for (i = 0; i < APP_TX_QUEUE_SIZE; i++) {
+    if (entries[i].state == TX_ENTRY_IN_FLIGHT
+        && entries[i].destination == destination) {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**************************************************************************//**
+ * Tells whether a failed transmission is worth another attempt.
+ *****************************************************************************/
+static bool is_retryable(EmberStatus status)
+{
+  switch (status) {
+    case EMBER_MAX_MESSAGE_LIMIT_REACHED:
+    case EMBER_NO_BUFFERS:
+    case EMBER_MAC_TRANSMIT_QUEUE_FULL:
+    case EMBER_PHY_TX_CCA_FAIL:
+    case EMBER_MAC_NO_ACK_RECEIVED:
+      return true;
+    default:
+      return false;
+  }
+}
@@ -0,0 +1,137 @@
+/***************************************************************************//**
+ * @file app_tx_queue.h
+ * @brief app_tx_queue.h
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+#ifndef APP_TX_QUEUE_H
+#define APP_TX_QUEUE_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include "tx-queue-config.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Priority classes of the TX queue, lower value is served first
+typedef enum {
+  APP_TX_PRIORITY_PAIR_CONFIRM = 0,
+  APP_TX_PRIORITY_CONFIG       = 1,
+  APP_TX_PRIORITY_ADVERTISE    = 2,
+  APP_TX_PRIORITY_COUNT
+} app_tx_priority_t;
+
+/// Metrics of the TX queue
+typedef struct {
+  /// Frames accepted per priority class
+  uint32_t enqueued[APP_TX_PRIORITY_COUNT];
+  /// Frames delivered per priority class
+  uint32_t delivered[APP_TX_PRIORITY_COUNT];
+  /// Frames dropped because the queue was full
+  uint32_t dropped_overflow;
+  /// Frames dropped after APP_TX_QUEUE_MAX_ATTEMPTS or a fatal status
+  uint32_t dropped_failed;
+  /// Frames handed back to the queue for another attempt
+  uint32_t retries;
+  /// Current and highest number of frames in the queue
+  uint8_t depth;
+  uint8_t peak_depth;
+  /// Enqueue to delivery latency of the delivered frames
+  uint32_t latency_min_ms;
+  uint32_t latency_max_ms;
+  uint32_t latency_sum_ms;
+} app_tx_queue_stats_t;
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+/// TX queue scheduler event control
+extern EmberEventControl *tx_queue_control;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Allocates the scheduler event and empties the queue.
+ *****************************************************************************/
+void app_tx_queue_init(void);
+
+/**************************************************************************//**
+ * Drops every queued frame, e.g. when the network goes down. Frames already
+ * handed to the stack are forgotten as well.
+ *****************************************************************************/
+void app_tx_queue_flush(void);
+
+/**************************************************************************//**
+ * Builds a sensor/sink frame (protocol ID, command ID, EUI64 and node ID of
+ * the sink followed by the payload) and queues it. The priority class is
+ * derived from the command.
+ *
+ * @param destination is the destination node ID (or broadcast address)
+ * @param command_id is the sensor/sink command ID
+ * @param *buffer is the payload of the command
+ * @param buffer_length is the length of the payload, up to
+ *        APP_PAYLOAD_MAX_LENGTH
+ * @returns EMBER_SUCCESS if the frame was queued, EMBER_MESSAGE_TOO_LONG or
+ *          EMBER_TABLE_FULL otherwise.
+ *****************************************************************************/
+EmberStatus app_tx_queue_send(EmberNodeId destination,
+                              uint8_t command_id,
+                              const uint8_t *buffer,
+                              uint8_t buffer_length);
+
+/**************************************************************************//**
+ * Queues a frame for transmission.
+ *
+ * @param destination is the destination node ID (or broadcast address)
+ * @param priority is the priority class of the frame
+ * @param *frame is the complete application frame, it is copied
+ * @param length is the length of the frame, up to APP_FRAME_MAX_LENGTH
+ * @returns EMBER_SUCCESS if the frame was queued, EMBER_MESSAGE_TOO_LONG or
+ *          EMBER_TABLE_FULL otherwise.
+ *****************************************************************************/
+EmberStatus app_tx_queue_enqueue(EmberNodeId destination,
+                                 app_tx_priority_t priority,
+                                 const uint8_t *frame,
+                                 uint8_t length);
+
+/**************************************************************************//**
+ * Feeds the queue and the channel map with the outcome of a transmission.
+ * To be called from emberAfMessageSentCallback(), frames not sent by the
+ * queue are ignored.
+ *
+ * @param status is the status reported by the stack
+ * @param *message is the outgoing message reported by the stack
+ * @returns true if the message belonged to the queue.
+ *****************************************************************************/
+bool app_tx_queue_message_sent(EmberStatus status,
+                               EmberOutgoingMessage *message);
+
+/**************************************************************************//**
+ * Event handler that hands the next eligible frames to the stack.
+ *****************************************************************************/
+void tx_queue_handler(void);
+
+/**************************************************************************//**
+ * Returns the metrics of the queue.
+ *****************************************************************************/
+const app_tx_queue_stats_t *app_tx_queue_get_stats(void);
+
+/**************************************************************************//**
+ * Clears the metrics of the queue, except the current depth.
+ *****************************************************************************/
+void app_tx_queue_reset_stats(void);
+
+#endif  // APP_TX_QUEUE_H
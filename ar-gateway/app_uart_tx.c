@@ -0,0 +1,430 @@
+/***************************************************************************//**
+ * @file app_uart_tx.c
+ * @brief app_uart_tx.c
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdio.h>
+#include <string.h>
+#include PLATFORM_HEADER
+#include "stack/include/ember.h"
+#include "em_device.h"
+#include "em_core.h"
+#include "em_ldma.h"
+#include "dmadrv.h"
+#include "sl_iostream.h"
+#include "sl_iostream_handles.h"
+#include "sl_component_catalog.h"
+#if defined(SL_CATALOG_CLI_PRESENT)
+#include "sl_cli_instances.h"
+#endif
+#include "app_uart_tx.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define TX_SIGNAL_(n)          ldmaPeripheralSignal_USART ## n ## _TXBL
+#define TX_SIGNAL(n)           TX_SIGNAL_(n)
+
+/// Benchmark lines: "#UB<path> <sequence, 4 hex digits> " and filler
+#define BENCH_FORMAT           "#UB%u %04X %.*s"
+#define BENCH_PREFIX_LENGTH    (10u)
+#define BENCH_MAX_LINE         (200u)
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Starts a transfer of what the ring holds, unless one is running. The
+ * descriptors are chained up to the end of the ring and past the wrap.
+ *****************************************************************************/
+static void start_transfer(void);
+
+/**************************************************************************//**
+ * DMADRV callback at the end of a transfer: frees its bytes and starts the
+ * next one.
+ *****************************************************************************/
+static bool on_transfer_done(unsigned int channel,
+                             unsigned int sequence,
+                             void *user);
+
+/**************************************************************************//**
+ * Write function of the stdio stream: copies to the ring, converting LF to
+ * CR LF, and waits for room if the ring is full.
+ *****************************************************************************/
+static sl_status_t stream_write(void *context, const void *buffer, size_t length);
+
+/**************************************************************************//**
+ * Read function of the stdio stream, served by the VCOM stream.
+ *****************************************************************************/
+static sl_status_t stream_read(void *context,
+                               void *buffer,
+                               size_t length,
+                               size_t *bytes_read);
+
+static uint32_t cycles(void);
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+/// Output ring. The data runs from tail to head; after a wrap, from tail to
+/// limit, then from the start of the ring to head. head == tail is empty.
+static uint8_t ring[APP_UART_TX_RING_SIZE];
+/// Written by the main loop
+static volatile uint16_t head = 0;
+static volatile uint16_t limit = APP_UART_TX_RING_SIZE;
+/// Written by the transfer callback
+static volatile uint16_t tail = 0;
+/// Open reservation
+static uint16_t reserved_at = 0;
+static uint16_t reserved_length = 0;
+
+/// Running transfer: its descriptors, where it ends and its length
+static LDMA_Descriptor_t descriptors[APP_UART_TX_DESCRIPTORS];
+static LDMA_TransferCfg_t transfer_config =
+  LDMA_TRANSFER_CFG_PERIPHERAL(TX_SIGNAL(SL_IOSTREAM_USART_VCOM_PERIPHERAL_NO));
+static unsigned int channel;
+/// Set once the channel is allocated, the ring is not used before
+static bool ready = false;
+static volatile bool busy = false;
+static uint16_t in_flight_end = 0;
+static uint16_t in_flight_length = 0;
+
+static sl_iostream_t stream = {
+  .context = NULL,
+  .write = stream_write,
+  .read = stream_read
+};
+
+static app_uart_tx_stats_t stats;
+
+/// Filler of the benchmark lines
+static const char bench_filler[BENCH_MAX_LINE] =
+  "ABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWX"
+  "YZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQRSTUV"
+  "WXYZABCDEFGHIJKLMNOPQRSTUVWXYZABCDEFGHIJKLMNOPQR";
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Allocates the LDMA channel and makes the TX engine the default stream, for
+ * the CLI instance as well.
+ *****************************************************************************/
+void app_uart_tx_init(void)
+{
+  // Initialized already if another component uses DMADRV.
+  (void) DMADRV_Init();
+  if (DMADRV_AllocateChannel(&channel, NULL) != ECODE_EMDRV_DMADRV_OK) {
+    // Printed by the VCOM stream, still the default
+    APP_INFO("UART TX: no LDMA channel, output stays synchronous\n");
+    return;
+  }
+  ready = true;
+  sl_iostream_set_default(&stream);
+#if defined(SL_CATALOG_CLI_PRESENT)
+  // The CLI took the default stream when it was initialized, before this
+  // call. Its echo and prompts must go through the ring too, written
+  // directly to the VCOM they would cut into the lines in flight.
+  sl_cli_example_handle->iostream_handle = &stream;
+#endif
+}
+
+/**************************************************************************//**
+ * Reserves contiguous room in the ring.
+ *****************************************************************************/
+uint8_t *app_uart_tx_reserve(uint16_t length)
+{
+  uint16_t read;
+
+  if (!ready || length == 0 || length >= APP_UART_TX_RING_SIZE) {
+    return NULL;
+  }
+  if (app_uart_tx_is_idle()) {
+    // Nothing in flight: start over, with the whole ring in one piece.
+    head = 0;
+    tail = 0;
+  }
+  read = tail;
+  if (head >= read) {
+    // Filling the ring up to its end wraps head to 0, it must not meet tail.
+    if (head + length < APP_UART_TX_RING_SIZE
+        || (head + length == APP_UART_TX_RING_SIZE && read != 0)) {
+      reserved_at = head;
+    } else if (length < read) {
+      reserved_at = 0;
+    } else {
+      return NULL;
+    }
+  } else if (head + length < read) {
+    reserved_at = head;
+  } else {
+    return NULL;
+  }
+  reserved_length = length;
+  return ring + reserved_at;
+}
+
+/**************************************************************************//**
+ * Hands the start of the reserved room to LDMA.
+ *****************************************************************************/
+void app_uart_tx_commit(uint16_t length)
+{
+  uint16_t read;
+  uint16_t used;
+  CORE_DECLARE_IRQ_STATE;
+
+  if (length > reserved_length) {
+    length = reserved_length;
+  }
+  reserved_length = 0;
+  if (length == 0) {
+    return;
+  }
+  if (reserved_at == 0 && head != 0) {
+    // Wrapped: the data of this lap ends where head was.
+    limit = head;
+    head = length;
+  } else if (head + length == APP_UART_TX_RING_SIZE) {
+    limit = APP_UART_TX_RING_SIZE;
+    head = 0;
+  } else {
+    head += length;
+  }
+
+  read = tail;
+  used = (head >= read) ? (uint16_t)(head - read) : (uint16_t)(limit - read + head);
+  if (used > stats.peak_used) {
+    stats.peak_used = used;
+  }
+  stats.committed += length;
+
+  CORE_ENTER_ATOMIC();
+  start_transfer();
+  CORE_EXIT_ATOMIC();
+}
+
+/**************************************************************************//**
+ * Returns true if the ring is empty and no transfer is running.
+ *****************************************************************************/
+bool app_uart_tx_is_idle(void)
+{
+  return !busy && tail == head;
+}
+
+/**************************************************************************//**
+ * Waits until the ring is sent.
+ *****************************************************************************/
+void app_uart_tx_flush(void)
+{
+  while (!app_uart_tx_is_idle()) {
+  }
+}
+
+/**************************************************************************//**
+ * Returns the metrics of the TX engine.
+ *****************************************************************************/
+const app_uart_tx_stats_t *app_uart_tx_get_stats(void)
+{
+  return &stats;
+}
+
+/**************************************************************************//**
+ * Clears the metrics of the TX engine.
+ *****************************************************************************/
+void app_uart_tx_reset_stats(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_ATOMIC();
+  memset(&stats, 0, sizeof(stats));
+  CORE_EXIT_ATOMIC();
+}
+
+/**************************************************************************//**
+ * Writes the same lines through the three output paths and counts the CPU
+ * cycles each one takes.
+ *****************************************************************************/
+bool app_uart_tx_benchmark(uint16_t count, uint8_t length, app_uart_tx_bench_t *result)
+{
+  int fill = (int)length - (int)BENCH_PREFIX_LENGTH;
+  uint32_t start;
+  uint16_t i;
+  uint8_t *out;
+
+  if (count == 0 || length < BENCH_PREFIX_LENGTH || length > BENCH_MAX_LINE) {
+    return false;
+  }
+  memset(result, 0, sizeof(*result));
+  CoreDebug->DEMCR |= CoreDebug_DEMCR_TRCENA_Msk;
+  DWT->CTRL |= DWT_CTRL_CYCCNTENA_Msk;
+
+  // The VCOM stream writes to the USART directly, the ring must be out first.
+  app_uart_tx_flush();
+  start = cycles();
+  for (i = 0; i < count; i++) {
+    sl_iostream_printf(sl_iostream_vcom_handle, BENCH_FORMAT "\n", 0u, i, fill, bench_filler);
+  }
+  result->vcom_printf.cycles = cycles() - start;
+  result->vcom_printf.bytes = (uint32_t)count * (length + APP_UART_TX_EOL_LENGTH);
+
+  start = cycles();
+  for (i = 0; i < count; i++) {
+    printf(BENCH_FORMAT "\n", 1u, i, fill, bench_filler);
+  }
+  result->ring_printf.cycles = cycles() - start;
+  result->ring_printf.bytes = (uint32_t)count * (length + APP_UART_TX_EOL_LENGTH);
+
+  start = cycles();
+  for (i = 0; i < count; i++) {
+    // snprintf() needs room for the terminating NUL.
+    while ((out = app_uart_tx_reserve(length + APP_UART_TX_EOL_LENGTH + 1)) == NULL) {
+    }
+    snprintf((char *)out, length + 1u, BENCH_FORMAT, 2u, i, fill, bench_filler);
+    memcpy(out + length, APP_UART_TX_EOL, APP_UART_TX_EOL_LENGTH);
+    app_uart_tx_commit(length + APP_UART_TX_EOL_LENGTH);
+  }
+  result->ring_direct.cycles = cycles() - start;
+  result->ring_direct.bytes = (uint32_t)count * (length + APP_UART_TX_EOL_LENGTH);
+
+  start = cycles();
+  app_uart_tx_flush();
+  result->drain_cycles = cycles() - start;
+  return true;
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+static void start_transfer(void)
+{
+  uint16_t write = head;
+  uint16_t position = tail;
+  uint16_t total = 0;
+  uint8_t count = 0;
+
+  if (busy) {
+    return;
+  }
+  while (count < APP_UART_TX_DESCRIPTORS && position != write) {
+    uint16_t length;
+
+    if (position == limit && write < position) {
+      position = 0;
+      continue;
+    }
+    length = (write > position) ? (uint16_t)(write - position) : (uint16_t)(limit - position);
+    if (length > DMADRV_MAX_XFER_COUNT) {
+      length = DMADRV_MAX_XFER_COUNT;
+    }
+    descriptors[count] = (LDMA_Descriptor_t)
+                         LDMA_DESCRIPTOR_LINKREL_M2P_BYTE(ring + position,
+                                                          &SL_IOSTREAM_USART_VCOM_PERIPHERAL->TXDATA,
+                                                          length,
+                                                          1);
+    count++;
+    position += length;
+    total += length;
+  }
+  if (count == 0) {
+    // Only the end of the previous lap was left, and it is empty.
+    tail = position;
+    return;
+  }
+  // The last descriptor ends the transfer and raises the interrupt.
+  descriptors[count - 1].xfer.link = 0;
+  descriptors[count - 1].xfer.doneIfs = 1;
+
+  busy = true;
+  in_flight_end = position;
+  in_flight_length = total;
+  stats.transfers++;
+  stats.descriptors += count;
+  DMADRV_LdmaStartTransfer((int)channel, &transfer_config, descriptors,
+                           on_transfer_done, NULL);
+}
+
+static bool on_transfer_done(unsigned int channel,
+                             unsigned int sequence,
+                             void *user)
+{
+  (void) channel;
+  (void) sequence;
+  (void) user;
+
+  stats.sent += in_flight_length;
+  tail = (in_flight_end == limit && head < in_flight_end) ? 0 : in_flight_end;
+  busy = false;
+  start_transfer();
+  return true;
+}
+
+static sl_status_t stream_write(void *context, const void *buffer, size_t length)
+{
+  const char *in = buffer;
+  bool waited = false;
+  (void) context;
+
+  while (length > 0) {
+    uint16_t room = (length * 2 < APP_UART_TX_WRITE_CHUNK)
+                    ? (uint16_t)(length * 2) : APP_UART_TX_WRITE_CHUNK;
+    uint16_t used = 0;
+    char *out;
+
+    while ((out = (char *)app_uart_tx_reserve(room)) == NULL) {
+      // Nobody empties the ring while the LDMA interrupt cannot run.
+      if (CORE_InIrqContext() || CORE_IrqIsDisabled()) {
+        stats.dropped += length;
+        return SL_STATUS_FULL;
+      }
+      if (!waited) {
+        waited = true;
+        stats.waits++;
+      }
+    }
+    // Every byte may take two, whatever is left goes in the next chunk.
+    while (length > 0 && used + 2 <= room) {
+#if SL_IOSTREAM_USART_VCOM_CONVERT_BY_DEFAULT_LF_TO_CRLF
+      if (*in == '\n') {
+        out[used++] = '\r';
+      }
+#endif
+      out[used++] = *in++;
+      length--;
+    }
+    app_uart_tx_commit(used);
+  }
+  return SL_STATUS_OK;
+}
+
+static sl_status_t stream_read(void *context,
+                               void *buffer,
+                               size_t length,
+                               size_t *bytes_read)
+{
+  (void) context;
+  return sl_iostream_read(sl_iostream_vcom_handle, buffer, length, bytes_read);
+}
+
+static uint32_t cycles(void)
+{
+  return DWT->CYCCNT;
+}
@@ -0,0 +1,133 @@
+/***************************************************************************//**
+ * @file app_uart_tx.h
+ * @brief app_uart_tx.h
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+#ifndef APP_UART_TX_H
+#define APP_UART_TX_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include "uart-tx-config.h"
+#include "sl_iostream_usart_vcom_config.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Line ending of the output written into the ring directly, the stdio
+/// stream converts "\n" the same way
+#if SL_IOSTREAM_USART_VCOM_CONVERT_BY_DEFAULT_LF_TO_CRLF
+#define APP_UART_TX_EOL                    "\r\n"
+#else
+#define APP_UART_TX_EOL                    "\n"
+#endif
+#define APP_UART_TX_EOL_LENGTH             (sizeof(APP_UART_TX_EOL) - 1)
+
+/// Metrics of the TX engine
+typedef struct {
+  /// Bytes committed to the ring and bytes sent by LDMA
+  uint32_t committed;
+  uint32_t sent;
+  /// LDMA transfers started and descriptors used by them
+  uint32_t transfers;
+  uint32_t descriptors;
+  /// Writes of the stdio stream that waited for room in the ring
+  uint32_t waits;
+  /// Bytes of the stdio stream dropped because the ring was full in
+  /// interrupt context
+  uint32_t dropped;
+  /// Highest number of bytes in the ring
+  uint16_t peak_used;
+} app_uart_tx_stats_t;
+
+/// Outcome of a benchmark path
+typedef struct {
+  uint32_t bytes;
+  /// CPU cycles spent by the writer, waits for the ring included
+  uint32_t cycles;
+} app_uart_tx_bench_path_t;
+
+/// Outcome of app_uart_tx_benchmark()
+typedef struct {
+  /// printf on the VCOM stream: formatted and sent byte by byte by the CPU
+  app_uart_tx_bench_path_t vcom_printf;
+  /// printf on the stdio stream: formatted, copied to the ring, sent by LDMA
+  app_uart_tx_bench_path_t ring_printf;
+  /// Formatted in place in the ring, sent by LDMA
+  app_uart_tx_bench_path_t ring_direct;
+  /// Cycles from the end of ring_direct to the last byte sent
+  uint32_t drain_cycles;
+} app_uart_tx_bench_t;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Allocates the LDMA channel and makes the TX engine the default stdio
+ * stream and the stream of the CLI instance: printf output, the CLI echo and
+ * prompts go through the ring from then on, input is still read from the
+ * VCOM stream.
+ *****************************************************************************/
+void app_uart_tx_init(void);
+
+/**************************************************************************//**
+ * Reserves contiguous room in the ring, to format output in place. Nothing
+ * is sent until app_uart_tx_commit(), and only one reservation may be open
+ * at a time. To be used from the main loop only.
+ *
+ * @param length is the room needed, below APP_UART_TX_RING_SIZE
+ * @returns the room, or NULL if the ring is too full or the engine did not
+ *          start. The output can go through printf then.
+ *****************************************************************************/
+uint8_t *app_uart_tx_reserve(uint16_t length);
+
+/**************************************************************************//**
+ * Hands the start of the reserved room to LDMA.
+ *
+ * @param length is the number of bytes written, up to the reserved length
+ *****************************************************************************/
+void app_uart_tx_commit(uint16_t length);
+
+/**************************************************************************//**
+ * Returns true if the ring is empty and no transfer is running. The USART
+ * may still be shifting out the last byte.
+ *****************************************************************************/
+bool app_uart_tx_is_idle(void);
+
+/**************************************************************************//**
+ * Waits until the ring is sent. Interrupts must be enabled.
+ *****************************************************************************/
+void app_uart_tx_flush(void);
+
+/**************************************************************************//**
+ * Returns the metrics of the TX engine.
+ *****************************************************************************/
+const app_uart_tx_stats_t *app_uart_tx_get_stats(void);
+
+/**************************************************************************//**
+ * Clears the metrics of the TX engine.
+ *****************************************************************************/
+void app_uart_tx_reset_stats(void);
+
+/**************************************************************************//**
+ * Writes the same lines through the three output paths and counts the CPU
+ * cycles each one takes, with the DWT cycle counter. Each path prints count
+ * lines of length characters, EOL excluded, starting with "#UB".
+ *
+ * @returns false if the arguments are out of range.
+ *****************************************************************************/
+bool app_uart_tx_benchmark(uint16_t count, uint8_t length, app_uart_tx_bench_t *result);
+
+#endif  // APP_UART_TX_H
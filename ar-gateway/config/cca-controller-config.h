@@ -0,0 +1,74 @@
+/***************************************************************************//**
+ * @brief Application CCA threshold controller configuration header.
+ *
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// <<< Use Configuration Wizard in Context Menu >>>
+
+// <h>Application CCA threshold controller configuration
+
+// <o APP_CCA_PERIOD_S> Control Period in seconds<0-3600>
+// <i> Default: 10
+// <i> The period at which the MAC counters are sampled and the threshold adjusted, 0 disables the controller.
+#define APP_CCA_PERIOD_S                   (10)
+
+// <o APP_CCA_MIN_DBM> Lowest Threshold in dBm<-120-0>
+// <i> Default: -85
+// <i> The controller never lowers the CCA threshold below this value.
+#define APP_CCA_MIN_DBM                    (-85)
+
+// <o APP_CCA_MAX_DBM> Highest Threshold in dBm<-120-0>
+// <i> Default: -50
+// <i> The controller never raises the CCA threshold above this value.
+#define APP_CCA_MAX_DBM                    (-50)
+
+// <o APP_CCA_STEP_DB> Adjustment Step in dB<1-20>
+// <i> Default: 3
+// <i> The change applied to the threshold by a single decision.
+#define APP_CCA_STEP_DB                    (3)
+
+// <o APP_CCA_MIN_SAMPLES> Minimum Transmissions per Period<1-1000>
+// <i> Default: 20
+// <i> Periods with fewer transmissions leave the threshold unchanged.
+#define APP_CCA_MIN_SAMPLES                (20)
+
+// <o APP_CCA_BUSY_PERCENT> Busy Channel CCA Failure Rate in percent<1-100>
+// <i> Default: 20
+// <i> Above this CCA failure rate, and as long as unicasts still get acknowledged, the threshold is raised.
+#define APP_CCA_BUSY_PERCENT               (20)
+
+// <o APP_CCA_MIN_UNICASTS> Minimum Unicasts to Raise the Threshold<1-1000>
+// <i> Default: 10
+// <i> The threshold is only raised for a busy channel if at least this many unicasts completed in the period, broadcasts alone do not show that delivery still works.
+#define APP_CCA_MIN_UNICASTS               (10)
+
+// <o APP_CCA_QUIET_PERCENT> Quiet Channel CCA Failure Rate in percent<0-100>
+// <i> Default: 2
+// <i> Below this CCA failure rate the threshold moves back towards EMBER_RADIO_CCA_THRESHOLD.
+#define APP_CCA_QUIET_PERCENT              (2)
+
+// <o APP_CCA_ACK_FAIL_PERCENT> Collision ACK Failure Rate in percent<1-100>
+// <i> Default: 10
+// <i> Above this rate of unacknowledged unicasts, transmissions are assumed to collide and the threshold is lowered.
+#define APP_CCA_ACK_FAIL_PERCENT           (10)
+
+// <o APP_CCA_NOISE_MARGIN_DB> Noise Floor Margin in dB<0-40>
+// <i> Default: 6
+// <i> The threshold is kept this far above the noise floor measured by the last channel survey, on the noisiest channel of the hopping list.
+#define APP_CCA_NOISE_MARGIN_DB            (6)
+
+// </h>
+
+// <<< end of configuration section >>>
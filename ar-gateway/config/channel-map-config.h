@@ -0,0 +1,49 @@
+/***************************************************************************//**
+ * @brief Application channel map configuration header.
+ *
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// <<< Use Configuration Wizard in Context Menu >>>
+
+// <h>Application channel map configuration
+
+// <o APP_CHANNEL_MAP_MIN_ATTEMPTS> Minimum Attempts<1-1000>
+// <i> Default: 8
+// <i> The number of transmissions on a channel before its failure rate is trusted.
+#define APP_CHANNEL_MAP_MIN_ATTEMPTS       (8)
+
+// <o APP_CHANNEL_MAP_EXCLUDE_PERCENT> Exclusion Threshold in percent<1-100>
+// <i> Default: 50
+// <i> A channel is excluded once its smoothed TX failure rate (no ACK or CCA failure) reaches this value.
+#define APP_CHANNEL_MAP_EXCLUDE_PERCENT    (50)
+
+// <o APP_CHANNEL_MAP_MAX_EXCLUDED_PERCENT> Maximum Excluded Channels in percent<0-90>
+// <i> Default: 50
+// <i> The share of the hopping channels that may be excluded at the same time.
+#define APP_CHANNEL_MAP_MAX_EXCLUDED_PERCENT  (50)
+
+// <o APP_CHANNEL_MAP_PROBATION_S> Exclusion Duration in seconds<1-65535>
+// <i> Default: 300
+// <i> An excluded channel is put back on probation after this time: it is used again and excluded again after a few failures.
+#define APP_CHANNEL_MAP_PROBATION_S        (300)
+
+// <o APP_CHANNEL_MAP_RECHECK_MS> TX Hold Recheck Period in milliseconds<10-1000>
+// <i> Default: 50
+// <i> While the radio sits on an excluded channel, the TX queue checks again for a hop after this time.
+#define APP_CHANNEL_MAP_RECHECK_MS         (50)
+
+// </h>
+
+// <<< end of configuration section >>>
@@ -0,0 +1,39 @@
+/***************************************************************************//**
+ * @brief Application channel survey configuration header.
+ *
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// <<< Use Configuration Wizard in Context Menu >>>
+
+// <h>Application channel survey configuration
+
+// <o APP_CHANNEL_SURVEY_MAX_CHANNELS> Maximum Number of Channels<1-255>
+// <i> Default: 64
+// <i> The survey scans channels upwards from 0 until the PHY reports an invalid channel or this many channels were scanned.
+#define APP_CHANNEL_SURVEY_MAX_CHANNELS    (64)
+
+// <o APP_CHANNEL_SURVEY_SAMPLES> RSSI Samples per Channel<1-255>
+// <i> Default: 32
+// <i> The number of RSSI samples taken by each energy scan.
+#define APP_CHANNEL_SURVEY_SAMPLES         (32)
+
+// <o APP_CHANNEL_SURVEY_PERIOD_S> Background Re-survey Period in seconds<0-65535>
+// <i> Default: 0
+// <i> The period of the background re-survey, 0 disables it. The re-survey only runs while the sink is not on a network, since it cannot receive or follow the hopping sequence while a channel is scanned. It can be changed at runtime using the CLI.
+#define APP_CHANNEL_SURVEY_PERIOD_S        (0)
+
+// </h>
+
+// <<< end of configuration section >>>
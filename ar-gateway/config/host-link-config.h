@@ -0,0 +1,34 @@
+/***************************************************************************//**
+ * @brief Host link configuration header.
+ *
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// <<< Use Configuration Wizard in Context Menu >>>
+
+// <h>Host link configuration
+
+// <o APP_HOST_LINK_SENSORS_PER_RESPONSE> Sensor Entries per Response<1-16>
+// <i> Default: 8
+// <i> The number of sensor table entries returned by one sensors request. Every entry is 17 bytes, printed as 34 hex digits.
+#define APP_HOST_LINK_SENSORS_PER_RESPONSE (8)
+
+// <o APP_HOST_LINK_STREAM_LINES_PER_EVENT> Stream Test Lines per Event<1-64>
+// <i> Default: 16
+// <i> The number of lines of a stream test written to the output ring per run of its event, the stack runs in between. The event also yields when the ring is full.
+#define APP_HOST_LINK_STREAM_LINES_PER_EVENT (16)
+
+// </h>
+
+// <<< end of configuration section >>>
@@ -0,0 +1,49 @@
+/***************************************************************************//**
+ * @brief Application downlink mailbox configuration header.
+ *
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// <<< Use Configuration Wizard in Context Menu >>>
+
+// <h>Application downlink mailbox configuration
+
+// <o APP_MAILBOX_COUNT> Number of Mailboxes<1-64>
+// <i> Default: 16
+// <i> The number of sleepy sensors that can have a mailbox at the same time. Matches EMBER_CHILD_TABLE_SIZE by default.
+#define APP_MAILBOX_COUNT                  (16)
+
+// <o APP_MAILBOX_DEPTH> Mailbox Depth<1-8>
+// <i> Default: 2
+// <i> The number of distinct commands held per sensor. Commands of the same type replace each other, so this only limits different command types.
+#define APP_MAILBOX_DEPTH                  (2)
+
+// <o APP_MAILBOX_PAYLOAD_SIZE> Maximum Payload Size in bytes<1-64>
+// <i> Default: 16
+// <i> The largest command payload a mailbox can hold.
+#define APP_MAILBOX_PAYLOAD_SIZE           (16)
+
+// <o APP_MAILBOX_EXPIRY_MS> Command Expiry in milliseconds<1000-86400000>
+// <i> Default: 3600000
+// <i> Commands not released within this time are dropped and reported as expired.
+#define APP_MAILBOX_EXPIRY_MS              (3600000)
+
+// <o APP_MAILBOX_SWEEP_PERIOD_MS> Expiry Check Period in milliseconds<100-60000>
+// <i> Default: 1000
+// <i> The period of the expiry check while any mailbox holds a command.
+#define APP_MAILBOX_SWEEP_PERIOD_MS        (1000)
+
+// </h>
+
+// <<< end of configuration section >>>
@@ -0,0 +1,29 @@
+/***************************************************************************//**
+ * @brief Sensor query configuration header.
+ *
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// <<< Use Configuration Wizard in Context Menu >>>
+
+// <h>Sensor query configuration
+
+// <o APP_SENSOR_QUERY_ROWS_PER_EVENT> Rows per Event<1-32>
+// <i> Default: 4
+// <i> The number of rows of a sensors CLI query printed per run of its event, the stack runs in between. The event also yields when the output ring is full.
+#define APP_SENSOR_QUERY_ROWS_PER_EVENT    (4)
+
+// </h>
+
+// <<< end of configuration section >>>
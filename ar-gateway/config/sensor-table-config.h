@@ -0,0 +1,34 @@
+/***************************************************************************//**
+ * @brief Application sensor table configuration header.
+ *
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// <<< Use Configuration Wizard in Context Menu >>>
+
+// <h>Application sensor table configuration
+
+// <o APP_SENSOR_TABLE_SIZE> Sensor Table Size<1-254>
+// <i> Default: 32
+// <i> The number of sensors the sink can pair with. Sensors behind range extenders do not take a child table entry of the sink, so it may exceed EMBER_CHILD_TABLE_SIZE.
+#define APP_SENSOR_TABLE_SIZE              (32)
+
+// <o APP_SENSOR_TABLE_HISTORY_DEPTH> Report History Depth<1-16>
+// <i> Default: 4
+// <i> The number of reports kept per sensor, the latest one included.
+#define APP_SENSOR_TABLE_HISTORY_DEPTH     (4)
+
+// </h>
+
+// <<< end of configuration section >>>
@@ -0,0 +1,29 @@
+/***************************************************************************//**
+ * @brief Serial port configuration header.
+ *
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// <<< Use Configuration Wizard in Context Menu >>>
+
+// <h>Serial port configuration
+
+// <o APP_SERIAL_BAUD_CONFIRM_MS> Baud Rate Confirmation Timeout in milliseconds<500-60000>
+// <i> Default: 3000
+// <i> After a baud rate change the sink returns to the previous rate, unless a host link request or the baud command without argument arrives at the new rate within this time.
+#define APP_SERIAL_BAUD_CONFIRM_MS         (3000)
+
+// </h>
+
+// <<< end of configuration section >>>
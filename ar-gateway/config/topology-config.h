@@ -0,0 +1,49 @@
+/***************************************************************************//**
+ * @brief Application topology configuration header.
+ *
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// <<< Use Configuration Wizard in Context Menu >>>
+
+// <h>Application topology configuration
+
+// <o APP_TOPOLOGY_MAX_EXTENDERS> Maximum Range Extenders<1-32>
+// <i> Default: 8
+// <i> The number of range extenders the sink keeps track of.
+#define APP_TOPOLOGY_MAX_EXTENDERS         (8)
+
+// <o APP_TOPOLOGY_SINK_CAPACITY> Sink Capacity<1-64>
+// <i> Default: 16
+// <i> The number of children of the sink, sensors and range extenders together. Matches EMBER_CHILD_TABLE_SIZE by default.
+#define APP_TOPOLOGY_SINK_CAPACITY         (16)
+
+// <o APP_TOPOLOGY_EXTENDER_CAPACITY> Range Extender Capacity<1-64>
+// <i> Default: 16
+// <i> The number of sensors a range extender can parent. Matches the EMBER_CHILD_TABLE_SIZE of the extender firmware.
+#define APP_TOPOLOGY_EXTENDER_CAPACITY     (16)
+
+// <o APP_TOPOLOGY_EXTENDER_TIMEOUT_MS> Range Extender Timeout in milliseconds<0-86400000>
+// <i> Default: 600000
+// <i> A range extender not heard from for longer is forgotten and no longer takes joins, 0 disables the timeout. Frames from the extender, reports of the sensors behind it and deliveries to it count. An idle extender without sensors is learned again when it rejoins.
+#define APP_TOPOLOGY_EXTENDER_TIMEOUT_MS   (600000)
+
+// <o APP_TOPOLOGY_EXTENDER_MAX_TX_FAILURES> Range Extender Maximum TX Failures<1-255>
+// <i> Default: 8
+// <i> A range extender is forgotten after this many failed transmissions in a row, every attempt of the TX queue counts.
+#define APP_TOPOLOGY_EXTENDER_MAX_TX_FAILURES (8)
+
+// </h>
+
+// <<< end of configuration section >>>
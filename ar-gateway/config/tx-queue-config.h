@@ -0,0 +1,49 @@
+/***************************************************************************//**
+ * @brief Application TX queue configuration header.
+ *
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// <<< Use Configuration Wizard in Context Menu >>>
+
+// <h>Application TX queue configuration
+
+// <o APP_TX_QUEUE_SIZE> Queue Size<1-127>
+// <i> Default: 12
+// <i> The maximum number of frames held by the application TX queue (queued and in flight).
+#define APP_TX_QUEUE_SIZE                  (12)
+
+// <o APP_TX_QUEUE_MAX_IN_FLIGHT> Maximum Frames In Flight<1-8>
+// <i> Default: 4
+// <i> The maximum number of frames handed to the stack at the same time. Keep it below EMBER_MAC_OUTGOING_QUEUE_SIZE so that the CLI and the stack itself keep some room in the MAC queue.
+#define APP_TX_QUEUE_MAX_IN_FLIGHT         (4)
+
+// <o APP_TX_QUEUE_MAX_ATTEMPTS> Maximum Attempts<1-16>
+// <i> Default: 4
+// <i> The number of times a frame is handed to the stack before it is dropped.
+#define APP_TX_QUEUE_MAX_ATTEMPTS          (4)
+
+// <o APP_TX_QUEUE_BACKOFF_BASE_MS> Retry Backoff Base in milliseconds<1-10000>
+// <i> Default: 50
+// <i> The delay before the first retry. Every further retry doubles it, plus a random jitter of up to the same amount.
+#define APP_TX_QUEUE_BACKOFF_BASE_MS       (50)
+
+// <o APP_TX_QUEUE_BACKOFF_MAX_MS> Retry Backoff Limit in milliseconds<1-60000>
+// <i> Default: 2000
+// <i> The upper bound of the retry backoff.
+#define APP_TX_QUEUE_BACKOFF_MAX_MS        (2000)
+
+// </h>
+
+// <<< end of configuration section >>>
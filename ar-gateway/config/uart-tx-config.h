@@ -0,0 +1,39 @@
+/***************************************************************************//**
+ * @brief UART TX engine configuration header.
+ *
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// <<< Use Configuration Wizard in Context Menu >>>
+
+// <h>UART TX engine configuration
+
+// <o APP_UART_TX_RING_SIZE> Output Ring Size in bytes<256-8192>
+// <i> Default: 2048
+// <i> The output waiting for the VCOM USART, sent by LDMA. A writer finding the ring full waits for room, so the ring should hold the largest burst of output, e.g. a sensor table dump.
+#define APP_UART_TX_RING_SIZE              (2048)
+
+// <o APP_UART_TX_DESCRIPTORS> Linked Descriptors per Transfer<2-8>
+// <i> Default: 4
+// <i> The LDMA descriptors chained in one transfer. A descriptor covers up to 2048 bytes and ends at the end of the ring.
+#define APP_UART_TX_DESCRIPTORS            (4)
+
+// <o APP_UART_TX_WRITE_CHUNK> printf Chunk Size in bytes<16-256>
+// <i> Default: 64
+// <i> The ring space reserved at a time for the output of the stdio stream, after the LF to CR LF conversion.
+#define APP_UART_TX_WRITE_CHUNK            (64)
+
+// </h>
+
+// <<< end of configuration section >>>
@@ -0,0 +1,329 @@
+/***************************************************************************//**
+ * @file channel_map_sim.c
+ * @brief channel_map_sim.c
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+// Host simulation of the sink channel map (ar-gateway/app_channel_map.c, built
+// as is against the stack stand-ins of stub/) on a jammed hopping channel.
+// The radio hops over the channels of ar-gateway/config/frequency-hopping-
+// config.h, the sink offers a frame at a fixed period, and every frame sent
+// on the jammed channel fails. A frame is sent once: it is delivered or lost.
+// The outcome arrives a little after the submission, possibly after a hop,
+// and is reported with the channel of the submission like the TX queue does.
+//
+// The same jammer runs twice: without the map, the frames go out on
+// whatever channel the radio is on; with it, the TX queue holds them while
+// the radio sits on an excluded channel. The delivery ratio, frames
+// delivered over frames offered, is printed for both, while jammed and over
+// the whole run.
+//
+// The run checks that the map recovers the delivery ratio of a clean band
+// while jammed, that the jammed channel is excluded, put on probation and
+// excluded again while jammed, readmitted for good once the jammer stops,
+// and that no other channel is excluded.
+//
+// Build: gcc -O2 -Wall -Istub -I../ar-gateway -I../ar-gateway/config -I../ar-common
+//            -DPLATFORM_HEADER='"host_platform.h"' -o channel_map_sim
+//            channel_map_sim.c ../ar-gateway/app_channel_map.c stub/host_stack.c
+// Usage: channel_map_sim [-j <jammed channel>] [-c <jammer stop s>]
+//                        [-t <duration s>] [-p <frame period ms>]
+//                        [-f <background failure %>] [-a]
+//
+// -a accounts the outcome on the channel of the sent callback instead, to
+// show the failures leaking to the next channel of the sequence.
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include PLATFORM_HEADER
+#include "stack/include/ember.h"
+#include "hal/hal.h"
+#include "app_channel_map.h"
+#include "host_stack.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Time from the submission of a frame to its sent callback (CSMA, MAC
+/// retries, ACK wait), plus a random part of up to the same
+#define TX_DURATION_MS          (20u)
+/// Simulation step
+#define STEP_MS                 (1u)
+/// Points of delivery ratio the map may lose against a clean band while
+/// jammed: the failures that get the channel excluded and each probation
+#define RECOVERY_MARGIN_PERCENT (3u)
+
+/// Parameters of a run
+typedef struct {
+  uint16_t jammed;
+  uint32_t clear_s;
+  uint32_t duration_s;
+  uint32_t period_ms;
+  unsigned background_percent;
+  bool at_completion;
+} sim_config_t;
+
+/// Outcome of a run
+typedef struct {
+  /// Frames offered and delivered, while jammed and over the whole run
+  uint64_t jam_offered;
+  uint64_t jam_delivered;
+  uint64_t offered;
+  uint64_t delivered;
+  uint64_t submitted;
+  uint64_t late_hops;
+  uint64_t on_excluded;
+  uint32_t first_exclusion_ms;
+  uint16_t exclusions_at_clear;
+} sim_result_t;
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+static void run(const sim_config_t *config, bool use_map, sim_result_t *result);
+static double ratio(uint64_t delivered, uint64_t offered);
+static uint16_t hop_channel(uint32_t slot);
+static bool check(bool condition, const char *what);
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static unsigned failed_checks = 0;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  sim_config_t config = {
+    .jammed = EMBER_FREQUENCY_HOPPING_START_CHANNEL + 3,
+    .clear_s = 900,
+    .duration_s = 1800,
+    .period_ms = 97,
+    .background_percent = 2,
+    .at_completion = false,
+  };
+  sim_result_t without_map;
+  sim_result_t with_map;
+  const app_channel_map_stats_t *stats;
+  double clean_percent;
+  uint8_t i;
+  int option;
+
+  while ((option = getopt(argc, argv, "j:c:t:p:f:a")) != -1) {
+    switch (option) {
+      case 'j': config.jammed = (uint16_t)strtoul(optarg, NULL, 0); break;
+      case 'c': config.clear_s = (uint32_t)strtoul(optarg, NULL, 0); break;
+      case 't': config.duration_s = (uint32_t)strtoul(optarg, NULL, 0); break;
+      case 'p': config.period_ms = (uint32_t)strtoul(optarg, NULL, 0); break;
+      case 'f': config.background_percent = (unsigned)strtoul(optarg, NULL, 0); break;
+      case 'a': config.at_completion = true; break;
+      default:
+        fprintf(stderr, "usage: %s [-j <jammed channel>] [-c <jammer stop s>] "
+                "[-t <duration s>] [-p <frame period ms>] "
+                "[-f <background failure %%>] [-a]\n", argv[0]);
+        return 2;
+    }
+  }
+  if (config.jammed < EMBER_FREQUENCY_HOPPING_START_CHANNEL
+      || config.jammed > EMBER_FREQUENCY_HOPPING_END_CHANNEL
+      || config.period_ms == 0
+      || config.background_percent > 100
+      || config.clear_s == 0
+      || config.clear_s + 2 * APP_CHANNEL_MAP_PROBATION_S > config.duration_s) {
+    fprintf(stderr, "%s: the jammed channel must be on the hopping list and "
+            "the run must last two probations past the jammer stop\n", argv[0]);
+    return 2;
+  }
+
+  app_channel_map_init();
+  printf("--- without the channel map\n");
+  run(&config, false, &without_map);
+  app_channel_map_reset();
+  printf("--- with the channel map\n");
+  run(&config, true, &with_map);
+
+  printf("frames: %llu submitted, %llu completed after a hop\n",
+         (unsigned long long)with_map.submitted,
+         (unsigned long long)with_map.late_hops);
+  for (i = 0; (stats = app_channel_map_get(i)) != NULL; i++) {
+    printf("channel %2d: attempts %6lu no-ack %6lu rate %3d%% excluded %d exclusions %d\n",
+           EMBER_FREQUENCY_HOPPING_START_CHANNEL + i,
+           (unsigned long)stats->attempts,
+           (unsigned long)stats->tx_failures,
+           stats->failure_percent,
+           stats->excluded,
+           stats->exclusions);
+  }
+
+  clean_percent = 100.0 - config.background_percent;
+  printf("%-20s %10s %10s\n", "delivery ratio", "jammed", "whole run");
+  printf("%-20s %9.1f%% %9.1f%%\n", "clean band", clean_percent, clean_percent);
+  printf("%-20s %9.1f%% %9.1f%%\n", "without the map",
+         ratio(without_map.jam_delivered, without_map.jam_offered),
+         ratio(without_map.delivered, without_map.offered));
+  printf("%-20s %9.1f%% %9.1f%%\n", "with the map",
+         ratio(with_map.jam_delivered, with_map.jam_offered),
+         ratio(with_map.delivered, with_map.offered));
+
+  check(ratio(with_map.jam_delivered, with_map.jam_offered)
+        > ratio(without_map.jam_delivered, without_map.jam_offered),
+        "the map improves the delivery ratio while jammed");
+  check(ratio(with_map.jam_delivered, with_map.jam_offered)
+        >= clean_percent - RECOVERY_MARGIN_PERCENT,
+        "the map recovers the delivery ratio of a clean band while jammed");
+  stats = app_channel_map_get(config.jammed - EMBER_FREQUENCY_HOPPING_START_CHANNEL);
+  check(with_map.first_exclusion_ms != 0, "jammed channel excluded");
+  check(with_map.exclusions_at_clear >= 2, "jammed channel excluded again after probation");
+  check(!stats->excluded, "jammed channel readmitted after the jammer stopped");
+  check(stats->exclusions <= with_map.exclusions_at_clear + 1,
+        "readmitted channel not excluded again more than once");
+  check(with_map.on_excluded == 0, "no frame submitted on an excluded channel");
+  for (i = 0; (stats = app_channel_map_get(i)) != NULL; i++) {
+    if (EMBER_FREQUENCY_HOPPING_START_CHANNEL + i != config.jammed
+        && stats->exclusions != 0) {
+      check(false, "clean channel never excluded");
+    }
+  }
+
+  printf("%s\n", (failed_checks == 0) ? "PASS" : "FAIL");
+  return (failed_checks == 0) ? 0 : 1;
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+/// Runs the jammer once. The frames offered while the TX queue holds them
+/// wait in a backlog, a frame still waiting at the end counts as not
+/// delivered.
+static void run(const sim_config_t *config, bool use_map, sim_result_t *result)
+{
+  const app_channel_map_stats_t *stats;
+  uint32_t now_ms;
+  uint32_t next_offer_ms = 0;
+  uint32_t pending_done_ms = 0;
+  uint32_t backlog = 0;
+  uint16_t pending_channel = 0;
+  bool pending = false;
+  bool pending_failed = false;
+  bool pending_jammed = false;
+  bool was_excluded = false;
+
+  MEMSET(result, 0, sizeof(*result));
+  srand(1);
+
+  for (now_ms = 0; now_ms < config->duration_s * MILLISECOND_TICKS_PER_SECOND; now_ms += STEP_MS) {
+    uint16_t channel = hop_channel(now_ms / EMBER_FREQUENCY_HOPPING_CHANNEL_DURATION_MS);
+    bool jam_on = (now_ms < config->clear_s * MILLISECOND_TICKS_PER_SECOND);
+
+    host_stack_set_channel(channel);
+
+    if (pending && (int32_t)(now_ms - pending_done_ms) >= 0) {
+      if (pending_channel != channel) {
+        result->late_hops++;
+      }
+      app_channel_map_note_tx(config->at_completion ? channel : pending_channel,
+                              pending_failed ? EMBER_MAC_NO_ACK_RECEIVED : EMBER_SUCCESS);
+      if (!pending_failed) {
+        result->delivered++;
+        if (pending_jammed) {
+          result->jam_delivered++;
+        }
+      }
+      pending = false;
+    }
+
+    if ((int32_t)(now_ms - next_offer_ms) >= 0) {
+      next_offer_ms = now_ms + config->period_ms;
+      backlog++;
+      result->offered++;
+      if (jam_on) {
+        result->jam_offered++;
+      }
+    }
+
+    // The TX queue holds its frames while the radio sits on an excluded
+    // channel.
+    if (!pending && backlog > 0
+        && !(use_map && app_channel_map_current_excluded())) {
+      stats = app_channel_map_get(channel - EMBER_FREQUENCY_HOPPING_START_CHANNEL);
+      if (use_map && stats->excluded) {
+        result->on_excluded++;
+      }
+      backlog--;
+      pending = true;
+      pending_channel = channel;
+      pending_done_ms = now_ms + TX_DURATION_MS + rand() % (TX_DURATION_MS + 1);
+      pending_failed = (jam_on && channel == config->jammed)
+                       || (unsigned)(rand() % 100) < config->background_percent;
+      // Accounted to the jammed part of the run with the offers it serves.
+      pending_jammed = jam_on;
+      result->submitted++;
+    }
+
+    stats = app_channel_map_get(config->jammed - EMBER_FREQUENCY_HOPPING_START_CHANNEL);
+    if (use_map) {
+      if (stats->excluded && !was_excluded && result->first_exclusion_ms == 0) {
+        result->first_exclusion_ms = now_ms;
+      }
+      if (stats->excluded != was_excluded) {
+        printf("%7.1f s: channel %d %s, %d%% failures\n",
+               now_ms / 1000.0, config->jammed,
+               stats->excluded ? "excluded" : "on probation",
+               stats->failure_percent);
+        was_excluded = stats->excluded;
+      }
+    }
+    if (now_ms == config->clear_s * MILLISECOND_TICKS_PER_SECOND) {
+      result->exclusions_at_clear = stats->exclusions;
+      printf("%7.1f s: jammer off\n", now_ms / 1000.0);
+    }
+
+    host_stack_advance(STEP_MS);
+  }
+}
+
+static double ratio(uint64_t delivered, uint64_t offered)
+{
+  return (offered > 0) ? (100.0 * delivered / offered) : 0.0;
+}
+
+/// Pseudo-random hopping sequence: every channel once per round, the order
+/// changing from round to round.
+static uint16_t hop_channel(uint32_t slot)
+{
+  uint32_t round = slot / APP_CHANNEL_MAP_CHANNEL_COUNT;
+  uint32_t step = 1 + round % (APP_CHANNEL_MAP_CHANNEL_COUNT - 1);
+
+  while (APP_CHANNEL_MAP_CHANNEL_COUNT % step == 0 && step > 1) {
+    step--;
+  }
+  return (uint16_t)(EMBER_FREQUENCY_HOPPING_START_CHANNEL
+                    + (slot * step + round) % APP_CHANNEL_MAP_CHANNEL_COUNT);
+}
+
+static bool check(bool condition, const char *what)
+{
+  printf("%s: %s\n", condition ? "ok  " : "FAIL", what);
+  if (!condition) {
+    failed_checks++;
+  }
+  return condition;
+}
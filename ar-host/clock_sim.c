@@ -0,0 +1,191 @@
+/***************************************************************************//**
+ * @file clock_sim.c
+ * @brief clock_sim.c
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+// Host test of the sensor network clock (ar-sensor/app_clock.c, built as is
+// against the sleeptimer stand-in of stub/). The sink time is the simulated
+// millisecond clock, the sleeptimer of the sensor runs off it by a set drift.
+// Time beacons arrive at the advertise period with a random radio delay.
+//
+// For every drift of the list the run checks that the estimate settles on the
+// opposite of the drift within the resolution of the beacons, that it never leaves the
+// +-500 ppm bound of app_clock.c, and that the network time read between two
+// beacons stays within the beacon delay plus the residual drift. A drift past
+// the bound must be clamped to it.
+//
+// Build: gcc -O2 -Wall -Istub -I../ar-sensor -DPLATFORM_HEADER='"host_platform.h"'
+//            -o clock_sim clock_sim.c ../ar-sensor/app_clock.c stub/host_stack.c
+// Usage: clock_sim [-p <beacon period s>] [-d <max beacon delay ms>]
+//                  [-n <beacons per drift>]
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <unistd.h>
+#include PLATFORM_HEADER
+#include "stack/include/ember.h"
+#include "hal/hal.h"
+#include "app_clock.h"
+#include "host_stack.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Bound of the drift estimate in app_clock.c
+#define DRIFT_BOUND_PPM         (500)
+/// Reads of the network time between two beacons
+#define READS_PER_PERIOD        (8u)
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+static bool run(int32_t drift_ppm, uint32_t period_ms, uint32_t max_delay_ms,
+                unsigned beacons);
+static bool check(bool condition, const char *what, int32_t drift_ppm);
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static unsigned failed_checks = 0;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  static const int32_t drifts_ppm[] = { 0, 20, -20, 100, -100, 450, -450, 800, -800 };
+  uint32_t period_s = 60;
+  uint32_t max_delay_ms = 10;
+  unsigned beacons = 60;
+  unsigned i;
+  int option;
+
+  while ((option = getopt(argc, argv, "p:d:n:")) != -1) {
+    switch (option) {
+      case 'p': period_s = (uint32_t)strtoul(optarg, NULL, 0); break;
+      case 'd': max_delay_ms = (uint32_t)strtoul(optarg, NULL, 0); break;
+      case 'n': beacons = (unsigned)strtoul(optarg, NULL, 0); break;
+      default:
+        fprintf(stderr, "usage: %s [-p <beacon period s>] [-d <max beacon delay ms>] "
+                "[-n <beacons per drift>]\n", argv[0]);
+        return 2;
+    }
+  }
+  if (period_s < 2 || beacons < 8) {
+    fprintf(stderr, "%s: the period must be at least 2 s and the run 8 beacons\n",
+            argv[0]);
+    return 2;
+  }
+
+  srand(1);
+  printf("  drift  estimate  max est.  last error  max read error (ms)\n");
+  for (i = 0; i < sizeof(drifts_ppm) / sizeof(drifts_ppm[0]); i++) {
+    run(drifts_ppm[i], period_s * MILLISECOND_TICKS_PER_SECOND, max_delay_ms, beacons);
+  }
+
+  printf("%s\n", (failed_checks == 0) ? "PASS" : "FAIL");
+  return (failed_checks == 0) ? 0 : 1;
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+/// Runs a sensor with the given drift through a series of beacons. The first
+/// half lets the estimate settle, the second half is checked.
+static bool run(int32_t drift_ppm, uint32_t period_ms, uint32_t max_delay_ms,
+                unsigned beacons)
+{
+  const app_clock_stats_t *stats = app_clock_get_stats();
+  // The estimate is the correction of the local clock, of opposite sign.
+  int32_t expected_ppm = -drift_ppm;
+  int32_t settle_ppm;
+  int32_t max_estimate_ppm = 0;
+  uint32_t max_read_error_ms = 0;
+  uint32_t read_bound_ms;
+  unsigned beacon;
+  unsigned r;
+  bool ok = true;
+
+  app_clock_reset();
+  host_stack_set_drift(drift_ppm);
+
+  if (expected_ppm > DRIFT_BOUND_PPM) {
+    expected_ppm = DRIFT_BOUND_PPM;
+  } else if (expected_ppm < -DRIFT_BOUND_PPM) {
+    expected_ppm = -DRIFT_BOUND_PPM;
+  }
+  // A single beacon measures the drift to within the spread of the delay
+  // over the period. The estimate keeps half of each new measurement.
+  settle_ppm = (int32_t)(((uint64_t)max_delay_ms * 1000000u) / period_ms) + 2;
+  // Between beacons the clock is off by the delay of the last beacon plus
+  // what the residual drift adds up to over a period.
+  read_bound_ms = max_delay_ms + 1
+                  + (uint32_t)(((uint64_t)(abs(drift_ppm + expected_ppm) + settle_ppm)
+                                * period_ms) / 1000000u);
+
+  for (beacon = 0; beacon < beacons; beacon++) {
+    uint32_t sent_ms = halCommonGetInt32uMillisecondTick();
+    uint32_t delay_ms = (max_delay_ms > 0) ? (uint32_t)rand() % (max_delay_ms + 1) : 0;
+
+    host_stack_advance(delay_ms);
+    app_clock_sync(sent_ms);
+    if (abs(stats->drift_ppm) > abs(max_estimate_ppm)) {
+      max_estimate_ppm = stats->drift_ppm;
+    }
+
+    for (r = 1; r <= READS_PER_PERIOD; r++) {
+      uint32_t network_ms;
+      int32_t error_ms;
+
+      host_stack_advance((period_ms - delay_ms) / READS_PER_PERIOD);
+      if (!app_clock_get_network_ms(&network_ms)) {
+        return check(false, "network time available after a beacon", drift_ppm);
+      }
+      error_ms = (int32_t)(network_ms - halCommonGetInt32uMillisecondTick());
+      if (beacon >= beacons / 2 && (uint32_t)abs(error_ms) > max_read_error_ms) {
+        max_read_error_ms = (uint32_t)abs(error_ms);
+      }
+    }
+    host_stack_advance((period_ms - delay_ms) % READS_PER_PERIOD);
+  }
+
+  printf("%7ld %9ld %9ld %11ld %10lu (bound %lu)\n",
+         (long)drift_ppm, (long)stats->drift_ppm, (long)max_estimate_ppm,
+         (long)stats->last_error_ms, (unsigned long)max_read_error_ms,
+         (unsigned long)read_bound_ms);
+  ok &= check(abs(stats->drift_ppm) <= DRIFT_BOUND_PPM
+              && abs(max_estimate_ppm) <= DRIFT_BOUND_PPM,
+              "estimate within the drift bound", drift_ppm);
+  ok &= check(abs(stats->drift_ppm - expected_ppm) <= settle_ppm,
+              "estimate settled on the drift", drift_ppm);
+  ok &= check(max_read_error_ms <= read_bound_ms,
+              "network time between beacons within the bound", drift_ppm);
+  ok &= check(stats->resets == 0, "no clock restart", drift_ppm);
+  return ok;
+}
+
+static bool check(bool condition, const char *what, int32_t drift_ppm)
+{
+  if (!condition) {
+    printf("FAIL: %s at %ld ppm\n", what, (long)drift_ppm);
+    failed_checks++;
+  }
+  return condition;
+}
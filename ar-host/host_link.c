@@ -0,0 +1,683 @@
+/***************************************************************************//**
+ * @file host_link.c
+ * @brief host_link.c
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+// Client of the host link of the sink: typed requests multiplexed with the
+// CLI on the serial port, several of them outstanding at a time.
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#define _DEFAULT_SOURCE
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <time.h>
+#include <unistd.h>
+#include "host_link.h"
+#include "sink_io.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define RESPONSE_PREFIX                "#HL "
+#define RESPONSE_PREFIX_LENGTH         (sizeof(RESPONSE_PREFIX) - 1)
+/// ID, type, status and CRC
+#define RESPONSE_MIN_LENGTH            (5u)
+#define FRAME_MAX_LENGTH               (HOST_LINK_LINE_SIZE / 2)
+/// Time given to the sink to switch its baud rate
+#define SWITCH_DELAY_MS                (20)
+
+/// Result of host_link_call()
+typedef struct {
+  uint8_t id;
+  bool done;
+  int status;
+  uint8_t *payload;
+  size_t *length;
+} call_t;
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+static uint64_t now_us(void);
+static int write_all(int fd, const char *data, size_t length);
+static void handle_line(host_link_t *link,
+                        const char *line,
+                        size_t length,
+                        host_link_response_cb_t callback,
+                        void *context);
+static int hex_value(char c);
+static void on_call_response(const host_link_response_t *response, void *context);
+static void store_le16(uint8_t *buffer, uint16_t value);
+static uint16_t fetch_le16(const uint8_t *buffer);
+static uint32_t fetch_le32(const uint8_t *buffer);
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+int host_link_open(host_link_t *link, const char *port, speed_t baud, unsigned options)
+{
+  memset(link, 0, sizeof(*link));
+  link->speed = baud;
+  link->fd = sink_open_serial(port, baud, options | SINK_SERIAL_NONBLOCK);
+  return (link->fd < 0) ? -1 : 0;
+}
+
+void host_link_close(host_link_t *link)
+{
+  if (link->fd >= 0) {
+    close(link->fd);
+  }
+  link->fd = -1;
+}
+
+void host_link_set_line_callback(host_link_t *link,
+                                 host_link_line_cb_t callback,
+                                 void *context)
+{
+  link->on_line = callback;
+  link->line_context = context;
+}
+
+int host_link_send(host_link_t *link,
+                   host_link_type_t type,
+                   const uint8_t *payload,
+                   size_t length)
+{
+  static const char hex[] = "0123456789ABCDEF";
+  uint8_t frame[2 + HOST_LINK_MAX_REQUEST_PAYLOAD + 2];
+  char text[sizeof("hl {}\n") + 2 * sizeof(frame)];
+  size_t frame_length;
+  size_t text_length;
+  uint8_t id;
+  size_t i;
+
+  if (length > HOST_LINK_MAX_REQUEST_PAYLOAD) {
+    errno = EMSGSIZE;
+    return -1;
+  }
+  if (link->pending == 256) {
+    errno = EBUSY;
+    return -1;
+  }
+  id = link->next_id;
+  while (link->outstanding[id]) {
+    id++;
+  }
+  link->next_id = (uint8_t)(id + 1);
+
+  frame[0] = id;
+  frame[1] = (uint8_t)type;
+  if (length > 0) {
+    memcpy(frame + 2, payload, length);
+  }
+  frame_length = 2 + length;
+  store_le16(frame + frame_length, host_link_crc(frame, frame_length, 0xFFFF));
+  frame_length += 2;
+
+  memcpy(text, "hl {", 4);
+  text_length = 4;
+  for (i = 0; i < frame_length; i++) {
+    text[text_length++] = hex[frame[i] >> 4];
+    text[text_length++] = hex[frame[i] & 0xF];
+  }
+  text[text_length++] = '}';
+  text[text_length++] = '\n';
+
+  link->outstanding[id] = true;
+  link->sent_us[id] = now_us();
+  link->pending++;
+  link->requests++;
+  if (write_all(link->fd, text, text_length) != 0) {
+    link->outstanding[id] = false;
+    link->pending--;
+    return -1;
+  }
+  return id;
+}
+
+int host_link_poll(host_link_t *link,
+                   int timeout_ms,
+                   host_link_response_cb_t callback,
+                   void *context)
+{
+  struct pollfd pfd = { .fd = link->fd, .events = POLLIN };
+  uint64_t responses = link->responses;
+  int ready = poll(&pfd, 1, timeout_ms);
+
+  if (ready < 0) {
+    return (errno == EINTR) ? 0 : -1;
+  }
+  while (ready > 0) {
+    ssize_t length = read(link->fd, link->buffer + link->length,
+                          sizeof(link->buffer) - link->length);
+    char *line = link->buffer;
+    char *end;
+    char *newline;
+
+    if (length < 0 && (errno == EAGAIN || errno == EINTR)) {
+      break;
+    }
+    if (length <= 0) {
+      if (length == 0) {
+        errno = EPIPE;
+      }
+      return -1;
+    }
+    end = link->buffer + link->length + (size_t)length;
+    while ((newline = memchr(line, '\n', (size_t)(end - line))) != NULL) {
+      handle_line(link, line, (size_t)(newline - line), callback, context);
+      line = newline + 1;
+    }
+    link->length = (size_t)(end - line);
+    if (link->length == sizeof(link->buffer)) {
+      // Not a line of the sink: drop it.
+      link->length = 0;
+    } else if (line != link->buffer && link->length > 0) {
+      memmove(link->buffer, line, link->length);
+    }
+  }
+  return (int)(link->responses - responses);
+}
+
+unsigned host_link_expire(host_link_t *link, unsigned timeout_ms)
+{
+  uint64_t limit_us = now_us() - (uint64_t)timeout_ms * 1000u;
+  unsigned expired = 0;
+  unsigned id;
+
+  for (id = 0; id < 256 && link->pending > 0; id++) {
+    if (link->outstanding[id] && link->sent_us[id] < limit_us) {
+      link->outstanding[id] = false;
+      link->pending--;
+      expired++;
+    }
+  }
+  link->expired += expired;
+  return expired;
+}
+
+int host_link_call(host_link_t *link,
+                   host_link_type_t type,
+                   const uint8_t *payload,
+                   size_t length,
+                   uint8_t *response,
+                   size_t *response_length,
+                   int timeout_ms)
+{
+  uint64_t deadline_us = now_us() + (uint64_t)timeout_ms * 1000u;
+  call_t call = { .payload = response, .length = response_length };
+  int id = host_link_send(link, type, payload, length);
+
+  if (id < 0) {
+    return -1;
+  }
+  call.id = (uint8_t)id;
+  while (!call.done) {
+    uint64_t now = now_us();
+    if (now >= deadline_us) {
+      link->outstanding[call.id] = false;
+      link->pending--;
+      link->expired++;
+      errno = ETIMEDOUT;
+      return -1;
+    }
+    if (host_link_poll(link, (int)((deadline_us - now + 999) / 1000),
+                       on_call_response, &call) < 0) {
+      return -1;
+    }
+  }
+  return call.status;
+}
+
+int host_link_get_info(host_link_t *link, host_link_info_t *info, int timeout_ms)
+{
+  uint8_t payload[13];
+  size_t length = sizeof(payload);
+  int status = host_link_call(link, HOST_LINK_INFO, NULL, 0, payload, &length, timeout_ms);
+
+  if (status == 0) {
+    if (length < sizeof(payload)) {
+      return HOST_LINK_STATUS_BAD_FRAME;
+    }
+    info->network_state = payload[0];
+    info->node_type = payload[1];
+    info->node_id = fetch_le16(payload + 2);
+    info->pan_id = fetch_le16(payload + 4);
+    info->channel = fetch_le16(payload + 6);
+    info->power = (int16_t)fetch_le16(payload + 8);
+    info->tx_options = payload[10];
+    info->sensors = payload[11];
+    info->table_size = payload[12];
+  }
+  return status;
+}
+
+int host_link_get_sensors(host_link_t *link,
+                          uint8_t first,
+                          host_link_sensor_t *sensors,
+                          size_t max_count,
+                          size_t *count,
+                          uint8_t *next,
+                          int timeout_ms)
+{
+  uint8_t payload[FRAME_MAX_LENGTH];
+  size_t length = sizeof(payload);
+  int status = host_link_call(link, HOST_LINK_SENSORS, &first, 1, payload, &length,
+                              timeout_ms);
+  const uint8_t *entry = payload + 2;
+  size_t i;
+  int byte;
+
+  *count = 0;
+  if (status != 0) {
+    return status;
+  }
+  if (length < 2 || length < 2 + (size_t)payload[1] * HOST_LINK_SENSOR_ENTRY_LENGTH) {
+    return HOST_LINK_STATUS_BAD_FRAME;
+  }
+  *next = payload[0];
+  for (i = 0; i < payload[1] && i < max_count; i++) {
+    sensors[i].index = entry[0];
+    sensors[i].node_id = fetch_le16(entry + 1);
+    sensors[i].parent_id = fetch_le16(entry + 3);
+    sensors[i].eui64 = 0;
+    for (byte = 7; byte >= 0; byte--) {
+      sensors[i].eui64 = (sensors[i].eui64 << 8) | entry[5 + byte];
+    }
+    sensors[i].age_ms = fetch_le32(entry + 13);
+    entry += HOST_LINK_SENSOR_ENTRY_LENGTH;
+  }
+  *count = i;
+  if (i < payload[1]) {
+    // The caller's array is full: resume from the first entry not returned.
+    *next = entry[0];
+  }
+  return status;
+}
+
+int host_link_query_sensors(host_link_t *link,
+                            uint8_t cursor,
+                            uint8_t limit,
+                            uint8_t fields,
+                            const host_link_sensor_filter_t *filter,
+                            host_link_sensor_row_t *rows,
+                            size_t max_count,
+                            size_t *count,
+                            uint8_t *next,
+                            int timeout_ms)
+{
+  uint8_t request[8];
+  uint8_t payload[FRAME_MAX_LENGTH];
+  size_t length = sizeof(payload);
+  size_t request_length = 3;
+  size_t entry_length;
+  const uint8_t *entry;
+  size_t i;
+  int byte;
+  int status;
+
+  *count = 0;
+  if (max_count == 0) {
+    errno = EINVAL;
+    return -1;
+  }
+  if (limit == 0 || limit > max_count) {
+    limit = (uint8_t)((max_count < 255) ? max_count : 255);
+  }
+  request[0] = cursor;
+  request[1] = limit;
+  request[2] = fields;
+  if (filter != NULL) {
+    store_le16(request + 3, filter->stale_s);
+    request[5] = (uint8_t)filter->rssi_below;
+    store_le16(request + 6, filter->parent_id);
+    request_length = 8;
+  }
+  status = host_link_call(link, HOST_LINK_SENSOR_QUERY, request, request_length,
+                          payload, &length, timeout_ms);
+  if (status != 0) {
+    return status;
+  }
+  if (length < 3) {
+    return HOST_LINK_STATUS_BAD_FRAME;
+  }
+  fields = payload[2];
+  entry_length = 1 + ((fields & HOST_LINK_FIELD_NODE_ID) ? 2 : 0)
+                 + ((fields & HOST_LINK_FIELD_EUI64) ? 8 : 0)
+                 + ((fields & HOST_LINK_FIELD_PARENT) ? 2 : 0)
+                 + ((fields & HOST_LINK_FIELD_AGE) ? 4 : 0)
+                 + ((fields & HOST_LINK_FIELD_RSSI) ? 1 : 0)
+                 + ((fields & HOST_LINK_FIELD_DATA) ? 8 : 0);
+  if (payload[1] > max_count || length < 3 + (size_t)payload[1] * entry_length) {
+    return HOST_LINK_STATUS_BAD_FRAME;
+  }
+  *next = payload[0];
+  entry = payload + 3;
+  for (i = 0; i < payload[1]; i++) {
+    memset(&rows[i], 0, sizeof(rows[i]));
+    rows[i].fields = fields;
+    rows[i].index = *entry++;
+    if (fields & HOST_LINK_FIELD_NODE_ID) {
+      rows[i].node_id = fetch_le16(entry);
+      entry += 2;
+    }
+    if (fields & HOST_LINK_FIELD_EUI64) {
+      for (byte = 7; byte >= 0; byte--) {
+        rows[i].eui64 = (rows[i].eui64 << 8) | entry[byte];
+      }
+      entry += 8;
+    }
+    if (fields & HOST_LINK_FIELD_PARENT) {
+      rows[i].parent_id = fetch_le16(entry);
+      entry += 2;
+    }
+    if (fields & HOST_LINK_FIELD_AGE) {
+      rows[i].age_ms = fetch_le32(entry);
+      entry += 4;
+    }
+    if (fields & HOST_LINK_FIELD_RSSI) {
+      rows[i].rssi = (int8_t)*entry++;
+    }
+    if (fields & HOST_LINK_FIELD_DATA) {
+      rows[i].temperature = (int32_t)fetch_le32(entry);
+      rows[i].humidity = fetch_le32(entry + 4);
+      entry += 8;
+    }
+  }
+  *count = i;
+  return status;
+}
+
+int host_link_send_data(host_link_t *link,
+                        uint16_t destination,
+                        const uint8_t *data,
+                        size_t length,
+                        int timeout_ms)
+{
+  uint8_t payload[HOST_LINK_MAX_REQUEST_PAYLOAD];
+
+  if (length > sizeof(payload) - 2) {
+    errno = EMSGSIZE;
+    return -1;
+  }
+  store_le16(payload, destination);
+  if (length > 0) {
+    memcpy(payload + 2, data, length);
+  }
+  return host_link_call(link, HOST_LINK_SEND_DATA, payload, 2 + length, NULL, NULL,
+                        timeout_ms);
+}
+
+int host_link_permit_join(host_link_t *link,
+                          uint8_t duration_s,
+                          const uint8_t *join_payload,
+                          size_t length,
+                          int timeout_ms)
+{
+  uint8_t payload[HOST_LINK_MAX_REQUEST_PAYLOAD];
+
+  if (length > sizeof(payload) - 1) {
+    errno = EMSGSIZE;
+    return -1;
+  }
+  payload[0] = duration_s;
+  if (length > 0) {
+    memcpy(payload + 1, join_payload, length);
+  }
+  return host_link_call(link, HOST_LINK_PERMIT_JOIN, payload, 1 + length, NULL, NULL,
+                        timeout_ms);
+}
+
+int host_link_get_counters(host_link_t *link,
+                           bool reset,
+                           uint8_t *snapshot,
+                           size_t *length,
+                           int timeout_ms)
+{
+  uint8_t flags = reset ? 0x01u : 0x00u;
+
+  return host_link_call(link, HOST_LINK_COUNTERS, &flags, 1, snapshot, length,
+                        timeout_ms);
+}
+
+int host_link_set_baud(host_link_t *link, unsigned long baud, int timeout_ms)
+{
+  speed_t speed = sink_baud_to_speed(baud);
+  uint8_t payload[4];
+  int status;
+
+  if (speed == 0) {
+    errno = EINVAL;
+    return -1;
+  }
+  payload[0] = (uint8_t)baud;
+  payload[1] = (uint8_t)(baud >> 8);
+  payload[2] = (uint8_t)(baud >> 16);
+  payload[3] = (uint8_t)(baud >> 24);
+  status = host_link_call(link, HOST_LINK_SET_BAUD, payload, sizeof(payload), NULL, NULL,
+                          timeout_ms);
+  if (status != 0) {
+    return status;
+  }
+
+  // The sink switches once its answer is out. Whatever it sends meanwhile is
+  // garbled, so it is dropped along with the partial line.
+  if (sink_set_serial_speed(link->fd, speed) != 0) {
+    return -1;
+  }
+  poll(NULL, 0, SWITCH_DELAY_MS);
+  tcflush(link->fd, TCIFLUSH);
+  link->length = 0;
+
+  status = host_link_call(link, HOST_LINK_PING, NULL, 0, NULL, NULL, timeout_ms);
+  if (status != 0) {
+    int error = errno;
+    sink_set_serial_speed(link->fd, link->speed);
+    errno = error;
+    return status;
+  }
+  link->speed = speed;
+  return 0;
+}
+
+int host_link_stream(host_link_t *link,
+                     uint16_t count,
+                     uint8_t line_length,
+                     host_link_stream_t *result,
+                     int timeout_ms)
+{
+  uint8_t payload[10];
+  size_t length = sizeof(payload);
+  int status;
+
+  store_le16(payload, count);
+  payload[2] = line_length;
+  status = host_link_call(link, HOST_LINK_STREAM, payload, 3, payload, &length, timeout_ms);
+  if (status == 0) {
+    if (length < sizeof(payload)) {
+      return HOST_LINK_STATUS_BAD_FRAME;
+    }
+    result->lines = fetch_le16(payload);
+    result->bytes = fetch_le32(payload + 2);
+    result->duration_ms = fetch_le32(payload + 6);
+  }
+  return status;
+}
+
+uint16_t host_link_crc(const uint8_t *buffer, size_t length, uint16_t crc)
+{
+  int bit;
+
+  while (length-- > 0) {
+    crc ^= (uint16_t)(*buffer++) << 8;
+    for (bit = 0; bit < 8; bit++) {
+      crc = (crc & 0x8000u) ? (uint16_t)((crc << 1) ^ 0x1021u) : (uint16_t)(crc << 1);
+    }
+  }
+  return crc;
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+static uint64_t now_us(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+static int write_all(int fd, const char *data, size_t length)
+{
+  while (length > 0) {
+    ssize_t written = write(fd, data, length);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == EAGAIN) {
+        struct pollfd pfd = { .fd = fd, .events = POLLOUT };
+        poll(&pfd, 1, 100);
+        continue;
+      }
+      return -1;
+    }
+    data += written;
+    length -= (size_t)written;
+  }
+  return 0;
+}
+
+static void handle_line(host_link_t *link,
+                        const char *line,
+                        size_t length,
+                        host_link_response_cb_t callback,
+                        void *context)
+{
+  uint8_t frame[FRAME_MAX_LENGTH];
+  host_link_response_t response;
+  const char *end = line + length;
+  const char *p;
+  size_t frame_length = 0;
+
+  if (length > 0 && line[length - 1] == '\r') {
+    end--;
+  }
+  // The CLI prompt may precede the response.
+  p = memchr(line, '#', (size_t)(end - line));
+  while (p != NULL && ((size_t)(end - p) < RESPONSE_PREFIX_LENGTH
+                       || memcmp(p, RESPONSE_PREFIX, RESPONSE_PREFIX_LENGTH) != 0)) {
+    p = memchr(p + 1, '#', (size_t)(end - p - 1));
+  }
+  if (p == NULL) {
+    if (link->on_line != NULL) {
+      link->on_line(line, (size_t)(end - line), link->line_context);
+    }
+    return;
+  }
+
+  p += RESPONSE_PREFIX_LENGTH;
+  while (end > p && end[-1] == ' ') {
+    end--;
+  }
+  while (p + 1 < end && frame_length < sizeof(frame)) {
+    int high = hex_value(p[0]);
+    int low = hex_value(p[1]);
+    if (high < 0 || low < 0) {
+      break;
+    }
+    frame[frame_length++] = (uint8_t)(high << 4 | low);
+    p += 2;
+  }
+  if (p != end || frame_length < RESPONSE_MIN_LENGTH
+      || host_link_crc(frame, frame_length - 2, 0xFFFF)
+      != fetch_le16(frame + frame_length - 2)
+      || (frame[1] & HOST_LINK_RESPONSE) == 0) {
+    link->bad_frames++;
+    return;
+  }
+  if (!link->outstanding[frame[0]]) {
+    // Given up, or the response to another client
+    link->unmatched++;
+    return;
+  }
+  link->outstanding[frame[0]] = false;
+  link->pending--;
+  link->responses++;
+
+  response.id = frame[0];
+  response.type = frame[1] & (uint8_t)~HOST_LINK_RESPONSE;
+  response.status = frame[2];
+  response.payload = frame + 3;
+  response.length = frame_length - RESPONSE_MIN_LENGTH;
+  response.round_trip_us = now_us() - link->sent_us[frame[0]];
+  if (callback != NULL) {
+    callback(&response, context);
+  }
+}
+
+static int hex_value(char c)
+{
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  return -1;
+}
+
+static void on_call_response(const host_link_response_t *response, void *context)
+{
+  call_t *call = context;
+
+  if (response->id != call->id) {
+    return;
+  }
+  call->done = true;
+  call->status = response->status;
+  if (call->length != NULL) {
+    size_t length = (response->length < *call->length) ? response->length : *call->length;
+    if (call->payload != NULL) {
+      memcpy(call->payload, response->payload, length);
+    }
+    *call->length = length;
+  }
+}
+
+static void store_le16(uint8_t *buffer, uint16_t value)
+{
+  buffer[0] = (uint8_t)value;
+  buffer[1] = (uint8_t)(value >> 8);
+}
+
+static uint16_t fetch_le16(const uint8_t *buffer)
+{
+  return (uint16_t)(buffer[0] | buffer[1] << 8);
+}
+
+static uint32_t fetch_le32(const uint8_t *buffer)
+{
+  return (uint32_t)buffer[0] | ((uint32_t)buffer[1] << 8)
+         | ((uint32_t)buffer[2] << 16) | ((uint32_t)buffer[3] << 24);
+}
@@ -0,0 +1,324 @@
+/***************************************************************************//**
+ * @file host_link.h
+ * @brief host_link.h
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+#ifndef HOST_LINK_H
+#define HOST_LINK_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <termios.h>
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Frames of the host link of the sink, see ar-gateway/app_host_link.h: the
+/// request ID, the message type, the payload and the CRC-16/CCITT of the
+/// preceding bytes. Requests are sent as "hl {<hex>}" CLI commands, the
+/// responses come back as "#HL <hex>" lines between the other output.
+#define HOST_LINK_VERSION              (1u)
+#define HOST_LINK_RESPONSE             (0x80u)
+#define HOST_LINK_MAX_REQUEST_PAYLOAD  (57u)
+#define HOST_LINK_SENSOR_ENTRY_LENGTH  (17u)
+#define HOST_LINK_LINE_SIZE            (4096u)
+
+/// Link statuses, the other statuses are EmberStatus values
+#define HOST_LINK_STATUS_BAD_FRAME     (0xF0u)
+#define HOST_LINK_STATUS_UNKNOWN_TYPE  (0xF1u)
+#define HOST_LINK_STATUS_BAD_ARGUMENT  (0xF2u)
+#define HOST_LINK_STATUS_BUSY          (0xF3u)
+
+/// Lines of HOST_LINK_STREAM: "#HS <sequence, 4 hex digits> " and filler
+#define HOST_LINK_STREAM_PREFIX        "#HS "
+#define HOST_LINK_STREAM_MIN_LINE      (9u)
+#define HOST_LINK_STREAM_MAX_LINE      (200u)
+
+typedef enum {
+  HOST_LINK_PING        = 0x01,
+  HOST_LINK_INFO        = 0x02,
+  HOST_LINK_SENSORS     = 0x03,
+  HOST_LINK_SEND_DATA   = 0x04,
+  HOST_LINK_PERMIT_JOIN = 0x05,
+  HOST_LINK_COUNTERS    = 0x06,
+  HOST_LINK_SET_BAUD    = 0x07,
+  HOST_LINK_STREAM      = 0x08,
+  HOST_LINK_SENSOR_QUERY = 0x09
+} host_link_type_t;
+
+/// Fields of HOST_LINK_SENSOR_QUERY, in entry order after the entry index
+#define HOST_LINK_FIELD_NODE_ID        (0x01u)
+#define HOST_LINK_FIELD_EUI64          (0x02u)
+#define HOST_LINK_FIELD_PARENT         (0x04u)
+#define HOST_LINK_FIELD_AGE            (0x08u)
+#define HOST_LINK_FIELD_RSSI           (0x10u)
+#define HOST_LINK_FIELD_DATA           (0x20u)
+#define HOST_LINK_FIELD_ALL            (0x3Fu)
+/// RSSI of a sensor not heard since it joined the table
+#define HOST_LINK_RSSI_UNKNOWN         (127)
+/// Parent ID of a sensor attached to the sink
+#define HOST_LINK_NULL_NODE_ID         (0xFFFFu)
+
+/// A response, valid during the callback only
+typedef struct {
+  uint8_t id;
+  uint8_t type;
+  uint8_t status;
+  /// Payload after the status
+  const uint8_t *payload;
+  size_t length;
+  uint64_t round_trip_us;
+} host_link_response_t;
+
+typedef void (*host_link_response_cb_t)(const host_link_response_t *response,
+                                        void *context);
+/// Called for every line that is not a response, e.g. the record lines
+typedef void (*host_link_line_cb_t)(const char *line, size_t length, void *context);
+
+typedef struct {
+  int fd;
+  speed_t speed;
+  char buffer[HOST_LINK_LINE_SIZE];
+  size_t length;
+  uint8_t next_id;
+  /// Requests waiting for their response, by request ID
+  bool outstanding[256];
+  uint64_t sent_us[256];
+  unsigned pending;
+  host_link_line_cb_t on_line;
+  void *line_context;
+  /// Metrics
+  uint64_t requests;
+  uint64_t responses;
+  uint64_t bad_frames;
+  uint64_t unmatched;
+  uint64_t expired;
+} host_link_t;
+
+typedef struct {
+  uint8_t network_state;
+  uint8_t node_type;
+  uint16_t node_id;
+  uint16_t pan_id;
+  uint16_t channel;
+  int16_t power;
+  uint8_t tx_options;
+  uint8_t sensors;
+  uint8_t table_size;
+} host_link_info_t;
+
+/// Outcome of a stream test, as counted by the sink
+typedef struct {
+  uint16_t lines;
+  uint32_t bytes;
+  uint32_t duration_ms;
+} host_link_stream_t;
+
+typedef struct {
+  uint8_t index;
+  uint16_t node_id;
+  uint16_t parent_id;
+  uint64_t eui64;
+  uint32_t age_ms;
+} host_link_sensor_t;
+
+/// Filters of a sensor query, 0 (HOST_LINK_NULL_NODE_ID for the parent)
+/// disables one
+typedef struct {
+  uint16_t stale_s;
+  int8_t rssi_below;
+  uint16_t parent_id;
+} host_link_sensor_filter_t;
+
+/// Result of a sensor query, only the fields returned by the sink are set
+typedef struct {
+  uint8_t fields;
+  uint8_t index;
+  uint16_t node_id;
+  uint64_t eui64;
+  uint16_t parent_id;
+  uint32_t age_ms;
+  int8_t rssi;
+  /// Latest report, 0 if none
+  int32_t temperature;
+  uint32_t humidity;
+} host_link_sensor_row_t;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Opens the serial port of a sink.
+ *
+ * @param options are SINK_SERIAL_ flags, see sink_io.h
+ * @returns 0, or -1 with errno set.
+ *****************************************************************************/
+int host_link_open(host_link_t *link, const char *port, speed_t baud, unsigned options);
+
+/**************************************************************************//**
+ * Closes the serial port, the outstanding requests are forgotten.
+ *****************************************************************************/
+void host_link_close(host_link_t *link);
+
+/**************************************************************************//**
+ * Sets the callback of the lines that are not responses.
+ *****************************************************************************/
+void host_link_set_line_callback(host_link_t *link,
+                                 host_link_line_cb_t callback,
+                                 void *context);
+
+/**************************************************************************//**
+ * Sends a request without waiting for its response, so that several can be
+ * outstanding.
+ *
+ * @returns the request ID, or -1 with errno set: EMSGSIZE if the payload is
+ *          longer than HOST_LINK_MAX_REQUEST_PAYLOAD, EBUSY if 256 requests
+ *          are outstanding.
+ *****************************************************************************/
+int host_link_send(host_link_t *link,
+                   host_link_type_t type,
+                   const uint8_t *payload,
+                   size_t length);
+
+/**************************************************************************//**
+ * Reads what the sink sent, waiting up to timeout_ms for something to read,
+ * and calls back for every response to an outstanding request.
+ *
+ * @returns the number of responses, or -1 with errno set.
+ *****************************************************************************/
+int host_link_poll(host_link_t *link,
+                   int timeout_ms,
+                   host_link_response_cb_t callback,
+                   void *context);
+
+/**************************************************************************//**
+ * Gives up the requests outstanding for longer than timeout_ms.
+ *
+ * @returns the number of requests given up.
+ *****************************************************************************/
+unsigned host_link_expire(host_link_t *link, unsigned timeout_ms);
+
+/**************************************************************************//**
+ * Sends a request and waits for its response. The responses to other
+ * outstanding requests are dropped meanwhile.
+ *
+ * @param *response receives the response payload after the status, may be
+ *        NULL
+ * @param *response_length is the size of response, receives the length of
+ *        the payload
+ * @returns the status, or -1 with errno set (ETIMEDOUT).
+ *****************************************************************************/
+int host_link_call(host_link_t *link,
+                   host_link_type_t type,
+                   const uint8_t *payload,
+                   size_t length,
+                   uint8_t *response,
+                   size_t *response_length,
+                   int timeout_ms);
+
+/**************************************************************************//**
+ * Typed calls, the same return values as host_link_call().
+ *****************************************************************************/
+int host_link_get_info(host_link_t *link, host_link_info_t *info, int timeout_ms);
+
+/**************************************************************************//**
+ * Reads a page of the sensor table, from entry first on.
+ *
+ * @param *next receives the first entry of the next page, 0xFF after the
+ *        last page
+ *****************************************************************************/
+int host_link_get_sensors(host_link_t *link,
+                          uint8_t first,
+                          host_link_sensor_t *sensors,
+                          size_t max_count,
+                          size_t *count,
+                          uint8_t *next,
+                          int timeout_ms);
+
+/**************************************************************************//**
+ * Reads a page of the sensors that pass the filters, from entry cursor on.
+ *
+ * @param limit is the page size, 0 for as many entries as fit a response
+ * @param fields are HOST_LINK_FIELD_ flags, 0 for the default ones of the
+ *        sink
+ * @param *filter may be NULL
+ * @param *next receives the cursor of the next page, 0xFF after the last
+ *        match
+ *****************************************************************************/
+int host_link_query_sensors(host_link_t *link,
+                            uint8_t cursor,
+                            uint8_t limit,
+                            uint8_t fields,
+                            const host_link_sensor_filter_t *filter,
+                            host_link_sensor_row_t *rows,
+                            size_t max_count,
+                            size_t *count,
+                            uint8_t *next,
+                            int timeout_ms);
+
+int host_link_send_data(host_link_t *link,
+                        uint16_t destination,
+                        const uint8_t *data,
+                        size_t length,
+                        int timeout_ms);
+
+int host_link_permit_join(host_link_t *link,
+                          uint8_t duration_s,
+                          const uint8_t *join_payload,
+                          size_t length,
+                          int timeout_ms);
+
+/**************************************************************************//**
+ * Reads the binary counter snapshot, see app_counters_dump().
+ *****************************************************************************/
+int host_link_get_counters(host_link_t *link,
+                           bool reset,
+                           uint8_t *snapshot,
+                           size_t *length,
+                           int timeout_ms);
+
+/**************************************************************************//**
+ * Switches the link to another baud rate: the sink answers at the current
+ * rate and switches, then both sides talk at the new rate and a ping
+ * confirms it to the sink. If the ping gets no answer, the port goes back to
+ * the current rate, as the sink does when the confirmation does not come.
+ *
+ * @returns the status, or -1 with errno set (EINVAL for a rate the port does
+ *          not support).
+ *****************************************************************************/
+int host_link_set_baud(host_link_t *link, unsigned long baud, int timeout_ms);
+
+/**************************************************************************//**
+ * Runs a throughput test: the sink prints count "#HS" lines of line_length
+ * characters, which reach the line callback, then answers with what it
+ * sent.
+ *
+ * @param timeout_ms is counted from the request to the end of the stream
+ *****************************************************************************/
+int host_link_stream(host_link_t *link,
+                     uint16_t count,
+                     uint8_t line_length,
+                     host_link_stream_t *result,
+                     int timeout_ms);
+
+/**************************************************************************//**
+ * Computes the CRC-16/CCITT of a buffer, 0xFFFF as initial value for a frame.
+ *****************************************************************************/
+uint16_t host_link_crc(const uint8_t *buffer, size_t length, uint16_t crc);
+
+#endif  // HOST_LINK_H
@@ -0,0 +1,242 @@
+/***************************************************************************//**
+ * @file sensor_table_bench.c
+ * @brief sensor_table_bench.c
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+// Host benchmark of the sink sensor table: timeout sweep and lookup cost of
+// ar-gateway/app_sensor_table.c, built as is against the stack stand-ins of
+// stub/, against a reference copy of the former array of structs. Both
+// tables are sized by ar-gateway/config/sensor-table-config.h and the report
+// length of stub/sl_app_common.h; build with -DSENSOR_SINK_DATA_LENGTH=<n> to
+// match another SDK.
+//
+// The sweeps run with every entry fresh, the cost of the scan a sweep pays on
+// every main loop iteration; the run checks that no entry was freed.
+//
+// Build: gcc -O2 -Wall -Istub -I../ar-gateway -I../ar-gateway/config
+//            -DPLATFORM_HEADER='"host_platform.h"' -o sensor_table_bench
+//            sensor_table_bench.c ../ar-gateway/app_sensor_table.c
+//            stub/host_stack.c
+// Usage: sensor_table_bench [iterations]
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include PLATFORM_HEADER
+#include "stack/include/ember.h"
+#include "hal/hal.h"
+#include "sl_app_common.h"
+#include "app_sensor_table.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define DEFAULT_ITERATIONS      (200000u)
+#define TIMEOUT_MS              (60000u)
+/// Node ID of the first entry, the others follow
+#define FIRST_NODE_ID           (0x1000u)
+/// The sink functions are called from another file, the reference copies
+/// must not be inlined into the measured loops either
+#define NOINLINE                __attribute__((noinline))
+
+/// Former entry layout, hot and cold fields interleaved
+typedef struct {
+  EmberNodeId node_id;
+  uint8_t node_eui64[EUI64_SIZE];
+  EmberNodeId parent_id;
+  int8_t last_rssi;
+  uint8_t history_head;
+  uint8_t history_count;
+  uint8_t reported_data_length[APP_SENSOR_TABLE_HISTORY_DEPTH];
+  uint8_t reported_data[APP_SENSOR_TABLE_HISTORY_DEPTH][SENSOR_SINK_DATA_LENGTH];
+  uint32_t last_report_ms;
+} aos_entry_t;
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static aos_entry_t aos[APP_SENSOR_TABLE_SIZE];
+/// Keeps the compiler from dropping the measured loops
+static volatile uint32_t sink;
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+static double now_ns(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return ts.tv_sec * 1e9 + ts.tv_nsec;
+}
+
+static void make_eui64(uint8_t index, uint8_t *eui64)
+{
+  uint8_t j;
+
+  for (j = 0; j < EUI64_SIZE; j++) {
+    eui64[j] = (uint8_t)(index * 31 + j);
+  }
+}
+
+/**************************************************************************//**
+ * Fills both tables, the sink one through app_sensor_table_add(). Every
+ * entry reports at the current time of the stub clock.
+ *****************************************************************************/
+static bool fill(void)
+{
+  uint8_t eui64[EUI64_SIZE];
+  bool added;
+  uint8_t i;
+
+  app_sensor_table_init();
+  for (i = 0; i < APP_SENSOR_TABLE_SIZE; i++) {
+    make_eui64(i, eui64);
+    if (app_sensor_table_add((EmberNodeId)(FIRST_NODE_ID + i), eui64, &added) != i
+        || !added) {
+      return false;
+    }
+    aos[i].node_id = (EmberNodeId)(FIRST_NODE_ID + i);
+    MEMCOPY(aos[i].node_eui64, eui64, EUI64_SIZE);
+    aos[i].last_report_ms = halCommonGetInt32uMillisecondTick();
+  }
+  return true;
+}
+
+NOINLINE static uint8_t aos_sweep(uint32_t now_ms, uint32_t timeout_ms)
+{
+  uint8_t removed = 0;
+  uint8_t i;
+
+  for (i = 0; i < APP_SENSOR_TABLE_SIZE; i++) {
+    if (aos[i].node_id != EMBER_NULL_NODE_ID
+        && elapsedTimeInt32u(aos[i].last_report_ms, now_ms) > timeout_ms) {
+      aos[i].node_id = EMBER_NULL_NODE_ID;
+      removed++;
+    }
+  }
+  return removed;
+}
+
+NOINLINE static uint8_t aos_find_node(EmberNodeId node_id)
+{
+  uint8_t i;
+
+  for (i = 0; i < APP_SENSOR_TABLE_SIZE; i++) {
+    if (aos[i].node_id == node_id) {
+      return i;
+    }
+  }
+  return APP_SENSOR_TABLE_INVALID_INDEX;
+}
+
+NOINLINE static uint8_t aos_find_eui64(const uint8_t *eui64)
+{
+  uint8_t i;
+
+  for (i = 0; i < APP_SENSOR_TABLE_SIZE; i++) {
+    if (aos[i].node_id != EMBER_NULL_NODE_ID
+        && MEMCOMPARE(aos[i].node_eui64, eui64, EUI64_SIZE) == 0) {
+      return i;
+    }
+  }
+  return APP_SENSOR_TABLE_INVALID_INDEX;
+}
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  uint32_t iterations = (argc > 1) ? (uint32_t)strtoul(argv[1], NULL, 0)
+                        : DEFAULT_ITERATIONS;
+  uint8_t eui64[APP_SENSOR_TABLE_SIZE + 1][EUI64_SIZE];
+  uint32_t removed = 0;
+  double start;
+  double aos_ns[3];
+  double soa_ns[3];
+  uint32_t n;
+  uint8_t i;
+
+  if (iterations == 0) {
+    iterations = DEFAULT_ITERATIONS;
+  }
+  if (!fill()) {
+    printf("FAIL: the sensor table does not hold %d entries\n",
+           APP_SENSOR_TABLE_SIZE);
+    return 1;
+  }
+  // The extra EUI64 is not in the tables, a lookup miss.
+  for (i = 0; i <= APP_SENSOR_TABLE_SIZE; i++) {
+    make_eui64(i, eui64[i]);
+  }
+  eui64[APP_SENSOR_TABLE_SIZE][0] ^= 0xFF;
+
+  start = now_ns();
+  for (n = 0; n < iterations; n++) {
+    removed += aos_sweep(n % TIMEOUT_MS, TIMEOUT_MS);
+  }
+  aos_ns[0] = (now_ns() - start) / iterations;
+  start = now_ns();
+  for (n = 0; n < iterations; n++) {
+    removed += app_sensor_table_sweep(n % TIMEOUT_MS, TIMEOUT_MS, NULL);
+  }
+  soa_ns[0] = (now_ns() - start) / iterations;
+
+  start = now_ns();
+  for (n = 0; n < iterations; n++) {
+    sink += aos_find_node((EmberNodeId)(FIRST_NODE_ID + n % (APP_SENSOR_TABLE_SIZE + 1)));
+  }
+  aos_ns[1] = (now_ns() - start) / iterations;
+  start = now_ns();
+  for (n = 0; n < iterations; n++) {
+    sink += app_sensor_table_find_node((EmberNodeId)(FIRST_NODE_ID + n % (APP_SENSOR_TABLE_SIZE + 1)));
+  }
+  soa_ns[1] = (now_ns() - start) / iterations;
+
+  start = now_ns();
+  for (n = 0; n < iterations; n++) {
+    sink += aos_find_eui64(eui64[n % (APP_SENSOR_TABLE_SIZE + 1)]);
+  }
+  aos_ns[2] = (now_ns() - start) / iterations;
+  start = now_ns();
+  for (n = 0; n < iterations; n++) {
+    sink += app_sensor_table_find_eui64(eui64[n % (APP_SENSOR_TABLE_SIZE + 1)]);
+  }
+  soa_ns[2] = (now_ns() - start) / iterations;
+
+  printf("entries: %d, history depth: %d, report length: %d, iterations: %lu\n",
+         APP_SENSOR_TABLE_SIZE, APP_SENSOR_TABLE_HISTORY_DEPTH,
+         (int)SENSOR_SINK_DATA_LENGTH, (unsigned long)iterations);
+  printf("bytes read by a sweep: %zu array of structs, %zu struct of arrays\n",
+         sizeof(aos), sizeof(sensor_hot));
+  printf("%-16s %10s %10s\n", "ns/op", "AoS", "SoA");
+  printf("%-16s %10.1f %10.1f\n", "timeout sweep", aos_ns[0], soa_ns[0]);
+  printf("%-16s %10.1f %10.1f\n", "find node ID", aos_ns[1], soa_ns[1]);
+  printf("%-16s %10.1f %10.1f\n", "find EUI64", aos_ns[2], soa_ns[2]);
+
+  if (removed != 0) {
+    printf("FAIL: the sweeps freed %lu fresh entries\n", (unsigned long)removed);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,536 @@
+/***************************************************************************//**
+ * @file sink_aggregator.c
+ * @brief sink_aggregator.c
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+// Aggregator of several sinks of one building. Every serial port has a reader
+// thread of its own, with its own parser, which hands the records to the
+// merge thread through a single producer single consumer lock-free ring. The
+// merge thread drops the copies of a report heard by more than one sink (same
+// EUI64 and sequence number) and writes the rest to one record log and,
+// optionally, one series store with its rollups. The readers share nothing, so they scale
+// with the cores until the merge thread is the bottleneck.
+//
+// Build: gcc -O2 -Wall -pthread -o sink_aggregator sink_aggregator.c
+//            sink_parser.c sink_io.c ts_store.c ts_rollup.c
+// Usage: sink_aggregator [-b <baud>] [-F] [-o <record log>] [-t <series store>]
+//                        [-i <stats period s>] <serial port>...
+//
+// -F enables RTS/CTS on every port, for sinks built with hardware flow
+// control.
+//
+// Per sink metrics, printed every stats period and on exit:
+//   records    records parsed from the port
+//   first      records stored from this sink, i.e. heard here first
+//   dup        copies of records already stored from another sink
+//   lag_ms     queue lag, from the read of a record to its merge (avg/max)
+//   behind_ms  how late the copies of this sink arrive after the first copy
+//              of the same report (avg/max)
+//   silent_s   time since the last record
+// Records without a sequence number (older sensor firmware) are all stored.
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdatomic.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include "sink_parser.h"
+#include "sink_io.h"
+#include "ts_rollup.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define MAX_SINKS               (16u)
+/// Records per ring, a power of 2
+#define RING_SIZE               (16384u)
+/// Records merged from a ring before the next ring is served
+#define MERGE_BATCH             (1024u)
+/// Sensors tracked for the deduplication, a power of 2
+#define MAX_SENSORS             (16384u)
+/// Sequence numbers behind the last one remembered per sensor
+#define SEQUENCE_WINDOW         (64u)
+/// A sequence number further behind than this is a restart of the sensor
+#define RESTART_DISTANCE        (4096u)
+#define REOPEN_DELAY_MS         (1000)
+#define CACHE_LINE              (64)
+
+/// Single producer single consumer ring of records
+typedef struct {
+  _Alignas(CACHE_LINE) atomic_size_t head;
+  _Alignas(CACHE_LINE) atomic_size_t tail;
+  _Alignas(CACHE_LINE) sink_record_t slots[RING_SIZE];
+} ring_t;
+
+typedef struct {
+  /// Owned by the reader
+  const char *port;
+  uint8_t index;
+  pthread_t thread;
+  sink_parser_t parser;
+  size_t head;
+  size_t cached_tail;
+  ring_t ring;
+  /// Written by the reader, read by the stats
+  atomic_uint_fast64_t records;
+  atomic_uint_fast64_t ring_full;
+  atomic_uint_fast64_t reconnects;
+  atomic_uint_fast64_t parse_errors;
+  atomic_uint_fast64_t last_record_us;
+  /// Owned by the merge thread
+  uint64_t first;
+  uint64_t duplicates;
+  uint64_t stale;
+  uint64_t lag_sum_us;
+  uint64_t lag_max_us;
+  uint64_t lag_count;
+  uint64_t behind_sum_us;
+  uint64_t behind_max_us;
+  uint64_t behind_count;
+  size_t peak_depth;
+} sink_t;
+
+/// Sequence numbers seen of a sensor
+typedef struct {
+  uint64_t eui64;
+  uint64_t first_us;
+  /// Bit i: last_sequence - i was seen
+  uint64_t seen;
+  uint32_t last_sequence;
+  bool used;
+} dedup_t;
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+static uint64_t now_us(void);
+static void *reader_main(void *context);
+static void on_record(const sink_record_t *record, void *context);
+static void publish(sink_t *sink);
+static size_t merge(sink_t *sink);
+static bool is_duplicate(sink_t *sink, const sink_record_t *record);
+static void store_record(const sink_record_t *record);
+static void flush_output(void);
+static void print_stats(void);
+static void on_signal(int signal);
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static volatile sig_atomic_t stop = 0;
+static atomic_bool readers_stop = false;
+static speed_t baud_speed;
+static unsigned serial_options = 0;
+static sink_t *sinks[MAX_SINKS];
+static unsigned sink_count = 0;
+static dedup_t dedup[MAX_SENSORS];
+static unsigned dedup_count = 0;
+static uint64_t untracked = 0;
+static uint64_t unsequenced = 0;
+static uint64_t started_us;
+/// Output
+static int log_fd = -1;
+static ts_rollup_t *series = NULL;
+static sink_record_t batch[MERGE_BATCH];
+static size_t batch_length = 0;
+static uint64_t stored = 0;
+static uint64_t write_errors = 0;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  const char *log_path = "sink.rec";
+  const char *series_path = NULL;
+  unsigned long baud = 115200;
+  unsigned stats_period_s = 0;
+  uint64_t next_stats_us;
+  int option;
+  unsigned i;
+
+  while ((option = getopt(argc, argv, "b:Fo:t:i:")) != -1) {
+    switch (option) {
+      case 'b': baud = strtoul(optarg, NULL, 0); break;
+      case 'F': serial_options |= SINK_SERIAL_FLOW_CONTROL; break;
+      case 'o': log_path = optarg; break;
+      case 't': series_path = optarg; break;
+      case 'i': stats_period_s = (unsigned)strtoul(optarg, NULL, 0); break;
+      default:
+        goto usage;
+    }
+  }
+  if (optind >= argc || argc - optind > (int)MAX_SINKS
+      || (baud_speed = sink_baud_to_speed(baud)) == 0) {
+    goto usage;
+  }
+
+  log_fd = sink_open_record_log(log_path);
+  if (log_fd < 0) {
+    perror(log_path);
+    return 1;
+  }
+  if (series_path != NULL && (series = ts_rollup_open(series_path, true, TS_SENSOR_VALUES)) == NULL) {
+    perror(series_path);
+    return 1;
+  }
+
+  signal(SIGINT, on_signal);
+  signal(SIGTERM, on_signal);
+  started_us = now_us();
+  for (i = 0; (int)i < argc - optind; i++) {
+    sink_t *sink = aligned_alloc(CACHE_LINE, sizeof(sink_t));
+    if (sink == NULL) {
+      perror("sink");
+      return 1;
+    }
+    memset(sink, 0, sizeof(sink_t));
+    sink->port = argv[optind + i];
+    sink->index = (uint8_t)i;
+    sinks[sink_count++] = sink;
+    if (pthread_create(&sink->thread, NULL, reader_main, sink) != 0) {
+      perror("pthread_create");
+      return 1;
+    }
+  }
+
+  // Merge thread: serve the rings in turn, nap when all of them are empty.
+  next_stats_us = started_us + stats_period_s * 1000000ull;
+  while (!stop) {
+    size_t merged = 0;
+
+    for (i = 0; i < sink_count; i++) {
+      merged += merge(sinks[i]);
+    }
+    if (merged == 0) {
+      flush_output();
+      // Roll up written blocks while the rings are empty.
+      if (series == NULL || ts_rollup_process(series, 1) == 0) {
+        poll(NULL, 0, 1);
+      }
+    }
+    if (stats_period_s > 0 && now_us() >= next_stats_us) {
+      print_stats();
+      next_stats_us += stats_period_s * 1000000ull;
+    }
+  }
+
+  atomic_store(&readers_stop, true);
+  for (i = 0; i < sink_count; i++) {
+    pthread_join(sinks[i]->thread, NULL);
+    while (merge(sinks[i]) > 0) {
+    }
+  }
+  flush_output();
+  print_stats();
+  ts_rollup_close(series);
+  close(log_fd);
+  return 0;
+
+  usage:
+  fprintf(stderr, "usage: %s [-b <baud>] [-F] [-o <record log>] [-t <series store>] "
+          "[-i <stats period s>] <serial port>...\n", argv[0]);
+  return 2;
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+static uint64_t now_us(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+static void *reader_main(void *context)
+{
+  sink_t *sink = context;
+  int fd = -1;
+
+  sink_parser_init(&sink->parser);
+  while (!atomic_load_explicit(&readers_stop, memory_order_relaxed)) {
+    struct pollfd pfd;
+    size_t available;
+    char *space;
+    ssize_t length;
+
+    if (fd < 0) {
+      fd = sink_open_serial(sink->port, baud_speed, serial_options);
+      if (fd < 0) {
+        poll(NULL, 0, REOPEN_DELAY_MS);
+        continue;
+      }
+      // A partial line from the previous connection is garbage.
+      sink_parser_init(&sink->parser);
+      atomic_fetch_add_explicit(&sink->reconnects, 1, memory_order_relaxed);
+    }
+
+    // Wake up now and then to notice the end.
+    pfd.fd = fd;
+    pfd.events = POLLIN;
+    if (poll(&pfd, 1, 200) <= 0) {
+      continue;
+    }
+    space = sink_parser_space(&sink->parser, &available);
+    length = read(fd, space, available);
+    if (length > 0) {
+      uint64_t errors = sink->parser.errors;
+      sink_parser_commit(&sink->parser, (size_t)length, now_us(), on_record, sink);
+      publish(sink);
+      if (sink->parser.errors != errors) {
+        atomic_fetch_add_explicit(&sink->parse_errors, sink->parser.errors - errors,
+                                  memory_order_relaxed);
+      }
+    } else if (length == 0 || errno != EINTR) {
+      // Unplugged, or the other end of a pseudo-terminal closed.
+      close(fd);
+      fd = -1;
+      sink_parser_flush(&sink->parser, on_record, sink);
+      publish(sink);
+    }
+  }
+  if (fd >= 0) {
+    close(fd);
+  }
+  return NULL;
+}
+
+static void on_record(const sink_record_t *record, void *context)
+{
+  sink_t *sink = context;
+
+  // Snapshots repeat the last values, only received reports are merged.
+  if ((record->flags & SINK_RECORD_FLAG_SNAPSHOT) != 0) {
+    return;
+  }
+  while (sink->head - sink->cached_tail == RING_SIZE) {
+    // The merge thread is behind: hand it what we have and wait for room.
+    publish(sink);
+    sink->cached_tail = atomic_load_explicit(&sink->ring.tail, memory_order_acquire);
+    if (sink->head - sink->cached_tail == RING_SIZE) {
+      atomic_fetch_add_explicit(&sink->ring_full, 1, memory_order_relaxed);
+      poll(NULL, 0, 1);
+    }
+  }
+  sink->ring.slots[sink->head & (RING_SIZE - 1)] = *record;
+  sink->ring.slots[sink->head & (RING_SIZE - 1)].sink = sink->index;
+  sink->head++;
+  atomic_fetch_add_explicit(&sink->records, 1, memory_order_relaxed);
+  atomic_store_explicit(&sink->last_record_us, record->time_us, memory_order_relaxed);
+}
+
+static void publish(sink_t *sink)
+{
+  // One release store per read, not per record
+  atomic_store_explicit(&sink->ring.head, sink->head, memory_order_release);
+}
+
+static size_t merge(sink_t *sink)
+{
+  size_t tail = atomic_load_explicit(&sink->ring.tail, memory_order_relaxed);
+  size_t head = atomic_load_explicit(&sink->ring.head, memory_order_acquire);
+  size_t count = head - tail;
+  uint64_t now = now_us();
+  size_t i;
+
+  if (count == 0) {
+    return 0;
+  }
+  if (count > sink->peak_depth) {
+    sink->peak_depth = count;
+  }
+  if (count > MERGE_BATCH) {
+    count = MERGE_BATCH;
+  }
+  for (i = 0; i < count; i++) {
+    const sink_record_t *record = &sink->ring.slots[(tail + i) & (RING_SIZE - 1)];
+    uint64_t lag_us = (now > record->time_us) ? now - record->time_us : 0;
+
+    sink->lag_sum_us += lag_us;
+    sink->lag_count++;
+    if (lag_us > sink->lag_max_us) {
+      sink->lag_max_us = lag_us;
+    }
+    if (!is_duplicate(sink, record)) {
+      sink->first++;
+      store_record(record);
+    }
+  }
+  atomic_store_explicit(&sink->ring.tail, tail + count, memory_order_release);
+  return count;
+}
+
+static bool is_duplicate(sink_t *sink, const sink_record_t *record)
+{
+  uint64_t hash = record->eui64 * 0x9E3779B97F4A7C15ull;
+  unsigned slot = (unsigned)(hash >> 50) & (MAX_SENSORS - 1);
+  uint32_t sequence = record->sequence;
+  dedup_t *entry;
+  uint32_t behind;
+
+  if ((record->flags & SINK_RECORD_FLAG_SEQUENCE) == 0) {
+    unsequenced++;
+    return false;
+  }
+  for (;;) {
+    entry = &dedup[slot];
+    if (!entry->used) {
+      if (dedup_count >= MAX_SENSORS * 3 / 4) {
+        untracked++;
+        return false;
+      }
+      entry->used = true;
+      entry->eui64 = record->eui64;
+      dedup_count++;
+      goto restart;
+    }
+    if (entry->eui64 == record->eui64) {
+      break;
+    }
+    slot = (slot + 1) & (MAX_SENSORS - 1);
+  }
+
+  behind = entry->last_sequence - sequence;
+  if (behind < SEQUENCE_WINDOW) {
+    if ((entry->seen >> behind) & 1u) {
+      if (behind == 0) {
+        uint64_t late_us = (record->time_us > entry->first_us)
+                           ? record->time_us - entry->first_us : 0;
+        sink->behind_sum_us += late_us;
+        sink->behind_count++;
+        if (late_us > sink->behind_max_us) {
+          sink->behind_max_us = late_us;
+        }
+      }
+      sink->duplicates++;
+      return true;
+    }
+    // Late, but the first copy of that report
+    entry->seen |= 1ull << behind;
+    return false;
+  }
+  if ((uint32_t)(sequence - entry->last_sequence) < RESTART_DISTANCE) {
+    // Ahead of the last one
+    uint32_t ahead = sequence - entry->last_sequence;
+    entry->seen = (ahead >= 64u) ? 1u : ((entry->seen << ahead) | 1u);
+    entry->last_sequence = sequence;
+    entry->first_us = record->time_us;
+    return false;
+  }
+  if (behind < RESTART_DISTANCE) {
+    // Too far behind to tell, the sink lags by more than the window.
+    sink->stale++;
+    sink->duplicates++;
+    return true;
+  }
+
+  restart:
+  // New sensor, or a restart of the sensor
+  entry->last_sequence = sequence;
+  entry->seen = 1u;
+  entry->first_us = record->time_us;
+  return false;
+}
+
+static void store_record(const sink_record_t *record)
+{
+  if (series != NULL) {
+    ts_sample_t sample = {
+      .time_ms = (int64_t)(record->time_us / 1000u),
+      .value = { record->temperature, (int32_t)record->humidity, 0 }
+    };
+    ts_rollup_append(series, record->eui64, &sample);
+  }
+  batch[batch_length++] = *record;
+  if (batch_length == MERGE_BATCH) {
+    flush_output();
+  }
+}
+
+static void flush_output(void)
+{
+  if (batch_length == 0) {
+    return;
+  }
+  if (sink_write_records(log_fd, batch, batch_length) != 0) {
+    write_errors++;
+  }
+  stored += batch_length;
+  batch_length = 0;
+}
+
+static void print_stats(void)
+{
+  uint64_t now = now_us();
+  double elapsed_s = (double)(now - started_us) / 1e6;
+  unsigned i;
+
+  fprintf(stderr, "uptime_s=%.0f stored=%llu rate=%.0f/s sensors=%u unsequenced=%llu "
+          "untracked=%llu write_errors=%llu\n",
+          elapsed_s, (unsigned long long)(stored + batch_length),
+          (elapsed_s > 0) ? (double)(stored + batch_length) / elapsed_s : 0.0,
+          dedup_count, (unsigned long long)unsequenced,
+          (unsigned long long)untracked, (unsigned long long)write_errors);
+  for (i = 0; i < sink_count; i++) {
+    sink_t *sink = sinks[i];
+    uint64_t last_us = atomic_load_explicit(&sink->last_record_us, memory_order_relaxed);
+
+    fprintf(stderr, "  sink %u %s: records=%llu first=%llu dup=%llu stale=%llu "
+            "lag_ms=%.2f/%.2f behind_ms=%.1f/%.1f peak_depth=%zu ring_full=%llu "
+            "reconnects=%llu parse_errors=%llu silent_s=%.1f\n",
+            i, sink->port,
+            (unsigned long long)atomic_load(&sink->records),
+            (unsigned long long)sink->first,
+            (unsigned long long)sink->duplicates,
+            (unsigned long long)sink->stale,
+            sink->lag_count ? (double)sink->lag_sum_us / sink->lag_count / 1e3 : 0.0,
+            (double)sink->lag_max_us / 1e3,
+            sink->behind_count ? (double)sink->behind_sum_us / sink->behind_count / 1e3 : 0.0,
+            (double)sink->behind_max_us / 1e3,
+            sink->peak_depth,
+            (unsigned long long)atomic_load(&sink->ring_full),
+            (unsigned long long)atomic_load(&sink->reconnects),
+            (unsigned long long)atomic_load(&sink->parse_errors),
+            (last_us > 0 && now > last_us) ? (double)(now - last_us) / 1e6 : -1.0);
+    // Per period figures
+    sink->lag_sum_us = 0;
+    sink->lag_count = 0;
+    sink->lag_max_us = 0;
+    sink->behind_sum_us = 0;
+    sink->behind_count = 0;
+    sink->behind_max_us = 0;
+    sink->peak_depth = 0;
+  }
+}
+
+static void on_signal(int signal)
+{
+  (void) signal;
+  stop = 1;
+}
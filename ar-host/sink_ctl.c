@@ -0,0 +1,497 @@
+/***************************************************************************//**
+ * @file sink_ctl.c
+ * @brief sink_ctl.c
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+// Drives a sink over its host link instead of the text CLI: typed requests
+// and responses, matched by request ID, with several requests outstanding.
+//
+// Build: gcc -O2 -Wall -o sink_ctl sink_ctl.c host_link.c sink_parser.c sink_io.c
+// Usage: sink_ctl [-p <serial port>] [-b <baud>] [-F] [-T <timeout ms>] [-v]
+//                 [-n <requests>] [-w <window>] [-s <bytes>] <command>
+// Commands:
+//   info                     network state of the sink
+//   sensors                  every sensor table entry, page by page
+//   query [<fields> [<stale s> [<RSSI dBm> [<parent ID>]]]]
+//                            the sensors silent for more than <stale s>,
+//                            heard below <RSSI dBm> and behind <parent ID>
+//                            (hex, the sink's own for the direct ones); 0,
+//                            or "-" for the parent, matches any; <fields>
+//                            are HOST_LINK_FIELD_ flags, 0 for the defaults.
+//                            Put "--" before the command for a negative RSSI
+//   data <node ID> <hex>     sends data to a sensor
+//   pjoin <s> [<hex>]        permits joining, with a selective join payload
+//   counters [reset]         counter snapshot, as a "counters:" hex line
+//   ping                     round trip benchmark: -n pings of -s bytes,
+//                            -w of them outstanding at a time
+//   baud <rate>              switches the sink to another baud rate, use
+//                            -b <rate> from then on
+//   stream [<lines> [<length>]]
+//                            output throughput benchmark: the sink prints
+//                            the lines as fast as it can, 1000 lines of 80
+//                            characters by default
+//
+// -F enables RTS/CTS, for a sink built with hardware flow control. -v prints
+// the other output of the sink, e.g. the record lines, to stderr.
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include "host_link.h"
+#include "sink_io.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define SENSORS_PER_CALL        (64u)
+#define COUNTERS_MAX_LENGTH     (512u)
+
+/// Stream benchmark defaults
+#define STREAM_LINES            (1000u)
+#define STREAM_LINE_LENGTH      (80u)
+
+/// State of the ping benchmark
+typedef struct {
+  unsigned received;
+  unsigned failed;
+  uint64_t round_trip_sum_us;
+  uint64_t round_trip_max_us;
+  uint64_t *round_trips_us;
+} ping_t;
+
+/// Lines of the stream benchmark seen by the host
+typedef struct {
+  bool verbose;
+  unsigned lines;
+  unsigned lost;
+  unsigned next_sequence;
+  uint64_t bytes;
+  uint64_t last_us;
+} stream_t;
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+static uint64_t now_us(void);
+static size_t parse_hex_bytes(const char *text, uint8_t *out, size_t size);
+static void print_line(const char *line, size_t length, void *context);
+static void print_sensor_row(const host_link_sensor_row_t *row);
+static int run_ping(host_link_t *link, unsigned count, unsigned window, size_t size,
+                    int timeout_ms);
+static void on_ping(const host_link_response_t *response, void *context);
+static int run_stream(host_link_t *link, unsigned long baud, unsigned lines,
+                      unsigned length, bool verbose, int timeout_ms);
+static void on_stream_line(const char *line, size_t length, void *context);
+static int compare_u64(const void *a, const void *b);
+static int report_status(const char *command, int status);
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  const char *port = "/dev/ttyACM0";
+  unsigned long baud = 115200;
+  int timeout_ms = 1000;
+  bool verbose = false;
+  unsigned options = 0;
+  unsigned count = 1000;
+  unsigned window = 4;
+  size_t size = 16;
+  const char *command;
+  host_link_t link;
+  speed_t speed;
+  int option;
+  int status;
+
+  while ((option = getopt(argc, argv, "p:b:FT:vn:w:s:")) != -1) {
+    switch (option) {
+      case 'p': port = optarg; break;
+      case 'b': baud = strtoul(optarg, NULL, 0); break;
+      case 'F': options |= SINK_SERIAL_FLOW_CONTROL; break;
+      case 'T': timeout_ms = atoi(optarg); break;
+      case 'v': verbose = true; break;
+      case 'n': count = (unsigned)strtoul(optarg, NULL, 0); break;
+      case 'w': window = (unsigned)strtoul(optarg, NULL, 0); break;
+      case 's': size = strtoul(optarg, NULL, 0); break;
+      default:
+        fprintf(stderr, "usage: %s [-p <serial port>] [-b <baud>] [-F] [-T <timeout ms>] "
+                "[-v] [-n <requests>] [-w <window>] [-s <bytes>] "
+                "info|sensors|query|data|pjoin|counters|ping|baud|stream ...\n", argv[0]);
+        return 2;
+    }
+  }
+  if (optind >= argc) {
+    fprintf(stderr, "%s: no command\n", argv[0]);
+    return 2;
+  }
+  command = argv[optind++];
+  speed = sink_baud_to_speed(baud);
+  if (speed == 0) {
+    fprintf(stderr, "%s: unsupported baud rate %lu\n", argv[0], baud);
+    return 2;
+  }
+  if (host_link_open(&link, port, speed, options) != 0) {
+    perror(port);
+    return 1;
+  }
+  if (verbose) {
+    host_link_set_line_callback(&link, print_line, NULL);
+  }
+
+  if (strcmp(command, "info") == 0) {
+    host_link_info_t info;
+    status = host_link_get_info(&link, &info, timeout_ms);
+    if (status == 0) {
+      printf("network state 0x%02X, node type 0x%02X, node ID 0x%04X, PAN ID 0x%04X, "
+             "channel %u, power %d, TX options 0x%02X, sensors %u/%u\n",
+             info.network_state, info.node_type, info.node_id, info.pan_id,
+             info.channel, info.power, info.tx_options, info.sensors, info.table_size);
+    }
+  } else if (strcmp(command, "sensors") == 0) {
+    host_link_sensor_t sensors[SENSORS_PER_CALL];
+    uint8_t first = 0;
+    size_t found;
+    size_t i;
+
+    do {
+      uint8_t next = 0xFF;
+      status = host_link_get_sensors(&link, first, sensors, SENSORS_PER_CALL, &found,
+                                     &next, timeout_ms);
+      for (i = 0; status == 0 && i < found; i++) {
+        printf("entry:%u id:0x%04X parent:0x%04X eui64:%016llX last report:%lu ms ago\n",
+               sensors[i].index, sensors[i].node_id, sensors[i].parent_id,
+               (unsigned long long)sensors[i].eui64, (unsigned long)sensors[i].age_ms);
+      }
+      first = next;
+    } while (status == 0 && first != 0xFF);
+  } else if (strcmp(command, "query") == 0) {
+    host_link_sensor_row_t rows[SENSORS_PER_CALL];
+    host_link_sensor_filter_t filter = { 0, 0, HOST_LINK_NULL_NODE_ID };
+    uint8_t fields = (argc - optind > 0) ? (uint8_t)strtoul(argv[optind], NULL, 0) : 0;
+    uint8_t cursor = 0;
+    size_t found;
+    size_t i;
+
+    if (argc - optind > 1) {
+      filter.stale_s = (uint16_t)strtoul(argv[optind + 1], NULL, 0);
+    }
+    if (argc - optind > 2) {
+      filter.rssi_below = (int8_t)strtol(argv[optind + 2], NULL, 0);
+    }
+    if (argc - optind > 3 && strcmp(argv[optind + 3], "-") != 0) {
+      filter.parent_id = (uint16_t)strtoul(argv[optind + 3], NULL, 16);
+    }
+    do {
+      uint8_t next = 0xFF;
+      status = host_link_query_sensors(&link, cursor, 0, fields, &filter, rows,
+                                       SENSORS_PER_CALL, &found, &next, timeout_ms);
+      for (i = 0; status == 0 && i < found; i++) {
+        print_sensor_row(&rows[i]);
+      }
+      cursor = next;
+    } while (status == 0 && cursor != 0xFF);
+  } else if (strcmp(command, "data") == 0 && argc - optind == 2) {
+    uint8_t data[HOST_LINK_MAX_REQUEST_PAYLOAD];
+    size_t length = parse_hex_bytes(argv[optind + 1], data, sizeof(data) - 2);
+    status = host_link_send_data(&link, (uint16_t)strtoul(argv[optind], NULL, 16),
+                                 data, length, timeout_ms);
+  } else if (strcmp(command, "pjoin") == 0 && argc - optind >= 1) {
+    uint8_t payload[HOST_LINK_MAX_REQUEST_PAYLOAD];
+    size_t length = (argc - optind > 1)
+                    ? parse_hex_bytes(argv[optind + 1], payload, sizeof(payload) - 1) : 0;
+    status = host_link_permit_join(&link, (uint8_t)strtoul(argv[optind], NULL, 0),
+                                   payload, length, timeout_ms);
+  } else if (strcmp(command, "counters") == 0) {
+    uint8_t snapshot[COUNTERS_MAX_LENGTH];
+    size_t length = sizeof(snapshot);
+    size_t i;
+
+    status = host_link_get_counters(&link,
+                                    argc - optind > 0 && strcmp(argv[optind], "reset") == 0,
+                                    snapshot, &length, timeout_ms);
+    if (status == 0) {
+      printf("counters:");
+      for (i = 0; i < length; i++) {
+        printf("%02X", snapshot[i]);
+      }
+      printf("\n");
+    }
+  } else if (strcmp(command, "ping") == 0) {
+    // Failures are in the report.
+    status = run_ping(&link, count, window, size, timeout_ms);
+    host_link_close(&link);
+    return (status == 0) ? 0 : 1;
+  } else if (strcmp(command, "baud") == 0 && argc - optind == 1) {
+    unsigned long rate = strtoul(argv[optind], NULL, 0);
+    status = host_link_set_baud(&link, rate, timeout_ms);
+    if (status == 0) {
+      printf("baud rate %lu\n", rate);
+    }
+  } else if (strcmp(command, "stream") == 0) {
+    unsigned lines = (argc - optind > 0)
+                     ? (unsigned)strtoul(argv[optind], NULL, 0) : STREAM_LINES;
+    unsigned length = (argc - optind > 1)
+                      ? (unsigned)strtoul(argv[optind + 1], NULL, 0) : STREAM_LINE_LENGTH;
+    // Failures are in the report.
+    status = run_stream(&link, baud, lines, length, verbose, timeout_ms);
+    host_link_close(&link);
+    return (status == 0) ? 0 : 1;
+  } else {
+    fprintf(stderr, "%s: unknown command or missing arguments: %s\n", argv[0], command);
+    host_link_close(&link);
+    return 2;
+  }
+
+  if (link.bad_frames > 0) {
+    fprintf(stderr, "bad frames: %llu\n", (unsigned long long)link.bad_frames);
+  }
+  host_link_close(&link);
+  return report_status(command, status);
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+static uint64_t now_us(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+static size_t parse_hex_bytes(const char *text, uint8_t *out, size_t size)
+{
+  size_t length = 0;
+  unsigned value;
+
+  while (length < size && sscanf(text, "%2x", &value) == 1) {
+    out[length++] = (uint8_t)value;
+    text += (text[1] != '\0') ? 2 : 1;
+  }
+  return length;
+}
+
+static void print_line(const char *line, size_t length, void *context)
+{
+  (void) context;
+  fprintf(stderr, "%.*s\n", (int)length, line);
+}
+
+/// Keeps window pings outstanding until count of them are answered or given
+/// up, 0 is returned if every ping was answered.
+static void print_sensor_row(const host_link_sensor_row_t *row)
+{
+  printf("entry:%u", row->index);
+  if (row->fields & HOST_LINK_FIELD_NODE_ID) {
+    printf(" id:0x%04X", row->node_id);
+  }
+  if (row->fields & HOST_LINK_FIELD_EUI64) {
+    printf(" eui64:%016llX", (unsigned long long)row->eui64);
+  }
+  if (row->fields & HOST_LINK_FIELD_PARENT) {
+    printf(" parent:0x%04X", row->parent_id);
+  }
+  if (row->fields & HOST_LINK_FIELD_AGE) {
+    printf(" age:%lu", (unsigned long)row->age_ms);
+  }
+  if (row->fields & HOST_LINK_FIELD_RSSI) {
+    if (row->rssi == HOST_LINK_RSSI_UNKNOWN) {
+      printf(" rssi:-");
+    } else {
+      printf(" rssi:%d", row->rssi);
+    }
+  }
+  if (row->fields & HOST_LINK_FIELD_DATA) {
+    printf(" data:%ld,%lu", (long)row->temperature, (unsigned long)row->humidity);
+  }
+  printf("\n");
+}
+
+static int run_ping(host_link_t *link, unsigned count, unsigned window, size_t size,
+                    int timeout_ms)
+{
+  uint8_t payload[HOST_LINK_MAX_REQUEST_PAYLOAD];
+  ping_t ping = { 0 };
+  unsigned sent = 0;
+  uint64_t started_us;
+  uint64_t elapsed_us;
+  size_t i;
+
+  if (size > sizeof(payload) || window == 0 || window > 255 || count == 0) {
+    fprintf(stderr, "ping: up to %u bytes, a window of 1 to 255\n",
+            HOST_LINK_MAX_REQUEST_PAYLOAD);
+    return -1;
+  }
+  ping.round_trips_us = calloc(count, sizeof(*ping.round_trips_us));
+  if (ping.round_trips_us == NULL) {
+    return -1;
+  }
+  for (i = 0; i < size; i++) {
+    payload[i] = (uint8_t)i;
+  }
+
+  started_us = now_us();
+  while (ping.received + ping.failed < count) {
+    while (sent < count && link->pending < window) {
+      if (host_link_send(link, HOST_LINK_PING, payload, size) < 0) {
+        perror("send");
+        free(ping.round_trips_us);
+        return -1;
+      }
+      sent++;
+    }
+    if (host_link_poll(link, 10, on_ping, &ping) < 0) {
+      perror("read");
+      break;
+    }
+    ping.failed += host_link_expire(link, (unsigned)timeout_ms);
+  }
+  elapsed_us = now_us() - started_us;
+
+  if (ping.received > 0) {
+    qsort(ping.round_trips_us, ping.received, sizeof(*ping.round_trips_us), compare_u64);
+    printf("pings=%u failed=%u window=%u size=%zu rate=%.0f/s "
+           "round_trip_ms avg=%.2f p50=%.2f p99=%.2f max=%.2f\n",
+           ping.received, ping.failed, window, size,
+           (double)ping.received * 1e6 / (double)elapsed_us,
+           (double)ping.round_trip_sum_us / ping.received / 1e3,
+           (double)ping.round_trips_us[ping.received / 2] / 1e3,
+           (double)ping.round_trips_us[(size_t)(ping.received * 0.99)] / 1e3,
+           (double)ping.round_trip_max_us / 1e3);
+  } else {
+    printf("pings=0 failed=%u\n", ping.failed);
+  }
+  free(ping.round_trips_us);
+  return (ping.failed == 0) ? 0 : -1;
+}
+
+static void on_ping(const host_link_response_t *response, void *context)
+{
+  ping_t *ping = context;
+
+  if (response->status != 0) {
+    ping->failed++;
+    return;
+  }
+  ping->round_trips_us[ping->received++] = response->round_trip_us;
+  ping->round_trip_sum_us += response->round_trip_us;
+  if (response->round_trip_us > ping->round_trip_max_us) {
+    ping->round_trip_max_us = response->round_trip_us;
+  }
+}
+
+/// Asks the sink for lines of length characters and compares what arrived
+/// with what the sink reports, 0 is returned if no line was lost.
+static int run_stream(host_link_t *link, unsigned long baud, unsigned lines,
+                      unsigned length, bool verbose, int timeout_ms)
+{
+  stream_t stream = { .verbose = verbose };
+  host_link_stream_t result;
+  uint64_t started_us;
+  double line_rate;
+  double host_s;
+  int status;
+
+  if (lines == 0 || lines > 0xFFFF
+      || length < HOST_LINK_STREAM_MIN_LINE || length > HOST_LINK_STREAM_MAX_LINE) {
+    fprintf(stderr, "stream: 1 to 65535 lines of %u to %u characters\n",
+            HOST_LINK_STREAM_MIN_LINE, HOST_LINK_STREAM_MAX_LINE);
+    return -1;
+  }
+  // The lines take their time on the wire: 10 bits per character, CR LF
+  // included, and twice that for slack.
+  timeout_ms += (int)((uint64_t)lines * (length + 2) * 10 * 1000 * 2 / baud);
+
+  host_link_set_line_callback(link, on_stream_line, &stream);
+  started_us = now_us();
+  status = host_link_stream(link, (uint16_t)lines, (uint8_t)length, &result, timeout_ms);
+  host_link_set_line_callback(link, verbose ? print_line : NULL, NULL);
+  if (status != 0) {
+    return report_status("stream", status);
+  }
+
+  // Bytes per second of the line at 10 bits per character
+  line_rate = (double)baud / 10.0;
+  host_s = (stream.last_us > started_us) ? (double)(stream.last_us - started_us) / 1e6 : 0.0;
+  stream.lost += lines - stream.next_sequence;
+  printf("lines=%u/%u lost=%u bytes=%llu/%lu\n",
+         stream.lines, result.lines, stream.lost,
+         (unsigned long long)stream.bytes, (unsigned long)result.bytes);
+  printf("sink: %lu ms %.0f B/s, host: %.0f ms %.0f B/s, line %.0f B/s, "
+         "utilization %.1f%%\n",
+         (unsigned long)result.duration_ms,
+         (result.duration_ms > 0) ? (double)result.bytes * 1e3 / result.duration_ms : 0.0,
+         host_s * 1e3,
+         (host_s > 0.0) ? (double)stream.bytes / host_s : 0.0,
+         line_rate,
+         (host_s > 0.0) ? (double)stream.bytes / host_s * 100.0 / line_rate : 0.0);
+  return (stream.lost == 0) ? 0 : -1;
+}
+
+static void on_stream_line(const char *line, size_t length, void *context)
+{
+  stream_t *stream = context;
+  const size_t prefix_length = sizeof(HOST_LINK_STREAM_PREFIX) - 1;
+  unsigned sequence;
+
+  if (length < HOST_LINK_STREAM_MIN_LINE
+      || memcmp(line, HOST_LINK_STREAM_PREFIX, prefix_length) != 0
+      || sscanf(line + prefix_length, "%4x", &sequence) != 1) {
+    if (stream->verbose) {
+      print_line(line, length, NULL);
+    }
+    return;
+  }
+  stream->last_us = now_us();
+  stream->lines++;
+  // CR LF included, as counted by the sink
+  stream->bytes += length + 2;
+  if (sequence > stream->next_sequence) {
+    stream->lost += sequence - stream->next_sequence;
+  }
+  stream->next_sequence = sequence + 1;
+}
+
+static int compare_u64(const void *a, const void *b)
+{
+  uint64_t x = *(const uint64_t *)a;
+  uint64_t y = *(const uint64_t *)b;
+
+  return (x > y) - (x < y);
+}
+
+static int report_status(const char *command, int status)
+{
+  if (status < 0) {
+    fprintf(stderr, "%s: %s\n", command, (errno == ETIMEDOUT) ? "no response" : strerror(errno));
+    return 1;
+  }
+  if (status != 0) {
+    fprintf(stderr, "%s: status 0x%02X\n", command, status);
+    return 1;
+  }
+  return 0;
+}
@@ -0,0 +1,563 @@
+/***************************************************************************//**
+ * @file sink_ingestd.c
+ * @brief sink_ingestd.c
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+// Ingest daemon for the serial output of a sink. It owns the serial port,
+// parses the record lines in place as they arrive and appends every record
+// to an append-only store file. A local socket answers queries about the
+// ingest and the last value of every sensor. Memory use is fixed: one line
+// buffer, one write batch and a bounded table of sensors.
+//
+// Build: gcc -O2 -Wall -o sink_ingestd sink_ingestd.c sink_parser.c sink_io.c
+//            ts_store.c ts_rollup.c
+// Usage: sink_ingestd -p <serial port> [-b <baud>] [-F] [-o <store>]
+//                     [-t <series store>] [-s <socket>] [-i <stats period s>]
+//
+// -F enables RTS/CTS, for a sink built with hardware flow control.
+//
+// The store is a record log, see sink_io.h. With -t the reports are also
+// appended to a ts_rollup set, the history of every sensor with its 1 min,
+// 1 h and 1 day rollups; its open blocks are written on exit, the record log
+// is the journal until then. Written blocks are rolled up a few at a time
+// between the events.
+//
+// Query socket commands, one per line, every answer ends with "end":
+//   stats             ingest metrics
+//   list              last record of every sensor
+//   last <EUI64>      last record of a sensor
+//   history <EUI64> <from ms> <to ms> [<step ms>]
+//                     history of a sensor at the coarsest resolution with
+//                     buckets no longer than the step (raw by default), one
+//                     line per point: start, duration, count, then mean,
+//                     minimum and maximum of every value
+//
+// Test without hardware: run sink_sim, which prints the pseudo-terminal to
+// pass with -p.
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <signal.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include "sink_parser.h"
+#include "sink_io.h"
+#include "ts_rollup.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Records written per write() at most
+#define WRITE_BATCH             (1024u)
+/// Sensors tracked by the last value table, a power of 2
+#define MAX_SENSORS             (4096u)
+/// Query clients served at the same time
+#define MAX_CLIENTS             (8u)
+#define CLIENT_BUFFER_SIZE      (256u)
+/// Written blocks rolled up per event loop round
+#define ROLLUP_BATCH            (8u)
+/// Delay before the serial port is opened again
+#define REOPEN_DELAY_MS         (1000)
+
+typedef struct {
+  int fd;
+  size_t length;
+  char buffer[CLIENT_BUFFER_SIZE];
+} client_t;
+
+typedef struct {
+  /// Serial port
+  const char *port;
+  speed_t baud;
+  /// SINK_SERIAL_ options of the port
+  unsigned serial_options;
+  int serial_fd;
+  sink_parser_t parser;
+  /// Store
+  int store_fd;
+  sink_record_t batch[WRITE_BATCH];
+  size_t batch_length;
+  uint64_t stored;
+  uint64_t write_errors;
+  /// History of the sensors, optional
+  ts_rollup_t *series;
+  size_t rollup_pending;
+  /// Last record of every sensor, open addressing on the EUI64
+  sink_record_t last[MAX_SENSORS];
+  bool used[MAX_SENSORS];
+  unsigned sensor_count;
+  uint64_t untracked;
+  /// Query socket
+  int listen_fd;
+  client_t clients[MAX_CLIENTS];
+  uint64_t started_us;
+} daemon_t;
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+static uint64_t now_us(void);
+static int open_socket(const char *path);
+static void on_record(const sink_record_t *record, void *context);
+static void flush_batch(daemon_t *d);
+static sink_record_t *find_sensor(daemon_t *d, uint64_t eui64, bool insert);
+static void read_serial(daemon_t *d);
+static void accept_client(daemon_t *d);
+static void serve_client(daemon_t *d, client_t *client);
+static void answer(daemon_t *d, int fd, const char *command);
+static void print_stats(const daemon_t *d, FILE *out);
+static bool on_history(uint64_t eui64, const ts_point_t *point, void *context);
+static void on_signal(int signal);
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static volatile sig_atomic_t stop = 0;
+/// Large, kept out of the stack
+static daemon_t daemon_state;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  daemon_t *d = &daemon_state;
+  const char *store_path = "sink.rec";
+  const char *series_path = NULL;
+  const char *socket_path = "sink_ingestd.sock";
+  unsigned long baud = 115200;
+  unsigned stats_period_s = 0;
+  uint64_t next_stats_us;
+  uint64_t next_open_us = 0;
+  int option;
+  unsigned i;
+
+  d->port = NULL;
+  d->serial_options = SINK_SERIAL_NONBLOCK;
+  while ((option = getopt(argc, argv, "p:b:Fo:t:s:i:")) != -1) {
+    switch (option) {
+      case 'p': d->port = optarg; break;
+      case 'b': baud = strtoul(optarg, NULL, 0); break;
+      case 'F': d->serial_options |= SINK_SERIAL_FLOW_CONTROL; break;
+      case 'o': store_path = optarg; break;
+      case 't': series_path = optarg; break;
+      case 's': socket_path = optarg; break;
+      case 'i': stats_period_s = (unsigned)strtoul(optarg, NULL, 0); break;
+      default:
+        fprintf(stderr, "usage: %s -p <serial port> [-b <baud>] [-F] [-o <store>] "
+                "[-t <series store>] [-s <socket>] [-i <stats period s>]\n", argv[0]);
+        return 2;
+    }
+  }
+  if (d->port == NULL || (d->baud = sink_baud_to_speed(baud)) == 0) {
+    fprintf(stderr, "%s: a serial port and a standard baud rate are needed\n", argv[0]);
+    return 2;
+  }
+
+  signal(SIGINT, on_signal);
+  signal(SIGTERM, on_signal);
+  signal(SIGPIPE, SIG_IGN);
+
+  sink_parser_init(&d->parser);
+  d->serial_fd = -1;
+  d->store_fd = sink_open_record_log(store_path);
+  if (d->store_fd < 0) {
+    perror(store_path);
+  }
+  d->listen_fd = open_socket(socket_path);
+  if (series_path != NULL) {
+    d->series = ts_rollup_open(series_path, true, TS_SENSOR_VALUES);
+    if (d->series == NULL) {
+      perror(series_path);
+      return 1;
+    }
+  }
+  if (d->store_fd < 0 || d->listen_fd < 0) {
+    return 1;
+  }
+  for (i = 0; i < MAX_CLIENTS; i++) {
+    d->clients[i].fd = -1;
+  }
+  d->started_us = now_us();
+  next_stats_us = d->started_us + stats_period_s * 1000000ull;
+
+  while (!stop) {
+    struct pollfd fds[2 + MAX_CLIENTS];
+    client_t *polled[MAX_CLIENTS];
+    nfds_t count = 0;
+    nfds_t k;
+    int timeout_ms = -1;
+
+    if (d->serial_fd < 0 && now_us() >= next_open_us) {
+      d->serial_fd = sink_open_serial(d->port, d->baud, d->serial_options);
+      if (d->serial_fd < 0) {
+        next_open_us = now_us() + REOPEN_DELAY_MS * 1000ull;
+      } else {
+        fprintf(stderr, "reading %s\n", d->port);
+        // A partial line from the previous connection is garbage.
+        sink_parser_init(&d->parser);
+      }
+    }
+    if (d->serial_fd < 0) {
+      timeout_ms = REOPEN_DELAY_MS;
+    }
+    if (d->rollup_pending > 0) {
+      timeout_ms = 0;
+    }
+    if (stats_period_s > 0) {
+      int until_stats_ms = (int)((next_stats_us > now_us())
+                                 ? (next_stats_us - now_us()) / 1000 : 0);
+      if (timeout_ms < 0 || until_stats_ms < timeout_ms) {
+        timeout_ms = until_stats_ms;
+      }
+    }
+
+    fds[count].fd = d->listen_fd;
+    fds[count++].events = POLLIN;
+    if (d->serial_fd >= 0) {
+      fds[count].fd = d->serial_fd;
+      fds[count++].events = POLLIN;
+    }
+    for (i = 0; i < MAX_CLIENTS; i++) {
+      if (d->clients[i].fd >= 0) {
+        polled[count - (d->serial_fd >= 0 ? 2 : 1)] = &d->clients[i];
+        fds[count].fd = d->clients[i].fd;
+        fds[count++].events = POLLIN;
+      }
+    }
+
+    if (poll(fds, count, timeout_ms) < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      perror("poll");
+      break;
+    }
+
+    for (k = 0; k < count; k++) {
+      if (fds[k].revents == 0) {
+        continue;
+      }
+      if (fds[k].fd == d->listen_fd) {
+        accept_client(d);
+      } else if (fds[k].fd == d->serial_fd) {
+        read_serial(d);
+      } else {
+        serve_client(d, polled[k - (d->serial_fd >= 0 ? 2 : 1)]);
+      }
+    }
+    flush_batch(d);
+    if (d->series != NULL) {
+      d->rollup_pending = ts_rollup_process(d->series, ROLLUP_BATCH);
+    }
+
+    if (stats_period_s > 0 && now_us() >= next_stats_us) {
+      print_stats(d, stderr);
+      next_stats_us += stats_period_s * 1000000ull;
+    }
+  }
+
+  flush_batch(d);
+  print_stats(d, stderr);
+  close(d->store_fd);
+  ts_rollup_close(d->series);
+  close(d->listen_fd);
+  unlink(socket_path);
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+static uint64_t now_us(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_REALTIME, &ts);
+  return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+static int open_socket(const char *path)
+{
+  struct sockaddr_un address;
+  int fd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK, 0);
+
+  if (fd < 0) {
+    perror("socket");
+    return -1;
+  }
+  memset(&address, 0, sizeof(address));
+  address.sun_family = AF_UNIX;
+  strncpy(address.sun_path, path, sizeof(address.sun_path) - 1);
+  unlink(path);
+  if (bind(fd, (struct sockaddr *)&address, sizeof(address)) != 0
+      || listen(fd, MAX_CLIENTS) != 0) {
+    perror(path);
+    close(fd);
+    return -1;
+  }
+  return fd;
+}
+
+static void on_record(const sink_record_t *record, void *context)
+{
+  daemon_t *d = context;
+  sink_record_t *last = find_sensor(d, record->eui64, true);
+
+  if (last != NULL) {
+    // A snapshot line does not carry the humidity and node ID.
+    if ((record->flags & SINK_RECORD_FLAG_SNAPSHOT) == 0 || last->eui64 != record->eui64) {
+      *last = *record;
+    } else {
+      last->temperature = record->temperature;
+      last->time_us = record->time_us;
+    }
+  } else {
+    d->untracked++;
+  }
+  // Snapshots repeat the last values, only received reports are stored.
+  if ((record->flags & SINK_RECORD_FLAG_SNAPSHOT) != 0) {
+    return;
+  }
+  if (d->series != NULL) {
+    ts_sample_t sample = {
+      .time_ms = (int64_t)(record->time_us / 1000u),
+      .value = { record->temperature, (int32_t)record->humidity, 0 }
+    };
+    ts_rollup_append(d->series, record->eui64, &sample);
+  }
+  d->batch[d->batch_length++] = *record;
+  if (d->batch_length == WRITE_BATCH) {
+    flush_batch(d);
+  }
+}
+
+static void flush_batch(daemon_t *d)
+{
+  if (sink_write_records(d->store_fd, d->batch, d->batch_length) != 0) {
+    d->write_errors++;
+  }
+  d->stored += d->batch_length;
+  d->batch_length = 0;
+}
+
+static sink_record_t *find_sensor(daemon_t *d, uint64_t eui64, bool insert)
+{
+  uint64_t hash = eui64 * 0x9E3779B97F4A7C15ull;
+  unsigned slot = (unsigned)(hash >> 52) & (MAX_SENSORS - 1);
+  unsigned probes;
+
+  for (probes = 0; probes < MAX_SENSORS; probes++) {
+    if (!d->used[slot]) {
+      if (!insert || d->sensor_count >= MAX_SENSORS * 3 / 4) {
+        return NULL;
+      }
+      d->used[slot] = true;
+      d->sensor_count++;
+      d->last[slot].eui64 = ~eui64;
+      return &d->last[slot];
+    }
+    if (d->last[slot].eui64 == eui64) {
+      return &d->last[slot];
+    }
+    slot = (slot + 1) & (MAX_SENSORS - 1);
+  }
+  return NULL;
+}
+
+static void read_serial(daemon_t *d)
+{
+  for (;;) {
+    size_t available;
+    char *space = sink_parser_space(&d->parser, &available);
+    ssize_t length = read(d->serial_fd, space, available);
+
+    if (length > 0) {
+      sink_parser_commit(&d->parser, (size_t)length, now_us(), on_record, d);
+      continue;
+    }
+    if (length < 0 && (errno == EAGAIN || errno == EINTR)) {
+      return;
+    }
+    // Unplugged, or the other end of a pseudo-terminal closed.
+    fprintf(stderr, "%s: %s\n", d->port, (length == 0) ? "closed" : strerror(errno));
+    close(d->serial_fd);
+    d->serial_fd = -1;
+    sink_parser_flush(&d->parser, on_record, d);
+    return;
+  }
+}
+
+static void accept_client(daemon_t *d)
+{
+  int fd = accept(d->listen_fd, NULL, NULL);
+  unsigned i;
+
+  if (fd < 0) {
+    return;
+  }
+  for (i = 0; i < MAX_CLIENTS; i++) {
+    if (d->clients[i].fd < 0) {
+      d->clients[i].fd = fd;
+      d->clients[i].length = 0;
+      return;
+    }
+  }
+  close(fd);
+}
+
+static void serve_client(daemon_t *d, client_t *client)
+{
+  ssize_t length = read(client->fd,
+                        client->buffer + client->length,
+                        CLIENT_BUFFER_SIZE - 1 - client->length);
+  char *line;
+  char *end;
+
+  if (length <= 0) {
+    close(client->fd);
+    client->fd = -1;
+    return;
+  }
+  client->length += (size_t)length;
+  client->buffer[client->length] = '\0';
+  line = client->buffer;
+  while ((end = strchr(line, '\n')) != NULL) {
+    *end = '\0';
+    if (end > line && end[-1] == '\r') {
+      end[-1] = '\0';
+    }
+    answer(d, client->fd, line);
+    line = end + 1;
+  }
+  client->length = strlen(line);
+  memmove(client->buffer, line, client->length);
+  if (client->length == CLIENT_BUFFER_SIZE - 1) {
+    // Not a command.
+    close(client->fd);
+    client->fd = -1;
+  }
+}
+
+static void answer(daemon_t *d, int fd, const char *command)
+{
+  FILE *out = fdopen(dup(fd), "w");
+  uint64_t eui64;
+  unsigned i;
+
+  if (out == NULL) {
+    return;
+  }
+  if (strcmp(command, "stats") == 0) {
+    print_stats(d, out);
+  } else if (strcmp(command, "list") == 0 || strncmp(command, "last ", 5) == 0) {
+    bool all = (command[1] == 'i');
+    if (!all && !sink_parse_eui64(command + 5, &eui64)) {
+      fprintf(out, "error: bad EUI64\n");
+    }
+    for (i = 0; i < MAX_SENSORS; i++) {
+      const sink_record_t *r = &d->last[i];
+      if (d->used[i] && (all || r->eui64 == eui64)) {
+        fprintf(out, "%016llX node=0x%04X temperature=%d humidity=%u time_us=%llu\n",
+                (unsigned long long)r->eui64, r->node_id, r->temperature,
+                r->humidity, (unsigned long long)r->time_us);
+      }
+    }
+  } else if (strncmp(command, "history ", 8) == 0) {
+    long long from_ms;
+    long long to_ms;
+    unsigned long step_ms = 0;
+    char eui[17];
+    if (d->series == NULL) {
+      fprintf(out, "error: no series store\n");
+    } else if (sscanf(command + 8, "%16s %lld %lld %lu", eui, &from_ms, &to_ms, &step_ms) < 3
+               || !sink_parse_eui64(eui, &eui64)) {
+      fprintf(out, "error: history <EUI64> <from ms> <to ms> [<step ms>]\n");
+    } else {
+      ts_rollup_query(d->series, eui64, from_ms, to_ms, (uint32_t)step_ms, on_history, out);
+    }
+  } else {
+    fprintf(out, "error: unknown command\n");
+  }
+  fprintf(out, "end\n");
+  fclose(out);
+}
+
+static void print_stats(const daemon_t *d, FILE *out)
+{
+  double elapsed_s = (double)(now_us() - d->started_us) / 1e6;
+
+  fprintf(out, "uptime_s=%.0f bytes=%llu lines=%llu records=%llu stored=%llu "
+          "rate=%.0f/s sensors=%u untracked=%llu overflows=%llu parse_errors=%llu "
+          "write_errors=%llu\n",
+          elapsed_s,
+          (unsigned long long)d->parser.bytes,
+          (unsigned long long)d->parser.lines,
+          (unsigned long long)d->parser.records,
+          (unsigned long long)d->stored,
+          (elapsed_s > 0) ? (double)d->parser.records / elapsed_s : 0.0,
+          d->sensor_count,
+          (unsigned long long)d->untracked,
+          (unsigned long long)d->parser.overflows,
+          (unsigned long long)d->parser.errors,
+          (unsigned long long)d->write_errors);
+  if (d->series != NULL) {
+    ts_rollup_stats_t stats;
+    ts_rollup_get_stats(d->series, &stats);
+    fprintf(out, "series=%llu blocks=%llu samples=%llu out_of_order=%llu bytes=%llu "
+            "rollup_pending=%llu rows_1m=%llu rows_1h=%llu rows_1d=%llu\n",
+            (unsigned long long)stats.store[TS_RESOLUTION_RAW].series,
+            (unsigned long long)stats.store[TS_RESOLUTION_RAW].blocks,
+            (unsigned long long)stats.store[TS_RESOLUTION_RAW].samples,
+            (unsigned long long)stats.store[TS_RESOLUTION_RAW].out_of_order,
+            (unsigned long long)stats.store[TS_RESOLUTION_RAW].file_bytes,
+            (unsigned long long)stats.pending_blocks,
+            (unsigned long long)stats.store[TS_RESOLUTION_MINUTE].samples,
+            (unsigned long long)stats.store[TS_RESOLUTION_HOUR].samples,
+            (unsigned long long)stats.store[TS_RESOLUTION_DAY].samples);
+  }
+}
+
+static bool on_history(uint64_t eui64, const ts_point_t *point, void *context)
+{
+  unsigned v;
+
+  (void) eui64;
+  fprintf(context, "%lld %lu %lu", (long long)point->start_ms,
+          (unsigned long)point->duration_ms, (unsigned long)point->count);
+  for (v = 0; v < TS_SENSOR_VALUES; v++) {
+    fprintf(context, " %ld %ld %ld",
+            (long)point->mean[v], (long)point->min[v], (long)point->max[v]);
+  }
+  fprintf(context, "\n");
+  return true;
+}
+
+static void on_signal(int signal)
+{
+  (void) signal;
+  stop = 1;
+}
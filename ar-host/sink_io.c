@@ -0,0 +1,149 @@
+/***************************************************************************//**
+ * @file sink_io.c
+ * @brief sink_io.c
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+// Serial port and record log helpers shared by the host tools.
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#define _DEFAULT_SOURCE
+#include <stdint.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "sink_io.h"
+
+_Static_assert(sizeof(sink_record_t) == 32, "sink_record_t is the record log layout");
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+speed_t sink_baud_to_speed(unsigned long baud)
+{
+  switch (baud) {
+    case 9600: return B9600;
+    case 19200: return B19200;
+    case 38400: return B38400;
+    case 57600: return B57600;
+    case 115200: return B115200;
+    case 230400: return B230400;
+    case 460800: return B460800;
+    case 921600: return B921600;
+    case 1000000: return B1000000;
+    case 2000000: return B2000000;
+    default: return 0;
+  }
+}
+
+int sink_open_serial(const char *port, speed_t baud, unsigned options)
+{
+  struct termios tio;
+  int fd = open(port, O_RDWR | O_NOCTTY
+                | ((options & SINK_SERIAL_NONBLOCK) ? O_NONBLOCK : 0));
+
+  if (fd < 0) {
+    return -1;
+  }
+  if (isatty(fd) && tcgetattr(fd, &tio) == 0) {
+    cfmakeraw(&tio);
+    cfsetispeed(&tio, baud);
+    cfsetospeed(&tio, baud);
+    tio.c_cflag |= CLOCAL | CREAD;
+    if (options & SINK_SERIAL_FLOW_CONTROL) {
+      tio.c_cflag |= CRTSCTS;
+    } else {
+      tio.c_cflag &= ~CRTSCTS;
+    }
+    tcsetattr(fd, TCSANOW, &tio);
+  }
+  return fd;
+}
+
+int sink_set_serial_speed(int fd, speed_t baud)
+{
+  struct termios tio;
+
+  if (!isatty(fd)) {
+    return 0;
+  }
+  if (tcgetattr(fd, &tio) != 0) {
+    return -1;
+  }
+  cfsetispeed(&tio, baud);
+  cfsetospeed(&tio, baud);
+  return tcsetattr(fd, TCSADRAIN, &tio);
+}
+
+int sink_open_record_log(const char *path)
+{
+  uint8_t header[SINK_RECORD_LOG_HEADER_LENGTH] = { 0 };
+  int fd = open(path, O_WRONLY | O_CREAT | O_APPEND, 0644);
+  off_t size;
+  int error;
+
+  if (fd < 0) {
+    return -1;
+  }
+  size = lseek(fd, 0, SEEK_END);
+  if (size == 0) {
+    memcpy(header, SINK_RECORD_LOG_MAGIC, sizeof(SINK_RECORD_LOG_MAGIC) - 1);
+    header[7] = SINK_RECORD_LOG_VERSION;
+    header[8] = sizeof(sink_record_t);
+    if (write(fd, header, sizeof(header)) != (ssize_t)sizeof(header)) {
+      goto fail;
+    }
+  } else if (size < (off_t)SINK_RECORD_LOG_HEADER_LENGTH) {
+    errno = EINVAL;
+    goto fail;
+  } else if ((size - SINK_RECORD_LOG_HEADER_LENGTH) % sizeof(sink_record_t) != 0) {
+    // A torn last record from a crash: the next ones stay aligned once it
+    // is cut.
+    if (ftruncate(fd, size - (size - SINK_RECORD_LOG_HEADER_LENGTH)
+                  % sizeof(sink_record_t)) != 0) {
+      goto fail;
+    }
+  }
+  return fd;
+
+  fail:
+  error = errno;
+  close(fd);
+  errno = error;
+  return -1;
+}
+
+int sink_write_records(int fd, const sink_record_t *records, size_t count)
+{
+  const uint8_t *data = (const uint8_t *)records;
+  size_t length = count * sizeof(sink_record_t);
+
+  while (length > 0) {
+    ssize_t written = write(fd, data, length);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      return -1;
+    }
+    data += written;
+    length -= (size_t)written;
+  }
+  return 0;
+}
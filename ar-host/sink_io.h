@@ -0,0 +1,83 @@
+/***************************************************************************//**
+ * @file sink_io.h
+ * @brief sink_io.h
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+#ifndef SINK_IO_H
+#define SINK_IO_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stddef.h>
+#include <stdbool.h>
+#include <termios.h>
+#include "sink_parser.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Record log: a header of SINK_RECORD_LOG_HEADER_LENGTH bytes ("SINKREC",
+/// version, record size) followed by sink_record_t records in host byte order
+#define SINK_RECORD_LOG_MAGIC          "SINKREC"
+#define SINK_RECORD_LOG_VERSION        (1u)
+#define SINK_RECORD_LOG_HEADER_LENGTH  (16u)
+
+/// Options of sink_open_serial()
+#define SINK_SERIAL_NONBLOCK           (0x01u)
+/// RTS/CTS, to match a sink built with hardware flow control
+#define SINK_SERIAL_FLOW_CONTROL       (0x02u)
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Converts a baud rate to its termios speed.
+ *
+ * @returns 0 if the baud rate is not a standard one.
+ *****************************************************************************/
+speed_t sink_baud_to_speed(unsigned long baud);
+
+/**************************************************************************//**
+ * Opens the serial port of a sink in raw mode. Other files, e.g. a pipe, are
+ * opened as they are.
+ *
+ * @param options are SINK_SERIAL_ flags
+ * @returns the file descriptor, or -1 with errno set.
+ *****************************************************************************/
+int sink_open_serial(const char *port, speed_t baud, unsigned options);
+
+/**************************************************************************//**
+ * Changes the speed of an open serial port, once the pending output is sent.
+ *
+ * @returns 0, or -1 with errno set.
+ *****************************************************************************/
+int sink_set_serial_speed(int fd, speed_t baud);
+
+/**************************************************************************//**
+ * Opens a record log for appending, created if needed. A torn last record is
+ * cut off.
+ *
+ * @returns the file descriptor, or -1 with errno set.
+ *****************************************************************************/
+int sink_open_record_log(const char *path);
+
+/**************************************************************************//**
+ * Appends records to a record log in one write.
+ *
+ * @returns 0, or -1 with errno set.
+ *****************************************************************************/
+int sink_write_records(int fd, const sink_record_t *records, size_t count);
+
+#endif  // SINK_IO_H
@@ -0,0 +1,441 @@
+/***************************************************************************//**
+ * @file sink_parser.c
+ * @brief sink_parser.c
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+// Incremental parser of the sink serial output, shared by the host tools.
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <string.h>
+#include "sink_parser.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define RECORD_PREFIX                  "rec:"
+#define RECORD_PREFIX_LENGTH           (sizeof(RECORD_PREFIX) - 1)
+#define DATA_PREFIX                    "RX: Data from 0x"
+#define DATA_PREFIX_LENGTH             (sizeof(DATA_PREFIX) - 1)
+
+/// Payload of a data report: temperature and humidity, little endian, then
+/// the application TLV elements (see app_protocol.h)
+#define DATA_LENGTH                    (8u)
+#define DATA_MAX_LENGTH                (127u)
+#define DATA_TLV_SEQUENCE              (0x04u)
+#define DATA_SEQUENCE_LENGTH           (4u)
+
+/// Cursor over a line
+typedef struct {
+  const char *p;
+  const char *end;
+} cursor_t;
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+static int hex_value(char c);
+static bool parse_hex(cursor_t *cursor, unsigned digits, uint64_t *value);
+static bool parse_unsigned(cursor_t *cursor, uint64_t *value);
+static bool parse_signed(cursor_t *cursor, int64_t *value);
+static bool expect(cursor_t *cursor, char c);
+static void skip_spaces(cursor_t *cursor);
+static bool parse_record_line(cursor_t *cursor, sink_record_t *record);
+static bool parse_snapshot_line(cursor_t *cursor, sink_record_t *record);
+static bool parse_data_line(cursor_t *cursor, sink_record_t *record);
+static uint32_t fetch_le32(const uint8_t *buffer);
+static const char *find_prefix(const char *line,
+                               const char *end,
+                               const char *prefix,
+                               size_t prefix_length);
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+void sink_parser_init(sink_parser_t *parser)
+{
+  parser->length = 0;
+  parser->skipping = false;
+  parser->holding = false;
+  parser->bytes = 0;
+  parser->lines = 0;
+  parser->records = 0;
+  parser->overflows = 0;
+  parser->errors = 0;
+}
+
+char *sink_parser_space(sink_parser_t *parser, size_t *available)
+{
+  if (parser->length == SINK_PARSER_BUFFER_SIZE) {
+    // A line filled the whole buffer: drop it up to its end.
+    parser->length = 0;
+    parser->skipping = true;
+    parser->overflows++;
+  }
+  *available = SINK_PARSER_BUFFER_SIZE - parser->length;
+  return parser->buffer + parser->length;
+}
+
+size_t sink_parser_commit(sink_parser_t *parser,
+                          size_t length,
+                          uint64_t time_us,
+                          sink_record_cb_t callback,
+                          void *context)
+{
+  const char *line = parser->buffer;
+  const char *end = parser->buffer + parser->length + length;
+  const char *scan = parser->buffer + parser->length;
+  size_t records = 0;
+  sink_record_t record;
+  bool error;
+
+  parser->bytes += length;
+  record.time_us = time_us;
+  record.sink = 0;
+
+  while ((scan = memchr(scan, '\n', (size_t)(end - scan))) != NULL) {
+    size_t line_length = (size_t)(scan - line);
+    if (line_length > 0 && line[line_length - 1] == '\r') {
+      line_length--;
+    }
+    if (parser->skipping) {
+      parser->skipping = false;
+    } else {
+      bool found = sink_parse_line(line, line_length, &record, &error);
+      parser->lines++;
+      parser->errors += error;
+      if (parser->holding) {
+        // The "rec:" line of the same report carries the EUI64.
+        parser->holding = false;
+        if (!found || record.node_id != parser->held.node_id
+            || (record.flags & (SINK_RECORD_FLAG_NODE_ONLY
+                                | SINK_RECORD_FLAG_SNAPSHOT)) != 0) {
+          records++;
+          if (callback != NULL) {
+            callback(&parser->held, context);
+          }
+        }
+      }
+      if (found && (record.flags & SINK_RECORD_FLAG_NODE_ONLY) != 0) {
+        parser->held = record;
+        parser->holding = true;
+      } else if (found) {
+        records++;
+        if (callback != NULL) {
+          callback(&record, context);
+        }
+      }
+    }
+    line = ++scan;
+  }
+
+  // Keep the incomplete last line.
+  parser->length = (size_t)(end - line);
+  if (line != parser->buffer && parser->length > 0) {
+    memmove(parser->buffer, line, parser->length);
+  }
+  parser->records += records;
+  return records;
+}
+
+size_t sink_parser_flush(sink_parser_t *parser,
+                         sink_record_cb_t callback,
+                         void *context)
+{
+  if (!parser->holding) {
+    return 0;
+  }
+  parser->holding = false;
+  parser->records++;
+  if (callback != NULL) {
+    callback(&parser->held, context);
+  }
+  return 1;
+}
+
+bool sink_parse_line(const char *line,
+                     size_t length,
+                     sink_record_t *record,
+                     bool *error)
+{
+  cursor_t cursor = { line, line + length };
+  const char *start;
+  bool found = false;
+  bool candidate = true;
+
+  // The CLI prompt may precede the output on the same line.
+  if ((start = find_prefix(line, cursor.end, RECORD_PREFIX,
+                           RECORD_PREFIX_LENGTH)) != NULL) {
+    cursor.p = start + RECORD_PREFIX_LENGTH;
+    found = parse_record_line(&cursor, record);
+  } else if ((start = find_prefix(line, cursor.end, DATA_PREFIX,
+                                  DATA_PREFIX_LENGTH)) != NULL) {
+    cursor.p = start + DATA_PREFIX_LENGTH;
+    found = parse_data_line(&cursor, record);
+  } else if ((start = memchr(line, '<', length)) != NULL) {
+    cursor.p = start + 1;
+    found = parse_snapshot_line(&cursor, record);
+    // CLI help lines hold "<argument>" too.
+    candidate = (start == line);
+  } else {
+    candidate = false;
+  }
+  if (error != NULL) {
+    *error = candidate && !found;
+  }
+  return found;
+}
+
+bool sink_parse_eui64(const char *text, uint64_t *eui64)
+{
+  cursor_t cursor = { text, text + strlen(text) };
+
+  return parse_hex(&cursor, 16, eui64) && cursor.p == cursor.end;
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+static int hex_value(char c)
+{
+  if (c >= '0' && c <= '9') {
+    return c - '0';
+  }
+  if (c >= 'A' && c <= 'F') {
+    return c - 'A' + 10;
+  }
+  if (c >= 'a' && c <= 'f') {
+    return c - 'a' + 10;
+  }
+  return -1;
+}
+
+/// Parses exactly the given number of hex digits, or 1 to 8 if 0.
+static bool parse_hex(cursor_t *cursor, unsigned digits, uint64_t *value)
+{
+  unsigned count = 0;
+  unsigned max = (digits == 0) ? 8 : digits;
+  int digit;
+
+  *value = 0;
+  while (count < max && cursor->p < cursor->end
+         && (digit = hex_value(*cursor->p)) >= 0) {
+    *value = (*value << 4) | (uint64_t)digit;
+    cursor->p++;
+    count++;
+  }
+  return (digits == 0) ? (count > 0) : (count == digits);
+}
+
+static bool parse_unsigned(cursor_t *cursor, uint64_t *value)
+{
+  const char *start = cursor->p;
+
+  *value = 0;
+  while (cursor->p < cursor->end && *cursor->p >= '0' && *cursor->p <= '9'
+         && cursor->p - start < 19) {
+    *value = *value * 10 + (uint64_t)(*cursor->p - '0');
+    cursor->p++;
+  }
+  return cursor->p != start;
+}
+
+static bool parse_signed(cursor_t *cursor, int64_t *value)
+{
+  bool negative = false;
+  uint64_t magnitude;
+
+  if (cursor->p < cursor->end && *cursor->p == '-') {
+    negative = true;
+    cursor->p++;
+  }
+  if (!parse_unsigned(cursor, &magnitude)) {
+    return false;
+  }
+  *value = negative ? -(int64_t)magnitude : (int64_t)magnitude;
+  return true;
+}
+
+static bool expect(cursor_t *cursor, char c)
+{
+  if (cursor->p < cursor->end && *cursor->p == c) {
+    cursor->p++;
+    return true;
+  }
+  return false;
+}
+
+static void skip_spaces(cursor_t *cursor)
+{
+  while (cursor->p < cursor->end && *cursor->p == ' ') {
+    cursor->p++;
+  }
+}
+
+/// "<EUI64>,<node ID>,<temperature>,<humidity>[,<sequence>]"
+static bool parse_record_line(cursor_t *cursor, sink_record_t *record)
+{
+  uint64_t value;
+  int64_t temperature;
+
+  if (!parse_hex(cursor, 16, &record->eui64) || !expect(cursor, ',')
+      || !parse_hex(cursor, 0, &value) || value > UINT16_MAX || !expect(cursor, ',')) {
+    return false;
+  }
+  record->node_id = (uint16_t)value;
+  if (!parse_signed(cursor, &temperature) || !expect(cursor, ',')
+      || !parse_unsigned(cursor, &value)) {
+    return false;
+  }
+  record->temperature = (int32_t)temperature;
+  record->humidity = (uint32_t)value;
+  record->flags = 0;
+  record->sequence = 0;
+  if (expect(cursor, ',')) {
+    if (!parse_unsigned(cursor, &value)) {
+      return false;
+    }
+    record->sequence = (uint32_t)value;
+    record->flags |= SINK_RECORD_FLAG_SEQUENCE;
+  }
+  return cursor->p == cursor->end;
+}
+
+/// " <EUI64> , <degrees>.<2 digits> >", the node ID is not printed
+static bool parse_snapshot_line(cursor_t *cursor, sink_record_t *record)
+{
+  int64_t degrees;
+  bool negative;
+  int tenths;
+  int hundredths;
+
+  skip_spaces(cursor);
+  if (!parse_hex(cursor, 16, &record->eui64)) {
+    return false;
+  }
+  skip_spaces(cursor);
+  if (!expect(cursor, ',')) {
+    return false;
+  }
+  skip_spaces(cursor);
+  negative = (cursor->p < cursor->end && *cursor->p == '-');
+  if (!parse_signed(cursor, &degrees) || !expect(cursor, '.')) {
+    return false;
+  }
+  if (degrees < 0) {
+    degrees = -degrees;
+  }
+  // The sink prints every digit group of a negative value with its own
+  // sign: -1234 m°C reads "-1.-2-3" and -500 m°C "0.-50".
+  tenths = -1;
+  hundredths = -1;
+  while (cursor->p < cursor->end && hundredths < 0) {
+    char c = *cursor->p++;
+    if (c == '-') {
+      negative = true;
+    } else if (c >= '0' && c <= '9') {
+      if (tenths < 0) {
+        tenths = c - '0';
+      } else {
+        hundredths = c - '0';
+      }
+    } else {
+      return false;
+    }
+  }
+  if (hundredths < 0) {
+    return false;
+  }
+  skip_spaces(cursor);
+  if (!expect(cursor, '>')) {
+    return false;
+  }
+  record->temperature = (int32_t)(degrees * 1000 + tenths * 100 + hundredths * 10);
+  if (negative) {
+    record->temperature = -record->temperature;
+  }
+  record->humidity = 0;
+  record->sequence = 0;
+  record->node_id = 0xFFFF;
+  record->flags = SINK_RECORD_FLAG_SNAPSHOT;
+  return true;
+}
+
+/// "<node ID>:" then " <2 hex digits>" per payload byte
+static bool parse_data_line(cursor_t *cursor, sink_record_t *record)
+{
+  uint8_t payload[DATA_MAX_LENGTH];
+  size_t length = 0;
+  size_t offset;
+  uint64_t value;
+
+  if (!parse_hex(cursor, 4, &value) || !expect(cursor, ':')) {
+    return false;
+  }
+  record->node_id = (uint16_t)value;
+  while (cursor->p < cursor->end) {
+    if (!expect(cursor, ' ') || length == DATA_MAX_LENGTH
+        || !parse_hex(cursor, 2, &value)) {
+      return false;
+    }
+    payload[length++] = (uint8_t)value;
+  }
+  if (length < DATA_LENGTH) {
+    return false;
+  }
+  record->eui64 = SINK_NODE_EUI64(record->node_id);
+  record->temperature = (int32_t)fetch_le32(payload);
+  record->humidity = fetch_le32(payload + 4);
+  record->sequence = 0;
+  record->flags = SINK_RECORD_FLAG_NODE_ONLY;
+
+  // Type, length, value elements; a truncated one ends the list.
+  offset = DATA_LENGTH;
+  while (offset + 2 <= length && offset + 2 + payload[offset + 1] <= length) {
+    if (payload[offset] == DATA_TLV_SEQUENCE
+        && payload[offset + 1] >= DATA_SEQUENCE_LENGTH) {
+      record->sequence = fetch_le32(payload + offset + 2);
+      record->flags |= SINK_RECORD_FLAG_SEQUENCE;
+    }
+    offset += 2 + (size_t)payload[offset + 1];
+  }
+  return true;
+}
+
+static uint32_t fetch_le32(const uint8_t *buffer)
+{
+  return (uint32_t)buffer[0] | ((uint32_t)buffer[1] << 8)
+         | ((uint32_t)buffer[2] << 16) | ((uint32_t)buffer[3] << 24);
+}
+
+static const char *find_prefix(const char *line,
+                               const char *end,
+                               const char *prefix,
+                               size_t prefix_length)
+{
+  const char *start = memchr(line, prefix[0], (size_t)(end - line));
+
+  while (start != NULL) {
+    if ((size_t)(end - start) >= prefix_length
+        && memcmp(start, prefix, prefix_length) == 0) {
+      return start;
+    }
+    start = memchr(start + 1, prefix[0], (size_t)(end - start - 1));
+  }
+  return NULL;
+}
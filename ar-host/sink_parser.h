@@ -0,0 +1,148 @@
+/***************************************************************************//**
+ * @file sink_parser.h
+ * @brief sink_parser.h
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+#ifndef SINK_PARSER_H
+#define SINK_PARSER_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Size of the line buffer of a parser, longer lines are dropped
+#define SINK_PARSER_BUFFER_SIZE        (16384u)
+
+/// The record carries a sequence number
+#define SINK_RECORD_FLAG_SEQUENCE      (0x01u)
+/// The record comes from the periodic "< EUI64 , temperature >" dump of the
+/// last values, not from a received report; it only has a temperature with
+/// 10 m°C resolution
+#define SINK_RECORD_FLAG_SNAPSHOT      (0x02u)
+/// The record comes from an "RX: Data from <node ID>: <payload>" line, which
+/// does not print the EUI64: the EUI64 is SINK_NODE_EUI64(node ID)
+#define SINK_RECORD_FLAG_NODE_ONLY     (0x04u)
+#define SINK_NODE_EUI64(node_id)       (0xFFFFFFFFFFFF0000ull | (uint16_t)(node_id))
+
+/// Sensor report parsed from the sink output
+typedef struct {
+  /// Host time the line was read at, in us since the epoch
+  uint64_t time_us;
+  /// EUI64 of the sensor, as printed: most significant byte first
+  uint64_t eui64;
+  /// Temperature in m°C and relative humidity in thousandths of percent
+  int32_t temperature;
+  uint32_t humidity;
+  /// Sequence number of the report, if SINK_RECORD_FLAG_SEQUENCE
+  uint32_t sequence;
+  uint16_t node_id;
+  uint8_t flags;
+  /// Index of the sink the record came from, set by the reader
+  uint8_t sink;
+} sink_record_t;
+
+/// Called for every parsed record
+typedef void (*sink_record_cb_t)(const sink_record_t *record, void *context);
+
+/// Incremental parser of the sink output. Data is read straight into its
+/// buffer and lines are parsed in place; only an incomplete last line is
+/// moved to the front of the buffer.
+///
+/// The sink prints "RX: Data" for every report, and the current firmware a
+/// "rec:" line right after it. A record of an "RX: Data" line is held until
+/// the next line: it is dropped if that is the "rec:" line of the same node.
+typedef struct {
+  char buffer[SINK_PARSER_BUFFER_SIZE];
+  size_t length;
+  /// Set while the rest of an overlong line is skipped
+  bool skipping;
+  /// Record of the last "RX: Data" line, if held
+  sink_record_t held;
+  bool holding;
+  /// Metrics
+  uint64_t bytes;
+  uint64_t lines;
+  uint64_t records;
+  uint64_t overflows;
+  /// Lines that look like records but do not parse
+  uint64_t errors;
+} sink_parser_t;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Empties a parser and clears its metrics.
+ *****************************************************************************/
+void sink_parser_init(sink_parser_t *parser);
+
+/**************************************************************************//**
+ * Returns where the next bytes are to be read to.
+ *
+ * @param *available receives the free space, never 0
+ *****************************************************************************/
+char *sink_parser_space(sink_parser_t *parser, size_t *available);
+
+/**************************************************************************//**
+ * Parses the bytes read to the space returned by sink_parser_space().
+ *
+ * @param length is the number of bytes read
+ * @param time_us is the time stamp given to the records
+ * @param callback is called for every record
+ * @returns the number of records.
+ *****************************************************************************/
+size_t sink_parser_commit(sink_parser_t *parser,
+                          size_t length,
+                          uint64_t time_us,
+                          sink_record_cb_t callback,
+                          void *context);
+
+/**************************************************************************//**
+ * Calls back for a held record, e.g. when the port closes.
+ *
+ * @returns the number of records.
+ *****************************************************************************/
+size_t sink_parser_flush(sink_parser_t *parser,
+                         sink_record_cb_t callback,
+                         void *context);
+
+/**************************************************************************//**
+ * Parses one line, without its line terminator. Recognizes the record lines
+ * "rec:<EUI64>,<node ID>,<temperature>,<humidity>[,<sequence>]", the
+ * "RX: Data from 0x<node ID>: <payload bytes>" lines and the periodic
+ * "< <EUI64> , <degrees>.<2 digits> >" dump lines.
+ *
+ * @param *error is set if the line looks like a record but does not parse,
+ *        may be NULL
+ * @returns true if the line holds a record. time_us and sink are left as is.
+ *****************************************************************************/
+bool sink_parse_line(const char *line,
+                     size_t length,
+                     sink_record_t *record,
+                     bool *error);
+
+/**************************************************************************//**
+ * Parses a 16 digit hex EUI64.
+ *
+ * @returns false if the text is not a valid EUI64.
+ *****************************************************************************/
+bool sink_parse_eui64(const char *text, uint64_t *eui64);
+
+#endif  // SINK_PARSER_H
@@ -0,0 +1,632 @@
+/***************************************************************************//**
+ * @file sink_replay.c
+ * @brief sink_replay.c
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+// Replays a serial capture of a sink on a pseudo-terminal, as the regression
+// benchmark of the host tools: sink_ingestd or sink_aggregator reads the pty
+// as if it were the sink. The capture is written at its recorded pace, sped
+// up (-x 100), or as fast as the reader takes it (-x 0).
+//
+// Build: gcc -O2 -Wall -o sink_replay sink_replay.c sink_parser.c sink_io.c
+// Usage: sink_replay [-x <speed>] [-r <lines/s>] [-l <link to the pty>]
+//                    [-f <record log of the reader>] [-w <start delay s>]
+//                    <capture>
+//
+// Capture lines may start with a timestamp, which is stripped and sets the
+// pace: "[<seconds>.<fraction>]", "[YYYY-MM-DD HH:MM:SS.fff]",
+// "YYYY-MM-DD HH:MM:SS.fff" or "HH:MM:SS.fff". A capture without timestamps
+// is written at -r lines/s (before the speed up).
+//
+// The capture goes through the same parser as the reader, which gives the
+// records expected and the parse errors. With -f, the record log written by
+// the reader is watched while replaying: the end-to-end latency is the time
+// from the write of a line to the record reaching the log.
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#define _XOPEN_SOURCE 600
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "sink_parser.h"
+#include "sink_io.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Lines buffered for the pty, and the size of a write at full speed
+#define CHUNK_SIZE              (65536u)
+#define WRITE_SIZE              (4096u)
+/// Write times of the records not yet in the record log, a power of 2
+#define PENDING_SIZE            (1u << 20)
+/// Period of the checks of the record log
+#define WATCH_PERIOD_US         (1000u)
+/// Latency buckets: 16 per power of 2
+#define LATENCY_BUCKETS         (976u)
+
+typedef struct {
+  /// Pseudo-terminal
+  int master;
+  int slave;
+  char chunk[CHUNK_SIZE];
+  size_t chunk_length;
+  /// Reference parser and its counts
+  sink_parser_t parser;
+  uint64_t expected;
+  uint64_t snapshots;
+  /// Record log of the reader
+  const char *log_path;
+  int log_fd;
+  uint64_t log_base;
+  uint64_t stored;
+  uint64_t next_watch_us;
+  /// Write time of expected record i at pending[i % PENDING_SIZE], for the
+  /// records up to stamped
+  uint64_t *pending;
+  uint64_t stamped;
+  uint64_t unmeasured;
+  /// Metrics
+  uint64_t lines;
+  uint64_t bytes;
+  uint64_t late_sum_us;
+  uint64_t late_max_us;
+  uint64_t latency_count;
+  uint64_t latency_max_us;
+  uint64_t latency[LATENCY_BUCKETS];
+} replay_t;
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+static uint64_t now_us(void);
+static size_t parse_timestamp(const char *line, size_t length, double *seconds);
+static bool parse_digits(const char **p, const char *end, unsigned count, unsigned *value);
+static int64_t days_from_civil(int year, unsigned month, unsigned day);
+static void parse_reference(replay_t *r, const char *line, size_t length);
+static void on_record(const sink_record_t *record, void *context);
+static void stamp_records(replay_t *r);
+static void flush_chunk(replay_t *r);
+static void watch_log(replay_t *r, bool force);
+static uint64_t log_records(replay_t *r);
+static void wait_stored(replay_t *r, uint64_t expected, double idle_s);
+static unsigned latency_bucket(uint64_t us);
+static uint64_t bucket_floor(unsigned bucket);
+static double latency_percentile(const replay_t *r, double fraction);
+static void on_signal(int signal);
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static volatile sig_atomic_t stop = 0;
+static replay_t replay;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  replay_t *r = &replay;
+  double speed = 1.0;
+  double line_rate = 50.0;
+  double delay_s = 1.0;
+  double idle_s = 2.0;
+  const char *link_path = NULL;
+  const char *capture_path;
+  const char *data;
+  const char *end;
+  const char *line;
+  struct termios tio;
+  struct stat st;
+  bool timestamped = false;
+  double first_s = 0.0;
+  double last_s = 0.0;
+  double day_offset_s = 0.0;
+  uint64_t started_us;
+  uint64_t elapsed_us;
+  int option;
+  int fd;
+
+  while ((option = getopt(argc, argv, "x:r:l:f:w:")) != -1) {
+    switch (option) {
+      case 'x': speed = strtod(optarg, NULL); break;
+      case 'r': line_rate = strtod(optarg, NULL); break;
+      case 'l': link_path = optarg; break;
+      case 'f': r->log_path = optarg; break;
+      case 'w': delay_s = strtod(optarg, NULL); break;
+      default:
+        fprintf(stderr, "usage: %s [-x <speed>] [-r <lines/s>] [-l <link to the pty>] "
+                "[-f <record log of the reader>] [-w <start delay s>] <capture>\n", argv[0]);
+        return 2;
+    }
+  }
+  if (optind + 1 != argc || speed < 0.0 || line_rate <= 0.0) {
+    fprintf(stderr, "%s: one capture, a speed of 0 (max) or more and a positive rate\n",
+            argv[0]);
+    return 2;
+  }
+  capture_path = argv[optind];
+
+  fd = open(capture_path, O_RDONLY);
+  if (fd < 0 || fstat(fd, &st) != 0) {
+    perror(capture_path);
+    return 1;
+  }
+  data = (st.st_size > 0)
+         ? mmap(NULL, (size_t)st.st_size, PROT_READ, MAP_PRIVATE, fd, 0) : "";
+  if (data == MAP_FAILED) {
+    perror(capture_path);
+    return 1;
+  }
+  end = data + st.st_size;
+  madvise((void *)data, (size_t)st.st_size, MADV_SEQUENTIAL);
+
+  r->pending = malloc(PENDING_SIZE * sizeof(*r->pending));
+  if (r->pending == NULL) {
+    perror("malloc");
+    return 1;
+  }
+  sink_parser_init(&r->parser);
+  r->log_fd = -1;
+
+  r->master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (r->master < 0 || grantpt(r->master) != 0 || unlockpt(r->master) != 0) {
+    perror("posix_openpt");
+    return 1;
+  }
+  // Raw on the slave side, so that the reader gets the bytes as written. The
+  // slave is kept open so the pty lives until a reader opens it.
+  r->slave = open(ptsname(r->master), O_RDWR | O_NOCTTY);
+  if (r->slave < 0 || tcgetattr(r->slave, &tio) != 0) {
+    perror(ptsname(r->master));
+    return 1;
+  }
+  cfmakeraw(&tio);
+  tcsetattr(r->slave, TCSANOW, &tio);
+  if (link_path != NULL) {
+    unlink(link_path);
+    if (symlink(ptsname(r->master), link_path) != 0) {
+      perror(link_path);
+      return 1;
+    }
+  }
+  printf("%s\n", ptsname(r->master));
+  fflush(stdout);
+
+  signal(SIGINT, on_signal);
+  signal(SIGTERM, on_signal);
+
+  // Time for the reader to open the pty and its record log.
+  poll(NULL, 0, (int)(delay_s * 1000.0));
+  fcntl(r->master, F_SETFL, fcntl(r->master, F_GETFL) | O_NONBLOCK);
+  if (r->log_path != NULL) {
+    r->log_base = log_records(r);
+  }
+
+  started_us = now_us();
+  for (line = data; line < end && !stop; ) {
+    const char *newline = memchr(line, '\n', (size_t)(end - line));
+    const char *next = (newline != NULL) ? newline + 1 : end;
+    size_t length = (size_t)(next - line);
+    double seconds;
+    size_t prefix = parse_timestamp(line, length, &seconds);
+    uint64_t due_us;
+    uint64_t now;
+
+    if (prefix > 0) {
+      // A time of day wraps at midnight.
+      if (timestamped && seconds + day_offset_s < last_s - 43200.0) {
+        day_offset_s += 86400.0;
+      }
+      last_s = seconds + day_offset_s;
+      if (!timestamped) {
+        first_s = last_s;
+        timestamped = true;
+      }
+    } else if (!timestamped) {
+      last_s = (double)r->lines / line_rate;
+    }
+    if (speed > 0.0) {
+      due_us = started_us + (uint64_t)((last_s - first_s) * 1e6 / speed);
+      now = now_us();
+      if (due_us > now) {
+        flush_chunk(r);
+        while (!stop && (now = now_us()) < due_us) {
+          watch_log(r, false);
+          poll(NULL, 0, (int)((due_us - now) > WATCH_PERIOD_US
+                              ? WATCH_PERIOD_US / 1000u : 0));
+        }
+      } else {
+        r->late_sum_us += now - due_us;
+        if (now - due_us > r->late_max_us) {
+          r->late_max_us = now - due_us;
+        }
+      }
+    }
+
+    line += prefix;
+    length -= prefix;
+    if (length >= CHUNK_SIZE) {
+      // Far beyond the line buffer of the readers, which drop it anyway
+      length = CHUNK_SIZE - 1;
+      newline = NULL;
+    }
+    if (r->chunk_length + length + 1 > CHUNK_SIZE) {
+      flush_chunk(r);
+    }
+    memcpy(r->chunk + r->chunk_length, line, length);
+    r->chunk_length += length;
+    if (newline == NULL) {
+      r->chunk[r->chunk_length++] = '\n';
+      length++;
+    }
+    parse_reference(r, r->chunk + r->chunk_length - length, length);
+    r->lines++;
+    r->bytes += length;
+    if (speed > 0.0 || r->chunk_length >= WRITE_SIZE) {
+      flush_chunk(r);
+    }
+    line = next;
+  }
+  flush_chunk(r);
+  elapsed_us = now_us() - started_us;
+
+  // Let the reader drain the pty, then close it: the reader reports the
+  // record held back for a "rec:" line on close.
+  tcdrain(r->master);
+  if (r->log_path != NULL) {
+    wait_stored(r, r->expected, idle_s);
+  } else {
+    poll(NULL, 0, 200);
+  }
+  if (link_path != NULL) {
+    unlink(link_path);
+  }
+  close(r->slave);
+  close(r->master);
+  sink_parser_flush(&r->parser, on_record, r);
+  stamp_records(r);
+  if (r->log_path != NULL) {
+    wait_stored(r, r->expected, idle_s);
+  }
+
+  fprintf(stderr, "lines=%llu bytes=%llu duration_s=%.3f rate=%.0f lines/s %.2f MB/s "
+          "records=%llu snapshots=%llu parse_errors=%llu overflows=%llu\n",
+          (unsigned long long)r->lines, (unsigned long long)r->bytes,
+          (double)elapsed_us / 1e6,
+          (elapsed_us > 0) ? (double)r->lines * 1e6 / (double)elapsed_us : 0.0,
+          (elapsed_us > 0) ? (double)r->bytes / (double)elapsed_us : 0.0,
+          (unsigned long long)r->expected, (unsigned long long)r->snapshots,
+          (unsigned long long)r->parser.errors, (unsigned long long)r->parser.overflows);
+  if (speed > 0.0) {
+    fprintf(stderr, "late_ms=%.2f/%.2f\n",
+            r->lines ? (double)r->late_sum_us / (double)r->lines / 1e3 : 0.0,
+            (double)r->late_max_us / 1e3);
+  }
+  if (r->log_path != NULL) {
+    fprintf(stderr, "stored=%llu missing=%lld latency_ms p50=%.2f p90=%.2f p99=%.2f "
+            "max=%.2f unmeasured=%llu\n",
+            (unsigned long long)r->stored,
+            (long long)(r->expected - r->stored),
+            latency_percentile(r, 0.50) / 1e3,
+            latency_percentile(r, 0.90) / 1e3,
+            latency_percentile(r, 0.99) / 1e3,
+            (double)r->latency_max_us / 1e3,
+            (unsigned long long)r->unmeasured);
+  }
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+static uint64_t now_us(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+/// @returns the length of the timestamp and the spaces after it, 0 if none
+static size_t parse_timestamp(const char *line, size_t length, double *seconds)
+{
+  const char *end = line + length;
+  const char *p = line;
+  bool bracket = (p < end && *p == '[');
+  unsigned year;
+  unsigned month;
+  unsigned day;
+  unsigned hours;
+  unsigned minutes;
+  unsigned secs;
+  double fraction = 0.0;
+  double scale = 0.1;
+
+  *seconds = 0.0;
+  if (bracket) {
+    p++;
+    while (p < end && *p == ' ') {
+      p++;
+    }
+  }
+  if (parse_digits(&p, end, 4, &year) && p < end && *p == '-'
+      && (p++, parse_digits(&p, end, 2, &month)) && p < end && *p == '-'
+      && (p++, parse_digits(&p, end, 2, &day)) && p < end && (*p == ' ' || *p == 'T')) {
+    p++;
+    *seconds = (double)days_from_civil((int)year, month, day) * 86400.0;
+  } else {
+    p = line + bracket;
+    while (bracket && p < end && *p == ' ') {
+      p++;
+    }
+  }
+  if (p + 2 < end && (p[1] == ':' || p[2] == ':')) {
+    if (!parse_digits(&p, end, (p[1] == ':') ? 1 : 2, &hours) || p >= end || *p++ != ':'
+        || !parse_digits(&p, end, 2, &minutes) || p >= end || *p++ != ':'
+        || !parse_digits(&p, end, 2, &secs)) {
+      return 0;
+    }
+    *seconds += (double)(hours * 3600u + minutes * 60u + secs);
+  } else if (bracket) {
+    // Seconds since the start of the capture
+    if (p >= end || *p < '0' || *p > '9') {
+      return 0;
+    }
+    while (p < end && *p >= '0' && *p <= '9') {
+      *seconds = *seconds * 10.0 + (*p++ - '0');
+    }
+  } else {
+    return 0;
+  }
+  if (p < end && (*p == '.' || *p == ',')) {
+    p++;
+    while (p < end && *p >= '0' && *p <= '9') {
+      fraction += (*p++ - '0') * scale;
+      scale /= 10.0;
+    }
+  }
+  *seconds += fraction;
+  if (bracket) {
+    if (p >= end || *p != ']') {
+      return 0;
+    }
+    p++;
+  } else if (p >= end || *p != ' ') {
+    return 0;
+  }
+  while (p < end && *p == ' ') {
+    p++;
+  }
+  return (size_t)(p - line);
+}
+
+static bool parse_digits(const char **p, const char *end, unsigned count, unsigned *value)
+{
+  *value = 0;
+  while (count-- > 0) {
+    if (*p >= end || **p < '0' || **p > '9') {
+      return false;
+    }
+    *value = *value * 10u + (unsigned)(*(*p)++ - '0');
+  }
+  return true;
+}
+
+/// Days since 1970-01-01 of a date of the proleptic Gregorian calendar
+static int64_t days_from_civil(int year, unsigned month, unsigned day)
+{
+  int64_t era;
+  unsigned year_of_era;
+  unsigned day_of_year;
+  unsigned day_of_era;
+
+  year -= (month <= 2);
+  era = (year >= 0 ? year : year - 399) / 400;
+  year_of_era = (unsigned)(year - era * 400);
+  day_of_year = (153u * (month > 2 ? month - 3 : month + 9) + 2u) / 5u + day - 1u;
+  day_of_era = year_of_era * 365u + year_of_era / 4u - year_of_era / 100u + day_of_year;
+  return era * 146097 + (int64_t)day_of_era - 719468;
+}
+
+/// Runs a line through the parser of the readers. Its records are stamped
+/// with the write time.
+static void parse_reference(replay_t *r, const char *line, size_t length)
+{
+  while (length > 0) {
+    size_t available;
+    char *space = sink_parser_space(&r->parser, &available);
+    size_t part = (length < available) ? length : available;
+
+    memcpy(space, line, part);
+    sink_parser_commit(&r->parser, part, 0, on_record, r);
+    line += part;
+    length -= part;
+  }
+}
+
+static void on_record(const sink_record_t *record, void *context)
+{
+  replay_t *r = context;
+
+  // The readers do not store snapshots.
+  if ((record->flags & SINK_RECORD_FLAG_SNAPSHOT) != 0) {
+    r->snapshots++;
+  } else {
+    r->expected++;
+  }
+}
+
+/// The records parsed since the last call are on their way from now on.
+static void stamp_records(replay_t *r)
+{
+  uint64_t now = now_us();
+
+  while (r->stamped < r->expected) {
+    r->pending[r->stamped++ & (PENDING_SIZE - 1)] = now;
+  }
+}
+
+static void flush_chunk(replay_t *r)
+{
+  const char *data = r->chunk;
+  size_t length = r->chunk_length;
+
+  if (length == 0) {
+    return;
+  }
+  stamp_records(r);
+  r->chunk_length = 0;
+  while (length > 0 && !stop) {
+    ssize_t written = write(r->master, data, length);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == EAGAIN) {
+        // The reader is behind: watch its progress meanwhile.
+        struct pollfd pfd = { .fd = r->master, .events = POLLOUT };
+        watch_log(r, false);
+        poll(&pfd, 1, WATCH_PERIOD_US / 1000u);
+        continue;
+      }
+      perror("write");
+      stop = 1;
+      return;
+    }
+    data += written;
+    length -= (size_t)written;
+  }
+  watch_log(r, false);
+}
+
+/// Takes the latency of the records that reached the record log since the
+/// last check, at most every WATCH_PERIOD_US unless forced.
+static void watch_log(replay_t *r, bool force)
+{
+  uint64_t now = now_us();
+  uint64_t count;
+
+  if (r->log_path == NULL || (!force && now < r->next_watch_us)) {
+    return;
+  }
+  r->next_watch_us = now + WATCH_PERIOD_US;
+  count = log_records(r);
+  count = (count > r->log_base) ? count - r->log_base : 0;
+  for (; r->stored < count; r->stored++) {
+    uint64_t latency_us;
+
+    if (r->stored >= r->stamped
+        || r->stored + PENDING_SIZE < r->stamped) {
+      // Not from the capture, or its write time was overwritten
+      r->unmeasured++;
+      continue;
+    }
+    latency_us = now - r->pending[r->stored & (PENDING_SIZE - 1)];
+    r->latency[latency_bucket(latency_us)]++;
+    r->latency_count++;
+    if (latency_us > r->latency_max_us) {
+      r->latency_max_us = latency_us;
+    }
+  }
+}
+
+static uint64_t log_records(replay_t *r)
+{
+  struct stat st;
+
+  // The reader may create the log after the start.
+  if (r->log_fd < 0) {
+    r->log_fd = open(r->log_path, O_RDONLY);
+  }
+  if (r->log_fd < 0 || fstat(r->log_fd, &st) != 0
+      || st.st_size < (off_t)SINK_RECORD_LOG_HEADER_LENGTH) {
+    return 0;
+  }
+  return ((uint64_t)st.st_size - SINK_RECORD_LOG_HEADER_LENGTH) / sizeof(sink_record_t);
+}
+
+/// Waits until the reader stored the expected records or made no progress
+/// for idle_s.
+static void wait_stored(replay_t *r, uint64_t expected, double idle_s)
+{
+  uint64_t stored = r->stored;
+  uint64_t progress_us = now_us();
+
+  while (!stop && r->stored < expected
+         && now_us() - progress_us < (uint64_t)(idle_s * 1e6)) {
+    poll(NULL, 0, WATCH_PERIOD_US / 1000u);
+    watch_log(r, true);
+    if (r->stored != stored) {
+      stored = r->stored;
+      progress_us = now_us();
+    }
+  }
+}
+
+/// 16 buckets per power of 2, i.e. within 6 %
+static unsigned latency_bucket(uint64_t us)
+{
+  unsigned exponent;
+
+  if (us < 16) {
+    return (unsigned)us;
+  }
+  exponent = 63u - (unsigned)__builtin_clzll(us);
+  return (exponent - 3u) * 16u + (unsigned)((us >> (exponent - 4u)) & 15u);
+}
+
+static uint64_t bucket_floor(unsigned bucket)
+{
+  if (bucket < 16) {
+    return bucket;
+  }
+  return (uint64_t)(16u + bucket % 16u) << (bucket / 16u - 1u);
+}
+
+static double latency_percentile(const replay_t *r, double fraction)
+{
+  uint64_t rank = (uint64_t)(fraction * (double)r->latency_count);
+  uint64_t seen = 0;
+  unsigned bucket;
+
+  for (bucket = 0; bucket < LATENCY_BUCKETS; bucket++) {
+    seen += r->latency[bucket];
+    if (seen > rank) {
+      return (double)bucket_floor(bucket);
+    }
+  }
+  return (double)r->latency_max_us;
+}
+
+static void on_signal(int signal)
+{
+  (void) signal;
+  stop = 1;
+}
@@ -0,0 +1,257 @@
+/***************************************************************************//**
+ * @file sink_sim.c
+ * @brief sink_sim.c
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+// Stand-in for a sink on a pseudo-terminal, to test the host tools without
+// hardware. It writes the output of a sink with many sensors: "rec:" report
+// lines, the periodic "< EUI64 , temperature >" dump and other console noise,
+// at a fixed rate of reports.
+//
+// Build: gcc -O2 -Wall -o sink_sim sink_sim.c
+// Usage: sink_sim [-n <sensors>] [-r <reports/s>] [-t <duration s>]
+//                 [-l <link to the pty>] [-S] [-e <EUI64 base>]
+//
+// -S appends a sequence number to the report lines. The counts of the
+// reports written are printed on exit, to compare with the reader.
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#define _XOPEN_SOURCE 600
+#define _DEFAULT_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <termios.h>
+#include <time.h>
+#include <unistd.h>
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Reports between two dumps of the last values
+#define DUMP_PERIOD             (5000u)
+/// Reports between two noise lines
+#define NOISE_PERIOD            (997u)
+/// Reports written per tick at most
+#define BURST_MAX               (256u)
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+static uint64_t now_us(void);
+static void write_all(int fd, const char *data, size_t length);
+static size_t format_eui64(char *out, uint64_t eui64);
+static void on_signal(int signal);
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static volatile sig_atomic_t stop = 0;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  unsigned sensors = 100;
+  double rate = 1000.0;
+  double duration_s = 0.0;
+  const char *link_path = NULL;
+  bool with_sequence = false;
+  uint64_t eui64_base = 0x000B57FFFE000000ull;
+  uint64_t reports = 0;
+  uint64_t dumps = 0;
+  uint64_t started_us;
+  struct termios tio;
+  int option;
+  int master;
+  int slave;
+
+  while ((option = getopt(argc, argv, "n:r:t:l:Se:")) != -1) {
+    switch (option) {
+      case 'n': sensors = (unsigned)strtoul(optarg, NULL, 0); break;
+      case 'r': rate = strtod(optarg, NULL); break;
+      case 't': duration_s = strtod(optarg, NULL); break;
+      case 'l': link_path = optarg; break;
+      case 'S': with_sequence = true; break;
+      case 'e': eui64_base = strtoull(optarg, NULL, 16); break;
+      default:
+        fprintf(stderr, "usage: %s [-n <sensors>] [-r <reports/s>] [-t <duration s>] "
+                "[-l <link to the pty>] [-S] [-e <EUI64 base>]\n", argv[0]);
+        return 2;
+    }
+  }
+  if (sensors == 0 || rate <= 0.0) {
+    fprintf(stderr, "%s: sensors and rate must be positive\n", argv[0]);
+    return 2;
+  }
+
+  master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (master < 0 || grantpt(master) != 0 || unlockpt(master) != 0) {
+    perror("posix_openpt");
+    return 1;
+  }
+  // Raw on the slave side, so that the reader gets the bytes as written. The
+  // slave is kept open so the pty lives until a reader opens it.
+  slave = open(ptsname(master), O_RDWR | O_NOCTTY);
+  if (slave < 0 || tcgetattr(slave, &tio) != 0) {
+    perror(ptsname(master));
+    return 1;
+  }
+  cfmakeraw(&tio);
+  tcsetattr(slave, TCSANOW, &tio);
+  if (link_path != NULL) {
+    unlink(link_path);
+    if (symlink(ptsname(master), link_path) != 0) {
+      perror(link_path);
+      return 1;
+    }
+  }
+  printf("%s\n", ptsname(master));
+  fflush(stdout);
+
+  signal(SIGINT, on_signal);
+  signal(SIGTERM, on_signal);
+
+  started_us = now_us();
+  while (!stop) {
+    static char chunk[BURST_MAX * 96];
+    uint64_t elapsed_us = now_us() - started_us;
+    uint64_t due = (uint64_t)((double)elapsed_us * rate / 1e6);
+    size_t length = 0;
+    unsigned burst = 0;
+
+    if (duration_s > 0.0 && (double)elapsed_us >= duration_s * 1e6) {
+      break;
+    }
+    while (reports < due && burst < BURST_MAX) {
+      unsigned index = (unsigned)(reports % sensors);
+      uint64_t eui64 = eui64_base + index;
+      // Slow drifts around 21 °C and 45 %RH, different for every sensor
+      int32_t temperature = 21000 + (int32_t)((index * 37u + reports / sensors * 13u) % 4000u) - 2000;
+      uint32_t humidity = 45000u + (uint32_t)((index * 53u + reports / sensors * 7u) % 10000u);
+
+      memcpy(chunk + length, "rec:", 4);
+      length += 4;
+      length += format_eui64(chunk + length, eui64);
+      length += (size_t)sprintf(chunk + length, ",%04X,%ld,%lu",
+                                (unsigned)(0x0100 + index) & 0xFFFFu,
+                                (long)temperature, (unsigned long)humidity);
+      if (with_sequence) {
+        length += (size_t)sprintf(chunk + length, ",%lu",
+                                  (unsigned long)(reports / sensors) & 0xFFFFFFFFul);
+      }
+      chunk[length++] = '\n';
+      reports++;
+      burst++;
+
+      if (reports % NOISE_PERIOD == 0) {
+        length += (size_t)sprintf(chunk + length, "TX: Data to 0x%04X: 12 bytes\n",
+                                  (unsigned)(0x0100 + index) & 0xFFFFu);
+      }
+      if (reports % DUMP_PERIOD == 0) {
+        // The dump of the sink: "< EUI64 , d.dd >" with a sign per part for
+        // negative values, one sensor per dump to keep the lines short.
+        int32_t t = (int32_t)(index % 2 == 0 ? temperature : -temperature);
+        chunk[length++] = '<';
+        chunk[length++] = ' ';
+        length += format_eui64(chunk + length, eui64);
+        length += (size_t)sprintf(chunk + length, " , %ld.%ld%ld >\n",
+                                  (long)(t / 1000), (long)((t % 1000) / 100),
+                                  (long)((t % 100) / 10));
+        dumps++;
+      }
+      if (length > sizeof(chunk) - 192) {
+        break;
+      }
+    }
+    if (length > 0) {
+      write_all(master, chunk, length);
+    } else {
+      poll(NULL, 0, 1);
+    }
+  }
+
+  fprintf(stderr, "reports=%llu dumps=%llu rate=%.0f/s\n",
+          (unsigned long long)reports, (unsigned long long)dumps,
+          (double)reports * 1e6 / (double)(now_us() - started_us));
+  // Let the reader drain the pty before it goes away.
+  tcdrain(master);
+  poll(NULL, 0, 200);
+  if (link_path != NULL) {
+    unlink(link_path);
+  }
+  close(slave);
+  close(master);
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+static uint64_t now_us(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+static void write_all(int fd, const char *data, size_t length)
+{
+  while (length > 0 && !stop) {
+    ssize_t written = write(fd, data, length);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      if (errno == EAGAIN) {
+        poll(NULL, 0, 1);
+        continue;
+      }
+      perror("write");
+      stop = 1;
+      return;
+    }
+    data += written;
+    length -= (size_t)written;
+  }
+}
+
+static size_t format_eui64(char *out, uint64_t eui64)
+{
+  static const char hex[] = "0123456789ABCDEF";
+  int i;
+
+  for (i = 0; i < 16; i++) {
+    out[i] = hex[(eui64 >> (60 - 4 * i)) & 0xF];
+  }
+  return 16;
+}
+
+static void on_signal(int signal)
+{
+  (void) signal;
+  stop = 1;
+}
@@ -0,0 +1,37 @@
+/***************************************************************************//**
+ * @file app_framework_common.h
+ * @brief app_framework_common.h
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+// Host stand-in of the Connect application framework, see host_platform.h.
+// -----------------------------------------------------------------------------
+#ifndef APP_FRAMEWORK_COMMON_H
+#define APP_FRAMEWORK_COMMON_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include "stack/include/ember.h"
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Allocates an event control run by host_stack_advance().
+ *****************************************************************************/
+void emberAfAllocateEvent(EmberEventControl **control, void (*handler)(void));
+
+#endif  // APP_FRAMEWORK_COMMON_H
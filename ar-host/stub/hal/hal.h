@@ -0,0 +1,40 @@
+/***************************************************************************//**
+ * @file hal.h
+ * @brief hal.h
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+// Host stand-in of the HAL, see host_platform.h.
+// -----------------------------------------------------------------------------
+#ifndef HAL_H
+#define HAL_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdint.h>
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define elapsedTimeInt32u(oldTime, newTime)  ((uint32_t)((uint32_t)(newTime) - (uint32_t)(oldTime)))
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+uint32_t halCommonGetInt32uMillisecondTick(void);
+uint16_t halCommonGetRandom(void);
+
+#endif  // HAL_H
@@ -0,0 +1,46 @@
+/***************************************************************************//**
+ * @file host_platform.h
+ * @brief host_platform.h
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+// Host stand-ins of the platform, stack and framework headers, just enough to
+// build application modules of ar-gateway and ar-sensor into the host tools.
+// Pass -DPLATFORM_HEADER='"host_platform.h"' -Istub to the compiler and link
+// stub/host_stack.c. The stack is simulated: a millisecond clock advanced by
+// the tool, a radio channel set by the tool and the event scheduler.
+// -----------------------------------------------------------------------------
+#ifndef HOST_PLATFORM_H
+#define HOST_PLATFORM_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define MEMSET(d, v, l)      memset((d), (v), (l))
+#define MEMCOPY(d, s, l)     memcpy((d), (s), (l))
+#define MEMMOVE(d, s, l)     memmove((d), (s), (l))
+#define MEMCOMPARE(a, b, l)  memcmp((a), (b), (l))
+
+#define MILLISECOND_TICKS_PER_SECOND    (1000u)
+
+#endif  // HOST_PLATFORM_H
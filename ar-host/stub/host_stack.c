@@ -0,0 +1,180 @@
+/***************************************************************************//**
+ * @file host_stack.c
+ * @brief host_stack.c
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include "host_platform.h"
+#include "stack/include/ember.h"
+#include "hal/hal.h"
+#include "app_framework_common.h"
+#include "sl_sleeptimer.h"
+#include "host_stack.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Events an application may allocate
+#define MAX_EVENTS    (32u)
+
+typedef struct {
+  EmberEventControl control;
+  void (*handler)(void);
+} event_t;
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static event_t events[MAX_EVENTS];
+static uint8_t event_count;
+/// Simulated time in ms, the sleeptimer follows it at drift_ppm
+static uint64_t now_ms;
+static int32_t drift_ppm;
+static uint16_t radio_channel;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+void host_stack_advance(uint32_t ms)
+{
+  uint64_t end_ms = now_ms + ms;
+
+  for (;; ) {
+    event_t *next = NULL;
+    uint8_t i;
+
+    for (i = 0; i < event_count; i++) {
+      event_t *event = &events[i];
+      if (event->control.status != EMBER_EVENT_INACTIVE
+          && elapsedTimeInt32u(now_ms, event->control.timeToExecute)
+          <= end_ms - now_ms
+          && (next == NULL
+              || elapsedTimeInt32u(now_ms, event->control.timeToExecute)
+              < elapsedTimeInt32u(now_ms, next->control.timeToExecute))) {
+        next = event;
+      }
+    }
+    if (next == NULL) {
+      break;
+    }
+    now_ms += elapsedTimeInt32u(now_ms, next->control.timeToExecute);
+    next->handler();
+  }
+  now_ms = end_ms;
+}
+
+void host_stack_set_channel(uint16_t channel)
+{
+  radio_channel = channel;
+}
+
+void host_stack_set_drift(int32_t ppm)
+{
+  drift_ppm = ppm;
+}
+
+void emberAfAllocateEvent(EmberEventControl **control, void (*handler)(void))
+{
+  if (event_count == MAX_EVENTS) {
+    fprintf(stderr, "host_stack: out of events\n");
+    exit(EXIT_FAILURE);
+  }
+  events[event_count].handler = handler;
+  events[event_count].control.status = EMBER_EVENT_INACTIVE;
+  *control = &events[event_count].control;
+  event_count++;
+}
+
+void emEventControlSetActive(EmberEventControl *control)
+{
+  control->status = EMBER_EVENT_ZERO_DELAY;
+  control->timeToExecute = (uint32_t)now_ms;
+}
+
+void emEventControlSetInactive(EmberEventControl *control)
+{
+  control->status = EMBER_EVENT_INACTIVE;
+}
+
+void emEventControlSetDelayMS(EmberEventControl *control, uint32_t delay)
+{
+  control->status = EMBER_EVENT_MS_TIME;
+  control->timeToExecute = (uint32_t)now_ms + delay;
+}
+
+uint32_t halCommonGetInt32uMillisecondTick(void)
+{
+  return (uint32_t)now_ms;
+}
+
+uint16_t halCommonGetRandom(void)
+{
+  return (uint16_t)rand();
+}
+
+uint64_t sl_sleeptimer_get_tick_count64(void)
+{
+  return (now_ms * HOST_SLEEPTIMER_FREQUENCY * (uint64_t)(1000000 + drift_ppm))
+         / (MILLISECOND_TICKS_PER_SECOND * 1000000ull);
+}
+
+uint32_t sl_sleeptimer_get_timer_frequency(void)
+{
+  return HOST_SLEEPTIMER_FREQUENCY;
+}
+
+bool emberStackIsUp(void)
+{
+  return true;
+}
+
+EmberNodeId emberGetNodeId(void)
+{
+  return 0x0000;
+}
+
+uint16_t emberGetRadioChannel(void)
+{
+  return radio_channel;
+}
+
+uint16_t emberFetchLowHighInt16u(const uint8_t *contents)
+{
+  return (uint16_t)(contents[0] | (contents[1] << 8));
+}
+
+uint32_t emberFetchLowHighInt32u(const uint8_t *contents)
+{
+  return (uint32_t)contents[0] | ((uint32_t)contents[1] << 8)
+         | ((uint32_t)contents[2] << 16) | ((uint32_t)contents[3] << 24);
+}
+
+void emberStoreLowHighInt16u(uint8_t *contents, uint16_t value)
+{
+  contents[0] = (uint8_t)value;
+  contents[1] = (uint8_t)(value >> 8);
+}
+
+void emberStoreLowHighInt32u(uint8_t *contents, uint32_t value)
+{
+  contents[0] = (uint8_t)value;
+  contents[1] = (uint8_t)(value >> 8);
+  contents[2] = (uint8_t)(value >> 16);
+  contents[3] = (uint8_t)(value >> 24);
+}
@@ -0,0 +1,48 @@
+/***************************************************************************//**
+ * @file host_stack.h
+ * @brief host_stack.h
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+#ifndef HOST_STACK_H
+#define HOST_STACK_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdint.h>
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Advances the simulated clock, running the events that become due in time
+ * order.
+ *
+ * @param ms is the time to advance by
+ *****************************************************************************/
+void host_stack_advance(uint32_t ms);
+
+/**************************************************************************//**
+ * Sets the channel returned by emberGetRadioChannel().
+ *****************************************************************************/
+void host_stack_set_channel(uint16_t channel);
+
+/**************************************************************************//**
+ * Sets the drift of the sleeptimer against the millisecond clock.
+ *
+ * @param ppm is positive for a fast sleeptimer
+ *****************************************************************************/
+void host_stack_set_drift(int32_t ppm);
+
+#endif  // HOST_STACK_H
@@ -0,0 +1,47 @@
+/***************************************************************************//**
+ * @file sl_app_common.h
+ * @brief sl_app_common.h
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+// Host stand-in of the common definitions of the Flex SDK applications, see
+// host_platform.h. The frame layout of the sensor/sink protocol follows the
+// SDK; build with -DSENSOR_SINK_DATA_LENGTH=<n> to match another SDK.
+// -----------------------------------------------------------------------------
+#ifndef SL_APP_COMMON_H
+#define SL_APP_COMMON_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdio.h>
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define APP_INFO(...)                         printf(__VA_ARGS__)
+
+#define SENSOR_SINK_PROTOCOL_ID               (0xC00Fu)
+#define SENSOR_SINK_PROTOCOL_ID_OFFSET        (0u)
+#define SENSOR_SINK_COMMAND_ID_OFFSET         (2u)
+#define SENSOR_SINK_EUI64_OFFSET              (3u)
+#define SENSOR_SINK_NODE_ID_OFFSET            (11u)
+#define SENSOR_SINK_DATA_OFFSET               (13u)
+#ifndef SENSOR_SINK_DATA_LENGTH
+#define SENSOR_SINK_DATA_LENGTH               (8u)
+#endif
+#define SENSOR_SINK_MAXIMUM_LENGTH            (SENSOR_SINK_DATA_OFFSET + SENSOR_SINK_DATA_LENGTH)
+
+#endif  // SL_APP_COMMON_H
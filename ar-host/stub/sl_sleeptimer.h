@@ -0,0 +1,42 @@
+/***************************************************************************//**
+ * @file sl_sleeptimer.h
+ * @brief sl_sleeptimer.h
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+// Host stand-in of the sleeptimer, see host_platform.h. The tick runs at
+// HOST_SLEEPTIMER_FREQUENCY, skewed by host_stack_set_drift().
+// -----------------------------------------------------------------------------
+#ifndef SL_SLEEPTIMER_H
+#define SL_SLEEPTIMER_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdint.h>
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Frequency of the sleeptimer of the EFR32 (LFXO)
+#define HOST_SLEEPTIMER_FREQUENCY    (32768u)
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+uint64_t sl_sleeptimer_get_tick_count64(void);
+uint32_t sl_sleeptimer_get_timer_frequency(void);
+
+#endif  // SL_SLEEPTIMER_H
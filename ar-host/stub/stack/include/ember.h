@@ -0,0 +1,89 @@
+/***************************************************************************//**
+ * @file ember.h
+ * @brief ember.h
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+// Host stand-in of the Connect stack API, see host_platform.h.
+// -----------------------------------------------------------------------------
+#ifndef EMBER_H
+#define EMBER_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdint.h>
+#include <stdbool.h>
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+typedef uint8_t EmberStatus;
+typedef uint16_t EmberNodeId;
+typedef uint8_t EmberNodeType;
+typedef uint8_t EmberMessageLength;
+typedef uint8_t EmberMessageOptions;
+
+/// Statuses used by the application modules
+#define EMBER_SUCCESS                   (0x00u)
+#define EMBER_ERR_FATAL                 (0x01u)
+#define EMBER_BAD_ARGUMENT              (0x02u)
+#define EMBER_NO_BUFFERS                (0x18u)
+#define EMBER_INVALID_CALL              (0x70u)
+#define EMBER_MESSAGE_TOO_LONG          (0x74u)
+#define EMBER_MAC_TRANSMIT_QUEUE_FULL   (0x39u)
+#define EMBER_MAC_NO_ACK_RECEIVED       (0x40u)
+#define EMBER_PHY_TX_CCA_FAIL           (0x8Cu)
+#define EMBER_MAX_MESSAGE_LIMIT_REACHED (0x72u)
+#define EMBER_TABLE_FULL                (0xB4u)
+
+#define EMBER_NULL_NODE_ID              (0xFFFFu)
+#define EMBER_BROADCAST_ADDRESS         (0xFFFCu)
+#define EUI64_SIZE                      (8u)
+
+/// Event control, armed at timeToExecute while status is EMBER_EVENT_MS_TIME
+typedef enum {
+  EMBER_EVENT_INACTIVE = 0,
+  EMBER_EVENT_MS_TIME,
+  EMBER_EVENT_ZERO_DELAY
+} EmberEventUnits;
+
+typedef struct {
+  EmberEventUnits status;
+  uint32_t timeToExecute;
+} EmberEventControl;
+
+#define emberEventControlSetActive(control)          emEventControlSetActive(&(control))
+#define emberEventControlSetInactive(control)        emEventControlSetInactive(&(control))
+#define emberEventControlSetDelayMS(control, delay)  emEventControlSetDelayMS(&(control), (delay))
+#define emberEventControlGetActive(control)          ((control).status != EMBER_EVENT_INACTIVE)
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+void emEventControlSetActive(EmberEventControl *control);
+void emEventControlSetInactive(EmberEventControl *control);
+void emEventControlSetDelayMS(EmberEventControl *control, uint32_t delay);
+
+bool emberStackIsUp(void);
+EmberNodeId emberGetNodeId(void);
+uint16_t emberGetRadioChannel(void);
+
+uint16_t emberFetchLowHighInt16u(const uint8_t *contents);
+uint32_t emberFetchLowHighInt32u(const uint8_t *contents);
+void emberStoreLowHighInt16u(uint8_t *contents, uint16_t value);
+void emberStoreLowHighInt32u(uint8_t *contents, uint32_t value);
+
+#endif  // EMBER_H
@@ -0,0 +1,315 @@
+/***************************************************************************//**
+ * @file trace2chrome.c
+ * @brief trace2chrome.c
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+// Converts the event trace dumped by the trace_dump CLI command of the sink
+// and the sensor into Chrome trace JSON, which both chrome://tracing and
+// ui.perfetto.dev open.
+//
+// Build: gcc -O2 -Wall -o trace2chrome trace2chrome.c
+// Usage: trace2chrome <log> [<log> ...] > trace.json
+//
+// Every log is a captured CLI session, lines without the "trace:" prefix are
+// ignored. Each log becomes a process, with its own timeline starting at its
+// first event, since the nodes do not share a clock.
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <ctype.h>
+#include <stdarg.h>
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Layout of the dump, see app_trace.h
+#define DUMP_VERSION            (1u)
+#define HEADER_LENGTH           (14u)
+#define LINE_PREFIX             "trace:"
+
+/// Event types, see app_trace_type_t
+enum {
+  TRACE_RX        = 0,
+  TRACE_TX        = 1,
+  TRACE_TX_DONE   = 2,
+  TRACE_EVENT     = 3,
+  TRACE_SLEEP     = 4,
+  TRACE_WAKE      = 5,
+  TRACE_I2C_START = 6,
+  TRACE_I2C_STOP  = 7
+};
+
+/// Threads of every process in the trace viewer
+enum {
+  THREAD_RADIO = 1,
+  THREAD_APP   = 2,
+  THREAD_POWER = 3,
+  THREAD_I2C   = 4
+};
+
+/// Growable byte buffer
+typedef struct {
+  uint8_t *data;
+  size_t length;
+  size_t size;
+} buffer_t;
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+static bool read_log(const char *path, buffer_t *buffer);
+static int convert(const buffer_t *buffer, unsigned pid, const char *path);
+static void emit(const char *format, ...);
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+/// Names of app_trace_event_id_t
+static const char *event_names[] = {
+  "report", "poll", "advertise", "data_report", "tx_queue"
+};
+/// Whether a JSON event was already written, for the separators
+static bool first_event = true;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  int i;
+  int events = 0;
+
+  if (argc < 2) {
+    fprintf(stderr, "usage: %s <log> [<log> ...] > trace.json\n", argv[0]);
+    return 2;
+  }
+
+  printf("{\"displayTimeUnit\":\"ms\",\"traceEvents\":[");
+  for (i = 1; i < argc; i++) {
+    buffer_t buffer = { NULL, 0, 0 };
+    int converted;
+
+    if (!read_log(argv[i], &buffer)) {
+      return 1;
+    }
+    converted = convert(&buffer, (unsigned)i, argv[i]);
+    free(buffer.data);
+    if (converted < 0) {
+      return 1;
+    }
+    events += converted;
+  }
+  printf("\n]}\n");
+  fprintf(stderr, "%d event(s) converted\n", events);
+  return 0;
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Collects the hex bytes of every "trace:" line of a log.
+ *****************************************************************************/
+static bool read_log(const char *path, buffer_t *buffer)
+{
+  FILE *file = fopen(path, "r");
+  char line[1024];
+
+  if (file == NULL) {
+    perror(path);
+    return false;
+  }
+  while (fgets(line, sizeof(line), file) != NULL) {
+    const char *p = strstr(line, LINE_PREFIX);
+    if (p == NULL) {
+      continue;
+    }
+    for (p += strlen(LINE_PREFIX); isxdigit((unsigned char)p[0])
+         && isxdigit((unsigned char)p[1]); p += 2) {
+      char hex[3] = { p[0], p[1], '\0' };
+      if (buffer->length == buffer->size) {
+        buffer->size = (buffer->size == 0) ? 4096 : 2 * buffer->size;
+        buffer->data = realloc(buffer->data, buffer->size);
+        if (buffer->data == NULL) {
+          perror("realloc");
+          fclose(file);
+          return false;
+        }
+      }
+      buffer->data[buffer->length++] = (uint8_t)strtoul(hex, NULL, 16);
+    }
+  }
+  fclose(file);
+  return true;
+}
+
+/**************************************************************************//**
+ * Converts every dump found in the bytes of a log into trace events of one
+ * process. Returns the number of events or -1 on a malformed dump.
+ *****************************************************************************/
+static int convert(const buffer_t *buffer, unsigned pid, const char *path)
+{
+  const uint8_t *data = buffer->data;
+  size_t pos = 0;
+  bool named = false;
+  bool have_origin = false;
+  uint32_t last_tick = 0;
+  uint64_t origin = 0;
+  uint64_t wraps = 0;
+  int events = 0;
+
+  while (pos + HEADER_LENGTH <= buffer->length) {
+    unsigned node_id;
+    uint32_t frequency;
+    unsigned entry_length;
+    unsigned count;
+    unsigned lost;
+    unsigned i;
+
+    if (data[pos] != 'T' || data[pos + 1] != 'R'
+        || data[pos + 2] != DUMP_VERSION || data[pos + 3] < 8) {
+      fprintf(stderr, "%s: no trace header at byte %zu\n", path, pos);
+      return -1;
+    }
+    entry_length = data[pos + 3];
+    node_id = data[pos + 4] | (data[pos + 5] << 8);
+    frequency = data[pos + 6] | (data[pos + 7] << 8)
+                | ((uint32_t)data[pos + 8] << 16) | ((uint32_t)data[pos + 9] << 24);
+    count = data[pos + 10] | (data[pos + 11] << 8);
+    lost = data[pos + 12] | (data[pos + 13] << 8);
+    pos += HEADER_LENGTH;
+    if (frequency == 0 || pos + (size_t)count * entry_length > buffer->length) {
+      fprintf(stderr, "%s: truncated dump of node 0x%04X\n", path, node_id);
+      return -1;
+    }
+    if (lost > 0) {
+      fprintf(stderr, "%s: %u event(s) of node 0x%04X were overwritten\n",
+              path, lost, node_id);
+    }
+
+    if (!named) {
+      emit("{\"ph\":\"M\",\"pid\":%u,\"name\":\"process_name\","
+           "\"args\":{\"name\":\"%s (node 0x%04X)\"}}", pid, path, node_id);
+      emit("{\"ph\":\"M\",\"pid\":%u,\"tid\":%d,\"name\":\"thread_name\","
+           "\"args\":{\"name\":\"radio\"}}", pid, THREAD_RADIO);
+      emit("{\"ph\":\"M\",\"pid\":%u,\"tid\":%d,\"name\":\"thread_name\","
+           "\"args\":{\"name\":\"events\"}}", pid, THREAD_APP);
+      emit("{\"ph\":\"M\",\"pid\":%u,\"tid\":%d,\"name\":\"thread_name\","
+           "\"args\":{\"name\":\"sleep\"}}", pid, THREAD_POWER);
+      emit("{\"ph\":\"M\",\"pid\":%u,\"tid\":%d,\"name\":\"thread_name\","
+           "\"args\":{\"name\":\"i2c\"}}", pid, THREAD_I2C);
+      named = true;
+    }
+
+    for (i = 0; i < count; i++, pos += entry_length) {
+      uint32_t tick = data[pos] | (data[pos + 1] << 8)
+                      | ((uint32_t)data[pos + 2] << 16)
+                      | ((uint32_t)data[pos + 3] << 24);
+      unsigned type = data[pos + 4];
+      unsigned arg8 = data[pos + 5];
+      unsigned arg16 = data[pos + 6] | (data[pos + 7] << 8);
+      uint64_t ticks;
+      double ts;
+
+      // The tick counter wraps, events are in chronological order.
+      if (have_origin && tick < last_tick) {
+        wraps += 1ull << 32;
+      }
+      last_tick = tick;
+      ticks = wraps + tick;
+      if (!have_origin) {
+        origin = ticks;
+        have_origin = true;
+      }
+      ts = (double)(ticks - origin) * 1e6 / frequency;
+
+      switch (type) {
+        case TRACE_RX:
+          emit("{\"ph\":\"i\",\"s\":\"t\",\"pid\":%u,\"tid\":%d,\"ts\":%.1f,"
+               "\"name\":\"RX 0x%02X\",\"args\":{\"source\":\"0x%04X\"}}",
+               pid, THREAD_RADIO, ts, arg8, arg16);
+          break;
+        case TRACE_TX:
+          emit("{\"ph\":\"b\",\"cat\":\"tx\",\"id\":\"0x%04X\",\"pid\":%u,"
+               "\"tid\":%d,\"ts\":%.1f,\"name\":\"TX to 0x%04X\","
+               "\"args\":{\"command\":\"0x%02X\"}}",
+               arg16, pid, THREAD_RADIO, ts, arg16, arg8);
+          break;
+        case TRACE_TX_DONE:
+          emit("{\"ph\":\"e\",\"cat\":\"tx\",\"id\":\"0x%04X\",\"pid\":%u,"
+               "\"tid\":%d,\"ts\":%.1f,\"name\":\"TX to 0x%04X\","
+               "\"args\":{\"status\":\"0x%02X\"}}",
+               arg16, pid, THREAD_RADIO, ts, arg16, arg8);
+          break;
+        case TRACE_EVENT:
+          if (arg8 < sizeof(event_names) / sizeof(event_names[0])) {
+            emit("{\"ph\":\"i\",\"s\":\"t\",\"pid\":%u,\"tid\":%d,\"ts\":%.1f,"
+                 "\"name\":\"%s\"}", pid, THREAD_APP, ts, event_names[arg8]);
+          } else {
+            emit("{\"ph\":\"i\",\"s\":\"t\",\"pid\":%u,\"tid\":%d,\"ts\":%.1f,"
+                 "\"name\":\"event %u\"}", pid, THREAD_APP, ts, arg8);
+          }
+          break;
+        case TRACE_SLEEP:
+          emit("{\"ph\":\"B\",\"pid\":%u,\"tid\":%d,\"ts\":%.1f,"
+               "\"name\":\"EM%u\"}", pid, THREAD_POWER, ts, arg8);
+          break;
+        case TRACE_WAKE:
+          emit("{\"ph\":\"E\",\"pid\":%u,\"tid\":%d,\"ts\":%.1f}",
+               pid, THREAD_POWER, ts);
+          break;
+        case TRACE_I2C_START:
+          emit("{\"ph\":\"B\",\"pid\":%u,\"tid\":%d,\"ts\":%.1f,"
+               "\"name\":\"I2C\"}", pid, THREAD_I2C, ts);
+          break;
+        case TRACE_I2C_STOP:
+          emit("{\"ph\":\"E\",\"pid\":%u,\"tid\":%d,\"ts\":%.1f,"
+               "\"args\":{\"ok\":%u}}", pid, THREAD_I2C, ts, arg8);
+          break;
+        default:
+          fprintf(stderr, "%s: unknown event type %u skipped\n", path, type);
+          continue;
+      }
+      events++;
+    }
+  }
+  if (pos != buffer->length) {
+    fprintf(stderr, "%s: %zu trailing byte(s) ignored\n",
+            path, buffer->length - pos);
+  }
+  return events;
+}
+
+/**************************************************************************//**
+ * Writes a JSON event with its separator.
+ *****************************************************************************/
+static void emit(const char *format, ...)
+{
+  va_list args;
+
+  printf(first_event ? "\n" : ",\n");
+  first_event = false;
+  va_start(args, format);
+  vprintf(format, args);
+  va_end(args);
+}
@@ -0,0 +1,385 @@
+/***************************************************************************//**
+ * @file ts_bench.c
+ * @brief ts_bench.c
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+// Benchmark of ts_store and its rollups: ingest rate, compression, scan
+// throughput and query cost per resolution for a fleet of sensors reporting
+// at the period of the sensor application (1 s). Samples are generated like
+// the sink reports them: host time stamps with jitter, temperature and
+// humidity drifting at the resolution of the Si7021. Every scanned sample is
+// checked against the generator, and the points of every resolution against
+// the count, minimum and maximum of the raw samples.
+//
+// Build: gcc -O2 -Wall -o ts_bench ts_bench.c ts_store.c ts_rollup.c
+// Usage: ts_bench [-n <sensors>] [-d <days>] [-p <period ms>] [-l]
+//                 [-o <store file>]
+//
+// -l also generates an illuminance curve, otherwise the lux column is 0 as
+// the sensors do not report it yet. The figures of a 1 year run are
+// extrapolated from the days run, -d 365 runs it in full.
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <stdbool.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include "ts_store.h"
+#include "ts_rollup.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define START_TIME_MS           (1767225600000ll)  // 2026-01-01
+#define JITTER_MS               (20u)
+#define EUI64_BASE              (0x000B57FFFE000000ull)
+/// Size of a sample as stored by sink_ingestd in its record log
+#define RECORD_LOG_SIZE         (32u)
+/// Sensors queried per resolution
+#define QUERY_SENSORS           (10u)
+
+/// Generator of the samples of one sensor
+typedef struct {
+  uint64_t rng;
+  uint64_t step;
+  ts_sample_t sample;
+} generator_t;
+
+typedef struct {
+  generator_t generator;
+  uint64_t checked;
+  uint64_t errors;
+  int32_t min[TS_SENSOR_VALUES];
+  int32_t max[TS_SENSOR_VALUES];
+} check_t;
+
+typedef struct {
+  uint64_t count;
+  uint64_t points;
+  int32_t min[TS_SENSOR_VALUES];
+  int32_t max[TS_SENSOR_VALUES];
+} summary_t;
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+static double now_s(void);
+static uint64_t blocks_read(const ts_rollup_t *rollup);
+static uint32_t next_random(uint64_t *rng);
+static void generator_init(generator_t *g, unsigned sensor);
+static void generator_next(generator_t *g, unsigned sensor, uint32_t period_ms, bool lux);
+static bool on_sample(uint64_t eui64, const ts_sample_t *sample, void *context);
+static bool on_point(uint64_t eui64, const ts_point_t *point, void *context);
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static uint32_t period_ms = 1000;
+static bool with_lux = false;
+static const struct {
+  const char *name;
+  uint32_t step_ms;
+} queries[] = {
+  { "raw", 1000u },
+  { "1 min", 60000u },
+  { "1 h", 3600000u },
+  { "1 day", 86400000u },
+};
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+int main(int argc, char **argv)
+{
+  const char *path = "ts_bench.tss";
+  unsigned sensors = 1000;
+  double days = 1.0;
+  generator_t *generators;
+  check_t *checks;
+  ts_rollup_t *rollup;
+  ts_rollup_stats_t stats;
+  uint64_t steps;
+  uint64_t step;
+  uint64_t scanned = 0;
+  uint64_t errors = 0;
+  uint64_t year_samples;
+  uint64_t tier_bytes = 0;
+  double started;
+  double ingest_s;
+  double scan_s;
+  double bytes_per_sample;
+  unsigned s;
+  unsigned q;
+  unsigned r;
+  int option;
+
+  while ((option = getopt(argc, argv, "n:d:p:lo:")) != -1) {
+    switch (option) {
+      case 'n': sensors = (unsigned)strtoul(optarg, NULL, 0); break;
+      case 'd': days = strtod(optarg, NULL); break;
+      case 'p': period_ms = (uint32_t)strtoul(optarg, NULL, 0); break;
+      case 'l': with_lux = true; break;
+      case 'o': path = optarg; break;
+      default:
+        fprintf(stderr, "usage: %s [-n <sensors>] [-d <days>] [-p <period ms>] [-l] "
+                "[-o <store file>]\n", argv[0]);
+        return 2;
+    }
+  }
+  if (sensors == 0 || days <= 0.0 || period_ms <= 2 * JITTER_MS) {
+    fprintf(stderr, "%s: bad arguments\n", argv[0]);
+    return 2;
+  }
+  steps = (uint64_t)(days * 86400000.0 / period_ms);
+
+  // Ingest: the sensors report in turn, as the sink sees them. The rollups
+  // run between the rounds, like in the idle time of sink_ingestd.
+  for (r = 0; r < TS_RESOLUTION_COUNT; r++) {
+    char tier_path[1024];
+    static const char *const suffix[] = { "", ".1m", ".1h", ".1d" };
+    snprintf(tier_path, sizeof(tier_path), "%s%s", path, suffix[r]);
+    unlink(tier_path);
+  }
+  rollup = ts_rollup_open(path, true, TS_SENSOR_VALUES);
+  generators = calloc(sensors, sizeof(generator_t));
+  checks = calloc(sensors, sizeof(check_t));
+  if (rollup == NULL || generators == NULL || checks == NULL) {
+    perror(path);
+    return 1;
+  }
+  for (s = 0; s < sensors; s++) {
+    generator_init(&generators[s], s);
+  }
+  started = now_s();
+  for (step = 0; step < steps; step++) {
+    for (s = 0; s < sensors; s++) {
+      generator_next(&generators[s], s, period_ms, with_lux);
+      if (ts_rollup_append(rollup, EUI64_BASE + s, &generators[s].sample) != 0) {
+        perror("ts_rollup_append");
+        return 1;
+      }
+    }
+    ts_rollup_process(rollup, SIZE_MAX);
+  }
+  ts_rollup_close(rollup);
+  ingest_s = now_s() - started;
+
+  // Full scan of every raw series, through a fresh map of the file
+  rollup = ts_rollup_open(path, false, 0);
+  if (rollup == NULL) {
+    perror(path);
+    return 1;
+  }
+  ts_rollup_get_stats(rollup, &stats);
+  started = now_s();
+  for (s = 0; s < sensors; s++) {
+    check_t *check = &checks[s];
+    unsigned v;
+    generator_init(&check->generator, s);
+    for (v = 0; v < TS_SENSOR_VALUES; v++) {
+      check->min[v] = INT32_MAX;
+      check->max[v] = INT32_MIN;
+    }
+    scanned += ts_store_scan(ts_rollup_raw(rollup), EUI64_BASE + s,
+                             INT64_MIN, INT64_MAX, on_sample, check);
+    errors += check->errors;
+  }
+  scan_s = now_s() - started;
+
+  bytes_per_sample = (double)stats.store[TS_RESOLUTION_RAW].file_bytes
+                     / (double)stats.store[TS_RESOLUTION_RAW].samples;
+  year_samples = (uint64_t)sensors * (365ull * 86400000ull / period_ms);
+  printf("sensors=%u days=%.2f period_ms=%u samples=%llu blocks=%llu\n",
+         sensors, days, period_ms,
+         (unsigned long long)stats.store[TS_RESOLUTION_RAW].samples,
+         (unsigned long long)stats.store[TS_RESOLUTION_RAW].blocks);
+  printf("ingest with rollups: %.2f s, %.0f samples/s\n", ingest_s,
+         (double)stats.store[TS_RESOLUTION_RAW].samples / ingest_s);
+  printf("raw: %llu bytes, %.2f bytes/sample, %.1fx vs raw samples (%u bytes), "
+         "%.1fx vs record log (%u bytes)\n",
+         (unsigned long long)stats.store[TS_RESOLUTION_RAW].file_bytes, bytes_per_sample,
+         (double)(8u + 4u * TS_SENSOR_VALUES) / bytes_per_sample,
+         8u + 4u * TS_SENSOR_VALUES,
+         RECORD_LOG_SIZE / bytes_per_sample, RECORD_LOG_SIZE);
+  for (r = TS_RESOLUTION_MINUTE; r < TS_RESOLUTION_COUNT; r++) {
+    printf("tier %s: %llu rows, %llu bytes\n", queries[r].name,
+           (unsigned long long)stats.store[r].samples,
+           (unsigned long long)stats.store[r].file_bytes);
+    tier_bytes += stats.store[r].file_bytes;
+  }
+  printf("scan: %.2f s, %.0f samples/s, %.0f MB/s of store, %llu errors\n",
+         scan_s, (double)scanned / scan_s,
+         (double)stats.store[TS_RESOLUTION_RAW].file_bytes / scan_s / 1e6,
+         (unsigned long long)errors);
+
+  // Whole history of a few sensors at every resolution
+  for (q = 0; q < sizeof(queries) / sizeof(queries[0]); q++) {
+    uint64_t points = 0;
+    uint64_t read_before = blocks_read(rollup);
+    double query_s;
+
+    started = now_s();
+    for (s = 0; s < QUERY_SENSORS && s < sensors; s++) {
+      summary_t summary;
+      unsigned v;
+      memset(&summary, 0, sizeof(summary));
+      for (v = 0; v < TS_SENSOR_VALUES; v++) {
+        summary.min[v] = INT32_MAX;
+        summary.max[v] = INT32_MIN;
+      }
+      ts_rollup_query(rollup, EUI64_BASE + s, INT64_MIN, INT64_MAX,
+                      queries[q].step_ms, on_point, &summary);
+      points += summary.points;
+      if (summary.count != checks[s].checked
+          || memcmp(summary.min, checks[s].min, sizeof(summary.min)) != 0
+          || memcmp(summary.max, checks[s].max, sizeof(summary.max)) != 0) {
+        errors++;
+      }
+    }
+    query_s = now_s() - started;
+    printf("query %.2f days at %s: %.0f points, %.1f KB read, %.3f ms per sensor\n",
+           days, queries[q].name, (double)points / s,
+           (double)(blocks_read(rollup) - read_before) * TS_BLOCK_SIZE / 1024.0 / s,
+           query_s * 1e3 / s);
+  }
+  ts_rollup_close(rollup);
+
+  printf("1 year: %llu samples, %.1f GB raw + %.2f GB rollups, ingest %.1f h, "
+         "full scan %.1f h\n",
+         (unsigned long long)year_samples,
+         (double)year_samples * bytes_per_sample / 1e9,
+         (double)tier_bytes * 365.0 / days / 1e9,
+         (double)year_samples / ((double)stats.store[TS_RESOLUTION_RAW].samples / ingest_s) / 3600.0,
+         (double)year_samples / ((double)scanned / scan_s) / 3600.0);
+  printf("%llu errors\n", (unsigned long long)errors);
+  return (scanned == stats.store[TS_RESOLUTION_RAW].samples && errors == 0) ? 0 : 1;
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+static double now_s(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+static uint64_t blocks_read(const ts_rollup_t *rollup)
+{
+  ts_rollup_stats_t stats;
+  uint64_t blocks = 0;
+  unsigned r;
+
+  ts_rollup_get_stats(rollup, &stats);
+  for (r = 0; r < TS_RESOLUTION_COUNT; r++) {
+    blocks += stats.store[r].blocks_read;
+  }
+  return blocks;
+}
+
+static uint32_t next_random(uint64_t *rng)
+{
+  // xorshift64*
+  *rng ^= *rng >> 12;
+  *rng ^= *rng << 25;
+  *rng ^= *rng >> 27;
+  return (uint32_t)((*rng * 0x2545F4914F6CDD1Dull) >> 32);
+}
+
+static void generator_init(generator_t *g, unsigned sensor)
+{
+  g->rng = 0x9E3779B97F4A7C15ull * (sensor + 1u);
+  g->step = 0;
+  g->sample.value[TS_VALUE_TEMPERATURE] = 20000 + (int32_t)(next_random(&g->rng) % 4000u);
+  g->sample.value[TS_VALUE_HUMIDITY] = 40000 + (int32_t)(next_random(&g->rng) % 20000u);
+  g->sample.value[TS_VALUE_LUX] = 0;
+}
+
+static void generator_next(generator_t *g, unsigned sensor, uint32_t period, bool lux)
+{
+  uint32_t r = next_random(&g->rng);
+  int64_t slot_ms = START_TIME_MS + (int64_t)(g->step * period);
+
+  // The sensors are spread over the period, the host time stamps jitter.
+  g->sample.time_ms = slot_ms + (int64_t)((sensor * 7u) % (period - 2 * JITTER_MS))
+                      + JITTER_MS + (int64_t)(r % (2 * JITTER_MS + 1)) - JITTER_MS;
+  // Si7021: about 10 m°C and 25 thousandths of %RH per step
+  if ((r >> 8) % 4u == 0) {
+    g->sample.value[TS_VALUE_TEMPERATURE] += (int32_t)((r >> 12) % 3u) * 10 - 10;
+  }
+  if ((r >> 16) % 4u == 0) {
+    g->sample.value[TS_VALUE_HUMIDITY] += (int32_t)((r >> 20) % 3u) * 25 - 25;
+  }
+  if (lux) {
+    // Daylight: a half sine from 6:00 to 18:00, up to 500 lx indoors
+    int64_t ms_of_day = (slot_ms / 1000 % 86400) * 1000;
+    g->sample.value[TS_VALUE_LUX] = 0;
+    if (ms_of_day > 21600000 && ms_of_day < 64800000) {
+      double x = (double)(ms_of_day - 21600000) / 43200000.0;
+      g->sample.value[TS_VALUE_LUX] = (int32_t)(500.0 * 4.0 * x * (1.0 - x)) + (int32_t)((r >> 24) % 5u);
+    }
+  }
+  g->step++;
+}
+
+static bool on_sample(uint64_t eui64, const ts_sample_t *sample, void *context)
+{
+  check_t *check = context;
+  unsigned sensor = (unsigned)(eui64 - EUI64_BASE);
+
+  unsigned v;
+
+  generator_next(&check->generator, sensor, period_ms, with_lux);
+  if (memcmp(sample, &check->generator.sample, sizeof(ts_sample_t)) != 0) {
+    check->errors++;
+  }
+  for (v = 0; v < TS_SENSOR_VALUES; v++) {
+    if (sample->value[v] < check->min[v]) {
+      check->min[v] = sample->value[v];
+    }
+    if (sample->value[v] > check->max[v]) {
+      check->max[v] = sample->value[v];
+    }
+  }
+  check->checked++;
+  return true;
+}
+
+static bool on_point(uint64_t eui64, const ts_point_t *point, void *context)
+{
+  summary_t *summary = context;
+  unsigned v;
+
+  (void) eui64;
+  summary->count += point->count;
+  summary->points++;
+  for (v = 0; v < TS_SENSOR_VALUES; v++) {
+    if (point->min[v] < summary->min[v]) {
+      summary->min[v] = point->min[v];
+    }
+    if (point->max[v] > summary->max[v]) {
+      summary->max[v] = point->max[v];
+    }
+  }
+  return true;
+}
@@ -0,0 +1,576 @@
+/***************************************************************************//**
+ * @file ts_rollup.c
+ * @brief ts_rollup.c
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+// Rollups of the sensor history: minimum, maximum and mean of the raw samples
+// per minute, hour and day, each tier a ts_store of its own. Raw blocks are
+// rolled up once written, and every closed bucket feeds the next tier, so a
+// sample is read once whatever the number of tiers.
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include "ts_rollup.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define TIER_COUNT              (TS_RESOLUTION_COUNT - 1u)
+#define INITIAL_SERIES          (1024u)
+
+/// Bucket of a tier being filled
+typedef struct {
+  int64_t start_ms;
+  uint32_t count;
+  bool active;
+  int32_t min[TS_ROLLUP_MAX_VALUES];
+  int32_t max[TS_ROLLUP_MAX_VALUES];
+  int64_t sum[TS_ROLLUP_MAX_VALUES];
+} bucket_t;
+
+typedef struct {
+  uint64_t eui64;
+  bool used;
+  /// Raw samples before this time are already rolled up
+  int64_t watermark_ms;
+  bucket_t bucket[TIER_COUNT];
+} series_state_t;
+
+struct ts_rollup {
+  ts_store_t *store[TS_RESOLUTION_COUNT];
+  bool writable;
+  unsigned values;
+  /// Open addressing on the EUI64, never more than half full
+  series_state_t *series;
+  size_t series_capacity;
+  size_t series_count;
+  /// Raw blocks written and not rolled up yet, oldest first
+  uint32_t *pending;
+  size_t pending_head;
+  size_t pending_length;
+  size_t pending_capacity;
+  uint64_t processed;
+};
+
+/// Context of the scans
+typedef struct {
+  ts_rollup_t *rollup;
+  series_state_t *state;
+  ts_resolution_t resolution;
+  ts_point_cb_t callback;
+  void *context;
+  int64_t next_ms;
+  uint64_t points;
+} scan_t;
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+static int64_t floor_to(int64_t time_ms, uint32_t resolution);
+static series_state_t *find_state(ts_rollup_t *rollup, uint64_t eui64);
+static void add_to_bucket(ts_rollup_t *rollup,
+                          series_state_t *state,
+                          ts_resolution_t resolution,
+                          int64_t time_ms,
+                          uint32_t count,
+                          const int32_t *min,
+                          const int32_t *max,
+                          const int64_t *sum);
+static void close_bucket(ts_rollup_t *rollup,
+                         series_state_t *state,
+                         ts_resolution_t resolution);
+static bool on_raw_sample(uint64_t eui64, const ts_sample_t *sample, void *context);
+static bool on_row(uint64_t eui64, const ts_sample_t *sample, void *context);
+static bool on_point(uint64_t eui64, const ts_sample_t *sample, void *context);
+static void on_seal(ts_store_t *store,
+                    uint32_t block,
+                    const ts_block_header_t *header,
+                    void *context);
+static int recover(ts_rollup_t *rollup);
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+static const uint32_t resolution_ms[TS_RESOLUTION_COUNT] = {
+  0, 60000u, 3600000u, 86400000u
+};
+static const char *const suffix[TS_RESOLUTION_COUNT] = {
+  "", ".1m", ".1h", ".1d"
+};
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+ts_rollup_t *ts_rollup_open(const char *path, bool writable, unsigned value_count)
+{
+  ts_rollup_t *rollup = calloc(1, sizeof(ts_rollup_t));
+  size_t length = strlen(path) + 4u;
+  char *tier_path = malloc(length);
+  int error = EINVAL;
+  unsigned r;
+
+  if (rollup == NULL || tier_path == NULL || value_count > TS_ROLLUP_MAX_VALUES) {
+    goto fail;
+  }
+  rollup->writable = writable;
+  rollup->series_capacity = INITIAL_SERIES;
+  rollup->series = calloc(rollup->series_capacity, sizeof(series_state_t));
+  rollup->store[TS_RESOLUTION_RAW] = ts_store_open(path, writable, value_count);
+  if (rollup->series == NULL || rollup->store[TS_RESOLUTION_RAW] == NULL) {
+    error = errno;
+    goto fail;
+  }
+  rollup->values = ts_store_value_count(rollup->store[TS_RESOLUTION_RAW]);
+  if (rollup->values > TS_ROLLUP_MAX_VALUES) {
+    goto fail;
+  }
+  for (r = TS_RESOLUTION_MINUTE; r < TS_RESOLUTION_COUNT; r++) {
+    snprintf(tier_path, length, "%s%s", path, suffix[r]);
+    rollup->store[r] = ts_store_open(tier_path, writable,
+                                     writable ? TS_ROLLUP_VALUES(rollup->values) : 0);
+    // Read only, a missing tier is served from the finer ones.
+    if (rollup->store[r] == NULL && writable) {
+      error = errno;
+      goto fail;
+    }
+  }
+  if (writable) {
+    ts_store_set_seal_callback(rollup->store[TS_RESOLUTION_RAW], on_seal, rollup);
+    if (recover(rollup) != 0) {
+      error = ENOMEM;
+      goto fail;
+    }
+  }
+  free(tier_path);
+  return rollup;
+
+  fail:
+  free(tier_path);
+  if (rollup != NULL) {
+    rollup->writable = false;
+    ts_rollup_close(rollup);
+  }
+  errno = error;
+  return NULL;
+}
+
+void ts_rollup_close(ts_rollup_t *rollup)
+{
+  unsigned r;
+
+  if (rollup == NULL) {
+    return;
+  }
+  if (rollup->writable) {
+    ts_store_flush(rollup->store[TS_RESOLUTION_RAW]);
+    ts_rollup_process(rollup, SIZE_MAX);
+  }
+  for (r = 0; r < TS_RESOLUTION_COUNT; r++) {
+    ts_store_close(rollup->store[r]);
+  }
+  free(rollup->series);
+  free(rollup->pending);
+  free(rollup);
+}
+
+int ts_rollup_append(ts_rollup_t *rollup,
+                     uint64_t eui64,
+                     const ts_sample_t *sample)
+{
+  return ts_store_append(rollup->store[TS_RESOLUTION_RAW], eui64, sample);
+}
+
+size_t ts_rollup_process(ts_rollup_t *rollup, size_t max_blocks)
+{
+  scan_t scan = { .rollup = rollup };
+
+  while (rollup->pending_head < rollup->pending_length && max_blocks > 0) {
+    ts_store_scan_block(rollup->store[TS_RESOLUTION_RAW],
+                        rollup->pending[rollup->pending_head++],
+                        INT64_MIN, INT64_MAX, on_raw_sample, &scan);
+    rollup->processed++;
+    max_blocks--;
+  }
+  if (rollup->pending_head == rollup->pending_length) {
+    rollup->pending_head = 0;
+    rollup->pending_length = 0;
+  }
+  return rollup->pending_length - rollup->pending_head;
+}
+
+ts_resolution_t ts_rollup_resolution(uint32_t step_ms)
+{
+  ts_resolution_t r = TS_RESOLUTION_DAY;
+
+  while (r > TS_RESOLUTION_RAW && resolution_ms[r] > step_ms) {
+    r--;
+  }
+  return r;
+}
+
+uint64_t ts_rollup_query(ts_rollup_t *rollup,
+                         uint64_t eui64,
+                         int64_t from_ms,
+                         int64_t to_ms,
+                         uint32_t step_ms,
+                         ts_point_cb_t callback,
+                         void *context)
+{
+  scan_t scan = {
+    .rollup = rollup,
+    .callback = callback,
+    .context = context,
+    .next_ms = from_ms,
+  };
+  int r;
+
+  // Complete buckets from the coarsest tier, the rest from the finer ones
+  for (r = ts_rollup_resolution(step_ms); r >= (int)TS_RESOLUTION_RAW; r--) {
+    int64_t from = (r == TS_RESOLUTION_RAW) ? scan.next_ms
+                   : floor_to(scan.next_ms, resolution_ms[r]);
+    if (rollup->store[r] == NULL) {
+      continue;
+    }
+    scan.resolution = (ts_resolution_t)r;
+    scan.callback = callback;
+    ts_store_scan(rollup->store[r], eui64, from, to_ms, on_point, &scan);
+    if (scan.callback == NULL || scan.next_ms > to_ms) {
+      break;
+    }
+  }
+  return scan.points;
+}
+
+ts_store_t *ts_rollup_raw(ts_rollup_t *rollup)
+{
+  return rollup->store[TS_RESOLUTION_RAW];
+}
+
+void ts_rollup_get_stats(const ts_rollup_t *rollup, ts_rollup_stats_t *stats)
+{
+  unsigned r;
+
+  memset(stats, 0, sizeof(ts_rollup_stats_t));
+  for (r = 0; r < TS_RESOLUTION_COUNT; r++) {
+    if (rollup->store[r] != NULL) {
+      ts_store_get_stats(rollup->store[r], &stats->store[r]);
+    }
+  }
+  stats->pending_blocks = rollup->pending_length - rollup->pending_head;
+  stats->processed_blocks = rollup->processed;
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+static int64_t floor_to(int64_t time_ms, uint32_t resolution)
+{
+  int64_t q;
+
+  if (time_ms == INT64_MIN) {
+    return time_ms;
+  }
+  q = time_ms / resolution;
+  if (time_ms % resolution < 0) {
+    q--;
+  }
+  return q * resolution;
+}
+
+static series_state_t *find_state(ts_rollup_t *rollup, uint64_t eui64)
+{
+  size_t mask = rollup->series_capacity - 1;
+  size_t slot = (size_t)((eui64 * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+  series_state_t *state;
+
+  while (rollup->series[slot].used) {
+    if (rollup->series[slot].eui64 == eui64) {
+      return &rollup->series[slot];
+    }
+    slot = (slot + 1) & mask;
+  }
+  if ((rollup->series_count + 1) * 2 > rollup->series_capacity) {
+    // Grow and rehash
+    series_state_t *old = rollup->series;
+    size_t old_capacity = rollup->series_capacity;
+    size_t i;
+
+    rollup->series = calloc(old_capacity * 2, sizeof(series_state_t));
+    if (rollup->series == NULL) {
+      rollup->series = old;
+      return NULL;
+    }
+    rollup->series_capacity = old_capacity * 2;
+    mask = rollup->series_capacity - 1;
+    for (i = 0; i < old_capacity; i++) {
+      if (old[i].used) {
+        size_t s = (size_t)((old[i].eui64 * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+        while (rollup->series[s].used) {
+          s = (s + 1) & mask;
+        }
+        rollup->series[s] = old[i];
+      }
+    }
+    free(old);
+    slot = (size_t)((eui64 * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+    while (rollup->series[slot].used) {
+      slot = (slot + 1) & mask;
+    }
+  }
+  state = &rollup->series[slot];
+  state->used = true;
+  state->eui64 = eui64;
+  state->watermark_ms = INT64_MIN;
+  rollup->series_count++;
+  return state;
+}
+
+static void add_to_bucket(ts_rollup_t *rollup,
+                          series_state_t *state,
+                          ts_resolution_t resolution,
+                          int64_t time_ms,
+                          uint32_t count,
+                          const int32_t *min,
+                          const int32_t *max,
+                          const int64_t *sum)
+{
+  bucket_t *bucket = &state->bucket[resolution - 1];
+  int64_t start_ms = floor_to(time_ms, resolution_ms[resolution]);
+  unsigned v;
+
+  if (bucket->active && bucket->start_ms != start_ms) {
+    close_bucket(rollup, state, resolution);
+  }
+  if (!bucket->active) {
+    bucket->active = true;
+    bucket->start_ms = start_ms;
+    bucket->count = 0;
+    for (v = 0; v < rollup->values; v++) {
+      bucket->min[v] = min[v];
+      bucket->max[v] = max[v];
+      bucket->sum[v] = 0;
+    }
+  }
+  bucket->count += count;
+  for (v = 0; v < rollup->values; v++) {
+    if (min[v] < bucket->min[v]) {
+      bucket->min[v] = min[v];
+    }
+    if (max[v] > bucket->max[v]) {
+      bucket->max[v] = max[v];
+    }
+    bucket->sum[v] += sum[v];
+  }
+}
+
+static void close_bucket(ts_rollup_t *rollup,
+                         series_state_t *state,
+                         ts_resolution_t resolution)
+{
+  bucket_t *bucket = &state->bucket[resolution - 1];
+  ts_sample_t row;
+  unsigned v;
+
+  memset(&row, 0, sizeof(row));
+  row.time_ms = bucket->start_ms;
+  row.value[TS_ROLLUP_COUNT] = (int32_t)bucket->count;
+  for (v = 0; v < rollup->values; v++) {
+    int64_t sum = bucket->sum[v];
+    int64_t half = (int64_t)bucket->count / 2;
+    row.value[TS_ROLLUP_MIN(v)] = bucket->min[v];
+    row.value[TS_ROLLUP_MAX(v)] = bucket->max[v];
+    row.value[TS_ROLLUP_MEAN(v)] = (int32_t)((sum >= 0 ? sum + half : sum - half)
+                                             / (int64_t)bucket->count);
+  }
+  ts_store_append(rollup->store[resolution], state->eui64, &row);
+  bucket->active = false;
+  if (resolution < TS_RESOLUTION_DAY) {
+    // Exact sums go up, not the rounded means.
+    add_to_bucket(rollup, state, resolution + 1, bucket->start_ms, bucket->count,
+                  bucket->min, bucket->max, bucket->sum);
+  }
+}
+
+static bool on_raw_sample(uint64_t eui64, const ts_sample_t *sample, void *context)
+{
+  scan_t *scan = context;
+  series_state_t *state = scan->state;
+  int64_t sum[TS_ROLLUP_MAX_VALUES];
+  unsigned v;
+
+  if (state == NULL || state->eui64 != eui64) {
+    state = find_state(scan->rollup, eui64);
+    scan->state = state;
+    if (state == NULL) {
+      return true;
+    }
+  }
+  if (sample->time_ms < state->watermark_ms) {
+    return true;
+  }
+  for (v = 0; v < scan->rollup->values; v++) {
+    sum[v] = sample->value[v];
+  }
+  add_to_bucket(scan->rollup, state, TS_RESOLUTION_MINUTE, sample->time_ms, 1,
+                sample->value, sample->value, sum);
+  return true;
+}
+
+static bool on_row(uint64_t eui64, const ts_sample_t *sample, void *context)
+{
+  scan_t *scan = context;
+  int32_t min[TS_ROLLUP_MAX_VALUES];
+  int32_t max[TS_ROLLUP_MAX_VALUES];
+  int64_t sum[TS_ROLLUP_MAX_VALUES];
+  uint32_t count = (uint32_t)sample->value[TS_ROLLUP_COUNT];
+  unsigned v;
+
+  (void) eui64;
+  for (v = 0; v < scan->rollup->values; v++) {
+    min[v] = sample->value[TS_ROLLUP_MIN(v)];
+    max[v] = sample->value[TS_ROLLUP_MAX(v)];
+    sum[v] = (int64_t)sample->value[TS_ROLLUP_MEAN(v)] * count;
+  }
+  add_to_bucket(scan->rollup, scan->state, scan->resolution, sample->time_ms, count,
+                min, max, sum);
+  return true;
+}
+
+static bool on_point(uint64_t eui64, const ts_sample_t *sample, void *context)
+{
+  scan_t *scan = context;
+  ts_point_t point;
+  unsigned v;
+
+  // Already covered by a coarser tier
+  if (sample->time_ms < scan->next_ms && scan->resolution == TS_RESOLUTION_RAW) {
+    return true;
+  }
+  memset(&point, 0, sizeof(point));
+  point.start_ms = sample->time_ms;
+  point.duration_ms = resolution_ms[scan->resolution];
+  if (scan->resolution == TS_RESOLUTION_RAW) {
+    point.count = 1;
+    for (v = 0; v < scan->rollup->values; v++) {
+      point.min[v] = sample->value[v];
+      point.max[v] = sample->value[v];
+      point.mean[v] = sample->value[v];
+    }
+    scan->next_ms = sample->time_ms + 1;
+  } else {
+    point.count = (uint32_t)sample->value[TS_ROLLUP_COUNT];
+    for (v = 0; v < scan->rollup->values; v++) {
+      point.min[v] = sample->value[TS_ROLLUP_MIN(v)];
+      point.max[v] = sample->value[TS_ROLLUP_MAX(v)];
+      point.mean[v] = sample->value[TS_ROLLUP_MEAN(v)];
+    }
+    scan->next_ms = sample->time_ms + point.duration_ms;
+  }
+  scan->points++;
+  if (!scan->callback(eui64, &point, scan->context)) {
+    scan->callback = NULL;
+    return false;
+  }
+  return true;
+}
+
+static void on_seal(ts_store_t *store,
+                    uint32_t block,
+                    const ts_block_header_t *header,
+                    void *context)
+{
+  ts_rollup_t *rollup = context;
+
+  (void) store;
+  (void) header;
+  if (rollup->pending_length == rollup->pending_capacity) {
+    size_t capacity;
+    uint32_t *pending;
+
+    if (rollup->pending_head > 0) {
+      memmove(rollup->pending, rollup->pending + rollup->pending_head,
+              (rollup->pending_length - rollup->pending_head) * sizeof(uint32_t));
+      rollup->pending_length -= rollup->pending_head;
+      rollup->pending_head = 0;
+    }
+    capacity = rollup->pending_capacity ? rollup->pending_capacity * 2 : 256;
+    pending = realloc(rollup->pending, capacity * sizeof(uint32_t));
+    if (pending == NULL) {
+      // The rollups of the block are rebuilt at the next open.
+      return;
+    }
+    rollup->pending = pending;
+    rollup->pending_capacity = capacity;
+  }
+  rollup->pending[rollup->pending_length++] = block;
+}
+
+static int recover(ts_rollup_t *rollup)
+{
+  ts_store_t *raw = rollup->store[TS_RESOLUTION_RAW];
+  size_t count = ts_store_series(raw, NULL, 0);
+  uint64_t *eui64 = malloc((count + 1) * sizeof(uint64_t));
+  size_t i;
+
+  if (eui64 == NULL) {
+    return -1;
+  }
+  ts_store_series(raw, eui64, count);
+  for (i = 0; i < count; i++) {
+    scan_t scan = { .rollup = rollup };
+    int64_t last_ms[TS_RESOLUTION_COUNT];
+    bool has_last[TS_RESOLUTION_COUNT];
+    unsigned r;
+
+    scan.state = find_state(rollup, eui64[i]);
+    if (scan.state == NULL) {
+      free(eui64);
+      return -1;
+    }
+    for (r = TS_RESOLUTION_MINUTE; r < TS_RESOLUTION_COUNT; r++) {
+      has_last[r] = ts_store_last_time(rollup->store[r], eui64[i], &last_ms[r]);
+    }
+    // Refill the open bucket of every tier from the rows of the tier below
+    // it, written after the last row of the tier.
+    for (r = TS_RESOLUTION_HOUR; r < TS_RESOLUTION_COUNT; r++) {
+      int64_t start_ms;
+      if (!has_last[r - 1]) {
+        continue;
+      }
+      start_ms = floor_to(last_ms[r - 1], resolution_ms[r]);
+      if (!has_last[r] || last_ms[r] < start_ms) {
+        scan.resolution = (ts_resolution_t)r;
+        ts_store_scan(rollup->store[r - 1], eui64[i], start_ms, last_ms[r - 1],
+                      on_row, &scan);
+      }
+    }
+    // Then roll up the raw samples after the last minute row.
+    if (has_last[TS_RESOLUTION_MINUTE]) {
+      scan.state->watermark_ms = last_ms[TS_RESOLUTION_MINUTE]
+                                 + resolution_ms[TS_RESOLUTION_MINUTE];
+    }
+    ts_store_scan(raw, eui64[i], scan.state->watermark_ms, INT64_MAX,
+                  on_raw_sample, &scan);
+  }
+  free(eui64);
+  return 0;
+}
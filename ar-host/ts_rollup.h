@@ -0,0 +1,143 @@
+/***************************************************************************//**
+ * @file ts_rollup.h
+ * @brief ts_rollup.h
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+#ifndef TS_ROLLUP_H
+#define TS_ROLLUP_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include "ts_store.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Values of a raw sample that can be rolled up
+#define TS_ROLLUP_MAX_VALUES           ((TS_MAX_VALUES - 1u) / 3u)
+/// Values of a row of a rollup tier: the count of samples, then the minimum,
+/// maximum and mean of every value of the raw samples
+#define TS_ROLLUP_COUNT                (0u)
+#define TS_ROLLUP_MIN(value)           (1u + 3u * (value))
+#define TS_ROLLUP_MAX(value)           (2u + 3u * (value))
+#define TS_ROLLUP_MEAN(value)          (3u + 3u * (value))
+#define TS_ROLLUP_VALUES(values)       (1u + 3u * (values))
+
+/// Resolutions of a rollup set, each but the raw one in a store of its own
+typedef enum {
+  TS_RESOLUTION_RAW    = 0,
+  TS_RESOLUTION_MINUTE = 1,
+  TS_RESOLUTION_HOUR   = 2,
+  TS_RESOLUTION_DAY    = 3,
+  TS_RESOLUTION_COUNT
+} ts_resolution_t;
+
+/// A point of a query: a raw sample, or a row of a rollup tier
+typedef struct {
+  int64_t start_ms;
+  /// Length of the bucket, 0 for a raw sample
+  uint32_t duration_ms;
+  uint32_t count;
+  int32_t min[TS_ROLLUP_MAX_VALUES];
+  int32_t max[TS_ROLLUP_MAX_VALUES];
+  int32_t mean[TS_ROLLUP_MAX_VALUES];
+} ts_point_t;
+
+/// Called for every point of a query, returns false to stop the query
+typedef bool (*ts_point_cb_t)(uint64_t eui64,
+                              const ts_point_t *point,
+                              void *context);
+
+/// Metrics of a rollup set
+typedef struct {
+  ts_store_stats_t store[TS_RESOLUTION_COUNT];
+  /// Raw blocks written but not rolled up yet, and rolled up
+  uint64_t pending_blocks;
+  uint64_t processed_blocks;
+} ts_rollup_stats_t;
+
+typedef struct ts_rollup ts_rollup_t;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Opens a raw store and its rollup tiers, in "<path>", "<path>.1m",
+ * "<path>.1h" and "<path>.1d". When writable, the rollups of every series
+ * are brought up to date with its raw samples: after a restart only the
+ * samples after the last minute row are read again.
+ *
+ * @param value_count is the number of values of a raw sample, up to
+ *        TS_ROLLUP_MAX_VALUES. 0 takes the one of an existing store.
+ * @returns NULL on error, with errno set.
+ *****************************************************************************/
+ts_rollup_t *ts_rollup_open(const char *path, bool writable, unsigned value_count);
+
+/**************************************************************************//**
+ * Writes the raw blocks, rolls them up and closes the stores. The rows of
+ * the buckets not complete yet are not written, they are rebuilt from the
+ * raw samples when the set is opened again.
+ *****************************************************************************/
+void ts_rollup_close(ts_rollup_t *rollup);
+
+/**************************************************************************//**
+ * Appends a raw sample, see ts_store_append(). The sample is rolled up once
+ * its block is written, by ts_rollup_process().
+ *****************************************************************************/
+int ts_rollup_append(ts_rollup_t *rollup,
+                     uint64_t eui64,
+                     const ts_sample_t *sample);
+
+/**************************************************************************//**
+ * Rolls up the raw blocks written since the last call, in the background of
+ * the caller: e.g. when its event loop is idle.
+ *
+ * @param max_blocks is the most raw blocks to read
+ * @returns the number of raw blocks left to roll up.
+ *****************************************************************************/
+size_t ts_rollup_process(ts_rollup_t *rollup, size_t max_blocks);
+
+/**************************************************************************//**
+ * Returns the coarsest resolution with buckets no longer than step_ms.
+ *****************************************************************************/
+ts_resolution_t ts_rollup_resolution(uint32_t step_ms);
+
+/**************************************************************************//**
+ * Calls back for the points of a sensor in [from_ms, to_ms], in time order,
+ * at the coarsest resolution with buckets no longer than step_ms. The end of
+ * the range not rolled up yet at that resolution is filled in from the finer
+ * ones, down to the raw samples.
+ *
+ * @returns the number of points called back for.
+ *****************************************************************************/
+uint64_t ts_rollup_query(ts_rollup_t *rollup,
+                         uint64_t eui64,
+                         int64_t from_ms,
+                         int64_t to_ms,
+                         uint32_t step_ms,
+                         ts_point_cb_t callback,
+                         void *context);
+
+/**************************************************************************//**
+ * Returns the raw store of a rollup set, e.g. for ts_store_series().
+ *****************************************************************************/
+ts_store_t *ts_rollup_raw(ts_rollup_t *rollup);
+
+/**************************************************************************//**
+ * Returns the metrics of a rollup set.
+ *****************************************************************************/
+void ts_rollup_get_stats(const ts_rollup_t *rollup, ts_rollup_stats_t *stats);
+
+#endif  // TS_ROLLUP_H
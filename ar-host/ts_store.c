@@ -0,0 +1,754 @@
+/***************************************************************************//**
+ * @file ts_store.c
+ * @brief ts_store.c
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+// Columnar time-series store of the sensor history, one file of fixed size
+// blocks. Written by the ingest side, read through a memory map.
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#define _DEFAULT_SOURCE
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include "ts_store.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+#define FILE_MAGIC              "TSSTORE"
+#define FILE_VERSION            (1u)
+#define BLOCK_MAGIC             (0x4B425354u)  // "TSBK"
+#define INITIAL_SERIES          (1024u)
+
+/// Variable length prefix code: bucket i is i one bits and a zero (the last
+/// bucket has no zero) followed by bits[i] bits of the zigzag encoded value.
+typedef struct {
+  uint8_t count;
+  uint8_t bits[6];
+} code_t;
+
+/// Block being filled, with one bit stream per column
+typedef struct {
+  ts_block_header_t header;
+  uint32_t bits[TS_MAX_COLUMNS];
+  int64_t last_time_ms;
+  int64_t last_delta_ms;
+  int32_t last[TS_MAX_VALUES];
+  /// Bit streams, grown on demand up to TS_BLOCK_PAYLOAD_SIZE
+  uint8_t *column[TS_MAX_COLUMNS];
+  size_t capacity[TS_MAX_COLUMNS];
+} open_block_t;
+
+typedef struct {
+  uint64_t eui64;
+  bool used;
+  /// Written blocks, in time order
+  uint32_t *blocks;
+  size_t block_count;
+  size_t block_capacity;
+  /// Time of the last sample, written or not
+  int64_t last_time_ms;
+  bool has_samples;
+  open_block_t *open;
+} series_t;
+
+struct ts_store {
+  int fd;
+  bool writable;
+  unsigned column_count;
+  ts_seal_cb_t seal_callback;
+  void *seal_context;
+  /// Open addressing on the EUI64, never more than half full
+  series_t *series;
+  size_t series_capacity;
+  size_t series_count;
+  uint64_t block_count;
+  /// Read only map of the file, grown on demand
+  uint8_t *map;
+  size_t map_length;
+  uint64_t samples;
+  uint64_t out_of_order;
+  uint64_t blocks_read;
+};
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+static uint32_t crc32(const uint8_t *data, size_t length);
+static series_t *find_series(ts_store_t *store, uint64_t eui64, bool insert);
+static int add_block(series_t *series, uint32_t block);
+static unsigned code_length(const code_t *code, uint64_t value);
+static void put_bits(uint8_t *buffer, uint32_t *position, uint64_t value, unsigned count);
+static void put_code(uint8_t *buffer, uint32_t *position, const code_t *code, uint64_t value);
+static uint64_t get_bits(const uint8_t *buffer, uint32_t *position, unsigned count);
+static uint64_t get_code(const uint8_t *buffer, uint32_t *position, const code_t *code);
+static void seal(const open_block_t *open, uint8_t *image);
+static int write_block(ts_store_t *store, series_t *series);
+static const uint8_t *map_block(ts_store_t *store, uint32_t block);
+static uint64_t decode(const uint8_t *image,
+                       int64_t from_ms,
+                       int64_t to_ms,
+                       ts_scan_cb_t callback,
+                       void *context,
+                       bool *stopped);
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+/// Time: delta-of-delta in ms. Samples come at a fixed period with some
+/// jitter, most fit in 9 bits.
+static const code_t time_code = { 6, { 0, 7, 12, 20, 32, 64 } };
+/// Values: delta to the previous sample, in 32 bits modulo arithmetic
+static const code_t value_code = { 5, { 0, 6, 10, 16, 32 } };
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+ts_store_t *ts_store_open(const char *path, bool writable, unsigned value_count)
+{
+  uint8_t header[TS_BLOCK_SIZE];
+  ts_store_t *store = calloc(1, sizeof(ts_store_t));
+  struct stat st;
+  uint64_t blocks;
+  uint64_t i;
+  int error = EINVAL;
+
+  if (store == NULL) {
+    return NULL;
+  }
+  if (value_count > TS_MAX_VALUES) {
+    free(store);
+    errno = EINVAL;
+    return NULL;
+  }
+  store->writable = writable;
+  store->fd = open(path, writable ? (O_RDWR | O_CREAT) : O_RDONLY, 0644);
+  store->series_capacity = INITIAL_SERIES;
+  store->series = calloc(store->series_capacity, sizeof(series_t));
+  if (store->fd < 0 || store->series == NULL || fstat(store->fd, &st) != 0) {
+    error = errno;
+    goto fail;
+  }
+
+  if (st.st_size == 0 && writable && value_count > 0) {
+    memset(header, 0, sizeof(header));
+    memcpy(header, FILE_MAGIC, sizeof(FILE_MAGIC) - 1);
+    header[7] = FILE_VERSION;
+    header[8] = (uint8_t)(value_count + 1u);
+    header[9] = (uint8_t)(TS_BLOCK_SIZE >> 8);
+    if (pwrite(store->fd, header, sizeof(header), 0) != (ssize_t)sizeof(header)) {
+      error = errno;
+      goto fail;
+    }
+    st.st_size = sizeof(header);
+  }
+  if (st.st_size < (off_t)TS_BLOCK_SIZE
+      || pread(store->fd, header, sizeof(header), 0) != (ssize_t)sizeof(header)
+      || memcmp(header, FILE_MAGIC, sizeof(FILE_MAGIC) - 1) != 0
+      || header[7] != FILE_VERSION
+      || header[8] < 2u || header[8] > TS_MAX_COLUMNS
+      || (value_count > 0 && header[8] != value_count + 1u)) {
+    goto fail;
+  }
+  store->column_count = header[8];
+
+  // Index the blocks. Blocks are only ever appended, so a torn write can
+  // only be the last block: that one has its CRC checked.
+  blocks = (uint64_t)st.st_size / TS_BLOCK_SIZE - 1u;
+  store->block_count = blocks;
+  for (i = 0; i < blocks; i++) {
+    const uint8_t *image = map_block(store, (uint32_t)i);
+    const ts_block_header_t *block = (const ts_block_header_t *)image;
+    series_t *series;
+
+    if (block == NULL) {
+      error = errno;
+      goto fail;
+    }
+    if (block->magic != BLOCK_MAGIC
+        || (i + 1 == blocks
+            && block->crc != crc32(image + 8, TS_BLOCK_SIZE - 8))) {
+      break;
+    }
+    series = find_series(store, block->eui64, true);
+    if (series == NULL || add_block(series, (uint32_t)i) != 0) {
+      error = ENOMEM;
+      goto fail;
+    }
+    series->last_time_ms = block->last_time_ms;
+    series->has_samples = true;
+    store->samples += block->count;
+  }
+  if (i < blocks) {
+    store->block_count = i;
+    if (writable && ftruncate(store->fd, (off_t)((i + 1) * TS_BLOCK_SIZE)) != 0) {
+      error = errno;
+      goto fail;
+    }
+  }
+  return store;
+
+  fail:
+  ts_store_close(store);
+  errno = error;
+  return NULL;
+}
+
+void ts_store_close(ts_store_t *store)
+{
+  size_t i;
+
+  if (store == NULL) {
+    return;
+  }
+  if (store->writable && store->fd >= 0) {
+    ts_store_flush(store);
+  }
+  for (i = 0; i < store->series_capacity && store->series != NULL; i++) {
+    open_block_t *open = store->series[i].open;
+    unsigned c;
+    free(store->series[i].blocks);
+    for (c = 0; open != NULL && c < TS_MAX_COLUMNS; c++) {
+      free(open->column[c]);
+    }
+    free(open);
+  }
+  if (store->map != NULL) {
+    munmap(store->map, store->map_length);
+  }
+  if (store->fd >= 0) {
+    close(store->fd);
+  }
+  free(store->series);
+  free(store);
+}
+
+int ts_store_append(ts_store_t *store,
+                    uint64_t eui64,
+                    const ts_sample_t *sample)
+{
+  series_t *series = find_series(store, eui64, true);
+  open_block_t *open;
+  unsigned values = store->column_count - 1u;
+  unsigned length[TS_MAX_COLUMNS];
+  uint64_t code[TS_MAX_COLUMNS];
+  size_t bytes = 0;
+  unsigned c;
+
+  if (series == NULL || !store->writable) {
+    return -1;
+  }
+  if (series->has_samples && sample->time_ms < series->last_time_ms) {
+    store->out_of_order++;
+    return -1;
+  }
+  if (series->open == NULL) {
+    series->open = calloc(1, sizeof(open_block_t));
+    if (series->open == NULL) {
+      return -1;
+    }
+  }
+  open = series->open;
+
+  if (open->header.count > 0) {
+    int64_t delta = sample->time_ms - open->last_time_ms;
+    int64_t dod = delta - open->last_delta_ms;
+
+    code[TS_COLUMN_TIME] = ((uint64_t)dod << 1) ^ (uint64_t)(dod >> 63);
+    length[TS_COLUMN_TIME] = code_length(&time_code, code[TS_COLUMN_TIME]);
+    for (c = 0; c < values; c++) {
+      int32_t d = (int32_t)((uint32_t)sample->value[c] - (uint32_t)open->last[c]);
+      code[c + 1] = (uint32_t)(((uint32_t)d << 1) ^ (uint32_t)(d >> 31));
+      length[c + 1] = code_length(&value_code, code[c + 1]);
+    }
+    for (c = 0; c < store->column_count; c++) {
+      bytes += (open->bits[c] + length[c] + 7u) / 8u;
+    }
+    if (bytes > TS_BLOCK_PAYLOAD_SIZE || open->header.count == UINT16_MAX) {
+      if (write_block(store, series) != 0) {
+        return -1;
+      }
+    }
+  }
+
+  if (open->header.count == 0) {
+    // The first sample lives in the header.
+    memset(&open->header, 0, sizeof(open->header));
+    memset(open->bits, 0, sizeof(open->bits));
+    open->header.magic = BLOCK_MAGIC;
+    open->header.eui64 = eui64;
+    open->header.column_count = (uint8_t)store->column_count;
+    open->header.first_time_ms = sample->time_ms;
+    for (c = 0; c < values; c++) {
+      open->header.first[c] = sample->value[c];
+    }
+    open->last_delta_ms = 0;
+  } else {
+    for (c = 0; c < store->column_count; c++) {
+      size_t needed = (open->bits[c] + length[c] + 7u) / 8u;
+      if (needed > open->capacity[c]) {
+        size_t capacity = open->capacity[c] ? open->capacity[c] * 2u : 64u;
+        uint8_t *column;
+        if (capacity < needed) {
+          capacity = needed;
+        }
+        if (capacity > TS_BLOCK_PAYLOAD_SIZE) {
+          capacity = TS_BLOCK_PAYLOAD_SIZE;
+        }
+        column = realloc(open->column[c], capacity);
+        if (column == NULL) {
+          return -1;
+        }
+        open->column[c] = column;
+        open->capacity[c] = capacity;
+      }
+    }
+    for (c = 0; c < store->column_count; c++) {
+      put_code(open->column[c], &open->bits[c],
+               (c == TS_COLUMN_TIME) ? &time_code : &value_code, code[c]);
+    }
+    open->last_delta_ms = sample->time_ms - open->last_time_ms;
+  }
+
+  open->last_time_ms = sample->time_ms;
+  open->header.last_time_ms = sample->time_ms;
+  open->header.count++;
+  for (c = 0; c < values; c++) {
+    open->last[c] = sample->value[c];
+  }
+  series->last_time_ms = sample->time_ms;
+  series->has_samples = true;
+  store->samples++;
+  return 0;
+}
+
+int ts_store_flush(ts_store_t *store)
+{
+  size_t i;
+
+  for (i = 0; i < store->series_capacity; i++) {
+    series_t *series = &store->series[i];
+    if (series->used && series->open != NULL && series->open->header.count > 0
+        && write_block(store, series) != 0) {
+      return -1;
+    }
+  }
+  return 0;
+}
+
+uint64_t ts_store_scan(ts_store_t *store,
+                       uint64_t eui64,
+                       int64_t from_ms,
+                       int64_t to_ms,
+                       ts_scan_cb_t callback,
+                       void *context)
+{
+  series_t *series = find_series(store, eui64, false);
+  uint64_t samples = 0;
+  bool stopped = false;
+  size_t low;
+  size_t high;
+
+  if (series == NULL) {
+    return 0;
+  }
+
+  // First block that ends at or after from_ms
+  low = 0;
+  high = series->block_count;
+  while (low < high) {
+    size_t middle = (low + high) / 2;
+    const ts_block_header_t *block =
+      (const ts_block_header_t *)map_block(store, series->blocks[middle]);
+    if (block == NULL) {
+      return samples;
+    }
+    if (block->last_time_ms < from_ms) {
+      low = middle + 1;
+    } else {
+      high = middle;
+    }
+  }
+  for (; low < series->block_count && !stopped; low++) {
+    const uint8_t *image = map_block(store, series->blocks[low]);
+    if (image == NULL || ((const ts_block_header_t *)image)->first_time_ms > to_ms) {
+      return samples;
+    }
+    store->blocks_read++;
+    samples += decode(image, from_ms, to_ms, callback, context, &stopped);
+  }
+
+  if (!stopped && series->open != NULL && series->open->header.count > 0
+      && series->open->header.first_time_ms <= to_ms) {
+    static uint8_t image[TS_BLOCK_SIZE];
+    seal(series->open, image);
+    store->blocks_read++;
+    samples += decode(image, from_ms, to_ms, callback, context, &stopped);
+  }
+  return samples;
+}
+
+uint64_t ts_store_scan_block(ts_store_t *store,
+                             uint32_t block,
+                             int64_t from_ms,
+                             int64_t to_ms,
+                             ts_scan_cb_t callback,
+                             void *context)
+{
+  const uint8_t *image = (block < store->block_count) ? map_block(store, block) : NULL;
+  bool stopped = false;
+
+  if (image == NULL) {
+    return 0;
+  }
+  store->blocks_read++;
+  return decode(image, from_ms, to_ms, callback, context, &stopped);
+}
+
+bool ts_store_last_time(ts_store_t *store, uint64_t eui64, int64_t *time_ms)
+{
+  series_t *series = find_series(store, eui64, false);
+
+  if (series == NULL || !series->has_samples) {
+    return false;
+  }
+  *time_ms = series->last_time_ms;
+  return true;
+}
+
+unsigned ts_store_value_count(const ts_store_t *store)
+{
+  return store->column_count - 1u;
+}
+
+void ts_store_set_seal_callback(ts_store_t *store,
+                                ts_seal_cb_t callback,
+                                void *context)
+{
+  store->seal_callback = callback;
+  store->seal_context = context;
+}
+
+size_t ts_store_series(const ts_store_t *store, uint64_t *eui64, size_t max)
+{
+  size_t count = 0;
+  size_t i;
+
+  for (i = 0; i < store->series_capacity; i++) {
+    if (store->series[i].used) {
+      if (count < max) {
+        eui64[count] = store->series[i].eui64;
+      }
+      count++;
+    }
+  }
+  return count;
+}
+
+void ts_store_get_stats(const ts_store_t *store, ts_store_stats_t *stats)
+{
+  stats->series = store->series_count;
+  stats->blocks = store->block_count;
+  stats->samples = store->samples;
+  stats->out_of_order = store->out_of_order;
+  stats->file_bytes = (store->block_count + 1) * TS_BLOCK_SIZE;
+  stats->blocks_read = store->blocks_read;
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+static uint32_t crc32(const uint8_t *data, size_t length)
+{
+  static uint32_t table[256];
+  uint32_t crc = 0xFFFFFFFFu;
+  size_t i;
+
+  if (table[1] == 0) {
+    for (i = 0; i < 256; i++) {
+      uint32_t value = (uint32_t)i;
+      int bit;
+      for (bit = 0; bit < 8; bit++) {
+        value = (value >> 1) ^ ((value & 1u) ? 0xEDB88320u : 0u);
+      }
+      table[i] = value;
+    }
+  }
+  for (i = 0; i < length; i++) {
+    crc = (crc >> 8) ^ table[(crc ^ data[i]) & 0xFFu];
+  }
+  return ~crc;
+}
+
+static series_t *find_series(ts_store_t *store, uint64_t eui64, bool insert)
+{
+  size_t mask = store->series_capacity - 1;
+  size_t slot = (size_t)((eui64 * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+
+  while (store->series[slot].used) {
+    if (store->series[slot].eui64 == eui64) {
+      return &store->series[slot];
+    }
+    slot = (slot + 1) & mask;
+  }
+  if (!insert) {
+    return NULL;
+  }
+  if ((store->series_count + 1) * 2 > store->series_capacity) {
+    // Grow and rehash, the series keep their block lists.
+    series_t *old = store->series;
+    size_t old_capacity = store->series_capacity;
+    size_t i;
+
+    store->series = calloc(old_capacity * 2, sizeof(series_t));
+    if (store->series == NULL) {
+      store->series = old;
+      return NULL;
+    }
+    store->series_capacity = old_capacity * 2;
+    mask = store->series_capacity - 1;
+    for (i = 0; i < old_capacity; i++) {
+      if (old[i].used) {
+        size_t s = (size_t)((old[i].eui64 * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+        while (store->series[s].used) {
+          s = (s + 1) & mask;
+        }
+        store->series[s] = old[i];
+      }
+    }
+    free(old);
+    slot = (size_t)((eui64 * 0x9E3779B97F4A7C15ull) >> 32) & mask;
+    while (store->series[slot].used) {
+      slot = (slot + 1) & mask;
+    }
+  }
+  store->series[slot].used = true;
+  store->series[slot].eui64 = eui64;
+  store->series_count++;
+  return &store->series[slot];
+}
+
+static int add_block(series_t *series, uint32_t block)
+{
+  if (series->block_count == series->block_capacity) {
+    size_t capacity = series->block_capacity ? series->block_capacity * 2 : 16;
+    uint32_t *blocks = realloc(series->blocks, capacity * sizeof(uint32_t));
+    if (blocks == NULL) {
+      return -1;
+    }
+    series->blocks = blocks;
+    series->block_capacity = capacity;
+  }
+  series->blocks[series->block_count++] = block;
+  return 0;
+}
+
+static unsigned code_length(const code_t *code, uint64_t value)
+{
+  unsigned i;
+
+  for (i = 0; i + 1 < code->count; i++) {
+    if (code->bits[i] == 0 ? value == 0 : value < (1ull << code->bits[i])) {
+      return i + 1 + code->bits[i];
+    }
+  }
+  return i + code->bits[i];
+}
+
+static void put_bits(uint8_t *buffer, uint32_t *position, uint64_t value, unsigned count)
+{
+  // Most significant bit first
+  while (count > 0) {
+    unsigned free_bits = 8u - (*position & 7u);
+    unsigned take = (count < free_bits) ? count : free_bits;
+    uint8_t bits = (uint8_t)((value >> (count - take)) & ((1u << take) - 1u));
+    uint8_t *byte = &buffer[*position >> 3];
+
+    if (free_bits == 8u) {
+      *byte = 0;
+    }
+    *byte |= (uint8_t)(bits << (free_bits - take));
+    *position += take;
+    count -= take;
+  }
+}
+
+static void put_code(uint8_t *buffer, uint32_t *position, const code_t *code, uint64_t value)
+{
+  unsigned i;
+
+  for (i = 0; i + 1 < code->count; i++) {
+    if (code->bits[i] == 0 ? value == 0 : value < (1ull << code->bits[i])) {
+      break;
+    }
+  }
+  // i ones, and a zero unless this is the last bucket
+  put_bits(buffer, position, (1ull << i) - 1u, i);
+  if (i + 1 < code->count) {
+    put_bits(buffer, position, 0, 1);
+  }
+  put_bits(buffer, position, value, code->bits[i]);
+}
+
+static uint64_t get_bits(const uint8_t *buffer, uint32_t *position, unsigned count)
+{
+  uint64_t value = 0;
+
+  while (count > 0) {
+    unsigned left = 8u - (*position & 7u);
+    unsigned take = (count < left) ? count : left;
+    uint8_t byte = buffer[*position >> 3];
+
+    value = (value << take) | ((byte >> (left - take)) & ((1u << take) - 1u));
+    *position += take;
+    count -= take;
+  }
+  return value;
+}
+
+static uint64_t get_code(const uint8_t *buffer, uint32_t *position, const code_t *code)
+{
+  unsigned i = 0;
+
+  while (i + 1 < code->count && get_bits(buffer, position, 1) != 0) {
+    i++;
+  }
+  return get_bits(buffer, position, code->bits[i]);
+}
+
+static void seal(const open_block_t *open, uint8_t *image)
+{
+  ts_block_header_t *header = (ts_block_header_t *)image;
+  size_t offset = TS_BLOCK_HEADER_SIZE;
+  unsigned c;
+
+  memcpy(header, &open->header, sizeof(ts_block_header_t));
+  for (c = 0; c < open->header.column_count; c++) {
+    size_t length = (open->bits[c] + 7u) / 8u;
+    header->column_bits[c] = (uint16_t)open->bits[c];
+    if (length > 0) {
+      memcpy(image + offset, open->column[c], length);
+    }
+    offset += length;
+  }
+  memset(image + offset, 0, TS_BLOCK_SIZE - offset);
+  header->crc = crc32(image + 8, TS_BLOCK_SIZE - 8);
+}
+
+static int write_block(ts_store_t *store, series_t *series)
+{
+  uint8_t image[TS_BLOCK_SIZE];
+  off_t offset = (off_t)((store->block_count + 1) * TS_BLOCK_SIZE);
+
+  seal(series->open, image);
+  if (pwrite(store->fd, image, sizeof(image), offset) != (ssize_t)sizeof(image)
+      || add_block(series, (uint32_t)store->block_count) != 0) {
+    return -1;
+  }
+  store->block_count++;
+  series->open->header.count = 0;
+  if (store->seal_callback != NULL) {
+    store->seal_callback(store,
+                         (uint32_t)(store->block_count - 1),
+                         (const ts_block_header_t *)image,
+                         store->seal_context);
+  }
+  return 0;
+}
+
+static const uint8_t *map_block(ts_store_t *store, uint32_t block)
+{
+  size_t end = ((size_t)block + 2) * TS_BLOCK_SIZE;
+
+  if (end > store->map_length) {
+    // Map the whole file again, with room to grow.
+    size_t length = ((size_t)store->block_count + 1) * TS_BLOCK_SIZE;
+    void *map;
+
+    length += length / 4 + 256u * TS_BLOCK_SIZE;
+    if (store->map != NULL) {
+      munmap(store->map, store->map_length);
+      store->map = NULL;
+      store->map_length = 0;
+    }
+    map = mmap(NULL, length, PROT_READ, MAP_SHARED, store->fd, 0);
+    if (map == MAP_FAILED) {
+      return NULL;
+    }
+    store->map = map;
+    store->map_length = length;
+  }
+  return store->map + ((size_t)block + 1) * TS_BLOCK_SIZE;
+}
+
+static uint64_t decode(const uint8_t *image,
+                       int64_t from_ms,
+                       int64_t to_ms,
+                       ts_scan_cb_t callback,
+                       void *context,
+                       bool *stopped)
+{
+  const ts_block_header_t *header = (const ts_block_header_t *)image;
+  const uint8_t *column[TS_MAX_COLUMNS];
+  uint32_t position[TS_MAX_COLUMNS] = { 0 };
+  unsigned values = header->column_count - 1u;
+  ts_sample_t sample;
+  int64_t delta = 0;
+  uint64_t samples = 0;
+  size_t offset = TS_BLOCK_HEADER_SIZE;
+  unsigned c;
+  uint16_t i;
+
+  for (c = 0; c < header->column_count; c++) {
+    column[c] = image + offset;
+    offset += (header->column_bits[c] + 7u) / 8u;
+  }
+  memset(&sample, 0, sizeof(sample));
+  sample.time_ms = header->first_time_ms;
+  memcpy(sample.value, header->first, values * sizeof(int32_t));
+
+  for (i = 0; i < header->count; i++) {
+    if (i > 0) {
+      uint64_t code = get_code(column[TS_COLUMN_TIME], &position[TS_COLUMN_TIME], &time_code);
+      delta += (int64_t)((code >> 1) ^ (~(code & 1u) + 1u));
+      sample.time_ms += delta;
+      if (sample.time_ms > to_ms) {
+        break;
+      }
+      for (c = 0; c < values; c++) {
+        uint32_t v = (uint32_t)get_code(column[c + 1], &position[c + 1], &value_code);
+        int32_t d = (int32_t)((v >> 1) ^ (~(v & 1u) + 1u));
+        sample.value[c] = (int32_t)((uint32_t)sample.value[c] + (uint32_t)d);
+      }
+    }
+    if (sample.time_ms >= from_ms && sample.time_ms <= to_ms) {
+      samples++;
+      if (!callback(header->eui64, &sample, context)) {
+        *stopped = true;
+        break;
+      }
+    }
+  }
+  return samples;
+}
@@ -0,0 +1,196 @@
+/***************************************************************************//**
+ * @file ts_store.h
+ * @brief ts_store.h
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+#ifndef TS_STORE_H
+#define TS_STORE_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include <stddef.h>
+#include <stdint.h>
+#include <stdbool.h>
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Size of the file header and of every block, a multiple of the page size
+#define TS_BLOCK_SIZE                  (4096u)
+#define TS_BLOCK_HEADER_SIZE           (128u)
+#define TS_BLOCK_PAYLOAD_SIZE          (TS_BLOCK_SIZE - TS_BLOCK_HEADER_SIZE)
+/// Columns of a block: the time and the values of ts_sample_t. The number
+/// of values is set when a store is created.
+#define TS_COLUMN_TIME                 (0u)
+#define TS_MAX_VALUES                  (12u)
+#define TS_MAX_COLUMNS                 (TS_MAX_VALUES + 1u)
+/// Values of the sensor history: temperature in m°C, relative humidity in
+/// thousandths of percent and illuminance in lux
+#define TS_VALUE_TEMPERATURE           (0u)
+#define TS_VALUE_HUMIDITY              (1u)
+#define TS_VALUE_LUX                   (2u)
+#define TS_SENSOR_VALUES               (3u)
+
+/// One sample of a series
+typedef struct {
+  /// Time in ms since the epoch
+  int64_t time_ms;
+  /// Values in the order of the columns, the ones past the value count of
+  /// the store are 0
+  int32_t value[TS_MAX_VALUES];
+} ts_sample_t;
+
+/// Header of a block, in host byte order. A block holds the samples of one
+/// sensor in time order. Every column is a bit stream of its own, starting
+/// at a byte boundary after the previous one: the time as delta-of-delta and
+/// every value as the delta to the previous sample, with variable length
+/// prefix codes. The first sample is only in the header.
+typedef struct {
+  uint32_t magic;
+  /// CRC32 of the block after this field
+  uint32_t crc;
+  uint64_t eui64;
+  int64_t first_time_ms;
+  int64_t last_time_ms;
+  uint16_t count;
+  uint8_t column_count;
+  uint8_t reserved;
+  /// Length of every column in bits
+  uint16_t column_bits[TS_MAX_COLUMNS];
+  uint16_t reserved2;
+  int32_t first[TS_MAX_VALUES];
+  uint8_t padding[16];
+} ts_block_header_t;
+
+/// Metrics of a store
+typedef struct {
+  uint64_t series;
+  uint64_t blocks;
+  uint64_t samples;
+  /// Samples dropped because they were older than the last of their series
+  uint64_t out_of_order;
+  uint64_t file_bytes;
+  /// Blocks decoded by scans, written or open
+  uint64_t blocks_read;
+} ts_store_stats_t;
+
+typedef struct ts_store ts_store_t;
+
+/// Called for every sample of a scan, returns false to stop the scan
+typedef bool (*ts_scan_cb_t)(uint64_t eui64,
+                             const ts_sample_t *sample,
+                             void *context);
+
+/// Called after a block was written to the file
+typedef void (*ts_seal_cb_t)(ts_store_t *store,
+                             uint32_t block,
+                             const ts_block_header_t *header,
+                             void *context);
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Opens a store, created if needed when writable. The block headers are
+ * read to index the series; a torn last block is cut off.
+ *
+ * @param value_count is the number of values of a sample, up to
+ *        TS_MAX_VALUES. 0 takes the one of an existing store.
+ * @returns NULL on error, with errno set.
+ *****************************************************************************/
+ts_store_t *ts_store_open(const char *path, bool writable, unsigned value_count);
+
+/**************************************************************************//**
+ * Returns the number of values of a sample of the store.
+ *****************************************************************************/
+unsigned ts_store_value_count(const ts_store_t *store);
+
+/**************************************************************************//**
+ * Sets the function called for every block written from now on.
+ *****************************************************************************/
+void ts_store_set_seal_callback(ts_store_t *store,
+                                ts_seal_cb_t callback,
+                                void *context);
+
+/**************************************************************************//**
+ * Writes the open blocks and closes the store.
+ *****************************************************************************/
+void ts_store_close(ts_store_t *store);
+
+/**************************************************************************//**
+ * Appends a sample to the series of a sensor. The sample is encoded into the
+ * open block of the series, which is written when it is full.
+ *
+ * @returns 0, or -1 if the sample is older than the last of the series or
+ *          on a write error.
+ *****************************************************************************/
+int ts_store_append(ts_store_t *store,
+                    uint64_t eui64,
+                    const ts_sample_t *sample);
+
+/**************************************************************************//**
+ * Writes every open block, partly filled, to the file.
+ *
+ * @returns 0, or -1 on a write error.
+ *****************************************************************************/
+int ts_store_flush(ts_store_t *store);
+
+/**************************************************************************//**
+ * Calls back for the samples of a sensor in [from_ms, to_ms], in time order,
+ * including the samples not yet written. Blocks are read through a shared
+ * memory map of the file and skipped on their time range.
+ *
+ * @returns the number of samples called back for.
+ *****************************************************************************/
+uint64_t ts_store_scan(ts_store_t *store,
+                       uint64_t eui64,
+                       int64_t from_ms,
+                       int64_t to_ms,
+                       ts_scan_cb_t callback,
+                       void *context);
+
+/**************************************************************************//**
+ * Calls back for the samples of one written block in [from_ms, to_ms].
+ *
+ * @returns the number of samples called back for.
+ *****************************************************************************/
+uint64_t ts_store_scan_block(ts_store_t *store,
+                             uint32_t block,
+                             int64_t from_ms,
+                             int64_t to_ms,
+                             ts_scan_cb_t callback,
+                             void *context);
+
+/**************************************************************************//**
+ * Returns the time of the last sample of a series, written or not.
+ *
+ * @returns false if the series has no samples.
+ *****************************************************************************/
+bool ts_store_last_time(ts_store_t *store, uint64_t eui64, int64_t *time_ms);
+
+/**************************************************************************//**
+ * Lists the sensors of the store.
+ *
+ * @param *eui64 receives at most max EUI64s, in no particular order
+ * @returns the number of sensors, which may be more than max.
+ *****************************************************************************/
+size_t ts_store_series(const ts_store_t *store, uint64_t *eui64, size_t max);
+
+/**************************************************************************//**
+ * Returns the metrics of a store.
+ *****************************************************************************/
+void ts_store_get_stats(const ts_store_t *store, ts_store_stats_t *stats);
+
+#endif  // TS_STORE_H
@@ -27,6 +27,15 @@
 #include "sl_flex_assert.h"
 #include "sl_app_common.h"
 #include "stack-info.h"
+#include "app_poll.h"
+#include "app_energy.h"
+#include "app_sleep.h"
+#include "app_counters.h"
+#include "app_clock.h"
+#include "app_trace.h"
+#include "app_memory.h"
+#include "app_status_led.h"
+#include "app_protocol.h"
 
 // -----------------------------------------------------------------------------
 //                              Macros and Typedefs
@@ -38,6 +47,9 @@
 #define DATA_ENDPOINT           1
 #define TX_TEST_ENDPOINT        2
 
+/// Default main loop measurement
+#define LOOP_COST_ITERATIONS    1000
+
 // -----------------------------------------------------------------------------
 //                          Static Function Declarations
 // -----------------------------------------------------------------------------
@@ -117,6 +129,10 @@ void cli_join(sl_cli_command_arg_t *arguments)
   emberClearSelectiveJoinPayload();
 
   status = emberJoinNetwork(EMBER_STAR_END_DEVICE, &parameters);
+  if (status == EMBER_SUCCESS) {
+    // Until EMBER_NETWORK_UP or a join failure
+    app_status_led_set(APP_STATUS_LED_FORMING);
+  }
   APP_INFO("join end device: status 0x%02X\n", status);
 }
 
@@ -149,6 +165,10 @@ void cli_join_sleepy(sl_cli_command_arg_t *arguments)
   }
 
   status = emberJoinNetwork(EMBER_STAR_SLEEPY_END_DEVICE, &parameters);
+  if (status == EMBER_SUCCESS) {
+    // Until EMBER_NETWORK_UP or a join failure
+    app_status_led_set(APP_STATUS_LED_FORMING);
+  }
   APP_INFO("join sleepy 0x%02X\n", status);
 }
 
@@ -181,6 +201,10 @@ void cli_join_extender(sl_cli_command_arg_t *arguments)
   }
 
   status = emberJoinNetwork(EMBER_STAR_RANGE_EXTENDER, &parameters);
+  if (status == EMBER_SUCCESS) {
+    // Until EMBER_NETWORK_UP or a join failure
+    app_status_led_set(APP_STATUS_LED_FORMING);
+  }
   APP_INFO("join range extender 0x%02X\n", status);
 }
 
@@ -204,6 +228,7 @@ void cli_pjoin(sl_cli_command_arg_t *arguments)
   }
 
   emberPermitJoining(duration);
+  app_status_led_permit_join(duration);
 }
 
 /******************************************************************************
@@ -275,8 +300,13 @@ void cli_set_security_key(sl_cli_command_arg_t *arguments)
  *****************************************************************************/
 void cli_set_report_period(sl_cli_command_arg_t *arguments)
 {
-  sensor_report_period_ms = sl_cli_get_argument_uint16(arguments, 0);
+  uint16_t report_period_ms = sl_cli_get_argument_uint16(arguments, 0);
 
+  if (report_period_ms < APP_CONFIGURE_MIN_REPORT_PERIOD_MS) {
+    APP_INFO("Report period below %d ms\n", APP_CONFIGURE_MIN_REPORT_PERIOD_MS);
+    return;
+  }
+  sensor_report_period_ms = report_period_ms;
   APP_INFO("Report period set to %d ms\n", sensor_report_period_ms);
 }
 
@@ -404,3 +434,300 @@ void cli_reset(sl_cli_command_arg_t *arguments)
   (void) arguments;
   halReboot();
 }
+
+/******************************************************************************
+ * CLI - poll_stats command
+ * Prints the state and the metrics of the poll controller. An optional
+ * non-zero argument clears the metrics after printing them.
+ *****************************************************************************/
+void cli_poll_stats(sl_cli_command_arg_t *arguments)
+{
+  static const char *state_names[APP_POLL_STATE_COUNT] = { "long", "short", "decay" };
+  const app_poll_stats_t *stats = app_poll_get_stats();
+  uint16_t interval_s;
+  app_poll_state_t state = app_poll_get_state(&interval_s);
+  uint8_t i;
+
+  APP_INFO("### Poll controller ###\n");
+  APP_INFO("          State: %s, long poll interval %d s\n",
+           state_names[state], interval_s);
+  APP_INFO("  Short polling: %lu after TX, %lu on pending data\n",
+           stats->short_after_tx, stats->short_on_pending);
+  for (i = 0; i < APP_POLL_STATE_COUNT; i++) {
+    APP_INFO("%15s: %lu ms, %lu downlink(s)\n",
+             state_names[i], stats->state_ms[i], stats->downlinks[i]);
+  }
+
+  if (sl_cli_get_argument_count(arguments) > 0
+      && sl_cli_get_argument_uint8(arguments, 0) != 0) {
+    app_poll_reset_stats();
+  }
+}
+
+/******************************************************************************
+ * CLI - energy command
+ * Prints the energy mode residency and the activity counters. An optional
+ * non-zero argument clears them after printing them.
+ *****************************************************************************/
+void cli_energy(sl_cli_command_arg_t *arguments)
+{
+  static const char *cause_names[APP_ENERGY_WAKEUP_CAUSE_COUNT] = {
+    "other", "event", "radio", "button"
+  };
+  app_energy_stats_t stats;
+  uint8_t i;
+
+  app_energy_get_stats(&stats);
+  APP_INFO("### Energy profile ###\n");
+  for (i = 0; i < APP_ENERGY_EM_COUNT; i++) {
+    APP_INFO("            EM%d: %lu ms, %lu wakeup(s)\n",
+             i, stats.em_ms[i], stats.wakeups[i]);
+  }
+  for (i = 0; i < APP_ENERGY_WAKEUP_CAUSE_COUNT; i++) {
+    APP_INFO("%15s: %lu wakeup(s)\n", cause_names[i], stats.wakeup_causes[i]);
+  }
+  APP_INFO("             TX: %lu frame(s), %lu ms\n", stats.tx_count, stats.tx_ms);
+  APP_INFO("             RX: %lu frame(s), %lu byte(s)\n", stats.rx_count, stats.rx_bytes);
+  APP_INFO("            I2C: %lu transaction(s), %lu ms\n", stats.i2c_count, stats.i2c_ms);
+  APP_INFO("        Reports: %lu, %lu wakeup(s) in total, %lu for the last one\n",
+           stats.reports, stats.report_wakeups, stats.last_report_wakeups);
+
+  if (sl_cli_get_argument_count(arguments) > 0
+      && sl_cli_get_argument_uint8(arguments, 0) != 0) {
+    app_energy_reset();
+  }
+}
+
+/******************************************************************************
+ * CLI - energy_dump command
+ * Prints the serialized energy metrics as a single hex line, for host tools.
+ *****************************************************************************/
+void cli_energy_dump(sl_cli_command_arg_t *arguments)
+{
+  (void) arguments;
+  uint8_t buffer[APP_ENERGY_DUMP_LENGTH];
+  uint8_t length = app_energy_dump(buffer);
+  uint8_t i;
+
+  APP_INFO("energy:");
+  for (i = 0; i < length; i++) {
+    APP_INFO("%02X", buffer[i]);
+  }
+  APP_INFO("\n");
+}
+
+/******************************************************************************
+ * CLI - sleep_policy command
+ * Prints how often the low-power policy picked each outcome. An optional
+ * non-zero argument clears the counters after printing them.
+ *****************************************************************************/
+void cli_sleep_policy(sl_cli_command_arg_t *arguments)
+{
+  static const char *decision_names[APP_SLEEP_DECISION_COUNT] = {
+    "EM2", "EM1", "override", "busy", "CLI", "short"
+  };
+  const uint32_t *decisions = app_sleep_get_decisions();
+  uint8_t i;
+
+  APP_INFO("### Low-power policy ###\n");
+  APP_INFO("       Override: %s\n", app_sleep_get_override() ? "on" : "off");
+  for (i = 0; i < APP_SLEEP_DECISION_COUNT; i++) {
+    APP_INFO("%15s: %lu\n", decision_names[i], decisions[i]);
+  }
+
+  if (sl_cli_get_argument_count(arguments) > 0
+      && sl_cli_get_argument_uint8(arguments, 0) != 0) {
+    app_sleep_reset_decisions();
+  }
+}
+
+/******************************************************************************
+ * CLI - counters command
+ * Prints the rates over the delta ring and a snapshot of every stack counter
+ * with its increase during the last sample period. An optional non-zero
+ * argument resets the counters after printing them.
+ *****************************************************************************/
+void cli_counters(sl_cli_command_arg_t *arguments)
+{
+  app_counters_rates_t rates;
+  uint8_t i;
+
+  app_counters_get_rates(&rates);
+  APP_INFO("### Stack counters ###\n");
+  APP_INFO("Rates over %lu ms (per s): TX %lu.%02lu, RX %lu.%02lu, "
+           "ACK fail %lu.%02lu, CCA fail %lu.%02lu, retries %lu.%02lu\n",
+           rates.window_ms,
+           rates.tx / 100, rates.tx % 100,
+           rates.rx / 100, rates.rx % 100,
+           rates.ack_failures / 100, rates.ack_failures % 100,
+           rates.cca_failures / 100, rates.cca_failures % 100,
+           rates.retries / 100, rates.retries % 100);
+  for (i = 0; i < EMBER_COUNTER_TYPE_COUNT; i++) {
+    APP_INFO("0x%02X: %lu (+%d)\n",
+             i, app_counters_get(i), app_counters_get_last_delta(i));
+  }
+
+  if (sl_cli_get_argument_count(arguments) > 0
+      && sl_cli_get_argument_uint8(arguments, 0) != 0) {
+    app_counters_reset();
+  }
+}
+
+/******************************************************************************
+ * CLI - counters_dump command
+ * Prints the binary snapshot of every stack counter as a single hex line.
+ *****************************************************************************/
+void cli_counters_dump(sl_cli_command_arg_t *arguments)
+{
+  (void) arguments;
+  uint8_t buffer[APP_COUNTERS_DUMP_LENGTH];
+  uint16_t length = app_counters_dump(buffer);
+  uint16_t i;
+
+  APP_INFO("counters:");
+  for (i = 0; i < length; i++) {
+    APP_INFO("%02X", buffer[i]);
+  }
+  APP_INFO("\n");
+}
+
+/******************************************************************************
+ * CLI - clock command
+ * Prints the network time and the synchronization metrics of the clock.
+ *****************************************************************************/
+void cli_clock(sl_cli_command_arg_t *arguments)
+{
+  (void) arguments;
+  const app_clock_stats_t *stats = app_clock_get_stats();
+  uint32_t network_ms;
+
+  APP_INFO("### Network clock ###\n");
+  if (app_clock_get_network_ms(&network_ms)) {
+    APP_INFO("   Network time: %lu ms\n", network_ms);
+  } else {
+    APP_INFO("   Network time: not synchronized\n");
+  }
+  APP_INFO("          Syncs: %lu, %lu restart(s)\n", stats->syncs, stats->resets);
+  APP_INFO("          Error: %ld ms last, %lu ms max\n",
+           stats->last_error_ms, stats->max_error_ms);
+  APP_INFO("          Drift: %ld ppm\n", stats->drift_ppm);
+}
+
+/******************************************************************************
+ * CLI - trace command
+ * Prints the state of the event trace. An optional argument pauses (0) or
+ * resumes (1) the recording.
+ *****************************************************************************/
+void cli_trace(sl_cli_command_arg_t *arguments)
+{
+  if (sl_cli_get_argument_count(arguments) > 0) {
+    app_trace_set_enabled(sl_cli_get_argument_uint8(arguments, 0) != 0);
+  }
+  APP_INFO("Trace %s, %d/%d events\n",
+           app_trace_is_enabled() ? "recording" : "paused",
+           app_trace_get_count(),
+           APP_TRACE_SIZE);
+}
+
+/******************************************************************************
+ * CLI - trace_dump command
+ * Prints the header and every event of the trace as hex lines, oldest event
+ * first. The recording is paused meanwhile. An optional argument of 1 empties
+ * the trace afterwards.
+ *****************************************************************************/
+void cli_trace_dump(sl_cli_command_arg_t *arguments)
+{
+  uint8_t buffer[APP_TRACE_HEADER_LENGTH];
+  bool was_enabled = app_trace_is_enabled();
+  uint16_t count;
+  uint16_t index;
+  uint8_t length;
+  uint8_t i;
+
+  app_trace_set_enabled(false);
+  count = app_trace_get_count();
+  length = app_trace_dump_header(buffer);
+  APP_INFO("trace:");
+  for (i = 0; i < length; i++) {
+    APP_INFO("%02X", buffer[i]);
+  }
+  APP_INFO("\n");
+  for (index = 0; index < count; index++) {
+    if (index % 4 == 0) {
+      APP_INFO("trace:");
+    }
+    app_trace_dump_entry(index, buffer);
+    for (i = 0; i < APP_TRACE_ENTRY_LENGTH; i++) {
+      APP_INFO("%02X", buffer[i]);
+    }
+    if (index % 4 == 3 || index == count - 1) {
+      APP_INFO("\n");
+    }
+  }
+
+  if (sl_cli_get_argument_count(arguments) > 0
+      && sl_cli_get_argument_uint8(arguments, 0) == 1) {
+    app_trace_clear();
+  }
+  app_trace_set_enabled(was_enabled);
+}
+
+/******************************************************************************
+ * CLI - memory command
+ * Prints the stack high-water marks and the heap usage. The buffer heap peak
+ * is sampled, see app_memory_sample(). An optional argument of 1 restarts the
+ * peak tracking of the Ember buffer heap afterwards.
+ *****************************************************************************/
+void cli_memory(sl_cli_command_arg_t *arguments)
+{
+  app_memory_stats_t stats;
+  const char *name;
+  uint16_t size;
+  uint16_t used;
+  uint8_t i;
+
+  app_memory_get_stats(&stats);
+  APP_INFO("### Memory usage (bytes) ###\n");
+  APP_INFO("     Main stack: %d/%d peak\n", stats.stack_peak, stats.stack_size);
+  for (i = 0; app_memory_get_task(i, &name, &size, &used); i++) {
+    APP_INFO("     Task stack: %d/%d peak, %s\n", used, size, name);
+  }
+  APP_INFO("   Buffer heap: %d used, %d sampled peak, %d total\n",
+           stats.buffer_used, stats.buffer_peak, stats.buffer_size);
+  APP_INFO("         C heap: %d used, %d peak\n",
+           stats.c_heap_used, stats.c_heap_peak);
+
+  if (sl_cli_get_argument_count(arguments) > 0
+      && sl_cli_get_argument_uint8(arguments, 0) == 1) {
+    app_memory_reset_peak();
+  }
+}
+
+/******************************************************************************
+ * CLI - loop_cost command
+ * Measures the CPU cycles of the next main loop iterations, printed once
+ * done. Optional arguments: iteration count and 1 to poll the LED on every
+ * iteration, as before the status LED events, for the comparison. Toggle
+ * the sleep override with button 0 first, or the iterations include the
+ * time asleep.
+ *****************************************************************************/
+void cli_loop_cost(sl_cli_command_arg_t *arguments)
+{
+#if APP_STATUS_LED_LOOP_METER
+  uint16_t iterations = LOOP_COST_ITERATIONS;
+  bool polling = false;
+
+  if (sl_cli_get_argument_count(arguments) > 0) {
+    iterations = sl_cli_get_argument_uint16(arguments, 0);
+  }
+  if (sl_cli_get_argument_count(arguments) > 1) {
+    polling = (sl_cli_get_argument_uint8(arguments, 1) != 0);
+  }
+  if (!app_status_led_measure_loop(iterations, polling)) {
+    APP_INFO("loop_cost: 1 or more iterations, one measurement at a time\n");
+  }
+#else
+  (void) arguments;
+  APP_INFO("loop_cost: built without APP_STATUS_LED_LOOP_METER\n");
+#endif
+}
@@ -0,0 +1,161 @@
+/***************************************************************************//**
+ * @file app_clock.c
+ * @brief app_clock.c
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include PLATFORM_HEADER
+#include "stack/include/ember.h"
+#include "sl_sleeptimer.h"
+#include "app_clock.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Bound of the drift estimate, well above the crystal tolerances
+#define MAX_DRIFT_PPM          (500)
+/// Beacons closer than this do not update the drift estimate
+#define MIN_DRIFT_INTERVAL_MS  (1000u)
+/// An error above this restarts the clock (sink reboot, missed wrap)
+#define MAX_ERROR_MS           (10000)
+/// Weight of a new drift measurement, 1 / 2^DRIFT_GAIN_SHIFT
+#define DRIFT_GAIN_SHIFT       (1u)
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Returns the local time in ms, from the 64-bit sleeptimer tick.
+ *****************************************************************************/
+static uint64_t local_ms(void);
+
+/**************************************************************************//**
+ * Extrapolates the network time at a given local time.
+ *****************************************************************************/
+static uint32_t network_at(uint64_t local);
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+/// Anchor of the clock: local and network time at the last beacon
+static bool synced = false;
+static uint64_t anchor_local_ms;
+static uint32_t anchor_network_ms;
+/// Metrics, the drift estimate included
+static app_clock_stats_t stats;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Corrects the clock with a time beacon of the sink. The error between the
+ * beacon and the extrapolated time, divided by the time since the previous
+ * beacon, is the residual drift; half of it is added to the estimate.
+ *****************************************************************************/
+void app_clock_sync(uint32_t network_ms)
+{
+  uint64_t now = local_ms();
+  uint64_t interval_ms = now - anchor_local_ms;
+  int32_t error_ms;
+  int32_t drift_ppm;
+
+  stats.syncs++;
+  if (synced) {
+    error_ms = (int32_t)(network_ms - network_at(now));
+    if (error_ms > MAX_ERROR_MS || error_ms < -MAX_ERROR_MS) {
+      stats.resets++;
+      stats.drift_ppm = 0;
+    } else {
+      stats.last_error_ms = error_ms;
+      if ((uint32_t)((error_ms < 0) ? -error_ms : error_ms) > stats.max_error_ms) {
+        stats.max_error_ms = (error_ms < 0) ? -error_ms : error_ms;
+      }
+      if (interval_ms >= MIN_DRIFT_INTERVAL_MS) {
+        drift_ppm = (int32_t)(((int64_t)error_ms * 1000000)
+                              / (int64_t)interval_ms);
+        drift_ppm = stats.drift_ppm + drift_ppm / (1 << DRIFT_GAIN_SHIFT);
+        if (drift_ppm > MAX_DRIFT_PPM) {
+          drift_ppm = MAX_DRIFT_PPM;
+        } else if (drift_ppm < -MAX_DRIFT_PPM) {
+          drift_ppm = -MAX_DRIFT_PPM;
+        }
+        stats.drift_ppm = drift_ppm;
+      }
+    }
+  }
+
+  synced = true;
+  anchor_local_ms = now;
+  anchor_network_ms = network_ms;
+}
+
+/**************************************************************************//**
+ * Forgets the synchronization.
+ *****************************************************************************/
+void app_clock_reset(void)
+{
+  synced = false;
+  stats.drift_ppm = 0;
+}
+
+/**************************************************************************//**
+ * Returns the current network time.
+ *****************************************************************************/
+bool app_clock_get_network_ms(uint32_t *network_ms)
+{
+  if (!synced) {
+    return false;
+  }
+  *network_ms = network_at(local_ms());
+  return true;
+}
+
+/**************************************************************************//**
+ * Returns the metrics of the clock.
+ *****************************************************************************/
+const app_clock_stats_t *app_clock_get_stats(void)
+{
+  return &stats;
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Returns the local time in ms, from the 64-bit sleeptimer tick.
+ *****************************************************************************/
+static uint64_t local_ms(void)
+{
+  return (sl_sleeptimer_get_tick_count64() * MILLISECOND_TICKS_PER_SECOND)
+         / sl_sleeptimer_get_timer_frequency();
+}
+
+/**************************************************************************//**
+ * Extrapolates the network time at a given local time, compensating the
+ * drift.
+ *****************************************************************************/
+static uint32_t network_at(uint64_t local)
+{
+  int64_t elapsed_ms = (int64_t)(local - anchor_local_ms);
+
+  return anchor_network_ms
+         + (uint32_t)(elapsed_ms + (elapsed_ms * stats.drift_ppm) / 1000000);
+}
@@ -0,0 +1,72 @@
+/***************************************************************************//**
+ * @file app_clock.h
+ * @brief app_clock.h
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+#ifndef APP_CLOCK_H
+#define APP_CLOCK_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Metrics of the network clock
+typedef struct {
+  /// Beacons applied, and the ones that restarted the clock
+  uint32_t syncs;
+  uint32_t resets;
+  /// Error of the clock at the last beacon and largest error seen, in ms
+  int32_t last_error_ms;
+  uint32_t max_error_ms;
+  /// Correction applied to the local clock to follow the sink, in ppm:
+  /// negative when the local clock runs fast
+  int32_t drift_ppm;
+} app_clock_stats_t;
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Corrects the clock with a time beacon of the sink.
+ *
+ * @param network_ms is the network time carried by the beacon
+ *****************************************************************************/
+void app_clock_sync(uint32_t network_ms);
+
+/**************************************************************************//**
+ * Forgets the synchronization, e.g. when the network goes down.
+ *****************************************************************************/
+void app_clock_reset(void);
+
+/**************************************************************************//**
+ * Returns the current network time.
+ *
+ * @param *network_ms is the output, in ms, wrapping
+ * @returns false if no beacon was received yet.
+ *****************************************************************************/
+bool app_clock_get_network_ms(uint32_t *network_ms);
+
+/**************************************************************************//**
+ * Returns the metrics of the clock.
+ *****************************************************************************/
+const app_clock_stats_t *app_clock_get_stats(void);
+
+#endif  // APP_CLOCK_H
@@ -0,0 +1,302 @@
+/***************************************************************************//**
+ * @file app_energy.c
+ * @brief app_energy.c
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include PLATFORM_HEADER
+#include "stack/include/ember.h"
+#include "em_core.h"
+#include "sl_component_catalog.h"
+#include "sl_sleeptimer.h"
+#if defined(SL_CATALOG_POWER_MANAGER_PRESENT)
+#include "sl_power_manager.h"
+#endif
+#include "app_energy.h"
+#include "app_trace.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+#if defined(SL_CATALOG_POWER_MANAGER_PRESENT)
+/**************************************************************************//**
+ * Power manager energy mode transition callback.
+ *****************************************************************************/
+static void on_em_transition(sl_power_manager_em_t from,
+                             sl_power_manager_em_t to);
+#endif
+
+/**************************************************************************//**
+ * Converts sleeptimer ticks to milliseconds.
+ *****************************************************************************/
+static uint32_t ticks_to_ms(uint64_t ticks);
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+#if defined(SL_CATALOG_POWER_MANAGER_PRESENT)
+/// Power manager subscription
+static sl_power_manager_em_transition_event_handle_t em_transition_handle;
+static const sl_power_manager_em_transition_event_info_t em_transition_info = {
+  .event_mask = SL_POWER_MANAGER_EVENT_TRANSITION_ENTERING_EM0
+                | SL_POWER_MANAGER_EVENT_TRANSITION_ENTERING_EM1
+                | SL_POWER_MANAGER_EVENT_TRANSITION_ENTERING_EM2
+                | SL_POWER_MANAGER_EVENT_TRANSITION_ENTERING_EM3,
+  .on_event = on_em_transition
+};
+#endif
+/// Residency per energy mode in sleeptimer ticks
+static uint64_t em_ticks[APP_ENERGY_EM_COUNT];
+/// Current energy mode and the tick it was entered at
+static uint8_t current_em;
+static uint32_t em_enter_tick;
+/// Set on wakeup until the wakeup is attributed
+static bool awaiting_cause;
+/// Ongoing transmission and I2C transaction
+static bool tx_active;
+static uint32_t tx_start_tick;
+static uint64_t tx_ticks;
+static bool i2c_active;
+static uint32_t i2c_start_tick;
+static uint64_t i2c_ticks;
+/// Counters, the time fields are filled by app_energy_get_stats()
+static app_energy_stats_t counters;
+/// Wakeups since the last report
+static uint32_t wakeups_since_report;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Subscribes to the energy mode transitions of the power manager.
+ *****************************************************************************/
+void app_energy_init(void)
+{
+  app_energy_reset();
+#if defined(SL_CATALOG_POWER_MANAGER_PRESENT)
+  sl_power_manager_subscribe_em_transition_event(&em_transition_handle,
+                                                 &em_transition_info);
+#endif
+}
+
+/**************************************************************************//**
+ * Attributes the current wakeup.
+ *****************************************************************************/
+void app_energy_note_wakeup(app_energy_wakeup_cause_t cause)
+{
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  if (awaiting_cause && cause < APP_ENERGY_WAKEUP_CAUSE_COUNT) {
+    counters.wakeup_causes[cause]++;
+    awaiting_cause = false;
+  }
+  CORE_EXIT_CRITICAL();
+}
+
+/**************************************************************************//**
+ * Marks the start of a transmission.
+ *****************************************************************************/
+void app_energy_tx_start(void)
+{
+  tx_active = true;
+  tx_start_tick = sl_sleeptimer_get_tick_count();
+}
+
+/**************************************************************************//**
+ * Marks the end of a transmission.
+ *****************************************************************************/
+void app_energy_tx_done(void)
+{
+  if (tx_active) {
+    tx_ticks += (uint32_t)(sl_sleeptimer_get_tick_count() - tx_start_tick);
+    counters.tx_count++;
+    tx_active = false;
+  }
+}
+
+/**************************************************************************//**
+ * Accounts a received frame.
+ *****************************************************************************/
+void app_energy_note_rx(uint8_t length)
+{
+  counters.rx_count++;
+  counters.rx_bytes += length;
+}
+
+/**************************************************************************//**
+ * Marks the start of an I2C transaction.
+ *****************************************************************************/
+void app_energy_i2c_start(void)
+{
+  i2c_active = true;
+  i2c_start_tick = sl_sleeptimer_get_tick_count();
+}
+
+/**************************************************************************//**
+ * Marks the end of an I2C transaction.
+ *****************************************************************************/
+void app_energy_i2c_stop(void)
+{
+  if (i2c_active) {
+    i2c_ticks += (uint32_t)(sl_sleeptimer_get_tick_count() - i2c_start_tick);
+    counters.i2c_count++;
+    i2c_active = false;
+  }
+}
+
+/**************************************************************************//**
+ * Accounts a sensor report and closes its wakeup count.
+ *****************************************************************************/
+void app_energy_note_report(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  counters.reports++;
+  counters.report_wakeups += wakeups_since_report;
+  counters.last_report_wakeups = wakeups_since_report;
+  wakeups_since_report = 0;
+  CORE_EXIT_CRITICAL();
+}
+
+/**************************************************************************//**
+ * Tells whether a transmission is ongoing.
+ *****************************************************************************/
+bool app_energy_tx_in_flight(void)
+{
+  return tx_active;
+}
+
+/**************************************************************************//**
+ * Tells whether an I2C transaction is ongoing.
+ *****************************************************************************/
+bool app_energy_i2c_busy(void)
+{
+  return i2c_active;
+}
+
+/**************************************************************************//**
+ * Takes a snapshot of the metrics, the current energy mode included.
+ *****************************************************************************/
+void app_energy_get_stats(app_energy_stats_t *stats)
+{
+  uint64_t ticks[APP_ENERGY_EM_COUNT];
+  uint8_t i;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_CRITICAL();
+  MEMCOPY(ticks, em_ticks, sizeof(ticks));
+  ticks[current_em] += (uint32_t)(sl_sleeptimer_get_tick_count() - em_enter_tick);
+  *stats = counters;
+  CORE_EXIT_CRITICAL();
+
+  for (i = 0; i < APP_ENERGY_EM_COUNT; i++) {
+    stats->em_ms[i] = ticks_to_ms(ticks[i]);
+  }
+  stats->tx_ms = ticks_to_ms(tx_ticks);
+  stats->i2c_ms = ticks_to_ms(i2c_ticks);
+}
+
+/**************************************************************************//**
+ * Serializes the metrics.
+ *****************************************************************************/
+uint8_t app_energy_dump(uint8_t *buffer)
+{
+  app_energy_stats_t stats;
+  const uint32_t *field = (const uint32_t *)&stats;
+  uint8_t length = 0;
+  uint8_t i;
+
+  app_energy_get_stats(&stats);
+  buffer[length++] = APP_ENERGY_DUMP_VERSION;
+  buffer[length++] = APP_ENERGY_EM_COUNT;
+  // The metrics are only made of uint32_t fields.
+  for (i = 0; i < sizeof(stats) / sizeof(uint32_t); i++) {
+    emberStoreLowHighInt32u(buffer + length, field[i]);
+    length += 4;
+  }
+  return length;
+}
+
+/**************************************************************************//**
+ * Clears the metrics.
+ *****************************************************************************/
+void app_energy_reset(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+  CORE_ENTER_CRITICAL();
+  MEMSET(em_ticks, 0, sizeof(em_ticks));
+  MEMSET(&counters, 0, sizeof(counters));
+  em_enter_tick = sl_sleeptimer_get_tick_count();
+  tx_ticks = 0;
+  i2c_ticks = 0;
+  wakeups_since_report = 0;
+  CORE_EXIT_CRITICAL();
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+#if defined(SL_CATALOG_POWER_MANAGER_PRESENT)
+/**************************************************************************//**
+ * Power manager energy mode transition callback. It runs on the sleep path,
+ * so it only moves a few counters.
+ *****************************************************************************/
+static void on_em_transition(sl_power_manager_em_t from,
+                             sl_power_manager_em_t to)
+{
+  uint32_t now_tick = sl_sleeptimer_get_tick_count();
+
+  if (from < APP_ENERGY_EM_COUNT) {
+    em_ticks[from] += (uint32_t)(now_tick - em_enter_tick);
+  }
+  em_enter_tick = now_tick;
+  current_em = (to < APP_ENERGY_EM_COUNT) ? to : (APP_ENERGY_EM_COUNT - 1);
+
+  if (to == SL_POWER_MANAGER_EM0 && from != SL_POWER_MANAGER_EM0) {
+    app_trace_record(APP_TRACE_WAKE, (uint8_t)from, 0);
+    if (from < APP_ENERGY_EM_COUNT) {
+      counters.wakeups[from]++;
+    }
+    wakeups_since_report++;
+    awaiting_cause = true;
+  } else if (to != SL_POWER_MANAGER_EM0 && awaiting_cause) {
+    // Back to sleep without any application work.
+    counters.wakeup_causes[APP_ENERGY_WAKEUP_OTHER]++;
+    awaiting_cause = false;
+  }
+  if (to != SL_POWER_MANAGER_EM0 && from == SL_POWER_MANAGER_EM0) {
+    app_trace_record(APP_TRACE_SLEEP, (uint8_t)to, 0);
+  }
+}
+#endif
+
+/**************************************************************************//**
+ * Converts sleeptimer ticks to milliseconds.
+ *****************************************************************************/
+static uint32_t ticks_to_ms(uint64_t ticks)
+{
+  return (uint32_t)((ticks * MILLISECOND_TICKS_PER_SECOND)
+                    / sl_sleeptimer_get_timer_frequency());
+}
@@ -0,0 +1,135 @@
+/***************************************************************************//**
+ * @file app_energy.h
+ * @brief app_energy.h
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+#ifndef APP_ENERGY_H
+#define APP_ENERGY_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Energy modes accounted by the profiler (EM0 to EM3)
+#define APP_ENERGY_EM_COUNT        (4u)
+
+/// Version of the binary dump layout
+#define APP_ENERGY_DUMP_VERSION    (1u)
+/// Length of the binary dump
+#define APP_ENERGY_DUMP_LENGTH     (2 + 4 * (2 * APP_ENERGY_EM_COUNT + APP_ENERGY_WAKEUP_CAUSE_COUNT + 9))
+
+/// Wakeup causes, attributed by the first application hook after a wakeup
+typedef enum {
+  /// No application hook ran before the next sleep: stack or drivers
+  APP_ENERGY_WAKEUP_OTHER,
+  /// An application event fired
+  APP_ENERGY_WAKEUP_EVENT,
+  /// A frame was received
+  APP_ENERGY_WAKEUP_RADIO,
+  /// The button was pressed
+  APP_ENERGY_WAKEUP_BUTTON,
+  APP_ENERGY_WAKEUP_CAUSE_COUNT
+} app_energy_wakeup_cause_t;
+
+/// Energy profiler metrics, times in milliseconds
+typedef struct {
+  /// Residency in each energy mode
+  uint32_t em_ms[APP_ENERGY_EM_COUNT];
+  /// Wakeups from each energy mode
+  uint32_t wakeups[APP_ENERGY_EM_COUNT];
+  /// Wakeups per cause
+  uint32_t wakeup_causes[APP_ENERGY_WAKEUP_CAUSE_COUNT];
+  /// Frames sent and time from emberMessageSend() to the sent callback
+  uint32_t tx_count;
+  uint32_t tx_ms;
+  /// Frames and bytes received
+  uint32_t rx_count;
+  uint32_t rx_bytes;
+  /// I2C transactions and time spent in them
+  uint32_t i2c_count;
+  uint32_t i2c_ms;
+  /// Reports and wakeups between consecutive reports
+  uint32_t reports;
+  uint32_t report_wakeups;
+  uint32_t last_report_wakeups;
+} app_energy_stats_t;
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Subscribes to the energy mode transitions of the power manager.
+ *****************************************************************************/
+void app_energy_init(void);
+
+/**************************************************************************//**
+ * Attributes the current wakeup, only the first call after a wakeup counts.
+ *****************************************************************************/
+void app_energy_note_wakeup(app_energy_wakeup_cause_t cause);
+
+/**************************************************************************//**
+ * Marks the start and the end of a transmission.
+ *****************************************************************************/
+void app_energy_tx_start(void);
+void app_energy_tx_done(void);
+
+/**************************************************************************//**
+ * Accounts a received frame.
+ *****************************************************************************/
+void app_energy_note_rx(uint8_t length);
+
+/**************************************************************************//**
+ * Marks the start and the end of an I2C transaction.
+ *****************************************************************************/
+void app_energy_i2c_start(void);
+void app_energy_i2c_stop(void);
+
+/**************************************************************************//**
+ * Accounts a sensor report and closes its wakeup count.
+ *****************************************************************************/
+void app_energy_note_report(void);
+
+/**************************************************************************//**
+ * Tells whether a transmission or an I2C transaction is ongoing.
+ *****************************************************************************/
+bool app_energy_tx_in_flight(void);
+bool app_energy_i2c_busy(void);
+
+/**************************************************************************//**
+ * Takes a snapshot of the metrics, the current energy mode included.
+ *****************************************************************************/
+void app_energy_get_stats(app_energy_stats_t *stats);
+
+/**************************************************************************//**
+ * Serializes the metrics, little endian: version (1), energy mode count (1),
+ * then every field of app_energy_stats_t as 4 bytes in declaration order.
+ *
+ * @param *buffer holds at least APP_ENERGY_DUMP_LENGTH bytes
+ * @returns the length of the dump
+ *****************************************************************************/
+uint8_t app_energy_dump(uint8_t *buffer);
+
+/**************************************************************************//**
+ * Clears the metrics.
+ *****************************************************************************/
+void app_energy_reset(void);
+
+#endif  // APP_ENERGY_H
@@ -25,6 +25,13 @@
 #include "sl_i2cspm_instances.h"
 #include "sl_sleeptimer.h"
 #include "app_process.h"
+#include "app_poll.h"
+#include "app_energy.h"
+#include "app_sleep.h"
+#include "app_counters.h"
+#include "app_trace.h"
+#include "app_memory.h"
+#include "app_status_led.h"
 #include "app_framework_common.h"
 // -----------------------------------------------------------------------------
 //                              Macros and Typedefs
@@ -52,6 +59,8 @@ void emberAfInitCallback(void)
 {
   EmberStatus status;
   uint8_t device_id = 0;
+
+  app_memory_init();
   // init temperature sensor
   if (!sl_si70xx_present(sl_i2cspm_sensor, SI7021_ADDR, &device_id)) {
     // wait a bit before re-trying
@@ -66,12 +75,22 @@ void emberAfInitCallback(void)
   sl_si1133_init(sl_i2cspm_sensor);
 
   emberAfAllocateEvent(&report_control, &report_handler);
+  app_trace_init();
+  app_poll_init();
+  app_energy_init();
+  app_sleep_init();
+  app_counters_init();
+  app_status_led_init();
   // CLI info message
   APP_INFO("\nSensor\n");
 
   emberSetSecurityKey(&security_key);
   status = emberNetworkInit();
   APP_INFO("Network status 0x%02X\n", status);
+  if (status == EMBER_SUCCESS && !emberStackIsUp()) {
+    // Resuming the network saved in tokens, until EMBER_NETWORK_UP
+    app_status_led_set(APP_STATUS_LED_FORMING);
+  }
 
 #if defined(EMBER_AF_PLUGIN_BLE)
   bleConnectionInfoTableInit();
@@ -0,0 +1,240 @@
+/***************************************************************************//**
+ * @file app_poll.c
+ * @brief app_poll.c
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include PLATFORM_HEADER
+#include "stack/include/ember.h"
+#include "hal/hal.h"
+#include "poll.h"
+#include "poll-config.h"
+#include "sl_app_common.h"
+#include "app_framework_common.h"
+#include "app_poll.h"
+#include "app_trace.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Switches to short polling or extends it.
+ *
+ * @param window_ms is the minimum time to keep short polling from now on
+ * @returns true if the controller was not short polling before.
+ *****************************************************************************/
+static bool start_short_polling(uint32_t window_ms);
+
+/**************************************************************************//**
+ * Moves to a state, accounting the time spent in the previous one.
+ *****************************************************************************/
+static void enter_state(app_poll_state_t new_state);
+
+/**************************************************************************//**
+ * Tells whether the node polls, i.e. it joined as a sleepy end device.
+ *****************************************************************************/
+static bool is_sleepy(void);
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+/// Poll controller event control
+EmberEventControl *poll_control;
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+/// Current state of the controller
+static app_poll_state_t state = APP_POLL_STATE_LONG;
+/// Start of the current state
+static uint32_t state_start_ms;
+/// Start and length of the short polling window
+static uint32_t short_start_ms;
+static uint32_t short_window_ms;
+/// Long poll interval of the current decay step
+static uint16_t decay_interval_s = EMBER_AF_PLUGIN_POLL_LONG_POLL_INTERVAL_S;
+/// Controller metrics
+static app_poll_stats_t stats;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Allocates the controller event and restores long polling.
+ *****************************************************************************/
+void app_poll_init(void)
+{
+  emberAfAllocateEvent(&poll_control, &poll_handler);
+  state = APP_POLL_STATE_LONG;
+  state_start_ms = halCommonGetInt32uMillisecondTick();
+  decay_interval_s = EMBER_AF_PLUGIN_POLL_LONG_POLL_INTERVAL_S;
+  emberAfPluginPollSetLongPollInterval(EMBER_AF_PLUGIN_POLL_LONG_POLL_INTERVAL_S);
+  emberAfPluginPollEnableShortPolling(false);
+}
+
+/**************************************************************************//**
+ * Tells the controller that a frame was sent to the sink.
+ *****************************************************************************/
+void app_poll_note_tx(void)
+{
+  if (is_sleepy() && start_short_polling(APP_POLL_TX_WINDOW_MS)) {
+    stats.short_after_tx++;
+  }
+}
+
+/**************************************************************************//**
+ * Tells the controller that the sink holds frames for this sensor.
+ *****************************************************************************/
+void app_poll_note_pending(void)
+{
+  if (is_sleepy() && start_short_polling(APP_POLL_PENDING_WINDOW_MS)) {
+    stats.short_on_pending++;
+  }
+}
+
+/**************************************************************************//**
+ * Tells the controller that a frame was received from the sink.
+ *****************************************************************************/
+void app_poll_note_downlink(bool pending)
+{
+  stats.downlinks[state]++;
+  if (pending) {
+    app_poll_note_pending();
+  }
+}
+
+/**************************************************************************//**
+ * Returns the current state of the controller.
+ *****************************************************************************/
+app_poll_state_t app_poll_get_state(uint16_t *interval_s)
+{
+  *interval_s = decay_interval_s;
+  return state;
+}
+
+/**************************************************************************//**
+ * Returns the metrics of the controller.
+ *****************************************************************************/
+const app_poll_stats_t *app_poll_get_stats(void)
+{
+  enter_state(state);
+  return &stats;
+}
+
+/**************************************************************************//**
+ * Clears the metrics of the controller.
+ *****************************************************************************/
+void app_poll_reset_stats(void)
+{
+  MEMSET(&stats, 0, sizeof(stats));
+  state_start_ms = halCommonGetInt32uMillisecondTick();
+}
+
+/**************************************************************************//**
+ * Event handler that ends short polling and steps the decay. Instead of
+ * falling back to the long poll interval at once, the interval doubles from
+ * APP_POLL_DECAY_START_S, so a late answer of the sink is still picked up
+ * reasonably fast.
+ *****************************************************************************/
+void poll_handler(void)
+{
+  emberEventControlSetInactive(*poll_control);
+  app_trace_record(APP_TRACE_EVENT, APP_TRACE_EVENT_POLL, 0);
+
+  if (state == APP_POLL_STATE_SHORT) {
+    emberAfPluginPollEnableShortPolling(false);
+    decay_interval_s = APP_POLL_DECAY_START_S;
+    enter_state(APP_POLL_STATE_DECAY);
+  } else if (state == APP_POLL_STATE_DECAY) {
+    if (decay_interval_s > EMBER_AF_PLUGIN_POLL_LONG_POLL_INTERVAL_S / 2) {
+      decay_interval_s = EMBER_AF_PLUGIN_POLL_LONG_POLL_INTERVAL_S;
+    } else {
+      decay_interval_s *= 2;
+    }
+  } else {
+    return;
+  }
+
+  if (decay_interval_s >= EMBER_AF_PLUGIN_POLL_LONG_POLL_INTERVAL_S) {
+    decay_interval_s = EMBER_AF_PLUGIN_POLL_LONG_POLL_INTERVAL_S;
+    emberAfPluginPollSetLongPollInterval(decay_interval_s);
+    enter_state(APP_POLL_STATE_LONG);
+  } else {
+    emberAfPluginPollSetLongPollInterval(decay_interval_s);
+    emberEventControlSetDelayMS(*poll_control,
+                                (uint32_t)decay_interval_s
+                                * APP_POLL_DECAY_POLLS_PER_STEP
+                                * MILLISECOND_TICKS_PER_SECOND);
+  }
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Switches to short polling or extends it.
+ *****************************************************************************/
+static bool start_short_polling(uint32_t window_ms)
+{
+  uint32_t now_ms = halCommonGetInt32uMillisecondTick();
+  bool switched = (state != APP_POLL_STATE_SHORT);
+
+  if (window_ms == 0) {
+    return false;
+  }
+
+  if (!switched) {
+    uint32_t elapsed_ms = elapsedTimeInt32u(short_start_ms, now_ms);
+    // Keep the current window if it ends later.
+    if (elapsed_ms < short_window_ms
+        && window_ms <= short_window_ms - elapsed_ms) {
+      return false;
+    }
+  } else {
+    emberAfPluginPollEnableShortPolling(true);
+    enter_state(APP_POLL_STATE_SHORT);
+  }
+
+  short_start_ms = now_ms;
+  short_window_ms = window_ms;
+  emberEventControlSetDelayMS(*poll_control, window_ms);
+  return switched;
+}
+
+/**************************************************************************//**
+ * Moves to a state, accounting the time spent in the previous one.
+ *****************************************************************************/
+static void enter_state(app_poll_state_t new_state)
+{
+  uint32_t now_ms = halCommonGetInt32uMillisecondTick();
+  stats.state_ms[state] += elapsedTimeInt32u(state_start_ms, now_ms);
+  state_start_ms = now_ms;
+  state = new_state;
+}
+
+/**************************************************************************//**
+ * Tells whether the node polls, i.e. it joined as a sleepy end device.
+ *****************************************************************************/
+static bool is_sleepy(void)
+{
+  return (emberStackIsUp()
+          && emberGetNodeType() == EMBER_STAR_SLEEPY_END_DEVICE);
+}
@@ -0,0 +1,101 @@
+/***************************************************************************//**
+ * @file app_poll.h
+ * @brief app_poll.h
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+#ifndef APP_POLL_H
+#define APP_POLL_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include "poll-controller-config.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Polling states of the controller
+typedef enum {
+  APP_POLL_STATE_LONG,
+  APP_POLL_STATE_SHORT,
+  APP_POLL_STATE_DECAY,
+  APP_POLL_STATE_COUNT
+} app_poll_state_t;
+
+/// Poll controller metrics
+typedef struct {
+  /// Time spent in each state
+  uint32_t state_ms[APP_POLL_STATE_COUNT];
+  /// Switches to short polling, after a TX or on pending data
+  uint32_t short_after_tx;
+  uint32_t short_on_pending;
+  /// Downlinks received in each state
+  uint32_t downlinks[APP_POLL_STATE_COUNT];
+} app_poll_stats_t;
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+/// Poll controller event control
+extern EmberEventControl *poll_control;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Allocates the controller event and restores long polling.
+ *****************************************************************************/
+void app_poll_init(void);
+
+/**************************************************************************//**
+ * Tells the controller that a frame was sent to the sink.
+ *****************************************************************************/
+void app_poll_note_tx(void);
+
+/**************************************************************************//**
+ * Tells the controller that the sink holds frames for this sensor.
+ *****************************************************************************/
+void app_poll_note_pending(void);
+
+/**************************************************************************//**
+ * Tells the controller that a frame was received from the sink.
+ *
+ * @param pending is true if the frame flags more pending frames
+ *****************************************************************************/
+void app_poll_note_downlink(bool pending);
+
+/**************************************************************************//**
+ * Returns the current state of the controller.
+ *
+ * @param *interval_s is set to the current long poll interval
+ *****************************************************************************/
+app_poll_state_t app_poll_get_state(uint16_t *interval_s);
+
+/**************************************************************************//**
+ * Returns the metrics of the controller, the time of the current state
+ * included.
+ *****************************************************************************/
+const app_poll_stats_t *app_poll_get_stats(void);
+
+/**************************************************************************//**
+ * Clears the metrics of the controller.
+ *****************************************************************************/
+void app_poll_reset_stats(void);
+
+/**************************************************************************//**
+ * Event handler that ends short polling and steps the decay.
+ *****************************************************************************/
+void poll_handler(void);
+
+#endif  // APP_POLL_H
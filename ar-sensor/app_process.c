@@ -29,10 +29,15 @@
 #include "poll.h"
 #include "sl_app_common.h"
 #include "app_process.h"
+#include "app_protocol.h"
+#include "app_poll.h"
+#include "app_energy.h"
+#include "app_sleep.h"
+#include "app_clock.h"
+#include "app_trace.h"
+#include "app_memory.h"
+#include "app_status_led.h"
 #include "app_framework_common.h"
-#if defined(SL_CATALOG_LED0_PRESENT)
-#include "sl_simple_led_instances.h"
-#endif
 
 #include "sl_simple_button_instances.h"
 
@@ -40,15 +45,33 @@
 //                              Macros and Typedefs
 // -----------------------------------------------------------------------------
 #define MAX_TX_FAILURES     (10u)
+/// Delay of a report while the radio sits on a channel excluded by the sink
+#define CHANNEL_RECHECK_MS  (50u)
 // -----------------------------------------------------------------------------
 //                          Static Function Declarations
 // -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Parses the TLV payload of an advertisement from the sink.
+ *****************************************************************************/
+static void parse_advertise_payload(const uint8_t *buffer, uint8_t length);
+
+/**************************************************************************//**
+ * Tells whether the sink excluded the current channel.
+ *****************************************************************************/
+static bool current_channel_excluded(void);
+
+/**************************************************************************//**
+ * Appends the timing TLV element of a report.
+ *
+ * @param *buffer is the output
+ * @param sample_ms is the time the sensors were sampled at
+ * @returns the length of the element.
+ *****************************************************************************/
+static uint8_t append_timing(uint8_t *buffer, uint32_t sample_ms);
 
 // -----------------------------------------------------------------------------
 //                                Global Variables
 // -----------------------------------------------------------------------------
-/// Global flag set by a button push to allow or disallow entering to sleep
-bool enable_sleep = false;
 /// report timing event control
 EmberEventControl *report_control;
 /// report timing period
@@ -61,14 +84,26 @@ EmberMessageOptions tx_options = EMBER_OPTIONS_ACK_REQUESTED | EMBER_OPTIONS_SEC
 // -----------------------------------------------------------------------------
 /// Destination of the currently processed sink node
 static EmberNodeId sink_node_id = EMBER_NULL_NODE_ID;
+/// Hopping channels excluded by the sink, see APP_ADVERTISE_TLV_CHANNEL_MAP
+static uint16_t excluded_first_channel = 0;
+static uint8_t excluded_bitmap[APP_CHANNEL_MAP_MAX_BITMAP_LENGTH];
+static uint8_t excluded_bitmap_length = 0;
+/// Send time of the pending report and radio delay of the last one
+static bool report_in_flight = false;
+static uint32_t report_send_ms;
+static uint16_t last_report_tx_ms = 0;
+/// Sequence number of the next report, see APP_DATA_TLV_SEQUENCE
+static uint32_t report_sequence = 0;
 
 // -----------------------------------------------------------------------------
 //                          Public Function Definitions
 // -----------------------------------------------------------------------------
 void sl_button_on_change(const sl_button_t *handle)
 {
+  app_energy_note_wakeup(APP_ENERGY_WAKEUP_BUTTON);
   if (sl_button_get_state(handle) == SL_SIMPLE_BUTTON_PRESSED) {
-    enable_sleep = !enable_sleep;
+    // Debug override, the low-power policy decides otherwise.
+    app_sleep_toggle_override();
   }
 }
 
@@ -78,19 +113,34 @@ void sl_button_on_change(const sl_button_t *handle)
  *****************************************************************************/
 void report_handler(void)
 {
+  app_energy_note_wakeup(APP_ENERGY_WAKEUP_EVENT);
+  app_trace_record(APP_TRACE_EVENT, APP_TRACE_EVENT_REPORT, 0);
   if (!emberStackIsUp()) {
     emberEventControlSetInactive(*report_control);
+  } else if (current_channel_excluded()) {
+    // Wait for the radio to hop to a channel the sink can hear on.
+    emberEventControlSetDelayMS(*report_control, CHANNEL_RECHECK_MS);
   } else {
     EmberStatus status;
     EmberStatus sensor_status = EMBER_SUCCESS;
-    uint8_t buffer[SENSOR_SINK_DATA_LENGTH];
+    uint8_t buffer[SENSOR_SINK_DATA_OFFSET + SENSOR_SINK_DATA_LENGTH
+                   + APP_TLV_VALUE_OFFSET + APP_DATA_TIMING_LENGTH
+                   + APP_TLV_VALUE_OFFSET + APP_TIME_LENGTH
+                   + APP_TLV_VALUE_OFFSET + APP_PARENT_LENGTH
+                   + APP_TLV_VALUE_OFFSET + APP_SEQUENCE_LENGTH];
+    uint8_t length;
     int32_t temp_data = 0;
     uint32_t rh_data = 0;
+    uint32_t sample_ms = halCommonGetInt32uMillisecondTick();
+    uint32_t sample_network_ms;
+    bool time_synced = app_clock_get_network_ms(&sample_network_ms);
     uint8_t i;
 
     // Sample temperature and humidity from sensors.
     // Temperature is sampled in "millicelsius".
     #ifndef UNIX_HOST
+    app_energy_i2c_start();
+    app_trace_record(APP_TRACE_I2C_START, 0, 0);
     if (sl_si70xx_measure_rh_and_temp(sl_i2cspm_sensor,
                                       SI7021_ADDR,
                                       &rh_data,
@@ -108,22 +158,63 @@ void report_handler(void)
     } else  {
         APP_INFO("Warning! Invalid si1133 reading\n");
     }
+    app_energy_i2c_stop();
+    app_trace_record(APP_TRACE_I2C_STOP, (sensor_status == EMBER_SUCCESS), 0);
 
     #endif
 
     if (sensor_status == EMBER_SUCCESS) {
-      emberStoreLowHighInt32u(buffer, temp_data);
-      emberStoreLowHighInt32u(buffer + 4, rh_data);
+      emberStoreLowHighInt16u(buffer + SENSOR_SINK_PROTOCOL_ID_OFFSET,
+                              SENSOR_SINK_PROTOCOL_ID);
+      buffer[SENSOR_SINK_COMMAND_ID_OFFSET] = SENSOR_SINK_COMMAND_ID_DATA;
+      MEMCOPY(buffer + SENSOR_SINK_EUI64_OFFSET, emberGetEui64(), EUI64_SIZE);
+      emberStoreLowHighInt16u(buffer + SENSOR_SINK_NODE_ID_OFFSET,
+                              emberGetNodeId());
+      length = SENSOR_SINK_DATA_OFFSET;
+      emberStoreLowHighInt32u(buffer + length, temp_data);
+      emberStoreLowHighInt32u(buffer + length + 4, rh_data);
+      length += SENSOR_SINK_DATA_LENGTH;
+      length += append_timing(buffer + length, sample_ms);
+      if (time_synced) {
+        buffer[length + APP_TLV_TYPE_OFFSET] = APP_DATA_TLV_SAMPLE_TIME;
+        buffer[length + APP_TLV_LENGTH_OFFSET] = APP_TIME_LENGTH;
+        emberStoreLowHighInt32u(buffer + length + APP_TLV_VALUE_OFFSET,
+                                sample_network_ms);
+        length += APP_TLV_VALUE_OFFSET + APP_TIME_LENGTH;
+      }
+      // Lets the sink map sensors behind range extenders.
+      buffer[length + APP_TLV_TYPE_OFFSET] = APP_DATA_TLV_PARENT;
+      buffer[length + APP_TLV_LENGTH_OFFSET] = APP_PARENT_LENGTH;
+      emberStoreLowHighInt16u(buffer + length + APP_TLV_VALUE_OFFSET,
+                              emberGetParentId());
+      length += APP_TLV_VALUE_OFFSET + APP_PARENT_LENGTH;
+      // Lets hosts drop the copies of the report heard by other sinks.
+      buffer[length + APP_TLV_TYPE_OFFSET] = APP_DATA_TLV_SEQUENCE;
+      buffer[length + APP_TLV_LENGTH_OFFSET] = APP_SEQUENCE_LENGTH;
+      emberStoreLowHighInt32u(buffer + length + APP_TLV_VALUE_OFFSET,
+                              report_sequence++);
+      length += APP_TLV_VALUE_OFFSET + APP_SEQUENCE_LENGTH;
 
+      app_energy_note_report();
       status = emberMessageSend(sink_node_id,
                                 0, // endpoint
                                 0, // messageTag
-                                SENSOR_SINK_DATA_LENGTH,
+                                length,
                                 buffer,
                                 tx_options);
+      if (status == EMBER_SUCCESS) {
+        // The stack holds its copy of the report until the completion.
+        app_memory_sample();
+        report_in_flight = true;
+        report_send_ms = halCommonGetInt32uMillisecondTick();
+        app_energy_tx_start();
+        app_trace_record(APP_TRACE_TX, SENSOR_SINK_COMMAND_ID_DATA, sink_node_id);
+        // The sink may answer, keep polling for a while.
+        app_poll_note_tx();
+      }
 
       APP_INFO("TX: Data to 0x%04X:", sink_node_id);
-      for (i = 0; i < SENSOR_SINK_DATA_LENGTH; i++) {
+      for (i = SENSOR_SINK_DATA_OFFSET; i < length; i++) {
         APP_INFO(" %02X", buffer[i]);
       }
       APP_INFO(": 0x%02X\n", status);
@@ -133,14 +224,12 @@ void report_handler(void)
 }
 
 /**************************************************************************//**
- * Entering sleep is approved or denied in this callback, depending on user
- * demand.
+ * Entering sleep is approved or denied in this callback by the low-power
+ * policy, unless the debug override is active.
  *****************************************************************************/
 bool emberAfCommonOkToEnterLowPowerCallback(bool enter_em2, uint32_t duration_ms)
 {
-  (void) enter_em2;
-  (void) duration_ms;
-  return enable_sleep;
+  return app_sleep_ok_to_enter(enter_em2, duration_ms);
 }
 
 /**************************************************************************//**
@@ -149,11 +238,81 @@ bool emberAfCommonOkToEnterLowPowerCallback(bool enter_em2, uint32_t duration_ms
 void emberAfIncomingMessageCallback(EmberIncomingMessage *message)
 {
   uint8_t i;
+  // The received message still holds its buffers.
+  app_memory_sample();
+  app_energy_note_wakeup(APP_ENERGY_WAKEUP_RADIO);
+  app_energy_note_rx(message->length);
+  app_trace_record(APP_TRACE_RX,
+                   (message->length > SENSOR_SINK_COMMAND_ID_OFFSET)
+                   ? message->payload[SENSOR_SINK_COMMAND_ID_OFFSET] : 0xFF,
+                   message->source);
   APP_INFO("RX: Data from 0x%04X:", message->source);
   for (i = SENSOR_SINK_DATA_OFFSET; i < message->length; i++) {
     APP_INFO(" %x", message->payload[i]);
   }
   APP_INFO("\n");
+
+  if (message->length < SENSOR_SINK_MINIMUM_LENGTH
+      || (emberFetchLowHighInt16u(message->payload + SENSOR_SINK_PROTOCOL_ID_OFFSET)
+          != SENSOR_SINK_PROTOCOL_ID)) {
+    return;
+  }
+
+  switch (message->payload[SENSOR_SINK_COMMAND_ID_OFFSET]) {
+    case SENSOR_SINK_COMMAND_ID_ADVERTISE:
+      sink_node_id = message->source;
+      app_poll_note_downlink(false);
+      parse_advertise_payload(message->payload + SENSOR_SINK_DATA_OFFSET,
+                              message->length - SENSOR_SINK_DATA_OFFSET);
+      break;
+    case APP_COMMAND_ID_CONFIGURE:
+      if (message->length >= SENSOR_SINK_DATA_OFFSET + APP_CONFIGURE_LENGTH) {
+        uint16_t report_period_ms =
+          emberFetchLowHighInt16u(message->payload
+                                  + SENSOR_SINK_DATA_OFFSET
+                                  + APP_CONFIGURE_REPORT_PERIOD_OFFSET);
+        sink_node_id = message->source;
+        app_poll_note_downlink((message->payload[SENSOR_SINK_DATA_OFFSET
+                                                 + APP_DOWNLINK_FLAGS_OFFSET]
+                                & APP_DOWNLINK_FLAG_PENDING) != 0);
+        // A shorter period would keep the report event busy.
+        if (report_period_ms < APP_CONFIGURE_MIN_REPORT_PERIOD_MS) {
+          APP_INFO("RX: Configure from 0x%04X, report period %d ms rejected\n",
+                   message->source,
+                   report_period_ms);
+          break;
+        }
+        sensor_report_period_ms = report_period_ms;
+        APP_INFO("RX: Configure from 0x%04X, report period %d ms\n",
+                 message->source,
+                 sensor_report_period_ms);
+      }
+      break;
+    case APP_COMMAND_ID_PERMIT_JOIN:
+      if (message->length >= SENSOR_SINK_DATA_OFFSET + APP_PERMIT_JOIN_PAYLOAD_OFFSET
+          && emberGetNodeType() == EMBER_STAR_RANGE_EXTENDER) {
+        const uint8_t *payload = message->payload + SENSOR_SINK_DATA_OFFSET;
+        uint8_t join_payload_length = message->length - SENSOR_SINK_DATA_OFFSET
+                                      - APP_PERMIT_JOIN_PAYLOAD_OFFSET;
+        // The sink picked this extender as the parent of the next sensors.
+        if (join_payload_length > 0) {
+          emberSetSelectiveJoinPayload(join_payload_length,
+                                       (uint8_t *)payload + APP_PERMIT_JOIN_PAYLOAD_OFFSET);
+        } else {
+          emberClearSelectiveJoinPayload();
+        }
+        emberPermitJoining(payload[APP_PERMIT_JOIN_DURATION_OFFSET]);
+        app_status_led_permit_join(payload[APP_PERMIT_JOIN_DURATION_OFFSET]);
+        APP_INFO("RX: Permit join from 0x%04X for %d s\n",
+                 message->source,
+                 payload[APP_PERMIT_JOIN_DURATION_OFFSET]);
+      }
+      app_poll_note_downlink(false);
+      break;
+    default:
+      app_poll_note_downlink(false);
+      break;
+  }
 }
 
 /**************************************************************************//**
@@ -163,7 +322,14 @@ void emberAfIncomingMessageCallback(EmberIncomingMessage *message)
 void emberAfMessageSentCallback(EmberStatus status,
                                 EmberOutgoingMessage *message)
 {
-  (void) message;
+  app_energy_tx_done();
+  app_trace_record(APP_TRACE_TX_DONE, status, message->destination);
+  if (report_in_flight) {
+    uint32_t tx_ms = elapsedTimeInt32u(report_send_ms,
+                                       halCommonGetInt32uMillisecondTick());
+    last_report_tx_ms = (tx_ms > UINT16_MAX) ? UINT16_MAX : (uint16_t)tx_ms;
+    report_in_flight = false;
+  }
   if (status != EMBER_SUCCESS) {
     APP_INFO("TX: 0x%02X\n", status);
   }
@@ -178,23 +344,33 @@ void emberAfStackStatusCallback(EmberStatus status)
     case EMBER_NETWORK_UP:
       APP_INFO("Network up\n");
       APP_INFO("Joined to Sink with node ID: 0x%04X\n", emberGetNodeId());
+      app_status_led_set(APP_STATUS_LED_JOINED);
       // Schedule start of periodic sensor reporting to the Sink
       emberEventControlSetDelayMS(*report_control, sensor_report_period_ms);
       break;
     case EMBER_NETWORK_DOWN:
       APP_INFO("Network down\n");
+      app_status_led_set(APP_STATUS_LED_OFF);
+      app_clock_reset();
       break;
     case EMBER_JOIN_SCAN_FAILED:
       APP_INFO("Scanning during join failed\n");
+      app_status_led_set(APP_STATUS_LED_OFF);
+      app_status_led_show(APP_STATUS_LED_ERROR, APP_STATUS_LED_ERROR_MS);
       break;
     case EMBER_JOIN_DENIED:
       APP_INFO("Joining to the network rejected!\n");
+      app_status_led_set(APP_STATUS_LED_OFF);
+      app_status_led_show(APP_STATUS_LED_ERROR, APP_STATUS_LED_ERROR_MS);
       break;
     case EMBER_JOIN_TIMEOUT:
       APP_INFO("Join process timed out!\n");
+      app_status_led_set(APP_STATUS_LED_OFF);
+      app_status_led_show(APP_STATUS_LED_ERROR, APP_STATUS_LED_ERROR_MS);
       break;
     default:
       APP_INFO("Stack status: 0x%02X\n", status);
+      app_status_led_show(APP_STATUS_LED_ERROR, APP_STATUS_LED_ERROR_MS);
       break;
   }
 }
@@ -205,12 +381,9 @@ void emberAfStackStatusCallback(EmberStatus status)
  *****************************************************************************/
 void emberAfTickCallback(void)
 {
-#if defined(SL_CATALOG_LED0_PRESENT)
-  if (emberStackIsUp()) {
-    sl_led_turn_on(&sl_led_led0);
-  } else {
-    sl_led_turn_off(&sl_led_led0);
-  }
+  // The status LED follows the stack status callbacks instead of a poll.
+#if APP_STATUS_LED_LOOP_METER
+  app_status_led_loop_tick();
 #endif
 }
 
@@ -269,3 +442,98 @@ void emberAfPluginMicriumRtosAppTask1MainLoopCallback(void *p_arg)
 }
 
 #endif // EMBER_AF_PLUGIN_MICRIUM_RTOS && EMBER_AF_PLUGIN_MICRIUM_RTOS_APP_TASK1
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Parses the TLV payload of an advertisement from the sink.
+ *****************************************************************************/
+static void parse_advertise_payload(const uint8_t *buffer, uint8_t length)
+{
+  uint8_t offset = 0;
+  uint8_t i;
+  bool channel_map_found = false;
+
+  while (offset + APP_TLV_VALUE_OFFSET <= length) {
+    uint8_t type = buffer[offset + APP_TLV_TYPE_OFFSET];
+    uint8_t value_length = buffer[offset + APP_TLV_LENGTH_OFFSET];
+    const uint8_t *value = buffer + offset + APP_TLV_VALUE_OFFSET;
+
+    if (offset + APP_TLV_VALUE_OFFSET + value_length > length) {
+      break;
+    }
+
+    switch (type) {
+      case APP_ADVERTISE_TLV_PENDING:
+        for (i = 0; i + 1 < value_length; i += 2) {
+          if (emberFetchLowHighInt16u(value + i) == emberGetNodeId()) {
+            app_poll_note_pending();
+            break;
+          }
+        }
+        break;
+      case APP_ADVERTISE_TLV_TIME:
+        if (value_length >= APP_TIME_LENGTH) {
+          app_clock_sync(emberFetchLowHighInt32u(value));
+        }
+        break;
+      case APP_ADVERTISE_TLV_CHANNEL_MAP:
+        if (value_length >= 2) {
+          channel_map_found = true;
+          excluded_first_channel = emberFetchLowHighInt16u(value);
+          excluded_bitmap_length = value_length - 2;
+          if (excluded_bitmap_length > APP_CHANNEL_MAP_MAX_BITMAP_LENGTH) {
+            excluded_bitmap_length = APP_CHANNEL_MAP_MAX_BITMAP_LENGTH;
+          }
+          MEMCOPY(excluded_bitmap, value + 2, excluded_bitmap_length);
+        }
+        break;
+      default:
+        // Unknown elements are skipped.
+        break;
+    }
+    offset += APP_TLV_VALUE_OFFSET + value_length;
+  }
+
+  // The sink omits the element once every channel is usable again.
+  if (!channel_map_found) {
+    excluded_bitmap_length = 0;
+  }
+}
+
+/**************************************************************************//**
+ * Tells whether the sink excluded the current channel.
+ *****************************************************************************/
+static bool current_channel_excluded(void)
+{
+  uint16_t channel = emberGetRadioChannel();
+  uint16_t index;
+
+  if (channel < excluded_first_channel) {
+    return false;
+  }
+  index = channel - excluded_first_channel;
+  return (index / 8 < excluded_bitmap_length
+          && (excluded_bitmap[index / 8] & (1u << (index % 8))) != 0);
+}
+
+/**************************************************************************//**
+ * Appends the timing TLV element of a report: age of the sample and radio
+ * delay of the previous report, both saturated to 16 bits.
+ *****************************************************************************/
+static uint8_t append_timing(uint8_t *buffer, uint32_t sample_ms)
+{
+  uint32_t age_ms = elapsedTimeInt32u(sample_ms,
+                                      halCommonGetInt32uMillisecondTick());
+
+  buffer[APP_TLV_TYPE_OFFSET] = APP_DATA_TLV_TIMING;
+  buffer[APP_TLV_LENGTH_OFFSET] = APP_DATA_TIMING_LENGTH;
+  emberStoreLowHighInt16u(buffer + APP_TLV_VALUE_OFFSET
+                          + APP_DATA_TIMING_SAMPLE_AGE_OFFSET,
+                          (age_ms > UINT16_MAX) ? UINT16_MAX : (uint16_t)age_ms);
+  emberStoreLowHighInt16u(buffer + APP_TLV_VALUE_OFFSET
+                          + APP_DATA_TIMING_LAST_TX_OFFSET,
+                          last_report_tx_ms);
+  return APP_TLV_VALUE_OFFSET + APP_DATA_TIMING_LENGTH;
+}
@@ -28,8 +28,6 @@
 // -----------------------------------------------------------------------------
 //                                Global Variables
 // -----------------------------------------------------------------------------
-/// Global flag set by a button push to allow or disallow entering to sleep
-extern bool enable_sleep;
 
 // -----------------------------------------------------------------------------
 //                          Public Function Declarations
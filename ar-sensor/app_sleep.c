@@ -0,0 +1,221 @@
+/***************************************************************************//**
+ * @file app_sleep.c
+ * @brief app_sleep.c
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include PLATFORM_HEADER
+#include "stack/include/ember.h"
+#include "hal/hal.h"
+#include "em_core.h"
+#include "em_gpio.h"
+#include "em_usart.h"
+#include "gpiointerrupt.h"
+#include "sl_component_catalog.h"
+#if defined(SL_CATALOG_POWER_MANAGER_PRESENT)
+#include "sl_power_manager.h"
+#endif
+#include "sl_iostream_usart_vcom_config.h"
+#include "app_energy.h"
+#include "app_sleep.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// External interrupt used on the VCOM RX pin, same number as the pin
+#define CLI_RX_INTERRUPT     (SL_IOSTREAM_USART_VCOM_RX_PIN)
+
+// -----------------------------------------------------------------------------
+//                          Static Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * VCOM RX line interrupt callback.
+ *****************************************************************************/
+static void cli_rx_callback(uint8_t interrupt);
+
+/**************************************************************************//**
+ * Holds the EM1 requirement while the VCOM transmits or the CLI is active,
+ * releases it once both are idle.
+ *
+ * @returns true if the requirement is held.
+ *****************************************************************************/
+static bool update_vcom_requirement(void);
+
+/**************************************************************************//**
+ * Takes the EM1 requirement of the VCOM, if not held yet.
+ *****************************************************************************/
+static void require_vcom(void);
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                                Static Variables
+// -----------------------------------------------------------------------------
+/// Debug override keeping the device awake
+static bool force_awake = false;
+/// Time of the last activity on the VCOM RX line
+static volatile uint32_t cli_activity_ms;
+/// Number of times each outcome was picked
+static uint32_t decisions[APP_SLEEP_DECISION_COUNT];
+/// EM1 requirement of the VCOM held
+static volatile bool vcom_required = false;
+
+// -----------------------------------------------------------------------------
+//                          Public Function Definitions
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Starts watching the VCOM RX line for CLI activity. The USART does not
+ * receive in EM2, the falling edge of the start bit wakes the device up and
+ * an EM1 requirement keeps the USART running for APP_SLEEP_CLI_HOLD_MS.
+ *****************************************************************************/
+void app_sleep_init(void)
+{
+  // Keep the CLI usable right after boot.
+  cli_activity_ms = halCommonGetInt32uMillisecondTick();
+  require_vcom();
+  GPIOINT_CallbackRegister(CLI_RX_INTERRUPT, cli_rx_callback);
+  GPIO_ExtIntConfig(SL_IOSTREAM_USART_VCOM_RX_PORT,
+                    SL_IOSTREAM_USART_VCOM_RX_PIN,
+                    CLI_RX_INTERRUPT,
+                    false,
+                    true,
+                    true);
+}
+
+/**************************************************************************//**
+ * Picks the deepest safe energy mode. EM1 keeps every peripheral running, so
+ * only the override prevents it. EM2 additionally needs an idle VCOM, radio
+ * and I2C bus and enough time to the next event to pay off. The VCOM holds
+ * an EM1 requirement while it is busy, so that the power manager does not
+ * even try EM2.
+ *****************************************************************************/
+bool app_sleep_ok_to_enter(bool enter_em2, uint32_t duration_ms)
+{
+  app_sleep_decision_t decision;
+  bool vcom_busy = update_vcom_requirement();
+
+  if (force_awake) {
+    decision = APP_SLEEP_DENIED_OVERRIDE;
+  } else if (!enter_em2) {
+    // Allowed whatever the VCOM does, it holds EM1 at most.
+    decision = APP_SLEEP_DECISION_EM1;
+  } else if (vcom_busy) {
+    decision = APP_SLEEP_DENIED_CLI;
+  } else if (app_energy_tx_in_flight() || app_energy_i2c_busy()) {
+    decision = APP_SLEEP_DENIED_BUSY;
+  } else if (duration_ms < APP_SLEEP_MIN_EM2_MS) {
+    decision = APP_SLEEP_DENIED_SHORT;
+  } else {
+    decision = APP_SLEEP_DECISION_EM2;
+  }
+
+  decisions[decision]++;
+  return (decision == APP_SLEEP_DECISION_EM2
+          || decision == APP_SLEEP_DECISION_EM1);
+}
+
+/**************************************************************************//**
+ * Toggles the debug override that keeps the device in EM0.
+ *****************************************************************************/
+bool app_sleep_toggle_override(void)
+{
+  force_awake = !force_awake;
+  return force_awake;
+}
+
+/**************************************************************************//**
+ * Tells whether the debug override is active.
+ *****************************************************************************/
+bool app_sleep_get_override(void)
+{
+  return force_awake;
+}
+
+/**************************************************************************//**
+ * Returns the number of times each outcome was picked.
+ *****************************************************************************/
+const uint32_t *app_sleep_get_decisions(void)
+{
+  return decisions;
+}
+
+/**************************************************************************//**
+ * Clears the decision counters.
+ *****************************************************************************/
+void app_sleep_reset_decisions(void)
+{
+  MEMSET(decisions, 0, sizeof(decisions));
+}
+
+// -----------------------------------------------------------------------------
+//                          Static Function Definitions
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * VCOM RX line interrupt callback.
+ *****************************************************************************/
+static void cli_rx_callback(uint8_t interrupt)
+{
+  (void) interrupt;
+  cli_activity_ms = halCommonGetInt32uMillisecondTick();
+  require_vcom();
+}
+
+/**************************************************************************//**
+ * The USART is busy until TXC reports the last stop bit out of the shift
+ * register, a blocking write returns as soon as the last byte is buffered.
+ *****************************************************************************/
+static bool update_vcom_requirement(void)
+{
+  bool busy;
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_CRITICAL();
+  busy = ((USART_StatusGet(SL_IOSTREAM_USART_VCOM_PERIPHERAL)
+           & USART_STATUS_TXC) == 0
+          || elapsedTimeInt32u(cli_activity_ms,
+                               halCommonGetInt32uMillisecondTick())
+          < APP_SLEEP_CLI_HOLD_MS);
+  if (busy) {
+    require_vcom();
+  } else if (vcom_required) {
+#if defined(SL_CATALOG_POWER_MANAGER_PRESENT)
+    sl_power_manager_remove_em_requirement(SL_POWER_MANAGER_EM1);
+#endif
+    vcom_required = false;
+  }
+  CORE_EXIT_CRITICAL();
+  return busy;
+}
+
+/**************************************************************************//**
+ * Takes the EM1 requirement of the VCOM, if not held yet.
+ *****************************************************************************/
+static void require_vcom(void)
+{
+  CORE_DECLARE_IRQ_STATE;
+
+  CORE_ENTER_CRITICAL();
+  if (!vcom_required) {
+#if defined(SL_CATALOG_POWER_MANAGER_PRESENT)
+    sl_power_manager_add_em_requirement(SL_POWER_MANAGER_EM1);
+#endif
+    vcom_required = true;
+  }
+  CORE_EXIT_CRITICAL();
+}
@@ -0,0 +1,91 @@
+/***************************************************************************//**
+ * @file app_sleep.h
+ * @brief app_sleep.h
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+#ifndef APP_SLEEP_H
+#define APP_SLEEP_H
+
+// -----------------------------------------------------------------------------
+//                                   Includes
+// -----------------------------------------------------------------------------
+#include "sleep-policy-config.h"
+
+// -----------------------------------------------------------------------------
+//                              Macros and Typedefs
+// -----------------------------------------------------------------------------
+/// Outcomes of the low-power policy
+typedef enum {
+  /// EM2 allowed
+  APP_SLEEP_DECISION_EM2,
+  /// EM1 allowed
+  APP_SLEEP_DECISION_EM1,
+  /// Staying awake: debug override
+  APP_SLEEP_DENIED_OVERRIDE,
+  /// EM2 denied: transmission or I2C transaction ongoing
+  APP_SLEEP_DENIED_BUSY,
+  /// EM2 denied: VCOM output pending or CLI activity. An EM1 request
+  /// counts as APP_SLEEP_DECISION_EM1.
+  APP_SLEEP_DENIED_CLI,
+  /// EM2 denied: next event too close
+  APP_SLEEP_DENIED_SHORT,
+  APP_SLEEP_DECISION_COUNT
+} app_sleep_decision_t;
+
+// -----------------------------------------------------------------------------
+//                                Global Variables
+// -----------------------------------------------------------------------------
+
+// -----------------------------------------------------------------------------
+//                          Public Function Declarations
+// -----------------------------------------------------------------------------
+/**************************************************************************//**
+ * Starts watching the VCOM RX line for CLI activity.
+ *****************************************************************************/
+void app_sleep_init(void);
+
+/**************************************************************************//**
+ * Picks the deepest safe energy mode. To be called from
+ * emberAfCommonOkToEnterLowPowerCallback().
+ *
+ * @param enter_em2 tells whether EM2 (true) or EM1 (false) is about to be
+ *        entered
+ * @param duration_ms is the time to the next scheduled event
+ * @returns true if the energy mode may be entered.
+ *****************************************************************************/
+bool app_sleep_ok_to_enter(bool enter_em2, uint32_t duration_ms);
+
+/**************************************************************************//**
+ * Toggles the debug override that keeps the device in EM0.
+ *
+ * @returns true if the override is now active.
+ *****************************************************************************/
+bool app_sleep_toggle_override(void);
+
+/**************************************************************************//**
+ * Tells whether the debug override is active.
+ *****************************************************************************/
+bool app_sleep_get_override(void);
+
+/**************************************************************************//**
+ * Returns the number of times each outcome was picked.
+ *****************************************************************************/
+const uint32_t *app_sleep_get_decisions(void);
+
+/**************************************************************************//**
+ * Clears the decision counters.
+ *****************************************************************************/
+void app_sleep_reset_decisions(void);
+
+#endif  // APP_SLEEP_H
@@ -0,0 +1,34 @@
+/***************************************************************************//**
+ * @brief Application stack counters configuration header.
+ *
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// <<< Use Configuration Wizard in Context Menu >>>
+
+// <h>Application stack counters configuration
+
+// <o APP_COUNTERS_SAMPLE_PERIOD_MS> Sample Period in milliseconds<100-3600000>
+// <i> Default: 10000
+// <i> The period at which every stack counter is sampled into the delta ring. Every sample wakes a sleepy sensor up.
+#define APP_COUNTERS_SAMPLE_PERIOD_MS      (10000)
+
+// <o APP_COUNTERS_RING_SIZE> Delta Ring Size<1-255>
+// <i> Default: 16
+// <i> The number of samples kept. The rates are averaged over the whole ring.
+#define APP_COUNTERS_RING_SIZE             (16)
+
+// </h>
+
+// <<< end of configuration section >>>
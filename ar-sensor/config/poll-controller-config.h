@@ -0,0 +1,44 @@
+/***************************************************************************//**
+ * @brief Application poll controller configuration header.
+ *
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// <<< Use Configuration Wizard in Context Menu >>>
+
+// <h>Application poll controller configuration
+
+// <o APP_POLL_TX_WINDOW_MS> Short Polling After TX in milliseconds<0-60000>
+// <i> Default: 2000
+// <i> How long a sleepy sensor keeps short polling after it sent a frame, to pick up the answer of the sink.
+#define APP_POLL_TX_WINDOW_MS              (2000)
+
+// <o APP_POLL_PENDING_WINDOW_MS> Short Polling On Pending Data in milliseconds<0-60000>
+// <i> Default: 4000
+// <i> How long a sleepy sensor keeps short polling after the sink flagged pending data for it.
+#define APP_POLL_PENDING_WINDOW_MS         (4000)
+
+// <o APP_POLL_DECAY_START_S> First Decay Step in seconds<1-65535>
+// <i> Default: 4
+// <i> The poll interval used right after short polling. It doubles at each step until it reaches EMBER_AF_PLUGIN_POLL_LONG_POLL_INTERVAL_S.
+#define APP_POLL_DECAY_START_S             (4)
+
+// <o APP_POLL_DECAY_POLLS_PER_STEP> Polls Per Decay Step<1-255>
+// <i> Default: 2
+// <i> The number of polls done at each decay step before the interval doubles.
+#define APP_POLL_DECAY_POLLS_PER_STEP      (2)
+
+// </h>
+
+// <<< end of configuration section >>>
@@ -0,0 +1,34 @@
+/***************************************************************************//**
+ * @brief Application low-power policy configuration header.
+ *
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// <<< Use Configuration Wizard in Context Menu >>>
+
+// <h>Application low-power policy configuration
+
+// <o APP_SLEEP_MIN_EM2_MS> Minimum EM2 Duration in milliseconds<0-1000>
+// <i> Default: 5
+// <i> EM2 is only entered if the next event is at least this far away. Shorter gaps are spent in EM1, where the wakeup costs nothing.
+#define APP_SLEEP_MIN_EM2_MS               (5)
+
+// <o APP_SLEEP_CLI_HOLD_MS> CLI Activity Hold in milliseconds<0-600000>
+// <i> Default: 30000
+// <i> The VCOM holds an EM1 requirement for this long after the last activity on the VCOM RX line, and while it transmits, so that the CLI stays responsive and the output is not cut off. The character that wakes the device up from EM2 is lost, press enter first.
+#define APP_SLEEP_CLI_HOLD_MS              (30000)
+
+// </h>
+
+// <<< end of configuration section >>>
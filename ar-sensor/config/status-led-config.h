@@ -0,0 +1,54 @@
+/***************************************************************************//**
+ * @brief Status LED configuration header.
+ *
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// <<< Use Configuration Wizard in Context Menu >>>
+
+// <h>Status LED configuration
+
+// <o APP_STATUS_LED_STEP_MS> Pattern Step in ms<10-1000>
+// <i> Default: 100
+// <i> A blink pattern is 16 steps, bit 0 first, the LED is on for the bits set. The pattern event only runs when the LED changes.
+#define APP_STATUS_LED_STEP_MS             (100)
+
+// <o APP_STATUS_LED_PATTERN_FORMING> Forming Pattern<0x0000-0xFFFF>
+// <i> Default: 0x5555
+// <i> Forming or joining a network: fast blink.
+#define APP_STATUS_LED_PATTERN_FORMING     (0x5555)
+
+// <o APP_STATUS_LED_PATTERN_PAIRING> Pairing Pattern<0x0000-0xFFFF>
+// <i> Default: 0x00FF
+// <i> Joining permitted: slow blink.
+#define APP_STATUS_LED_PATTERN_PAIRING     (0x00FF)
+
+// <o APP_STATUS_LED_PATTERN_ERROR> Error Pattern<0x0000-0xFFFF>
+// <i> Default: 0x0005
+// <i> A join failed or the stack reported an error: double flash.
+#define APP_STATUS_LED_PATTERN_ERROR       (0x0005)
+
+// <o APP_STATUS_LED_ERROR_MS> Error Display Time in ms<0-60000>
+// <i> Default: 5000
+// <i> How long the error pattern is shown before the LED goes back to the network state.
+#define APP_STATUS_LED_ERROR_MS            (5000)
+
+// <q APP_STATUS_LED_LOOP_METER> Main Loop Meter
+// <i> Default: 0
+// <i> Builds in the loop_cost CLI command, which measures the CPU cycles of a main loop iteration with and without the former polling of the LED. It costs a function call per iteration, leave it off outside of measurements.
+#define APP_STATUS_LED_LOOP_METER          (0)
+
+// </h>
+
+// <<< end of configuration section >>>
@@ -0,0 +1,34 @@
+/***************************************************************************//**
+ * @brief Application event trace configuration header.
+ *
+ *******************************************************************************
+ * # License
+ * <b>Copyright 2018 Silicon Laboratories Inc. www.silabs.com</b>
+ *******************************************************************************
+ *
+ * The licensor of this software is Silicon Laboratories Inc. Your use of this
+ * software is governed by the terms of Silicon Labs Master Software License
+ * Agreement (MSLA) available at
+ * www.silabs.com/about-us/legal/master-software-license-agreement. This
+ * software is distributed to you in Source Code format and is governed by the
+ * sections of the MSLA applicable to Source Code.
+ *
+ ******************************************************************************/
+
+// <<< Use Configuration Wizard in Context Menu >>>
+
+// <h>Application event trace configuration
+
+// <o APP_TRACE_SIZE> Trace Ring Size<16-4096>
+// <i> Default: 256
+// <i> The number of events kept. Every event takes 8 bytes of RAM, the oldest ones are overwritten.
+#define APP_TRACE_SIZE                     (256)
+
+// <q APP_TRACE_ENABLED_AT_STARTUP> Record From Startup
+// <i> Default: 1
+// <i> Records events from startup. The trace CLI command can pause and resume the recording.
+#define APP_TRACE_ENABLED_AT_STARTUP       (1)
+
+// </h>
+
+// <<< end of configuration section >>>